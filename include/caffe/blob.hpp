@@ -25,7 +25,7 @@ template <typename Dtype>
 class Blob {
  public:
   Blob()
-       : data_(), diff_(), count_(0), capacity_(0) {} //blobs分为四个域 data diff count capacity
+       : data_(), diff_(), count_(0), capacity_(0), channel_block_(0) {} //blobs分为四个域 data diff count capacity
 //构造函数组
   /// @brief Deprecated; use <code>Blob(const vector<int>& shape)</code>.
   explicit Blob(const int num, const int channels, const int height,
@@ -258,6 +258,25 @@ class Blob {
 
   /** mutable_gpu_diff() 返回gpu端的diff域 读写*/
   Dtype* mutable_gpu_diff();
+
+  /** mutable_cpu_data_uninitialized() 同mutable_cpu_data 但首次分配时不清零
+   *  只用于在读之前会写满整个blob的场合 例如层的top*/
+  Dtype* mutable_cpu_data_uninitialized();
+
+  /** mutable_cpu_diff_uninitialized() 同mutable_cpu_diff 但首次分配时不清零*/
+  Dtype* mutable_cpu_diff_uninitialized();
+
+  /** set_data_storage() data域以16位精度(FP16/BF16)保存 见SyncedMemory::set_storage()
+   *  只对float和double实现 写入data域后恢复为FP32*/
+  void set_data_storage(StoragePrecision precision);
+  /** data_storage() data域16位副本的精度 没有副本时为FP32*/
+  StoragePrecision data_storage() const {
+    return data_ ? data_->storage() : FP32;
+  }
+  /** reduced_cpu_data() data域的16位副本 没有时为NULL 供可以直接读取16位数据的计算使用*/
+  const uint16_t* reduced_cpu_data() const {
+    return data_ ? data_->reduced_cpu_data() : NULL;
+  }
 //函数组结束
 
   void Update();
@@ -308,6 +327,16 @@ class Blob {
   /**ShapeEquals 判断两Blob是否同形状 */
   bool ShapeEquals(const BlobProto& other);
 
+  /**channel_block 数据的通道分块大小 0为普通的NCHW布局
+   * @brief The memory layout of a 4-axis blob: 0 for NCHW, otherwise the
+   *        blocked layout N x C/channel_block x H x W x channel_block, which
+   *        keeps channel_block channels of a pixel together. The shape stays
+   *        (N, C, H, W) either way; only layers that handle the blocked layout
+   *        set it, on their tops in Reshape.
+   */
+  inline int channel_block() const { return channel_block_; }
+  void set_channel_block(int channel_block);
+
  protected:
   shared_ptr<SyncedMemory> data_; //属性 保存data域的 SyncedMemory
   shared_ptr<SyncedMemory> diff_; //属性 保存diff域的 SyncedMemory
@@ -315,6 +344,7 @@ class Blob {
   vector<int> shape_; //属性 形状向量
   int count_;
   int capacity_;
+  int channel_block_; //属性 通道分块大小
 
   DISABLE_COPY_AND_ASSIGN(Blob); //宏操作 取消Blob类的拷贝和赋值操作符
 };  // class Blob
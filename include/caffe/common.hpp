@@ -105,6 +105,27 @@ using std::vector;
 // A global initialization function that you should call in your main function.
 // Currently it initializes google flags and google logging.
 void GlobalInit(int* pargc, char*** pargv);
+
+/**HostMemoryPolicy 主机内存放置策略 大页 NUMA节点绑定 或者跨节点交错分配
+ * @brief Where and how SyncedMemory places the host buffers it allocates.
+ *
+ * The default policy uses the caching HostAllocator. Any other policy maps
+ * the buffer directly: huge_pages aligns it to 2MB and asks for transparent
+ * huge pages, numa_node makes its pages prefer that node at first touch, and
+ * interleave spreads its pages round-robin over all online nodes.
+ */
+struct HostMemoryPolicy {
+  HostMemoryPolicy() : huge_pages(false), numa_node(-1), interleave(false) {}
+  bool is_default() const {
+    return !huge_pages && numa_node < 0 && !interleave;
+  }
+  bool huge_pages;  ///< 2MB-aligned buffers backed by transparent huge pages
+  int numa_node;    ///< node to place pages on, or -1 to leave it to the OS
+  bool interleave;  ///< interleave pages over all nodes; overrides numa_node
+};
+
+class ThreadPool;
+
 /**Caffe 类 一个单例类,包含常用的Caffe工具 像cublas curand 的句柄
   *单例类 目的是在一个线程中只有一个唯一的Caffe对象 协调cublas curands 等的局部上下文
   *
@@ -170,6 +191,30 @@ class Caffe {
   // it personally but better to note it here in the header file.
   inline static void set_mode(Brew mode) { Get().mode_ = mode; }
 
+  /**host_memory_policy() 返回本线程新分配主机内存的放置策略*/
+  // The placement of host memory allocated from now on by this thread.
+  inline static const HostMemoryPolicy& host_memory_policy() {
+    return Get().host_memory_policy_;
+  }
+  inline static void set_host_memory_policy(const HostMemoryPolicy& policy) {
+    Get().host_memory_policy_ = policy;
+  }
+
+  /**thread_pool() 返回进程内所有线程共享的线程池 层和数学函数用它并行执行循环*/
+  // The intra-op thread pool shared by every thread of the process. Layers
+  // and math helpers split their loops over it, usually via parallel_for()
+  // (util/thread_pool.hpp). Loops that start while another thread's loop
+  // holds the pool run serially.
+  static shared_ptr<ThreadPool> thread_pool();
+  /**set_num_threads() 设置线程池和BLAS的线程数 默认取环境变量或BLAS的线程数*/
+  // Sets the number of threads of the pool and of a single BLAS call. The
+  // pool defaults to OMP_NUM_THREADS, OPENBLAS_NUM_THREADS or
+  // MKL_NUM_THREADS, else to the BLAS thread count, else to the number of
+  // cores; only this call changes the BLAS setting. Loops already running
+  // finish on the old pool.
+  static void set_num_threads(const int num_threads);
+  static int num_threads();
+
   /**set_random_seed() 设置boost和curand的随机数种子*/
   // Sets the random seed of both boost and curand
   static void set_random_seed(const unsigned int seed);
@@ -211,6 +256,7 @@ class Caffe {
   Brew mode_;         //属性 工作模式
   int solver_count_;  //属性 求解器数量
   bool root_solver_;  //属性 是否是根求解器
+  HostMemoryPolicy host_memory_policy_;  //属性 主机内存放置策略
 
  private:
   /**Caffe() 私有构造函数 防止破坏单例的条件*/
@@ -46,7 +46,7 @@ class InternalThread {
 
  private:
   void entry(int device, Caffe::Brew mode, int rand_seed, int solver_count,
-      bool root_solver);
+      bool root_solver, HostMemoryPolicy host_memory_policy);
 
   shared_ptr<boost::thread> thread_;//属性 指向boost线程对象的共享指针
 };
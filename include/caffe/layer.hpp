@@ -2,6 +2,7 @@
 #define CAFFE_LAYER_H_
 
 #include <algorithm>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -10,6 +11,7 @@
 #include "caffe/layer_factory.hpp"
 #include "caffe/proto/caffe.pb.h"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/workspace.hpp"
 
 /**
  Forward declare boost::thread instead of including boost/thread.hpp
@@ -38,7 +40,8 @@ class Layer {
    * layer.
    */
   explicit Layer(const LayerParameter& param)
-    : layer_param_(param), is_shared_(false) {
+    : layer_param_(param), activation_fusion_suspended_(false),
+      share_bottom_data_(false), is_shared_(false) {
       // Set phase and copy blobs (if there are any).
       phase_ = param.phase();
       if (layer_param_.blobs_size() > 0) {
@@ -321,6 +324,107 @@ class Layer {
     param_propagate_down_[param_id] = value;
   }
 
+  /**set_shared_workspace 设置与网络中其他层共享的临时内存 需要临时缓冲区的层(如卷积的im2col)可以用它代替自己的缓冲区
+   * @brief Hands the layer scratch memory shared with the other layers of
+   *        its net. Layers that need a scratch buffer during Forward or
+   *        Backward, e.g. the im2col buffer of convolutions, may use it
+   *        instead of one of their own. Ignored by default.
+   */
+  virtual void set_shared_workspace(const shared_ptr<Workspace>& workspace) {}
+
+  /**AllowElementwiseFusion 返回此层是否为可与其他层融合执行的逐元素层
+   * @brief Whether the layer maps each value of its one bottom to the value
+   *        at the same position of its one top, and can run fused with other
+   *        layers over ranges of a blob: Forward_cpu_fused_begin once per
+   *        pass, then Forward_cpu_fused and Backward_cpu_fused on ranges.
+   */
+  virtual inline bool AllowElementwiseFusion() const { return false; }
+  /**Forward_cpu_fused_begin 在一次融合计算前准备此层
+   * @brief Prepares a fused pass over blob, shaped as the bottom. If
+   *        keep_input, the layer's own Backward_cpu follows, and the layer
+   *        keeps what it needs of the input as an in-place Forward_cpu does.
+   */
+  virtual void Forward_cpu_fused_begin(const Blob<Dtype>& blob,
+      bool keep_input) {}
+  /**Forward_cpu_fused 原地计算blob的[begin, end)区间
+   * @brief Forward_cpu in place on values [begin, end) of the blob; data
+   *        points at value begin. Disjoint ranges may run concurrently.
+   */
+  virtual void Forward_cpu_fused(Dtype* data, int begin, int end) {
+    NOT_IMPLEMENTED;
+  }
+  /**Backward_cpu_fused 原地将[begin, end)区间的输出梯度变为输入梯度
+   * @brief Backward_cpu on values [begin, end): turns the top diff in diff
+   *        into the bottom diff in place, given the bottom_data the range
+   *        was computed from and the resulting top_data. All three point at
+   *        value begin. The gradients of the parameters are added to as by
+   *        Backward_cpu, so ranges run one at a time when any
+   *        param_propagate_down is set.
+   */
+  virtual void Backward_cpu_fused(const Dtype* bottom_data,
+      const Dtype* top_data, Dtype* diff, int begin, int end) {
+    NOT_IMPLEMENTED;
+  }
+
+  /**FuseActivation 请求此层在自己的CPU前向计算末尾 趁输出还在缓存中时 执行原地作用于其唯一输出的逐元素层
+   * @brief Asks the layer to run activation, a layer that
+   *        AllowElementwiseFusion and works in place on the layer's only
+   *        top, at the end of its own CPU forward pass while the output is
+   *        still in cache. Returns whether it will, in which case the Net
+   *        skips the Forward of activation on the CPU; its Backward runs as
+   *        before. Fused activations run in the order they were given. Only
+   *        layers that AllowActivationFusion accept. keep_input tells
+   *        whether the Backward of activation follows, so that it keeps what
+   *        it needs of its input.
+   */
+  virtual bool FuseActivation(Layer<Dtype>* activation, bool keep_input);
+  /**SuspendActivationFusion 暂停或恢复在CPU前向计算中执行融合的激活层
+   * @brief While suspended, the CPU forward pass of the layer leaves out its
+   *        fused activations, e.g. for a Net pass that stops at this layer.
+   */
+  virtual void SuspendActivationFusion(bool suspend) {
+    activation_fusion_suspended_ = suspend;
+  }
+  /**AllowActivationFusion 返回此层的CPU前向计算是否会执行融合的激活层
+   * @brief Whether the CPU forward pass of the layer runs fused activations.
+   */
+  virtual inline bool AllowActivationFusion() const { return false; }
+
+  /**BottomViewOffset 输入blob可以直接存放在输出blob中时 返回其偏移 否则返回-1
+   * @brief Returns the offset, in values, at which bottom[bottom_id] can
+   *        live inside top[0] for the current shapes, or -1. The Net then
+   *        makes the data and diff of that bottom views into the top (see
+   *        NetParameter.blob_views), and Forward_cpu and Backward_cpu copy
+   *        nothing for a bottom they find already in place.
+   */
+  virtual int BottomViewOffset(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top, int bottom_id) const { return -1; }
+  /**TopViewOffset 输出blob是输入blob中连续的一段时 返回其偏移 否则返回-1
+   * @brief Returns the offset, in values, at which top[top_id] lies inside
+   *        bottom[0] for the current shapes, or -1. The Net then makes the
+   *        data and diff of that top views into the bottom, and
+   *        Forward_cpu and Backward_cpu copy nothing for a top they find
+   *        already in place.
+   */
+  virtual int TopViewOffset(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top, int top_id) const { return -1; }
+  /**MayShareBottomData 返回前向计算时输出blob是否可能共享对应输入blob的数据
+   * @brief Whether Forward may make top[i] share the data and diff of
+   *        bottom[i], as a layer that finds itself an identity for the
+   *        current input does, once set_share_bottom_data allows it. The
+   *        activation memory planner then keeps bottom[i] alive for as long
+   *        as top[i].
+   */
+  virtual inline bool MayShareBottomData() const { return false; }
+  /**set_share_bottom_data 设置是否允许输出blob共享输入blob的数据
+   * @brief Allows a layer that MayShareBottomData to share. Off by default;
+   *        the Net allows it under the same conditions as top views (see
+   *        Net::PlanBlobViews).
+   */
+  inline void set_share_bottom_data(bool share) { share_bottom_data_ = share; }
+  /**share_bottom_data 返回是否允许输出blob共享输入blob的数据 */
+  inline bool share_bottom_data() const { return share_bottom_data_; }
+
 
  protected:
   /** The protobuf that stores the layer parameters */
@@ -335,6 +439,39 @@ class Layer {
   /** The vector that indicates whether each top blob has a non-zero weight in
    *  the objective function. */
   vector<Dtype> loss_;//表明每个输出(top)blob 是否在投影函数中有一个非零的权重的向量
+  /** The activations run at the end of the CPU forward pass, in order. */
+  vector<Layer<Dtype>*> fused_activations_; //在CPU前向计算末尾执行的激活层
+  /** Whether each fused activation keeps its input for Backward. */
+  vector<bool> fused_activation_keep_input_; //各融合激活层是否为后向保留输入
+  /** Whether the CPU forward pass leaves out the fused activations. */
+  bool activation_fusion_suspended_; //是否暂停执行融合的激活层
+  /** Whether a layer that MayShareBottomData may share now. */
+  bool share_bottom_data_; //是否允许输出blob共享输入blob的数据
+  /** Whether the CPU forward pass runs fused activations now. */
+  inline bool runs_fused_activations() const {
+    return !fused_activations_.empty() && !activation_fusion_suspended_;
+  }
+
+  /**
+   * For layers that AllowActivationFusion: forward_cpu_activations_begin
+   * once per pass over top, then forward_cpu_activations on ranges of its
+   * values as they are computed, from several threads if the ranges are
+   * disjoint.
+   */
+  void forward_cpu_activations_begin(const Blob<Dtype>& top);
+  void forward_cpu_activations(Dtype* top_data, int begin, int end);
+
+  /**DetachStaleView 视图不在base中的offset处时 为其复制一份独立内存
+   * @brief Gives view data and diff of their own again, with their values,
+   *        where they lie inside those of base but not at offset (-1 for
+   *        nowhere). For layers with a BottomViewOffset or TopViewOffset to
+   *        call from Reshape: a view the Net made for earlier shapes would
+   *        otherwise be copied over its own base.
+   */
+  void DetachStaleView(Blob<Dtype>* view, const Blob<Dtype>& base,
+      int offset);
+  /** The memory of the views given their own by DetachStaleView. */
+  std::map<SyncedMemory*, shared_ptr<SyncedMemory> > detached_views_; //独立出来的视图内存
 
   /* Forward_cpu cpu前向函数 使用cpu计算层输出*/
   /** @brief Using the CPU device, compute the layer output. */
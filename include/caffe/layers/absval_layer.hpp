@@ -30,6 +30,12 @@ class AbsValLayer : public NeuronLayer<Dtype> {
       const vector<Blob<Dtype>*>& top);
 
   virtual inline const char* type() const { return "AbsVal"; }
+
+  virtual inline bool AllowElementwiseFusion() const { return true; }
+  virtual void Forward_cpu_fused(Dtype* data, int begin, int end);
+  virtual void Backward_cpu_fused(const Dtype* bottom_data,
+      const Dtype* top_data, Dtype* diff, int begin, int end);
+
   virtual inline int ExactNumBottomBlobs() const { return 1; }
   virtual inline int ExactNumTopBlobs() const { return 1; }
 
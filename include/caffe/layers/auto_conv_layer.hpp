@@ -0,0 +1,70 @@
+#ifndef CAFFE_AUTO_CONV_LAYER_HPP_
+#define CAFFE_AUTO_CONV_LAYER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**AutoConvolutionLayer 对每种卷积形状计时各CPU卷积引擎 选最快的并缓存到文件
+ * @brief ConvolutionLayer that runs, on the CPU, whichever of the CAFFE,
+ *        DIRECT, WINOGRAD, FFT and IMPLICIT_GEMM engines is fastest for the
+ *        current shape.
+ *
+ * On Reshape to a new shape, the engines that apply to it are timed over a
+ * few forward passes and the fastest is kept, sharing this layer's weights.
+ * The choice goes into the ConvAlgorithmCache under a key of the CPU model,
+ * data type, thread count and convolution shape, and to the autotune_cache
+ * file if set, so later runs skip the timing. With autotune: NEVER_TUNE,
+ * shapes without a cached choice take the default CPU engine instead. GPU
+ * mode uses ConvolutionLayer.
+ */
+template <typename Dtype>
+class AutoConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit AutoConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param),
+        engine_type_(ConvolutionParameter_Engine_CAFFE) {}
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void set_shared_workspace(const shared_ptr<Workspace>& workspace);
+  /// @brief Fuses activation into this layer and its engines.
+  virtual bool FuseActivation(Layer<Dtype>* activation, bool keep_input);
+  virtual void SuspendActivationFusion(bool suspend);
+
+  /// @brief The engine that runs the current shape on the CPU.
+  inline ConvolutionParameter_Engine engine() const { return engine_type_; }
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  /// @brief The engines worth timing for the current shape.
+  vector<ConvolutionParameter_Engine> candidates();
+  /// @brief Sets up a layer of the given engine on this layer's weights.
+  shared_ptr<ConvolutionLayer<Dtype> > CreateEngine(
+      ConvolutionParameter_Engine engine, const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  /// @brief The fastest of the candidates on bottom, by forward time.
+  ConvolutionParameter_Engine Tune(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  /// @brief The cache key of the current shape.
+  string shape_key(const Blob<Dtype>& bottom);
+
+  shared_ptr<ConvolutionLayer<Dtype> > engine_;
+  ConvolutionParameter_Engine engine_type_;
+  /// @brief The cache key engine_ was picked for.
+  string engine_key_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_AUTO_CONV_LAYER_HPP_
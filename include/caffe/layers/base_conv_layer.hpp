@@ -27,6 +27,12 @@ class BaseConvolutionLayer : public Layer<Dtype> {
   virtual inline int MinBottomBlobs() const { return 1; }
   virtual inline int MinTopBlobs() const { return 1; }
   virtual inline bool EqualNumBottomTopBlobs() const { return true; }
+  virtual inline bool AllowActivationFusion() const { return true; }
+
+  /// @brief Takes the column buffer from the shared workspace from now on.
+  virtual void set_shared_workspace(const shared_ptr<Workspace>& workspace) {
+    shared_workspace_ = workspace;
+  }
 
  protected:
   // Helper functions that abstract away the column buffer and gemm arguments.
@@ -35,11 +41,46 @@ class BaseConvolutionLayer : public Layer<Dtype> {
   void forward_cpu_gemm(const Dtype* input, const Dtype* weights,
       Dtype* output, bool skip_im2col = false);
   void forward_cpu_bias(Dtype* output, const Dtype* bias);
+  // The end of the forward pass of image n of top_data: the bias, if any,
+  // then the fused activations, a channel at a time while it is in cache.
+  void forward_cpu_epilogue(Dtype* top_data, int n);
   void backward_cpu_gemm(const Dtype* input, const Dtype* weights,
       Dtype* output);
   void weight_cpu_gemm(const Dtype* input, const Dtype* output, Dtype*
       weights);
   void backward_cpu_bias(Dtype* bias, const Dtype* input);
+  // The same, with an explicit column buffer of col_buffer_size() elements
+  // (unused by 1x1 convolutions), so that several images can be processed
+  // at once. NULL weights stand for the 16-bit weights of blobs_[0], widened
+  // a panel at a time into weight_panel (weight_panel_size() elements).
+  void forward_cpu_gemm(const Dtype* input, const Dtype* weights,
+      Dtype* output, Dtype* col_buff, bool skip_im2col,
+      Dtype* weight_panel = NULL);
+  void backward_cpu_gemm(const Dtype* input, const Dtype* weights,
+      Dtype* output, Dtype* col_buff);
+  void weight_cpu_gemm(const Dtype* input, const Dtype* output,
+      Dtype* weights, Dtype* col_buff);
+  /// @brief The number of elements of one column buffer.
+  inline int col_buffer_size() const { return col_buffer_.count(); }
+  // Batched variants for num consecutive images: their columns are laid side
+  // by side in one wide matrix, so each group needs a single GEMM. buff
+  // holds batch_gemm_buffer_size(num) elements.
+  void forward_cpu_gemm_batch(const Dtype* input, const Dtype* weights,
+      Dtype* output, int num, Dtype* buff, Dtype* weight_panel = NULL);
+  void weight_cpu_gemm_batch(const Dtype* input, const Dtype* output,
+      Dtype* weights, int num, Dtype* buff);
+  /// @brief The number of images batched into one GEMM within the
+  ///        batch_gemm_memory budget; 1 if batching is off.
+  int batch_gemm_images() const;
+  /// @brief The scratch size of the batched helpers for num images.
+  int batch_gemm_buffer_size(int num) const;
+  /// @brief The size of the panel the 16-bit weights are widened into, a
+  ///        few output channels at a time, or 0 if they are at full precision.
+  int weight_panel_size() const;
+  /// @brief Returns count elements of CPU scratch memory, from the shared
+  ///        workspace if there is one, or NULL if count is 0. Contents only
+  ///        last for the current call.
+  Dtype* scratch_cpu(int count);
 
 #ifndef CPU_ONLY
   void forward_gpu_gemm(const Dtype* col_input, const Dtype* weights,
@@ -92,8 +133,28 @@ class BaseConvolutionLayer : public Layer<Dtype> {
   bool bias_term_;
   bool is_1x1_;
   bool force_nd_im2col_;
+  /// @brief Scratch memory shared with the other layers of the net, if any.
+  shared_ptr<Workspace> shared_workspace_;
 
  private:
+  // The column buffer: a view of the shared workspace if there is one,
+  // col_buffer_ otherwise. Contents only last for the current call.
+  inline Dtype* col_buffer_cpu() {
+    if (shared_workspace_) {
+      return static_cast<Dtype*>(shared_workspace_->mutable_cpu_data(
+          col_buffer_.count() * sizeof(Dtype)));
+    }
+    return col_buffer_.mutable_cpu_data_uninitialized();
+  }
+#ifndef CPU_ONLY
+  inline Dtype* col_buffer_gpu() {
+    if (shared_workspace_) {
+      return static_cast<Dtype*>(shared_workspace_->mutable_gpu_data(
+          col_buffer_.count() * sizeof(Dtype)));
+    }
+    return col_buffer_.mutable_gpu_data();
+  }
+#endif
   // wrap im2col/col2im so we don't have to remember the (long) argument lists
   inline void conv_im2col_cpu(const Dtype* data, Dtype* col_buff) {
     if (!force_nd_im2col_ && num_spatial_axes_ == 2) {
@@ -165,7 +226,16 @@ class BaseConvolutionLayer : public Layer<Dtype> {
   int col_offset_;
   int output_offset_;
 
+  // The GEMMs of every group, output = weights * col, over n columns; the
+  // group offsets of col and output are col_step and output_step.
+  void forward_cpu_group_gemms(const Dtype* weights, const Dtype* col,
+      int col_step, Dtype* output, int output_step, int n,
+      Dtype* weight_panel);
+  // The output channels of a group widened into one weight panel.
+  int weight_panel_rows() const;
+
   Blob<Dtype> col_buffer_;
+  Blob<Dtype> scratch_;
   Blob<Dtype> bias_multiplier_;
 };
 
@@ -28,6 +28,9 @@ class BatchReindexLayer : public Layer<Dtype> {
   virtual inline const char* type() const { return "BatchReindex"; }
   virtual inline int ExactNumBottomBlobs() const { return 2; }
   virtual inline int ExactNumTopBlobs() const { return 1; }
+  /// @brief The top shares the data of the bottom while the indices are
+  ///        0, 1, ..., N - 1, if allowed to.
+  virtual inline bool MayShareBottomData() const { return true; }
 
  protected:
   /**
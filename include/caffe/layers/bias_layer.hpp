@@ -33,6 +33,16 @@ class BiasLayer : public Layer<Dtype> {
   virtual inline int MaxBottomBlobs() const { return 2; }
   virtual inline int ExactNumTopBlobs() const { return 1; }
 
+  /// Fuses only with the bias learned as a parameter.
+  virtual inline bool AllowElementwiseFusion() const {
+    return this->blobs_.size() == 1;
+  }
+  virtual void Forward_cpu_fused_begin(const Blob<Dtype>& blob,
+      bool keep_input);
+  virtual void Forward_cpu_fused(Dtype* data, int begin, int end);
+  virtual void Backward_cpu_fused(const Dtype* bottom_data,
+      const Dtype* top_data, Dtype* diff, int begin, int end);
+
   virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
   virtual void Forward_gpu(const vector<Blob<Dtype>*>& bottom,
@@ -45,6 +55,8 @@ class BiasLayer : public Layer<Dtype> {
  private:
   Blob<Dtype> bias_multiplier_;
   int outer_dim_, bias_dim_, inner_dim_, dim_;
+  // The shape of the blob in a fused pass
+  int fused_bias_dim_, fused_inner_dim_;
 };
 
 
@@ -0,0 +1,62 @@
+#ifndef CAFFE_BLOCKED_CONV_LAYER_HPP_
+#define CAFFE_BLOCKED_CONV_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**BlockedConvolutionLayer 输出为通道分块布局的CPU二维卷积 用于推理
+ * @brief ConvolutionLayer whose top is in the blocked layout of
+ *        convolution_param.channel_block (see Blob::channel_block), for 2D
+ *        ungrouped convolutions on the CPU.
+ *
+ * The Net sets channel_block on the convolutions of the blocked chains of
+ * NetParameter.channel_block nets. The bottom may be blocked too, or plain
+ * for the first convolution of a chain. The weights are packed into panels
+ * of one block of output channels, and every input value is multiplied into
+ * a whole block of outputs at once; images and output blocks run in
+ * parallel. The blocked layout is for inference: there is no backward pass.
+ */
+template <typename Dtype>
+class BlockedConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit BlockedConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param), weight_memory_(NULL),
+        weight_version_(0) {}
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  /// @brief Fused activations would see the channels interleaved.
+  virtual inline bool AllowActivationFusion() const { return false; }
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  // Packs the weights into packed_weights_ if they changed since.
+  void PackWeights();
+  // The work of the parallel loop: (image, output block) pairs
+  // n * num_output_ / block + b in [begin, end).
+  void forward_cpu_blocks(const Dtype* bottom_data, int in_block,
+      Dtype* top_data, int begin, int end);
+
+  /// @brief The channels per block of the top.
+  int block_;
+  /// @brief The weights, packed by blocked_conv_pack_weights_cpu.
+  Blob<Dtype> packed_weights_;
+  /// @brief The weight data packed_weights_ was packed from, and its version
+  ///        then.
+  const SyncedMemory* weight_memory_;
+  unsigned int weight_version_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_BLOCKED_CONV_LAYER_HPP_
@@ -36,6 +36,11 @@ class BNLLLayer : public NeuronLayer<Dtype> {
 
   virtual inline const char* type() const { return "BNLL"; }
 
+  virtual inline bool AllowElementwiseFusion() const { return true; }
+  virtual void Forward_cpu_fused(Dtype* data, int begin, int end);
+  virtual void Backward_cpu_fused(const Dtype* bottom_data,
+      const Dtype* top_data, Dtype* diff, int begin, int end);
+
  protected:
   /// @copydoc BNLLLayer
   virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
@@ -27,6 +27,11 @@ class ConcatLayer : public Layer<Dtype> {
   virtual inline int MinBottomBlobs() const { return 1; }
   virtual inline int ExactNumTopBlobs() const { return 1; }
 
+  /// @brief The bottoms are contiguous in the top when the axes before the
+  ///        concatenation axis all have size 1, e.g. channels of one image.
+  virtual int BottomViewOffset(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top, int bottom_id) const;
+
  protected:
   /**
    * @param bottom input Blob vector (length 2+)
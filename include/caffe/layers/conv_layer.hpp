@@ -77,6 +77,27 @@ class ConvolutionLayer : public BaseConvolutionLayer<Dtype> {
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
   virtual inline bool reverse_dimensions() { return false; }
   virtual void compute_output_shape();
+
+  /**num_batch_shares 返回CPU上一个batch的图像被分成的份数 每个线程一份 每份至少一张图像
+   * @brief The number of shares the images of a batch are split into on the
+   *        CPU: one per thread of the pool, at most one per image, or a
+   *        single one unless batch_parallel is set.
+   */
+  int num_batch_shares() const;
+  /// @brief Forward pass for the images of shares [begin, end). NULL weight
+  ///        widens the 16-bit weights into the share's own weight panel.
+  void forward_cpu_shares(const Dtype* weight, const Dtype* bottom_data,
+      Dtype* top_data, Dtype* col_buffers, Dtype* weight_panels, int begin,
+      int end);
+  /// @brief Backward pass for the images of shares [begin, end); each share
+  ///        accumulates into its own weight gradient buffer. A NULL
+  ///        bottom_diff or weight_diffs skips that gradient.
+  void backward_cpu_shares(const Dtype* weight, const Dtype* top_diff,
+      const Dtype* bottom_data, Dtype* bottom_diff, Dtype* weight_diffs,
+      Dtype* col_buffers, int begin, int end);
+
+  /// @brief The number of shares of the current pass.
+  int num_shares_;
 };
 
 }  // namespace caffe
@@ -31,6 +31,12 @@ class CropLayer : public Layer<Dtype> {
   virtual inline int ExactNumBottomBlobs() const { return 2; }
   virtual inline int ExactNumTopBlobs() const { return 1; }
 
+  /// @brief The crop is contiguous in the bottom when the axes before the
+  ///        last cropped one all have size 1 in the top, e.g. a crop of
+  ///        rows from one channel of one image.
+  virtual int TopViewOffset(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top, int top_id) const;
+
  protected:
   virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
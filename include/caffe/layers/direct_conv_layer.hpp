@@ -0,0 +1,60 @@
+#ifndef CAFFE_DIRECT_CONV_LAYER_HPP_
+#define CAFFE_DIRECT_CONV_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**DirectConvolutionLayer 深度可分离卷积和小分组卷积的CPU直接实现 不用im2col和GEMM
+ * @brief Direct implementation of ConvolutionLayer for 2D grouped
+ *        convolutions with few input channels per group, such as depthwise
+ *        convolutions (group == channels), on the CPU.
+ *
+ * im2col + GEMM issues one tiny GEMM per group there. Instead, every kernel
+ * tap is applied to whole output rows, and the images and groups run in
+ * parallel: forward and the bottom gradient over (image, group) pairs, the
+ * weight gradient over groups. Ungrouped convolutions, groups wider than
+ * kMaxGroupChannels input channels, N-D convolutions, and GPU mode, are left
+ * to ConvolutionLayer. So are grouped convolutions that are not depthwise,
+ * unless the engine is DIRECT rather than DEFAULT.
+ */
+template <typename Dtype>
+class DirectConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit DirectConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param) {}
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+  /// @brief The most input channels per group the direct kernels handle.
+  static const int kMaxGroupChannels = 8;
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  // The work of the parallel loops: (image, group) pairs n * group_ + g in
+  // [begin, end) for forward_cpu_groups and backward_cpu_groups, groups in
+  // [begin, end) over all images for weight_cpu_groups.
+  void forward_cpu_groups(const Dtype* bottom_data, const Dtype* weight,
+      Dtype* top_data, int begin, int end);
+  void backward_cpu_groups(const Dtype* top_diff, const Dtype* weight,
+      Dtype* bottom_diff, int begin, int end);
+  void weight_cpu_groups(const Dtype* bottom_data, const Dtype* top_diff,
+      Dtype* weight_diff, int begin, int end);
+
+  /// @brief Whether this shape goes through the direct kernels.
+  bool use_direct_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_DIRECT_CONV_LAYER_HPP_
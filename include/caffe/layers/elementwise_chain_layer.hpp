@@ -0,0 +1,73 @@
+#ifndef CAFFE_ELEMENTWISE_CHAIN_LAYER_HPP_
+#define CAFFE_ELEMENTWISE_CHAIN_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/neuron_layer.hpp"
+
+namespace caffe {
+
+/**ElementwiseChainLayer 在一次分块循环中依次执行一串逐元素层 由Net为连续的逐元素层构造
+ * @brief Runs a chain of layers that AllowElementwiseFusion as one layer:
+ *        each cache-sized block of the bottom goes through every layer of
+ *        the chain before the next block is read, instead of every layer
+ *        making a pass over the whole blob.
+ *
+ * The Net builds these for runs of consecutive element-wise layers (see
+ * NetParameter.fuse_elementwise). The layers of the chain keep their
+ * parameters and stay in the Net; the chain only calls their
+ * Forward_cpu_fused and Backward_cpu_fused. The blobs between them are
+ * neither written nor read.
+ *
+ * The backward pass recomputes the values between the layers block by
+ * block, from the bottom data, and then runs the layers backward over the
+ * block in reverse order. When the chain works in place, the forward pass
+ * keeps a copy of its input for that, if keep_input.
+ */
+template <typename Dtype>
+class ElementwiseChainLayer : public NeuronLayer<Dtype> {
+ public:
+  /**
+   * @param layers the layers of the chain, in order, already set up;
+   *     not owned.
+   * @param keep_input whether Backward may follow an in-place Forward.
+   */
+  ElementwiseChainLayer(const LayerParameter& param,
+      const vector<Layer<Dtype>*>& layers, bool keep_input);
+
+  virtual inline const char* type() const { return "ElementwiseChain"; }
+
+  /// @brief returns the input kept by the last in-place Forward, or NULL if
+  ///        the chain does not keep it.
+  inline const Blob<Dtype>* kept_input() const {
+    return keep_input_ ? &input_ : NULL;
+  }
+
+  /// @brief The number of values each layer runs on at a time.
+  static const int kBlockSize = 2048;
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  // The work of the parallel loops: blocks [begin, end) of count values.
+  void forward_cpu_blocks(const Dtype* bottom_data, Dtype* top_data,
+      Dtype* input_data, int count, int begin, int end);
+  void backward_cpu_blocks(const Dtype* bottom_data, const Dtype* top_data,
+      const Dtype* top_diff, Dtype* bottom_diff, int count, int begin,
+      int end);
+
+  vector<Layer<Dtype>*> layers_;
+  bool keep_input_;
+  Blob<Dtype> input_;  // the input of an in-place chain, for Backward
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_ELEMENTWISE_CHAIN_LAYER_HPP_
@@ -34,6 +34,11 @@ class ELULayer : public NeuronLayer<Dtype> {
 
   virtual inline const char* type() const { return "ELU"; }
 
+  virtual inline bool AllowElementwiseFusion() const { return true; }
+  virtual void Forward_cpu_fused(Dtype* data, int begin, int end);
+  virtual void Backward_cpu_fused(const Dtype* bottom_data,
+      const Dtype* top_data, Dtype* diff, int begin, int end);
+
  protected:
   /**
    * @param bottom input Blob vector (length 1)
@@ -0,0 +1,81 @@
+#ifndef CAFFE_FFT_CONV_LAYER_HPP_
+#define CAFFE_FFT_CONV_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**FFTConvolutionLayer 用FFT计算大卷积核 步长1的CPU卷积 按运算量与GEMM比较后自动选择
+ * @brief FFT implementation of ConvolutionLayer for stride 1 2D filters on
+ *        the CPU, for large kernels in particular; 1-D signals are 2D inputs
+ *        of height 1.
+ *
+ * The forward pass and the gradient w.r.t. the bottom are computed tile by
+ * tile in the frequency domain (see fft_conv_cpu), images and groups in
+ * parallel. Each shape goes through the FFT only if that takes fewer
+ * multiply-adds than im2col + GEMM by a simple operation count, so small
+ * kernels stay on ConvolutionLayer; so do strided and N-D convolutions, and
+ * GPU mode. The gradient w.r.t. the bottom needs pad < kernel extent, and the
+ * weight gradient still goes through im2col.
+ *
+ * The transformed filters are cached and only recomputed when the weights
+ * change. Results match the CAFFE engine up to rounding.
+ */
+template <typename Dtype>
+class FFTConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit FFTConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param), fft_h_(0), fft_w_(0),
+        fft_backward_h_(0), fft_backward_w_(0), weight_memory_(NULL),
+        weight_version_(0), transformed_valid_(false),
+        flipped_valid_(false) {}
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+  /// @brief Whether the current shape goes through the FFT.
+  inline bool use_fft() const { return use_fft_; }
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  /// @brief Returns the transformed filters for the current weights; flipped
+  ///        for the gradient w.r.t. the bottom.
+  const Dtype* transformed_weights(bool flipped);
+  /// @brief The number of shares the (image, group) pairs are split into,
+  ///        one per thread of the pool.
+  int num_fft_shares() const;
+  /// @brief The FFT of the (image, group) pairs n * group_ + g of the shares
+  ///        [begin, end), forward or for the gradient w.r.t. the bottom.
+  void fft_cpu_shares(bool backward, const Dtype* input,
+      const Dtype* transformed, Dtype* output, Dtype* workspace, int begin,
+      int end);
+
+  /// @brief Whether this shape goes through the FFT at all.
+  bool use_fft_;
+  /// @brief Whether the gradient w.r.t. the bottom does too.
+  bool use_fft_backward_;
+  /// @brief The FFT sizes, forward and for the gradient w.r.t. the bottom.
+  int fft_h_, fft_w_;
+  int fft_backward_h_, fft_backward_w_;
+  /// @brief The weight data the cached transforms were computed from, and
+  ///        its version then.
+  const SyncedMemory* weight_memory_;
+  unsigned int weight_version_;
+  Blob<Dtype> transformed_weights_;
+  Blob<Dtype> flipped_weights_;
+  bool transformed_valid_;
+  bool flipped_valid_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_FFT_CONV_LAYER_HPP_
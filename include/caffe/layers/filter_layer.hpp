@@ -28,6 +28,9 @@ class FilterLayer : public Layer<Dtype> {
   virtual inline const char* type() const { return "Filter"; }
   virtual inline int MinBottomBlobs() const { return 2; }
   virtual inline int MinTopBlobs() const { return 1; }
+  /// @brief The tops share the data of the bottoms while every item is
+  ///        selected, if allowed to.
+  virtual inline bool MayShareBottomData() const { return true; }
 
  protected:
   /**
@@ -0,0 +1,48 @@
+#ifndef CAFFE_IMPLICIT_GEMM_CONV_LAYER_HPP_
+#define CAFFE_IMPLICIT_GEMM_CONV_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**ImplicitGemmConvolutionLayer 不生成im2col缓冲区的CPU二维卷积 按块即时打包后做GEMM
+ * @brief Implicit-GEMM implementation of ConvolutionLayer for 2D
+ *        convolutions on the CPU: the im2col columns are packed a
+ *        cache-sized panel at a time straight from the bottom, so the
+ *        (C * kh * kw) x (H_out * W_out) column buffer is never allocated.
+ *
+ * Forward, the panels feed a register-blocked micro-kernel; backward, the
+ * weight gradient is reduced against the same panels and the bottom gradient
+ * is scattered back panel by panel. 1x1 convolutions with unit stride and no
+ * padding need no im2col in the first place, and N-D convolutions, and GPU
+ * mode, are left to ConvolutionLayer.
+ */
+template <typename Dtype>
+class ImplicitGemmConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit ImplicitGemmConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param) {}
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  /// @brief Whether this shape goes through the implicit GEMM.
+  bool use_implicit_gemm_;
+  /// @brief The weights of each group, packed for the forward micro-kernel.
+  Blob<Dtype> packed_weights_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_IMPLICIT_GEMM_CONV_LAYER_HPP_
@@ -28,6 +28,7 @@ class InnerProductLayer : public Layer<Dtype> {
   virtual inline const char* type() const { return "InnerProduct"; }
   virtual inline int ExactNumBottomBlobs() const { return 1; }
   virtual inline int ExactNumTopBlobs() const { return 1; }
+  virtual inline bool AllowActivationFusion() const { return true; }
 
  protected:
   virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
@@ -39,6 +40,12 @@ class InnerProductLayer : public Layer<Dtype> {
   virtual void Backward_gpu(const vector<Blob<Dtype>*>& top,
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
 
+  // Forward_cpu for weights held at 16 bits: panels [begin, end) of
+  // panel_cols outputs each are widened one at a time into a buffer that
+  // stays in cache for their GEMM.
+  void forward_cpu_reduced_panels(const Dtype* bottom_data, Dtype* top_data,
+      int panel_cols, int begin, int end);
+
   int M_;
   int K_;
   int N_;
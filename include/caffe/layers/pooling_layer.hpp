@@ -43,6 +43,10 @@ class PoolingLayer : public Layer<Dtype> {
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
   virtual void Backward_gpu(const vector<Blob<Dtype>*>& top,
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+  /// @brief MAX and AVE pooling forward for inputs in the blocked layout
+  ///        (see Blob::channel_block), one channel block at a time.
+  void Forward_blocked_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
 
   int kernel_h_, kernel_w_;
   int stride_h_, stride_w_;
@@ -31,7 +31,8 @@ class PReLULayer : public NeuronLayer<Dtype> {
    *     negative slopes are shared across channels.
    */
   explicit PReLULayer(const LayerParameter& param)
-      : NeuronLayer<Dtype>(param) {}
+      : NeuronLayer<Dtype>(param), fused_dim_(1), fused_channels_(1),
+        fused_bottom_memory_(NULL) {}
 
   virtual void LayerSetUp(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
@@ -41,6 +42,13 @@ class PReLULayer : public NeuronLayer<Dtype> {
 
   virtual inline const char* type() const { return "PReLU"; }
 
+  virtual inline bool AllowElementwiseFusion() const { return true; }
+  virtual void Forward_cpu_fused_begin(const Blob<Dtype>& blob,
+      bool keep_input);
+  virtual void Forward_cpu_fused(Dtype* data, int begin, int end);
+  virtual void Backward_cpu_fused(const Dtype* bottom_data,
+      const Dtype* top_data, Dtype* diff, int begin, int end);
+
  protected:
   /**
    * @param bottom input Blob vector (length 1)
@@ -94,6 +102,11 @@ class PReLULayer : public NeuronLayer<Dtype> {
   Blob<Dtype> multiplier_;  // dot multiplier for backward computation of params
   Blob<Dtype> backward_buff_;  // temporary buffer for backward computation
   Blob<Dtype> bottom_memory_;  // memory for in-place computation
+  // The shape of the blob and, if kept, the data of bottom_memory_ in a
+  // fused pass
+  int fused_dim_;
+  int fused_channels_;
+  Dtype* fused_bottom_memory_;
 };
 
 }  // namespace caffe
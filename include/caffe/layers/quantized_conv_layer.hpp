@@ -0,0 +1,74 @@
+#ifndef CAFFE_QUANTIZED_CONV_LAYER_HPP_
+#define CAFFE_QUANTIZED_CONV_LAYER_HPP_
+
+#include <stdint.h>
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**QuantizedConvolutionLayer int8权重和输入 int32累加的CPU二维卷积 用于推理
+ * @brief ConvolutionLayer computed in int8 on the CPU, for the layers whose
+ *        quantization_param.precision is INT8.
+ *
+ * The bottom is quantized symmetrically over quantization_param.bottom_range,
+ * as calibrated by CalibrateQuantization, and the weights over the range of
+ * each output channel. im2col runs on the int8 image, the products are
+ * summed in int32, and the GEMM requantizes the sums back to the floating
+ * point top with the bias added, so the layers around need no change. Images
+ * and groups run in parallel. The quantized weights are kept until the
+ * weights change. N-D convolutions are left to ConvolutionLayer.
+ * Quantization is for inference: there is no backward pass.
+ */
+template <typename Dtype>
+class QuantizedConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit QuantizedConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param), weight_memory_(NULL),
+        weight_version_(0) {}
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  // The work of the parallel loop: the (image, group) pairs n * group_ + g
+  // of shares [begin, end).
+  void forward_cpu_int8(Dtype* top_data, int begin, int end);
+  /// @brief Quantizes the weights, unless they are unchanged since the last
+  ///        time.
+  void QuantizeWeights();
+  /// @brief The bytes of buffer_int8_ each share takes: the int8 columns,
+  ///        unless 1x1, and the same packed for int8_gemm_cpu.
+  int share_buffer_size() const;
+
+  /// @brief Whether this shape is computed in int8.
+  bool use_int8_;
+  /// @brief The weights, quantized per output channel.
+  std::vector<int8_t> weights_int8_;
+  /// @brief The quantization scale of each output channel of the weights.
+  Blob<Dtype> weight_scale_;
+  /// @brief The weight data weights_int8_ was quantized from, and its
+  ///        version then.
+  const SyncedMemory* weight_memory_;
+  unsigned int weight_version_;
+  /// @brief The bottom being computed, quantized.
+  std::vector<int8_t> bottom_int8_;
+  /// @brief The column buffers of the shares.
+  std::vector<int8_t> buffer_int8_;
+  /// @brief What brings the int32 sums of each output channel back to the
+  ///        scale of the top.
+  Blob<Dtype> output_scale_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_QUANTIZED_CONV_LAYER_HPP_
@@ -0,0 +1,65 @@
+#ifndef CAFFE_QUANTIZED_INNER_PRODUCT_LAYER_HPP_
+#define CAFFE_QUANTIZED_INNER_PRODUCT_LAYER_HPP_
+
+#include <stdint.h>
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/inner_product_layer.hpp"
+
+namespace caffe {
+
+/**QuantizedInnerProductLayer int8权重和输入 int32累加的全连接层 用于推理
+ * @brief InnerProductLayer computed in int8 on the CPU, for the layers whose
+ *        quantization_param.precision is INT8.
+ *
+ * As in QuantizedConvolutionLayer, the bottom is quantized over the
+ * calibrated quantization_param.bottom_range and the weights over the range
+ * of each output, the products are summed in int32, and the GEMM requantizes
+ * the sums back to the floating point top with the bias added. Rows of the
+ * bottom run in parallel. The quantized weights are kept, packed, until the
+ * weights change. Quantization is for inference: there is no backward pass.
+ */
+template <typename Dtype>
+class QuantizedInnerProductLayer : public InnerProductLayer<Dtype> {
+ public:
+  explicit QuantizedInnerProductLayer(const LayerParameter& param)
+      : InnerProductLayer<Dtype>(param), weight_memory_(NULL),
+        weight_version_(0) {}
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  // The work of the parallel loop: rows [begin, end) of the bottom.
+  void forward_cpu_rows(Dtype* top_data, int begin, int end);
+  /// @brief Quantizes and packs the weights, unless they are unchanged since
+  ///        the last time.
+  void QuantizeWeights();
+
+  /// @brief The weights, quantized per output, packed as K_ x N_ by
+  ///        int8_pack_cpu.
+  std::vector<int8_t> weights_packed_;
+  /// @brief The quantization scale of each output of the weights.
+  Blob<Dtype> weight_scale_;
+  /// @brief The weight data weights_packed_ was quantized from, and its
+  ///        version then.
+  const SyncedMemory* weight_memory_;
+  unsigned int weight_version_;
+  /// @brief The bottom being computed, quantized.
+  std::vector<int8_t> bottom_int8_;
+  /// @brief What brings the int32 sums of each output back to the scale of
+  ///        the top.
+  Blob<Dtype> output_scale_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_QUANTIZED_INNER_PRODUCT_LAYER_HPP_
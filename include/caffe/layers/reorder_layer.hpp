@@ -0,0 +1,43 @@
+#ifndef CAFFE_REORDER_LAYER_HPP_
+#define CAFFE_REORDER_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+namespace caffe {
+
+/**ReorderLayer 在普通NCHW布局和通道分块布局之间转换数据 由Net在分块链的边界处插入
+ * @brief Copies a 4-axis Blob into the memory layout of
+ *        reorder_param.channel_block (see Blob::channel_block), whatever the
+ *        layout of the input.
+ *
+ * The Net inserts these at the boundaries of the blocked chains of
+ * NetParameter.channel_block nets, so the layers outside a chain only see
+ * NCHW blobs. The shape is unchanged.
+ */
+template <typename Dtype>
+class ReorderLayer : public Layer<Dtype> {
+ public:
+  explicit ReorderLayer(const LayerParameter& param)
+      : Layer<Dtype>(param) {}
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+  virtual inline const char* type() const { return "Reorder"; }
+  virtual inline int ExactNumBottomBlobs() const { return 1; }
+  virtual inline int ExactNumTopBlobs() const { return 1; }
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  /// @brief Copies the top diff back into the layout of the bottom.
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_REORDER_LAYER_HPP_
@@ -24,7 +24,7 @@ template <typename Dtype>
 class ScaleLayer: public Layer<Dtype> {
  public:
   explicit ScaleLayer(const LayerParameter& param)
-      : Layer<Dtype>(param) {}
+      : Layer<Dtype>(param), fused_temp_(NULL) {}
   virtual void LayerSetUp(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
   virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
@@ -36,6 +36,16 @@ class ScaleLayer: public Layer<Dtype> {
   virtual inline int MaxBottomBlobs() const { return 2; }
   virtual inline int ExactNumTopBlobs() const { return 1; }
 
+  /// Fuses only with the scale (and bias) learned as parameters.
+  virtual inline bool AllowElementwiseFusion() const {
+    return this->blobs_.size() == (bias_layer_ ? 2 : 1);
+  }
+  virtual void Forward_cpu_fused_begin(const Blob<Dtype>& blob,
+      bool keep_input);
+  virtual void Forward_cpu_fused(Dtype* data, int begin, int end);
+  virtual void Backward_cpu_fused(const Dtype* bottom_data,
+      const Dtype* top_data, Dtype* diff, int begin, int end);
+
  protected:
   /**
    * In the below shape specifications, @f$ i @f$ denotes the value of the
@@ -75,6 +85,9 @@ class ScaleLayer: public Layer<Dtype> {
   Blob<Dtype> temp_;
   int axis_;
   int outer_dim_, scale_dim_, inner_dim_;
+  // The shape of the blob and, if kept, the data of temp_ in a fused pass
+  int fused_scale_dim_, fused_inner_dim_;
+  Dtype* fused_temp_;
 };
 
 
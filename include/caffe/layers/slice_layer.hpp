@@ -29,6 +29,11 @@ class SliceLayer : public Layer<Dtype> {
   virtual inline int ExactNumBottomBlobs() const { return 1; }
   virtual inline int MinTopBlobs() const { return 1; }
 
+  /// @brief The tops are contiguous in the bottom when the axes before the
+  ///        slice axis all have size 1, e.g. channels of one image.
+  virtual int TopViewOffset(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top, int top_id) const;
+
  protected:
   virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
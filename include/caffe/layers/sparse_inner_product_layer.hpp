@@ -0,0 +1,82 @@
+#ifndef CAFFE_SPARSE_INNER_PRODUCT_LAYER_HPP_
+#define CAFFE_SPARSE_INNER_PRODUCT_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/inner_product_layer.hpp"
+
+namespace caffe {
+
+/**SparseInnerProductLayer 稀疏权重的全连接层 权重以CSR格式参与CPU计算 用于剪枝后的模型
+ * @brief InnerProductLayer for pruned weights, for the layers whose
+ *        inner_product_param.sparse_threshold is positive.
+ *
+ * In the TEST phase, when at least sparse_threshold of the weights are
+ * zero, the CPU forward pass and the gradient w.r.t. the bottom read them in
+ * compressed sparse row form, one row per output, and skip the zeros;
+ * otherwise, in the TRAIN phase, and on the GPU, the layer is
+ * InnerProductLayer. The CSR form is built from the dense weights, which
+ * stay the parameter, and rebuilt whenever their SyncedMemory::version()
+ * changes, such as after loading a model. Once built, the dense weights are
+ * released unless another blob shares them; ToProto() and the GPU write
+ * them back from the CSR form. The weight and bias gradients are dense.
+ */
+template <typename Dtype>
+class SparseInnerProductLayer : public InnerProductLayer<Dtype> {
+ public:
+  explicit SparseInnerProductLayer(const LayerParameter& param)
+      : InnerProductLayer<Dtype>(param), weight_memory_(NULL),
+        weight_version_(0), use_sparse_(false), dense_released_(false) {}
+
+  /// @brief Whether the current weights run in CSR form.
+  bool use_sparse() {
+    UpdateSparseWeights();
+    return use_sparse_;
+  }
+  /// @brief Whether the dense weights were released for the CSR form; the
+  ///        blob then reads as zeros until RestoreDenseWeights().
+  bool dense_released() const { return dense_released_; }
+  /// @brief Writes the released dense weights back from the CSR form.
+  void RestoreDenseWeights();
+
+  virtual void ToProto(LayerParameter* param, bool write_diff = false);
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Forward_gpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+  virtual void Backward_gpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  // Rebuilds the CSR weights if the dense ones changed since.
+  void UpdateSparseWeights();
+  // The work of the parallel loops: outputs [begin, end) of the forward
+  // pass, and rows [begin, end) of the bottom gradient.
+  void forward_cpu_outputs(const Dtype* bottom_data, Dtype* top_data,
+      int begin, int end);
+  void backward_cpu_rows(const Dtype* top_diff, Dtype* bottom_diff,
+      int begin, int end);
+
+  /// @brief The weights as N_ x K_ CSR: the nonzeros of output o are
+  ///        values_[row_start_[o] .. row_start_[o + 1]), at inputs
+  ///        columns_[...].
+  vector<int> row_start_;
+  vector<int> columns_;
+  vector<Dtype> values_;
+  /// @brief The weights the CSR form was built from, and their version.
+  const SyncedMemory* weight_memory_;
+  unsigned int weight_version_;
+  bool use_sparse_;
+  bool dense_released_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_SPARSE_INNER_PRODUCT_LAYER_HPP_
@@ -31,6 +31,9 @@ class ThresholdLayer : public NeuronLayer<Dtype> {
 
   virtual inline const char* type() const { return "Threshold"; }
 
+  virtual inline bool AllowElementwiseFusion() const { return true; }
+  virtual void Forward_cpu_fused(Dtype* data, int begin, int end);
+
  protected:
   /**
    * @param bottom input Blob vector (length 1)
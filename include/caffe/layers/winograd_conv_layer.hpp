@@ -0,0 +1,72 @@
+#ifndef CAFFE_WINOGRAD_CONV_LAYER_HPP_
+#define CAFFE_WINOGRAD_CONV_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**WinogradConvolutionLayer 用Winograd算法计算3x3 步长1的CPU卷积 其他形状退回ConvolutionLayer
+ * @brief Winograd implementation of ConvolutionLayer for 3x3, stride 1,
+ *        undilated 2D filters on the CPU. Other shapes, and GPU mode, fall
+ *        back to ConvolutionLayer.
+ *
+ * The forward pass and the gradient w.r.t. the bottom are computed as
+ * F(m x m, 3 x 3) with m = winograd_tile (2 or 4), which takes 2.25x (m = 2)
+ * or 4x (m = 4) fewer multiplications than im2col + GEMM. The gradient
+ * w.r.t. the bottom needs pad <= 2. The weight gradient still goes through
+ * im2col.
+ *
+ * The transformed filters are cached and only recomputed when the weights
+ * change. Results match the CAFFE engine up to rounding; F(4x4, 3x3) rounds
+ * noticeably more than F(2x2, 3x3).
+ */
+template <typename Dtype>
+class WinogradConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit WinogradConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param), weight_memory_(NULL),
+        weight_version_(0), transformed_valid_(false),
+        flipped_valid_(false) {}
+  virtual void LayerSetUp(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  /// @brief Returns the transformed filters for the current weights; flipped
+  ///        for the gradient w.r.t. the bottom.
+  const Dtype* transformed_weights(bool flipped);
+  /// @brief The transform workspace, from the net's shared workspace if
+  ///        there is one.
+  Dtype* winograd_workspace();
+
+  int tile_;
+  /// @brief Whether this shape goes through Winograd at all.
+  bool use_winograd_;
+  /// @brief Whether the gradient w.r.t. the bottom does too (pad <= 2).
+  bool use_winograd_backward_;
+  /// @brief The weight data the cached transforms were computed from, and
+  ///        its version then.
+  const SyncedMemory* weight_memory_;
+  unsigned int weight_version_;
+  Blob<Dtype> transformed_weights_;
+  Blob<Dtype> flipped_weights_;
+  bool transformed_valid_;
+  bool flipped_valid_;
+  Blob<Dtype> workspace_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_WINOGRAD_CONV_LAYER_HPP_
@@ -92,6 +92,96 @@ class Net {
     return loss;
   }
 
+  /**PlanActivationMemory 按生命周期规划中间激活blob的内存 生命周期不重叠的blob共享同一块内存区(arena)的不同片段
+   * @brief Backs the intermediate activation blobs with slices of one shared
+   *        arena, reusing memory between blobs whose lifetimes over the
+   *        layer order do not overlap.
+   *
+   * Called by Net::Init and Net::Reshape when NetParameter.optimize_memory is
+   * set. Net inputs, net outputs, and the tops of layers without bottoms keep
+   * their own memory. Skipped in GPU mode and for nets that need backward,
+   * since the backward pass reads activations after their forward lifetime.
+   */
+  void PlanActivationMemory();
+  /// @brief returns the bytes of the shared activation arena (0 if unplanned).
+  inline size_t activation_arena_bytes() const {
+    return activation_arena_ ? activation_arena_->size() : 0;
+  }
+  /// @brief returns the bytes the planned blobs would take without sharing.
+  inline size_t activation_naive_bytes() const {
+    return activation_naive_bytes_;
+  }
+  /// @brief returns the bytes of the scratch workspace shared by the layers
+  ///        (0 if not shared); it grows to the largest request as layers run.
+  inline size_t workspace_bytes() const {
+    return workspace_ ? workspace_->size() : 0;
+  }
+  /**
+   * @brief Hands each in-place element-wise layer (see
+   *        Layer::AllowElementwiseFusion) that directly follows a
+   *        Convolution or InnerProduct layer to that layer, to run in its
+   *        CPU forward pass. Called by Net::Init when
+   *        NetParameter.fuse_activations is set.
+   */
+  void FuseActivations();
+  /// @brief returns whether the layer runs, on the CPU, inside the forward
+  ///        pass of the layer that produces its bottom.
+  inline bool layer_fused(int layer_id) const {
+    return layer_fused_.size() > layer_id && layer_fused_[layer_id];
+  }
+  /**
+   * @brief Runs each run of two or more consecutive element-wise layers,
+   *        on the CPU, as one ElementwiseChainLayer. A blob between two
+   *        layers of a run must not be read by any later layer nor be an
+   *        output of the net, since the chain does not write it. Called by
+   *        Net::Init, after FuseActivations, when
+   *        NetParameter.fuse_elementwise is set. ForwardFromTo and
+   *        BackwardFromTo run the layers of a chain one by one when their
+   *        range covers only part of it.
+   */
+  void FuseElementwiseChains();
+  /// @brief returns the index of the chain that runs the layer on the CPU,
+  ///        or -1.
+  inline int layer_chain(int layer_id) const {
+    return layer_chain_.size() > layer_id ? layer_chain_[layer_id] : -1;
+  }
+  /// @brief returns the element-wise chains, each of which runs in place
+  ///        of its layers on the CPU.
+  inline const vector<shared_ptr<Layer<Dtype> > >& chains() const {
+    return chains_;
+  }
+  /**
+   * @brief Finds the bottoms that can be views into the top of the layer
+   *        reading them (see Layer::BottomViewOffset), so that their
+   *        producers write straight into it, and the tops that can be views
+   *        into the bottom of the layer writing them (see
+   *        Layer::TopViewOffset). A bottom qualifies if it has no other
+   *        reader and no writer after the layer; a top if its bottom has no
+   *        writer after the layer. Both must share their memory with no
+   *        other blob, hold no loss weight, and not be made by a Split
+   *        layer, a layer without bottoms or one that MayShareBottomData.
+   *        With backward, neither may be written in place after the layer,
+   *        as a producer may still need the values. The layers that
+   *        MayShareBottomData are allowed to share when each of their tops
+   *        meets the conditions of a top view. Called by
+   *        Net::Init, in CPU mode, when NetParameter.blob_views is set.
+   *        Layers working in place on a view during Backward then leave
+   *        their diff in that of the base.
+   */
+  void PlanBlobViews();
+  /**
+   * @brief Points the data, and the diff if backward is needed, of the
+   *        blobs found by PlanBlobViews into their base blobs, at the
+   *        offsets for the current shapes. Called by Net::Init and
+   *        Net::Reshape after PlanActivationMemory, which plans a view
+   *        together with its base.
+   */
+  void ApplyBlobViews();
+  /// @brief returns the blob that the blob is a view into, or -1.
+  inline int blob_view_base(int blob_id) const {
+    return blob_view_base_.size() > blob_id ? blob_view_base_[blob_id] : -1;
+  }
+
   /// @brief Updates the network weights based on the diff values computed.
   void Update();
   /**
@@ -101,6 +191,12 @@ class Net {
    * called manually.
    */
   void ShareWeights();
+  /**
+   * @brief Holds the parameter blobs at the param_storage precision of the
+   *        NetParameter. Called by Net::Init and after copying trained
+   *        layers; parameters are widened back by any write, such as Update.
+   */
+  void ApplyParamStorage();
 
   /**
    * @brief For an already initialized net, implicitly copies (i.e., using no
@@ -281,6 +377,10 @@ class Net {
   /**UpdateDebugInfo 在更新过程中显示调试信息的帮助函数 */
   /// @brief Helper for displaying debug info in Update.
   void UpdateDebugInfo(const int param_id);
+  /**UnfuseChain 逐层重新执行上次整体前向的逐元素层链 写出链中间的blob */
+  /// @brief Writes the blobs between the layers of a chain that last ran
+  ///        forward as a whole, by running its layers one by one.
+  void UnfuseChain(int chain);
 
   /// @brief The network name
   string name_; //属性 网络名称
@@ -337,6 +437,42 @@ class Net {
   vector<bool> has_params_decay_; //属性 是否拥有衰减因子
   /// The bytes of memory used by this net
   size_t memory_used_; //属性 网络对象占用的内存大小
+  /// Whether to plan the activation memory after Init and Reshape
+  bool optimize_memory_; //属性 是否规划激活blob的内存
+  /// The precision the parameters are held in
+  StoragePrecision param_storage_; //属性 参数保存的精度
+  /// The arena backing the planned activation blobs
+  shared_ptr<SyncedMemory> activation_arena_; //属性 承载激活blob的共享内存区
+  /// The bytes the planned activation blobs would take without sharing
+  size_t activation_naive_bytes_; //属性 不共享时激活blob所需的内存大小
+  /// Whether each layer is run by the layer before it on the CPU
+  vector<bool> layer_fused_; //属性 各层是否在CPU上由前一层代为执行
+  /// The element-wise chains, and their first and last layers
+  vector<shared_ptr<Layer<Dtype> > > chains_; //属性 在CPU上代替其中各层执行的逐元素层链
+  vector<int> chain_first_layer_; //属性 各链的首层
+  vector<int> chain_last_layer_; //属性 各链的末层
+  /// Whether each chain last ran forward as a whole, leaving the blobs
+  /// between its layers unwritten
+  vector<bool> chain_ran_fused_; //属性 各链上次前向是否整体执行
+  /// The chain each layer belongs to, or -1
+  vector<int> layer_chain_; //属性 各层所属的链 不属于任何链时为-1
+  /// The layer and blob of each blob view, bases before the views in them
+  vector<pair<int, int> > blob_views_; //属性 各视图blob及使其成为视图的层(层, blob)
+  /// The blob each blob is a view into, or -1
+  vector<int> blob_view_base_; //属性 各blob作为视图所在的blob 不是视图时为-1
+  /// The memory each view points into, kept alive while it does
+  vector<shared_ptr<SyncedMemory> > blob_view_data_; //属性 各视图data所指向的内存
+  vector<shared_ptr<SyncedMemory> > blob_view_diff_; //属性 各视图diff所指向的内存
+  /// The scratch memory shared by the layers, if share_workspace is set
+  shared_ptr<Workspace> workspace_; //属性 各层共享的临时内存
+  /// Whether blobs may have several readers, with no Split layers inserted
+  bool shared_readers_; //属性 未插入Split层 一个blob可以有多个读取层(remove_identities)
+  /// Whether the net places its host memory according to the policies below
+  bool has_host_memory_policy_; //属性 是否使用网络自己的主机内存放置策略
+  /// Placement of the learnable parameters, allocated during Init
+  HostMemoryPolicy param_memory_policy_; //属性 可学习参数的主机内存放置策略
+  /// Placement of the activations, allocated during Forward and Backward
+  HostMemoryPolicy activation_memory_policy_; //属性 激活blob的主机内存放置策略
   /// Whether to compute and display debug info for the net.
   bool debug_info_; //属性 是否计算并显示网络的调试信息
   /// The root net that actually holds the shared layers in data parallelism
@@ -1,9 +1,13 @@
 #ifndef CAFFE_SYNCEDMEM_HPP_
 #define CAFFE_SYNCEDMEM_HPP_
 
+#include <stdint.h>
 #include <cstdlib>
+#include <vector>
 
 #include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/host_allocator.hpp"
 
 namespace caffe {
 // CaffeMallocHost CaffeFreeHost 主机内存分配和释放 不要使用malloc 和 free
@@ -13,27 +17,35 @@ namespace caffe {
 // The improvement in performance seems negligible in the single GPU case,
 // but might be more significant for parallel training. Most importantly,
 // it improved stability for large models on many GPUs.
-inline void CaffeMallocHost(void** ptr, size_t size, bool* use_cuda) {
+// 否则由HostAllocator按当前线程的主机内存放置策略分配 释放时须给出相同的大小和策略
+// Otherwise the memory comes from HostAllocator, placed according to the
+// thread's Caffe::host_memory_policy(). The policy used is returned so that
+// CaffeFreeHost can be given the same size and policy.
+inline void CaffeMallocHost(void** ptr, size_t size, bool* use_cuda,
+    HostMemoryPolicy* policy) {
 #ifndef CPU_ONLY
   if (Caffe::mode() == Caffe::GPU) {
     CUDA_CHECK(cudaMallocHost(ptr, size));//调用cudaMallocHost 在主机端分配分页锁定内存(pinned)
     *use_cuda = true;
+    *policy = HostMemoryPolicy();
     return;
   }
 #endif
-  *ptr = malloc(size);
+  *policy = Caffe::host_memory_policy();
+  *ptr = HostAllocator::Allocate(size, *policy);
   *use_cuda = false;
   CHECK(*ptr) << "host allocation of size " << size << " failed";
 }
 
-inline void CaffeFreeHost(void* ptr, bool use_cuda) {
+inline void CaffeFreeHost(void* ptr, size_t size, bool use_cuda,
+    const HostMemoryPolicy& policy) {
 #ifndef CPU_ONLY
   if (use_cuda) {
     CUDA_CHECK(cudaFreeHost(ptr));
     return;
   }
 #endif
-  free(ptr);
+  HostAllocator::Free(ptr, size, policy);
 }
 
 
@@ -48,11 +60,13 @@ class SyncedMemory {
   SyncedMemory()
       : cpu_ptr_(NULL), gpu_ptr_(NULL), size_(0), head_(UNINITIALIZED),
         own_cpu_data_(false), cpu_malloc_use_cuda_(false), own_gpu_data_(false),
-        gpu_device_(-1) {}
+        gpu_device_(-1), version_(0), reduced_precision_(FP32),
+        reduced_element_size_(0) {}
   explicit SyncedMemory(size_t size)
       : cpu_ptr_(NULL), gpu_ptr_(NULL), size_(size), head_(UNINITIALIZED),
         own_cpu_data_(false), cpu_malloc_use_cuda_(false), own_gpu_data_(false),
-        gpu_device_(-1) {}
+        gpu_device_(-1), version_(0), reduced_precision_(FP32),
+        reduced_element_size_(0) {}
   ~SyncedMemory();
   const void* cpu_data(); // 向CPU同步数据 返回CPU端内存指针 只读
   void set_cpu_data(void* data); // 设置CPU端内存数据指针到data
@@ -60,25 +74,73 @@ class SyncedMemory {
   void set_gpu_data(void* data); // 设置GPU端内存数据指针到data
   void* mutable_cpu_data(); // 向CPU同步数据 返回CPU端数据 读写 将head_ 设为CPU
   void* mutable_gpu_data(); // 向GPU同步数据 返回GPU端数据 读写 将head_ 设为GPU
-  enum SyncedHead { UNINITIALIZED, HEAD_AT_CPU, HEAD_AT_GPU, SYNCED }; //枚举 同步标志 
+  // 同mutable_cpu_data 但首次分配时不清零 调用者须保证读之前写满整块内存
+  // Like mutable_cpu_data(), but a fresh allocation is not zero-filled. Only
+  // for callers that overwrite every byte before anything reads it.
+  void* mutable_cpu_data_uninitialized();
+  // HEAD_AT_REDUCED 数据只保存在16位副本中 读取时再展开
+  enum SyncedHead { UNINITIALIZED, HEAD_AT_CPU, HEAD_AT_GPU, SYNCED,
+      HEAD_AT_REDUCED }; //枚举 同步标志
   SyncedHead head() { return head_; } //返回同步标志 不能显示设置同步标志
   size_t size() { return size_; } //返回内存大小
+  /**version() 数据版本号 每次交出可写指针或设置数据时加一 用于判断由数据派生的缓存是否过期
+   * @brief Counts the times the data may have changed: every mutable_*()
+   *        call, set_*_data() and set_storage(). State derived from the data
+   *        is current as long as the version is the same.
+   */
+  unsigned int version() const { return version_; }
+
+  /**set_storage() 以16位精度(FP16/BF16)保存数据 释放CPU端内存 读取时展开为Dtype
+   * @brief Keeps the data, taken as an array of Dtype, in a 16-bit copy of
+   *        the given precision and frees the CPU memory this owns, which
+   *        cpu_data() brings back widened (and rounded) on the next read.
+   *        Kernels read the copy through reduced_cpu_data(), widening what
+   *        they need as they go; the first full precision read, on the CPU
+   *        or the GPU, widens the data and drops the copy, so that the two
+   *        are never held together. FP32 does the same.
+   */
+  template <typename Dtype>
+  void set_storage(StoragePrecision precision);
+  /// The precision of the 16-bit copy, FP32 if there is none.
+  StoragePrecision storage() const { return reduced_precision_; }
+  /// The 16-bit copy of the data, or NULL if there is none.
+  const uint16_t* reduced_cpu_data() const {
+    return reduced_.empty() ? NULL : &reduced_[0];
+  }
+
+  /**set_poison_uninitialized() 调试用 未清零的分配用0xFF填充(浮点数即NaN) 以便发现先读后写的错误
+   * @brief When set, memory handed out by mutable_cpu_data_uninitialized() is
+   *        filled with 0xFF bytes (NaN as float or double) instead of being
+   *        left as is, so reads before writes show up. On by default in
+   *        DEBUG builds.
+   */
+  static void set_poison_uninitialized(bool poison) {
+    poison_uninitialized_ = poison;
+  }
+  static bool poison_uninitialized() { return poison_uninitialized_; }
 
 #ifndef CPU_ONLY 
   void async_gpu_push(const cudaStream_t& stream); //异步推送数据 异步将数据由CPU端推送GPU端 需要预先同步流 要满足(head_ == HEAD_AT_CPU)否则主机线程会被终止 将head_ 设置为 SYNCED
 #endif
 
  private:
-  void to_cpu();     //将数据向CPU端同步 CPU端超前将直接返回
+  void to_cpu(bool zero_fill = true); //将数据向CPU端同步 CPU端超前将直接返回 zero_fill 决定新分配的内存是否清零
   void to_gpu();     //将数据相GPU端同步 GPU端超前将直接返回
+  void drop_reduced(); //写入前丢弃16位副本
   void* cpu_ptr_;    //CPU端指针
   void* gpu_ptr_;    //GPU端指针
   size_t size_;      //属性 内存大小
   SyncedHead head_;  //属性 同步标志
   bool own_cpu_data_;       // 属性 是否拥有CPU端数据
   bool cpu_malloc_use_cuda_;// 属性 CPU端数据是否是由cudaAPI(cudaMallocHost)分配
+  HostMemoryPolicy cpu_malloc_policy_; // 属性 CPU端数据分配时使用的放置策略
   bool own_gpu_data_;       // 属性 是否拥有GPU端数据
   int gpu_device_;   //内存所在设备
+  unsigned int version_; //数据版本号
+  static bool poison_uninitialized_; //是否毒化未清零的分配
+  std::vector<uint16_t> reduced_;        // 16位精度的数据副本
+  StoragePrecision reduced_precision_;   // 副本的精度 没有副本时为FP32
+  size_t reduced_element_size_;          // 副本展开后每个元素的字节数
 
   DISABLE_COPY_AND_ASSIGN(SyncedMemory); //宏操作 取消 SyncedMemory 类的赋值和拷贝操作符
 };  // class SyncedMemory
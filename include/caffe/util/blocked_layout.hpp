@@ -0,0 +1,44 @@
+#ifndef CAFFE_UTIL_BLOCKED_LAYOUT_HPP_
+#define CAFFE_UTIL_BLOCKED_LAYOUT_HPP_
+
+namespace caffe {
+
+// The blocked layout (see Blob::channel_block) stores num x channels x
+// spatial_dim values as num x channels / block x spatial_dim x block, so the
+// block channels of a pixel are contiguous and kernels can run along them as
+// vectors. A block of 0 stands for the plain NCHW layout.
+
+/// @brief Copies src, in the layout of src_block, into dst in the layout of
+///        dst_block. channels must be a multiple of every nonzero block.
+template <typename Dtype>
+void reorder_channels_cpu(const int num, const int channels,
+    const int spatial_dim, const int src_block, const int dst_block,
+    const Dtype* src, Dtype* dst);
+
+/// @brief Packs ConvolutionLayer weights, num_output x kernel_dim, for
+///        blocked_conv_cpu: num_output / block panels of kernel_dim x block,
+///        each holding the weights of one block of output channels.
+template <typename Dtype>
+void blocked_conv_pack_weights_cpu(const Dtype* weights, const int num_output,
+    const int kernel_dim, const int block, Dtype* packed);
+
+// 2D convolution of one image into one block of output channels, in the
+// blocked layout. The input is in the layout of in_block (0 for NCHW, so that
+// the first convolution of a chain can read a plain image); packed is the
+// panel of the output block and bias, if not NULL, its block of biases. Each
+// input value is broadcast against the block of weights of a kernel tap and
+// accumulated into the block of outputs of its pixel, over the output columns
+// that do not fall into the padding. The output, output_h x output_w x
+// block, is overwritten. The function is serial: callers run images and
+// blocks in parallel.
+template <typename Dtype>
+void blocked_conv_cpu(const Dtype* data_im, const int channels,
+    const int in_block, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const Dtype* packed, const Dtype* bias,
+    const int block, Dtype* data_out);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_BLOCKED_LAYOUT_HPP_
@@ -0,0 +1,51 @@
+#ifndef CAFFE_UTIL_CONV_AUTOTUNE_HPP_
+#define CAFFE_UTIL_CONV_AUTOTUNE_HPP_
+
+#include <map>
+#include <string>
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/// @brief The CPU model, from /proc/cpuinfo where available. It keys the
+///        autotuning choices, since timings do not carry over between CPUs.
+string cpu_model_name();
+
+/**ConvAlgorithmCache 卷积算法自动调优结果的缓存 可以保存到文件 下次启动时复用
+ * @brief The convolution engine the AUTO engine chose for each shape, kept
+ *        in memory and, given a file, on disk across runs.
+ *
+ * A file holds one "key<TAB>algorithm" line per choice, appended as the
+ * choices are made; later lines win. An empty file name keeps the choices in
+ * memory only. All methods are thread-safe.
+ *
+ * boost/thread.hpp is kept out of this header, which is reached from CUDA
+ * sources through the layer headers.
+ */
+class ConvAlgorithmCache {
+ public:
+  /// @brief The process-wide cache.
+  static ConvAlgorithmCache& Get();
+
+  /// @brief Looks key up among the choices of file, reading the file first
+  ///        if it has not been read yet.
+  bool Lookup(const string& file, const string& key, string* algorithm);
+  /// @brief Records a choice, appending it to file if there is one.
+  void Store(const string& file, const string& key, const string& algorithm);
+  /// @brief Forgets every choice; files are read again on the next lookup.
+  void Clear();
+
+ private:
+  ConvAlgorithmCache() {}
+  // Reads file into choices_[file] if not done yet; the caller holds the lock.
+  void Load(const string& file);
+
+  std::map<string, std::map<string, string> > choices_;
+
+  DISABLE_COPY_AND_ASSIGN(ConvAlgorithmCache);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_CONV_AUTOTUNE_HPP_
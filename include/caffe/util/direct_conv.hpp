@@ -0,0 +1,44 @@
+#ifndef CAFFE_UTIL_DIRECT_CONV_HPP_
+#define CAFFE_UTIL_DIRECT_CONV_HPP_
+
+namespace caffe {
+
+// Direct 2D convolution of one image by one group, for groups of few
+// channels such as depthwise convolutions, where im2col + GEMM degenerates
+// into many tiny GEMMs. Each kernel tap is applied to a whole output row at a
+// time, over the range of columns that do not fall into the padding, so the
+// inner loops run over contiguous pixels without branches. Weights are
+// num_output x channels x kernel_h x kernel_w, as in ConvolutionLayer;
+// outputs are num_output x output_h x output_w. The functions are serial:
+// callers run images and groups in parallel.
+
+/// @brief data_out = conv(data_im, weights). The output is overwritten.
+template <typename Dtype>
+void direct_conv_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* weights,
+    const int num_output, Dtype* data_out);
+
+/// @brief weight_diff += the gradient of conv(data_im, weights) w.r.t. the
+///        weights, given top_diff. Accumulates, like
+///        BaseConvolutionLayer::weight_cpu_gemm.
+template <typename Dtype>
+void direct_conv_weight_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* top_diff,
+    const int num_output, Dtype* weight_diff);
+
+/// @brief bottom_diff = the gradient of conv(data_im, weights) w.r.t.
+///        data_im, given top_diff. The bottom diff is overwritten.
+template <typename Dtype>
+void direct_conv_data_cpu(const Dtype* top_diff, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* weights,
+    const int num_output, Dtype* bottom_diff);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_DIRECT_CONV_HPP_
@@ -0,0 +1,60 @@
+#ifndef CAFFE_UTIL_FFT_CONV_HPP_
+#define CAFFE_UTIL_FFT_CONV_HPP_
+
+namespace caffe {
+
+// FFT convolution for stride 1 2D filters, large ones in particular: the
+// input is cut into fft_h x fft_w tiles overlapping by the kernel extent
+// minus one (overlap-save), each tile is transformed once per channel,
+// multiplied by the transformed filters and transformed back, which takes
+// O(log(fft_h * fft_w)) operations per output instead of O(kernel_h *
+// kernel_w) per input channel. FFT sizes are powers of 2, and complex
+// numbers are stored as interleaved (real, imaginary) pairs.
+
+/// @brief Picks the FFT size, a power of 2, for one dimension of a
+///        convolution with output_size outputs and the given kernel extent
+///        (dilation * (kernel - 1) + 1).
+int fft_conv_size(const int output_size, const int kernel_extent);
+
+/// The number of elements of the filters transformed by
+/// fft_conv_transform_weights_cpu.
+int fft_conv_transformed_size(const int num_output, const int channels,
+    const int fft_h, const int fft_w);
+
+/// The number of elements of the workspace fft_conv_cpu needs.
+int fft_conv_workspace_size(const int channels, const int fft_h,
+    const int fft_w);
+
+/**
+ * @brief Transforms num_output x channels x kernel_h x kernel_w filters into
+ *        fft_h x fft_w spectra.
+ *
+ * Without flip the spectra are num_output x channels and correlate a
+ * channels-deep input into num_output outputs. With flip, filter (k, c) is
+ * rotated by 180 degrees and stored at (c, k), so the spectra correlate a
+ * num_output-deep gradient back into channels inputs (the backward pass
+ * w.r.t. the bottom, with padding kernel_extent - 1 - pad).
+ */
+template <typename Dtype>
+void fft_conv_transform_weights_cpu(const Dtype* weights,
+    const int num_output, const int channels, const int kernel_h,
+    const int kernel_w, const int dilation_h, const int dilation_w,
+    const int fft_h, const int fft_w, const bool flip, Dtype* transformed);
+
+/**
+ * @brief Correlates a channels x height x width input with filters
+ *        transformed by fft_conv_transform_weights_cpu into a num_output x
+ *        output_h x output_w output, output_h = height + 2 * pad_h -
+ *        kernel_extent_h + 1 and likewise for the width. The output is
+ *        overwritten.
+ */
+template <typename Dtype>
+void fft_conv_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int pad_h, const int pad_w,
+    const int kernel_extent_h, const int kernel_extent_w, const int fft_h,
+    const int fft_w, const Dtype* transformed, const int num_output,
+    Dtype* data_out, Dtype* workspace);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_FFT_CONV_HPP_
@@ -0,0 +1,22 @@
+#ifndef CAFFE_UTIL_FOLD_BATCH_NORM_HPP_
+#define CAFFE_UTIL_FOLD_BATCH_NORM_HPP_
+
+#include "caffe/proto/caffe.pb.h"
+
+namespace caffe {
+
+// Copy NetParameters with the per-channel affine layers that follow a
+// Convolution folded into its weights and bias, for inference: BatchNorm
+// with global statistics, and Scale and Bias over the channel axis with
+// learned parameters. The folded layers are removed and the convolution
+// writes their top instead; a convolution without a bias gains one. param
+// must hold the trained weights, e.g. from Net::ToProto, and so does
+// param_folded, which can be saved or given to a Net as it is. A layer is
+// folded only if it is the only reader of the convolution's output, or
+// works in place. CompareQuantizedNet (util/quantization.hpp) checks that a
+// net built from param_folded computes the same outputs as the original.
+void FoldBatchNorm(const NetParameter& param, NetParameter* param_folded);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_FOLD_BATCH_NORM_HPP_
@@ -0,0 +1,75 @@
+#ifndef CAFFE_UTIL_HOST_ALLOCATOR_HPP_
+#define CAFFE_UTIL_HOST_ALLOCATOR_HPP_
+
+#include <cstddef>
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/**HostAllocator 主机内存缓存分配器 按尺寸等级缓存释放的内存块 供SyncedMemory复用
+ * @brief A process-wide caching allocator for host memory.
+ *
+ * Requests are rounded up to a size class (four classes per power of two, at
+ * least 64 bytes) and freed blocks are kept on per-class free lists instead of
+ * being returned to the system, so that blobs which are repeatedly reshaped or
+ * created and destroyed do not go to malloc/free every time. Small blocks are
+ * first cached in a per-thread cache that needs no global locking; the rest
+ * go to a shared cache bounded by max_held_bytes(). Trim() returns every
+ * cached block to the system.
+ *
+ * Buffers with a non-default HostMemoryPolicy bypass the caches and are
+ * mapped directly with the requested page size and NUMA placement; the bytes
+ * placed on each node are tracked by NodeBytes(). Small placed blocks (up to
+ * 256KB) are instead carved out of shared 2MB placed chunks and pooled per
+ * policy; those chunks stay mapped for the life of the process.
+ *
+ * Free() must be given the same size and policy that were passed to
+ * Allocate().
+ */
+class HostAllocator {
+ public:
+  /// Counters describing the cache behaviour since the last ResetStats().
+  struct Stats {
+    Stats() : hits(0), misses(0), bytes_held(0), bytes_in_use(0) {}
+    size_t hits;          ///< allocations served from a cache
+    size_t misses;        ///< allocations that went to the system
+    size_t bytes_held;    ///< bytes cached in free lists (all threads)
+    size_t bytes_in_use;  ///< bytes handed out and not yet freed
+  };
+
+  static void* Allocate(size_t size,
+      const HostMemoryPolicy& policy = HostMemoryPolicy());
+  static void Free(void* ptr, size_t size,
+      const HostMemoryPolicy& policy = HostMemoryPolicy());
+  /// Returns all cached blocks, of every thread, to the system.
+  static void Trim();
+  static Stats GetStats();
+  /// Clears the hit and miss counters.
+  static void ResetStats();
+
+  /// The number of bytes actually reserved for a request of the given size.
+  static size_t SizeClass(size_t size);
+
+  /**NodeBytes() 返回每个NUMA节点上按策略放置的字节数 交错分配的内存平均计入各节点*/
+  // Bytes currently placed on each NUMA node by a numa_node or interleave
+  // policy, indexed by node id. Interleaved buffers count evenly per node,
+  // and pooled blocks count their size class.
+  static vector<size_t> NodeBytes();
+  /// The number of NUMA node ids on this machine (1 if NUMA is unavailable).
+  static int num_numa_nodes();
+
+  /**set_max_held_bytes() 设置共享缓存最多持有的字节数 设为0则关闭缓存*/
+  // Caps the bytes kept in the shared cache; 0 disables caching altogether
+  // and makes Allocate/Free plain malloc/free. Meant to be set up front,
+  // before other threads start allocating.
+  static void set_max_held_bytes(size_t bytes);
+  static size_t max_held_bytes();
+
+ private:
+  HostAllocator();
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_HOST_ALLOCATOR_HPP_
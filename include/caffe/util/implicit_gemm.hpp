@@ -0,0 +1,52 @@
+#ifndef CAFFE_UTIL_IMPLICIT_GEMM_HPP_
+#define CAFFE_UTIL_IMPLICIT_GEMM_HPP_
+
+namespace caffe {
+
+// Implicit-GEMM 2D convolution: the products of im2col + GEMM, computed
+// without the column buffer. The columns of one panel of output pixels are
+// gathered from the image into a cache-sized block right before they are
+// used, and the forward pass feeds the blocks to a register-blocked
+// micro-kernel. Weights are num_output x (channels * kernel_h * kernel_w), as
+// in ConvolutionLayer; outputs are num_output x output_h x output_w.
+
+/// The number of elements of the weights packed by
+/// implicit_gemm_pack_weights_cpu.
+int implicit_gemm_packed_size(const int num_output, const int kernel_dim);
+
+/// @brief Packs num_output x kernel_dim weights into the row strips the
+///        forward micro-kernel reads.
+template <typename Dtype>
+void implicit_gemm_pack_weights_cpu(const Dtype* weights,
+    const int num_output, const int kernel_dim, Dtype* packed);
+
+/// @brief data_out = weights * im2col(data_im), with weights packed by
+///        implicit_gemm_pack_weights_cpu. The output is overwritten.
+template <typename Dtype>
+void implicit_gemm_conv_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* packed_weights,
+    const int num_output, Dtype* data_out);
+
+/// @brief weight_diff += top_diff * im2col(data_im)^T. Accumulates, like
+///        BaseConvolutionLayer::weight_cpu_gemm.
+template <typename Dtype>
+void implicit_gemm_conv_weight_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* top_diff,
+    const int num_output, Dtype* weight_diff);
+
+/// @brief bottom_diff = col2im(weights^T * top_diff), with unpacked weights.
+///        The bottom diff is overwritten.
+template <typename Dtype>
+void implicit_gemm_conv_data_cpu(const Dtype* top_diff, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* weights,
+    const int num_output, Dtype* bottom_diff);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_IMPLICIT_GEMM_HPP_
@@ -0,0 +1,33 @@
+#ifndef _CAFFE_UTIL_INSERT_REORDERS_HPP_
+#define _CAFFE_UTIL_INSERT_REORDERS_HPP_
+
+#include <string>
+
+#include "caffe/proto/caffe.pb.h"
+
+namespace caffe {
+
+// Copy NetParameters with the chains of layers that can take the blocked
+// layout of param.channel_block() switched to it, and ReorderLayers added
+// where blobs cross between a chain and the other layers. A chain starts at
+// a 2D ungrouped convolution (2D as far as the shapes of the Input layers
+// and the net inputs tell) and goes on through the convolutions, MAX and
+// AVE pooling, ReLU and eltwise layers fed by it. The blobs of a chain are
+// renamed with a "_blocked" suffix; the NCHW blobs keep their names, and the
+// net outputs stay NCHW.
+void InsertReorders(const NetParameter& param, NetParameter* param_reorder);
+
+// Whether a layer can be part of a blocked chain, given its parameters and
+// the number of axes of its first bottom, or -1 if that is not known from
+// the net. Convolutions need 2 spatial axes: a 4-axis bottom, or kernel
+// parameters that are 2D by themselves when the bottom is not known.
+bool TakesBlockedLayout(const LayerParameter& layer_param,
+    const int channel_block, const int bottom_num_axes);
+
+void ConfigureReorderLayer(const string& layer_name, const string& bottom,
+    const string& top, const int channel_block,
+    LayerParameter* reorder_layer_param);
+
+}  // namespace caffe
+
+#endif  // _CAFFE_UTIL_INSERT_REORDERS_HPP_
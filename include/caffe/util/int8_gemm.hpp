@@ -0,0 +1,64 @@
+#ifndef CAFFE_UTIL_INT8_GEMM_HPP_
+#define CAFFE_UTIL_INT8_GEMM_HPP_
+
+#include <stdint.h>
+
+namespace caffe {
+
+// Symmetric int8 quantization for inference: a value x is stored as
+// q = round(x * scale) saturated to [-127, 127], with scale = 127 / range for
+// the range of the values, so that 0 stays exactly 0 (the padding of im2col)
+// and products of two int8 values can be summed in int32 without overflow
+// for any kernel_dim below 2^17. The functions are serial: callers run
+// images and groups in parallel. The GEMM reads B packed by int8_pack_cpu,
+// four values of k side by side for each column, which it takes on AVX2
+// CPUs (see simd_isa()) with _mm256_maddubs_epi16 / _mm256_madd_epi16.
+
+/// @brief The largest absolute value of data.
+template <typename Dtype>
+Dtype int8_max_abs(const int n, const Dtype* data);
+
+/// @brief The scale that maps [-range, range] onto [-127, 127]; 1 if range is
+///        0, which quantizes anything to 0 all the same.
+template <typename Dtype>
+inline Dtype int8_scale(const Dtype range) {
+  return range > 0 ? Dtype(127) / range : Dtype(1);
+}
+
+/// @brief q = round(x * scale), saturated to [-127, 127].
+template <typename Dtype>
+void int8_quantize_cpu(const int n, const Dtype* x, const Dtype scale,
+    int8_t* q);
+
+/// @brief Quantizes each of the rows of data (rows x cols) with its own
+///        scale, taken from the range of the row, such as the weights of each
+///        output channel.
+template <typename Dtype>
+void int8_quantize_rows_cpu(const int rows, const int cols, const Dtype* data,
+    Dtype* scale, int8_t* q);
+
+/// @brief The bytes int8_pack_cpu takes for a K x N matrix: K rounded up to
+///        a multiple of 4 times N rounded up to a multiple of 8.
+inline int int8_packed_size(const int K, const int N) {
+  return ((K + 3) / 4 * 4) * ((N + 7) / 8 * 8);
+}
+
+/// @brief Packs the int8 K x N matrix B, whose element (k, n) is at
+///        B[k * k_stride + n * n_stride], for int8_gemm_cpu, zero-padded to
+///        int8_packed_size(K, N) bytes.
+void int8_pack_cpu(const int K, const int N, const int8_t* B,
+    const int k_stride, const int n_stride, int8_t* packed);
+
+/// @brief C = (A * B) * scale + bias for int8 A (M x K) and B (K x N), B
+///        packed by int8_pack_cpu, with the products summed in int32 and
+///        dequantized on the way out. scale and bias (which may be NULL) hold
+///        one value per output channel: per row of C, or per column if
+///        channels_in_columns. C is overwritten.
+template <typename Dtype>
+void int8_gemm_cpu(const int M, const int N, const int K, const int8_t* A,
+    const int8_t* packed_B, const Dtype* scale, const Dtype* bias,
+    const bool channels_in_columns, Dtype* C);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_INT8_GEMM_HPP_
@@ -12,6 +12,15 @@
 
 namespace caffe {
 
+/**caffe_cpu_set_parallel_threshold() 设置并行执行的最小元素数 小于该值时串行执行*/
+// The CPU helpers below, other than gemm, gemv and the random generators,
+// split arrays of at least caffe_cpu_parallel_threshold() elements across
+// the Caffe::num_threads() threads of Caffe::thread_pool(). Reductions sum
+// fixed-size blocks in a fixed order, so their results do not depend on the
+// number of threads.
+void caffe_cpu_set_parallel_threshold(const int threshold);
+int caffe_cpu_parallel_threshold();
+
 // Caffe gemm provides a simpler interface to the gemm functions, with the
 // limitation that the data has to be contiguous in memory.
 template <typename Dtype>
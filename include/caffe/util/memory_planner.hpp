@@ -0,0 +1,45 @@
+#ifndef CAFFE_UTIL_MEMORY_PLANNER_HPP_
+#define CAFFE_UTIL_MEMORY_PLANNER_HPP_
+
+#include <vector>
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/**
+ * @brief A chunk of memory that must stay valid from step first to step last
+ *        (inclusive), e.g. an activation blob alive between the layer that
+ *        produces it and the last layer that consumes it.
+ */
+struct MemoryBlock {
+  MemoryBlock() : size(0), first(0), last(0) {}
+  MemoryBlock(size_t size, int first, int last)
+      : size(size), first(first), last(last) {}
+  size_t size;
+  int first;
+  int last;
+};
+
+/**
+ * @brief Assign every block an offset inside a single arena such that blocks
+ *        with overlapping [first, last] lifetimes never overlap in memory.
+ *
+ * Blocks are placed largest first, each into the smallest gap left by the
+ * already placed blocks it is alive together with. Offsets are multiples of
+ * alignment.
+ *
+ * @return the number of bytes the arena must hold.
+ */
+size_t PlanMemoryBlocks(const vector<MemoryBlock>& blocks,
+    const size_t alignment, vector<size_t>* offsets);
+
+/**
+ * @brief The largest number of bytes alive at any single step, i.e. the lower
+ *        bound on the arena size any plan could achieve.
+ */
+size_t PeakLiveBytes(const vector<MemoryBlock>& blocks);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_MEMORY_PLANNER_HPP_
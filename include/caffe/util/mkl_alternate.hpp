@@ -12,7 +12,12 @@ extern "C" {
 }
 #include <math.h>
 
+#include "caffe/util/simd_math.hpp"
+
 // Functions that caffe uses but are not present if MKL is not linked.
+// The v##name templates are the scalar reference implementations; the
+// vs##name and vd##name entry points go through the runtime-dispatched
+// AVX2/AVX-512 kernels of simd_math.hpp.
 
 // A simple way to define the vsl unary functions. The operation should
 // be in the form e.g. y[i] = sqrt(a[i])
@@ -24,11 +29,11 @@ extern "C" {
   } \
   inline void vs##name( \
     const int n, const float* a, float* y) { \
-    v##name<float>(n, a, y); \
+    caffe::simd_v##name(n, a, y); \
   } \
   inline void vd##name( \
       const int n, const double* a, double* y) { \
-    v##name<double>(n, a, y); \
+    caffe::simd_v##name(n, a, y); \
   }
 
 DEFINE_VSL_UNARY_FUNC(Sqr, y[i] = a[i] * a[i]);
@@ -46,11 +51,11 @@ DEFINE_VSL_UNARY_FUNC(Abs, y[i] = fabs(a[i]));
   } \
   inline void vs##name( \
     const int n, const float* a, const float b, float* y) { \
-    v##name<float>(n, a, b, y); \
+    caffe::simd_v##name(n, a, b, y); \
   } \
   inline void vd##name( \
       const int n, const double* a, const float b, double* y) { \
-    v##name<double>(n, a, b, y); \
+    caffe::simd_v##name(n, a, b, y); \
   }
 
 DEFINE_VSL_UNARY_FUNC_WITH_PARAM(Powx, y[i] = pow(a[i], b));
@@ -65,11 +70,11 @@ DEFINE_VSL_UNARY_FUNC_WITH_PARAM(Powx, y[i] = pow(a[i], b));
   } \
   inline void vs##name( \
     const int n, const float* a, const float* b, float* y) { \
-    v##name<float>(n, a, b, y); \
+    caffe::simd_v##name(n, a, b, y); \
   } \
   inline void vd##name( \
       const int n, const double* a, const double* b, double* y) { \
-    v##name<double>(n, a, b, y); \
+    caffe::simd_v##name(n, a, b, y); \
   }
 
 DEFINE_VSL_BINARY_FUNC(Add, y[i] = a[i] + b[i]);
@@ -0,0 +1,62 @@
+#ifndef CAFFE_UTIL_QUANTIZATION_HPP_
+#define CAFFE_UTIL_QUANTIZATION_HPP_
+
+#include <string>
+#include <vector>
+
+#include "caffe/net.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+namespace caffe {
+
+// Post-training INT8 quantization of the Convolution and InnerProduct layers
+// of a trained net (see QuantizationParameter): calibrate on a few batches
+// of representative data, save the result with WriteProtoToBinaryFile, and
+// check what the quantization costs with CompareQuantizedNet.
+
+/**
+ * @brief Runs iterations batches from the data layers of net through it and
+ *        records the largest absolute value reaching each Convolution and
+ *        InnerProduct layer. Then copies net into quantized, like
+ *        Net::ToProto, with those layers switched to INT8 and their
+ *        calibrated bottom_range.
+ *
+ * quantized holds the weights too, so it can be saved as the quantized
+ * parameter file and loaded on its own as a net.
+ */
+template <typename Dtype>
+void CalibrateQuantization(Net<Dtype>* net, const int iterations,
+    NetParameter* quantized);
+
+/// @brief How far an output of a quantized net is from that of the net it was
+///        calibrated from.
+struct QuantizationError {
+  QuantizationError()
+      : reference_mean(0), quantized_mean(0), max_abs_diff(0),
+        relative_error(0) {}
+  string blob_name;
+  /// The mean of the output over every value and batch, e.g. the accuracy
+  /// for an Accuracy layer.
+  double reference_mean;
+  double quantized_mean;
+  /// The largest absolute difference of any value.
+  double max_abs_diff;
+  /// |quantized - reference| / |reference|, in the L2 norm over all batches.
+  double relative_error;
+};
+
+/**
+ * @brief Runs iterations batches through both nets and compares each output
+ *        of quantized with the output of the same name of reference.
+ *
+ * Both nets see the same data: the tops of the leading layers of quantized
+ * that have no bottoms, i.e. its data layers, are copied from the blobs of
+ * the same name of reference before quantized runs its other layers.
+ */
+template <typename Dtype>
+vector<QuantizationError> CompareQuantizedNet(Net<Dtype>* reference,
+    Net<Dtype>* quantized, const int iterations);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_QUANTIZATION_HPP_
@@ -0,0 +1,92 @@
+#ifndef CAFFE_UTIL_REDUCED_PRECISION_HPP_
+#define CAFFE_UTIL_REDUCED_PRECISION_HPP_
+
+#include <stdint.h>
+#include <cmath>
+#include <cstring>
+
+#include "caffe/proto/caffe.pb.h"
+
+namespace caffe {
+
+// Conversions between full precision and the 16-bit storage precisions of
+// StoragePrecision. Narrowing rounds to the nearest even value; FP16
+// overflows to infinity past 65504 and goes subnormal below 2^-14, while
+// BF16 keeps the range of float. NaN stays NaN.
+
+inline uint32_t float_bits(const float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float float_from_bits(const uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline uint16_t float_to_fp16(const float value) {
+  // The float arithmetic does the rounding: scaling up by 2^112 and back
+  // down by 2^-110 leaves the value rounded to the mantissa FP16 has at its
+  // exponent, or to the subnormal spacing, and adding the bias shifts that
+  // mantissa to the low bits.
+  const float scale_to_inf = float_from_bits(0x77800000);   // 2^112
+  const float scale_to_zero = float_from_bits(0x08800000);  // 2^-110
+  float base = (std::fabs(value) * scale_to_inf) * scale_to_zero;
+  const uint32_t w = float_bits(value);
+  const uint32_t shl1_w = w + w;
+  const uint32_t sign = w & 0x80000000u;
+  uint32_t bias = shl1_w & 0xFF000000u;
+  if (bias < 0x71000000u) {
+    bias = 0x71000000u;
+  }
+  base = float_from_bits((bias >> 1) + 0x07800000u) + base;
+  const uint32_t bits = float_bits(base);
+  const uint32_t exp_bits = (bits >> 13) & 0x00007C00u;
+  const uint32_t mantissa_bits = bits & 0x00000FFFu;
+  return static_cast<uint16_t>((sign >> 16) |
+      (shl1_w > 0xFF000000u ? 0x7E00u : exp_bits + mantissa_bits));
+}
+
+inline float fp16_to_float(const uint16_t value) {
+  const uint32_t w = static_cast<uint32_t>(value) << 16;
+  const uint32_t sign = w & 0x80000000u;
+  const uint32_t two_w = w + w;
+  // Normal values: move the exponent and mantissa into place and rebias the
+  // exponent by a multiplication, which also handles infinity and NaN.
+  const float normalized = float_from_bits((two_w >> 4) + (0xE0u << 23)) *
+      float_from_bits(0x07800000);  // 2^-112
+  // Subnormal values: the mantissa under a 0.5 exponent, minus 0.5.
+  const float denormalized =
+      float_from_bits((two_w >> 17) | (126u << 23)) - 0.5f;
+  return float_from_bits(sign | (two_w < (1u << 27) ?
+      float_bits(denormalized) : float_bits(normalized)));
+}
+
+inline uint16_t float_to_bf16(const float value) {
+  const uint32_t bits = float_bits(value);
+  if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+    return static_cast<uint16_t>((bits >> 16) | 0x0040u);  // quiet NaN
+  }
+  return static_cast<uint16_t>(
+      (bits + 0x7FFFu + ((bits >> 16) & 1u)) >> 16);
+}
+
+inline float bf16_to_float(const uint16_t value) {
+  return float_from_bits(static_cast<uint32_t>(value) << 16);
+}
+
+/// @brief y = x narrowed to the 16-bit precision, which must not be FP32.
+template <typename Dtype>
+void caffe_cpu_reduce_precision(const int n, const Dtype* x,
+    const StoragePrecision precision, uint16_t* y);
+
+/// @brief y = x widened from the 16-bit precision, which must not be FP32.
+template <typename Dtype>
+void caffe_cpu_expand_precision(const int n, const uint16_t* x,
+    const StoragePrecision precision, Dtype* y);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_REDUCED_PRECISION_HPP_
@@ -0,0 +1,23 @@
+#ifndef CAFFE_UTIL_REMOVE_IDENTITIES_HPP_
+#define CAFFE_UTIL_REMOVE_IDENTITIES_HPP_
+
+#include "caffe/proto/caffe.pb.h"
+
+namespace caffe {
+
+// Copy NetParameters without the layers that only pass their input on in
+// the forward pass: Dropout in the TEST phase and Split. The later layers
+// read the bottom of a removed layer in place of its tops. A layer stays if
+// that would change what those layers see: if its bottom is written again
+// later, if one of its tops is a net output, or if a top written later in
+// place would also be seen by the other readers of the bottom. Silence
+// layers are removed too when each of their bottoms has another reader, so
+// that the net outputs stay the same. Each removal is logged. Only the
+// forward pass of the result matches the original: Net::Init applies this
+// to TEST nets with NetParameter.remove_identities.
+void RemoveIdentityLayers(const NetParameter& param,
+    NetParameter* param_removed);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_REMOVE_IDENTITIES_HPP_
@@ -0,0 +1,56 @@
+#ifndef CAFFE_UTIL_SIMD_MATH_H_
+#define CAFFE_UTIL_SIMD_MATH_H_
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/**SimdIsa 向量指令集 运行时按CPU支持情况选择
+ * @brief The instruction sets the element-wise kernels below can run on.
+ *        The best one the CPU supports is picked at startup.
+ */
+enum SimdIsa {
+  SIMD_SCALAR = 0,
+  SIMD_AVX2 = 1,    ///< AVX2 + FMA, 8 floats / 4 doubles per instruction
+  SIMD_AVX512 = 2   ///< AVX-512F, 16 floats / 8 doubles per instruction
+};
+
+/// The best instruction set supported by this CPU and build.
+SimdIsa simd_best_isa();
+/// The instruction set the kernels currently dispatch to.
+SimdIsa simd_isa();
+/**set_simd_isa() 设置使用的指令集 不能超过CPU支持的范围 主要用于测试和性能对比*/
+// Forces the kernels onto a given instruction set, which must be supported;
+// meant for tests and benchmarks.
+void set_simd_isa(SimdIsa isa);
+
+// Runtime-dispatched element-wise kernels backing the vs*/vd* functions of
+// mkl_alternate.hpp when Caffe is built without MKL. The float exp and log
+// are vectorized polynomial approximations within a few ulp of the C
+// library; powx is computed as exp(b * log(a)) for positive finite a and
+// falls back to pow() otherwise. Double precision exp, log and powx stay
+// scalar.
+void simd_vAdd(const int n, const float* a, const float* b, float* y);
+void simd_vAdd(const int n, const double* a, const double* b, double* y);
+void simd_vSub(const int n, const float* a, const float* b, float* y);
+void simd_vSub(const int n, const double* a, const double* b, double* y);
+void simd_vMul(const int n, const float* a, const float* b, float* y);
+void simd_vMul(const int n, const double* a, const double* b, double* y);
+void simd_vDiv(const int n, const float* a, const float* b, float* y);
+void simd_vDiv(const int n, const double* a, const double* b, double* y);
+
+void simd_vSqr(const int n, const float* a, float* y);
+void simd_vSqr(const int n, const double* a, double* y);
+void simd_vAbs(const int n, const float* a, float* y);
+void simd_vAbs(const int n, const double* a, double* y);
+void simd_vExp(const int n, const float* a, float* y);
+void simd_vExp(const int n, const double* a, double* y);
+void simd_vLn(const int n, const float* a, float* y);
+void simd_vLn(const int n, const double* a, double* y);
+
+void simd_vPowx(const int n, const float* a, const float b, float* y);
+void simd_vPowx(const int n, const double* a, const double b, double* y);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_SIMD_MATH_H_
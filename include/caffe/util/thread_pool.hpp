@@ -0,0 +1,77 @@
+#ifndef CAFFE_UTIL_THREAD_POOL_HPP_
+#define CAFFE_UTIL_THREAD_POOL_HPP_
+
+#include <boost/function.hpp>
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/**ThreadPool 固定数量的工作线程 把一个循环的各次迭代分配到多个线程上执行
+ * @brief A fixed set of worker threads that share the iterations of one loop
+ *        at a time. The calling thread takes part in the work, so a pool of
+ *        num_threads threads starts num_threads - 1 workers.
+ *
+ * Each thread starts on its own contiguous share of the iterations and, once
+ * that runs out, steals the back half of the largest share left to another
+ * thread, so uneven iterations still keep every thread busy.
+ *
+ * The process-wide pool is Caffe::thread_pool(); most code should go through
+ * parallel_for() below rather than build pools of its own.
+ *
+ * boost/thread.hpp is kept out of this header, which is reached from CUDA
+ * sources (see internal_thread.hpp).
+ */
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  int num_threads() const { return num_threads_; }
+
+  /**Run() 对[0, num_tasks)中的每个i调用task(i) 全部完成后返回
+   * @brief Calls task(i) for every i in [0, num_tasks), spread over the pool,
+   *        and returns once all of them have finished.
+   *
+   * Tasks may run in any order. They run serially on the calling thread if
+   * the pool is busy with a loop started by another thread, or if the caller
+   * is itself a pool task. BLAS calls made by the tasks are limited to one
+   * thread each while the loop runs in parallel.
+   */
+  void Run(int num_tasks, const boost::function<void(int)>& task);
+
+  /// Whether the current thread is running tasks of some pool.
+  static bool in_parallel_region();
+
+ private:
+  class Workers;
+
+  const int num_threads_;
+  shared_ptr<Workers> workers_;
+
+  DISABLE_COPY_AND_ASSIGN(ThreadPool);
+};
+
+/**parallel_for() 把[begin, end)切成若干段 在Caffe的线程池上对每段调用body(段首, 段尾)
+ * @brief Calls body(b, e) on consecutive subranges [b, e) that together cover
+ *        [begin, end), in parallel on Caffe::thread_pool().
+ *
+ * Every subrange but the last holds at least grain iterations, so loops of
+ * fewer than 2 * grain iterations run serially on the calling thread. There
+ * are a few subranges per thread to leave room for work stealing.
+ */
+void parallel_for(int begin, int end, int grain,
+    const boost::function<void(int, int)>& body);
+
+/**set_blas_num_threads() 设置BLAS库的线程数 支持MKL和OpenBLAS 其他BLAS忽略*/
+// Sets the number of threads MKL or OpenBLAS use for a single call; other
+// BLAS libraries are left alone. Caffe::set_num_threads() calls this.
+void set_blas_num_threads(int num_threads);
+/**blas_num_threads() 返回BLAS库当前的线程数 未知时返回0*/
+// The number of threads MKL or OpenBLAS currently use for a single call, or
+// 0 for other BLAS libraries.
+int blas_num_threads();
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_THREAD_POOL_HPP_
@@ -0,0 +1,45 @@
+#ifndef CAFFE_UTIL_WINOGRAD_HPP_
+#define CAFFE_UTIL_WINOGRAD_HPP_
+
+namespace caffe {
+
+// Winograd convolution F(m x m, 3 x 3) for 3x3, stride 1, undilated filters
+// (Lavin & Gray, "Fast Algorithms for Convolutional Neural Networks"). Each
+// (m + 2) x (m + 2) input tile yields an m x m output tile; tile is m and
+// must be 2 or 4. F(2x2, 3x3) takes 16 multiplications per output tile
+// instead of 36, F(4x4, 3x3) 36 instead of 144.
+
+/// The number of elements of the workspace winograd_conv_cpu needs.
+int winograd_workspace_size(const int tile, const int channels,
+    const int num_output, const int output_h, const int output_w);
+
+/**
+ * @brief Transforms num_output x channels 3x3 filters into (tile + 2)^2
+ *        matrices, one per position in a tile.
+ *
+ * Without flip the matrices are num_output x channels and convolve a
+ * channels-deep input into num_output outputs. With flip, filter (k, c) is
+ * rotated by 180 degrees and stored at (c, k), so the matrices convolve a
+ * num_output-deep gradient back into channels inputs (the backward pass
+ * w.r.t. the bottom, with padding 2 - pad).
+ */
+template <typename Dtype>
+void winograd_transform_filter_cpu(const int tile, const Dtype* weights,
+    const int num_output, const int channels, const bool flip,
+    Dtype* transformed);
+
+/**
+ * @brief Convolves a channels x height x width input with filters transformed
+ *        by winograd_transform_filter_cpu into a num_output x output_h x
+ *        output_w output, output_h = height + 2 * pad_h - 2 and likewise for
+ *        the width. The output is overwritten.
+ */
+template <typename Dtype>
+void winograd_conv_cpu(const int tile, const Dtype* data_im,
+    const int channels, const int height, const int width,
+    const int pad_h, const int pad_w, const Dtype* transformed,
+    const int num_output, Dtype* data_out, Dtype* workspace);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_WINOGRAD_HPP_
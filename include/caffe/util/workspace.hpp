@@ -0,0 +1,44 @@
+#ifndef CAFFE_UTIL_WORKSPACE_HPP_
+#define CAFFE_UTIL_WORKSPACE_HPP_
+
+#include "caffe/common.hpp"
+#include "caffe/syncedmem.hpp"
+
+namespace caffe {
+
+/**Workspace 同一网络各层共享的临时内存 随请求增长 大小为各层需求的最大值
+ * @brief Scratch memory shared by the layers of a Net, which run one at a
+ *        time. It grows to the largest request made of it, so a net holds one
+ *        buffer of the size of its largest im2col buffer rather than one per
+ *        layer.
+ *
+ * The contents are only valid until another layer asks for the memory; a
+ * layer must not expect them to survive from one of its calls to the next.
+ */
+class Workspace {
+ public:
+  Workspace() : size_(0) {}
+
+  /// @brief Returns at least size bytes of CPU memory, contents undefined.
+  void* mutable_cpu_data(size_t size);
+#ifndef CPU_ONLY
+  /// @brief Returns at least size bytes of GPU memory, contents undefined.
+  void* mutable_gpu_data(size_t size);
+#endif
+
+  /// @brief The bytes held, i.e. the largest request so far.
+  size_t size() const { return size_; }
+
+ private:
+  /// Grows the memory to size bytes; the old contents are dropped.
+  void Reserve(size_t size);
+
+  size_t size_;
+  shared_ptr<SyncedMemory> memory_;
+
+  DISABLE_COPY_AND_ASSIGN(Workspace);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_WORKSPACE_HPP_
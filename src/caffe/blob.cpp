@@ -5,6 +5,7 @@
 #include "caffe/common.hpp"
 #include "caffe/syncedmem.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/reduced_precision.hpp"
 
 namespace caffe {
 
@@ -61,14 +62,14 @@ template <typename Dtype>
 Blob<Dtype>::Blob(const int num, const int channels, const int height,
     const int width)
   // capacity_ must be initialized before calling Reshape
-  : capacity_(0) {
+  : capacity_(0), channel_block_(0) {
   Reshape(num, channels, height, width);
 }
 /** Blob(const vector<int>& shape) 按形状向量构造*/
 template <typename Dtype>
 Blob<Dtype>::Blob(const vector<int>& shape)
   // capacity_ must be initialized before calling Reshape
-  : capacity_(0) {
+  : capacity_(0), channel_block_(0) {
   Reshape(shape);
 }
 //函数组结束
@@ -142,6 +143,20 @@ Dtype* Blob<Dtype>::mutable_gpu_diff() {
   return static_cast<Dtype*>(diff_->mutable_gpu_data());
 }
 
+/** mutable_cpu_data_uninitialized() 返回cpu端的data域 读写 首次分配不清零*/
+template <typename Dtype>
+Dtype* Blob<Dtype>::mutable_cpu_data_uninitialized() {
+  CHECK(data_);
+  return static_cast<Dtype*>(data_->mutable_cpu_data_uninitialized());
+}
+
+/** mutable_cpu_diff_uninitialized() 返回cpu端的diff域 读写 首次分配不清零*/
+template <typename Dtype>
+Dtype* Blob<Dtype>::mutable_cpu_diff_uninitialized() {
+  CHECK(diff_);
+  return static_cast<Dtype*>(diff_->mutable_cpu_data_uninitialized());
+}
+
 /** ShareData() 共享Data域*/
 template <typename Dtype>
 void Blob<Dtype>::ShareData(const Blob& other) {
@@ -168,6 +183,7 @@ void Blob<Dtype>::Update() {
   // We will perform update based on where the data is located.
   switch (data_->head()) {
   case SyncedMemory::HEAD_AT_CPU:
+  case SyncedMemory::HEAD_AT_REDUCED:
     // perform computation on CPU
     caffe_axpy<Dtype>(count_, Dtype(-1),
         static_cast<const Dtype*>(diff_->cpu_data()),
@@ -188,6 +204,23 @@ void Blob<Dtype>::Update() {
     LOG(FATAL) << "Syncedmem not initialized."; //未初始化的head属性将引发错误
   }
 }
+// 16位存储只对float和double实现
+template <> void Blob<unsigned int>::set_data_storage(
+    StoragePrecision precision) {
+  NOT_IMPLEMENTED;
+}
+
+template <> void Blob<int>::set_data_storage(StoragePrecision precision) {
+  NOT_IMPLEMENTED;
+}
+
+/**set_data_storage() data域转为16位精度保存 FP32则恢复全精度*/
+template <typename Dtype>
+void Blob<Dtype>::set_data_storage(StoragePrecision precision) {
+  CHECK(data_);
+  data_->set_storage<Dtype>(precision);
+}
+
 // Blob<unsigned int> 和 Blob<int> 的 data域L1正则函数没有实现
 template <> unsigned int Blob<unsigned int>::asum_data() const {
   NOT_IMPLEMENTED;
@@ -204,6 +237,7 @@ Dtype Blob<Dtype>::asum_data() const {
   if (!data_) { return 0; }
   switch (data_->head()) {
   case SyncedMemory::HEAD_AT_CPU:
+  case SyncedMemory::HEAD_AT_REDUCED:
     return caffe_cpu_asum(count_, cpu_data());
   case SyncedMemory::HEAD_AT_GPU:
   case SyncedMemory::SYNCED:
@@ -280,6 +314,7 @@ Dtype Blob<Dtype>::sumsq_data() const {
   if (!data_) { return 0; }
   switch (data_->head()) {
   case SyncedMemory::HEAD_AT_CPU:
+  case SyncedMemory::HEAD_AT_REDUCED:
     data = cpu_data();
     sumsq = caffe_cpu_dot(count_, data, data);
     break;
@@ -355,6 +390,7 @@ void Blob<Dtype>::scale_data(Dtype scale_factor) {
   if (!data_) { return; }
   switch (data_->head()) {
   case SyncedMemory::HEAD_AT_CPU:
+  case SyncedMemory::HEAD_AT_REDUCED:
     data = mutable_cpu_data();
     caffe_scal(count_, scale_factor, data);
     return;
@@ -431,6 +467,17 @@ bool Blob<Dtype>::ShapeEquals(const BlobProto& other) {
   }
   return shape_ == other_shape;
 }
+/**set_channel_block(int channel_block); 设置数据的通道分块大小 0为NCHW */
+template <typename Dtype>
+void Blob<Dtype>::set_channel_block(int channel_block) {
+  CHECK_GE(channel_block, 0);
+  if (channel_block > 0) {
+    CHECK_EQ(4, num_axes()) << "Only 4-axis blobs have a blocked layout.";
+    CHECK_EQ(0, shape(1) % channel_block)
+        << "The channels must split into whole blocks of " << channel_block;
+  }
+  channel_block_ = channel_block;
+}
 
 /**CopyFrom(const Blob& source,bool copy_diff,bool reshape); 拷贝source的数据,copy_diff决定是否拷贝diff域，reshape决定是否整形 若source与此Blob不同型,且reshape=false,则会引发错误*/
 template <typename Dtype>
@@ -491,7 +538,25 @@ void Blob<Dtype>::FromProto(const BlobProto& proto, bool reshape) {
   }
   // copy data 拷贝数据
   Dtype* data_vec = mutable_cpu_data();
-  if (proto.double_data_size() > 0) {
+  if (proto.storage() != FP32) {
+    // 16-bit values: widen them and keep the data at that precision.
+    CHECK_EQ(2 * count_, proto.reduced_data().size());
+    vector<uint16_t> reduced(count_);
+    for (int i = 0; i < count_; ++i) {
+      const unsigned char* bytes = reinterpret_cast<const unsigned char*>(
+          proto.reduced_data().data()) + 2 * i;
+      reduced[i] = static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+    }
+    vector<float> values(count_);
+    if (count_ > 0) {
+      caffe_cpu_expand_precision(count_, &reduced[0], proto.storage(),
+          &values[0]);
+    }
+    for (int i = 0; i < count_; ++i) {
+      data_vec[i] = values[i];
+    }
+    set_data_storage(proto.storage());
+  } else if (proto.double_data_size() > 0) {
     CHECK_EQ(count_, proto.double_data_size());
     for (int i = 0; i < count_; ++i) {
       data_vec[i] = proto.double_data(i);
@@ -517,6 +582,18 @@ void Blob<Dtype>::FromProto(const BlobProto& proto, bool reshape) {
   }
 }
 
+// 16位数据按小端顺序写入reduced_data
+static void WriteReducedData(const int count, const StoragePrecision storage,
+    const uint16_t* reduced, BlobProto* proto) {
+  proto->set_storage(storage);
+  string* bytes = proto->mutable_reduced_data();
+  bytes->resize(2 * count);
+  for (int i = 0; i < count; ++i) {
+    (*bytes)[2 * i] = static_cast<char>(reduced[i] & 0xFF);
+    (*bytes)[2 * i + 1] = static_cast<char>(reduced[i] >> 8);
+  }
+}
+
 /**ToProto(BlobProto* proto,bool write_diff);序列化函数,将此blob中的数据写入proto中,write_diff决定是否写入diff域 写入的是CPU端的数据 注意数据同步 */
 template <>
 void Blob<double>::ToProto(BlobProto* proto, bool write_diff) const {
@@ -526,9 +603,15 @@ void Blob<double>::ToProto(BlobProto* proto, bool write_diff) const {
   }
   proto->clear_double_data();
   proto->clear_double_diff();
-  const double* data_vec = cpu_data();
-  for (int i = 0; i < count_; ++i) {
-    proto->add_double_data(data_vec[i]);
+  proto->clear_storage();
+  proto->clear_reduced_data();
+  if (data_storage() != FP32) {
+    WriteReducedData(count_, data_storage(), reduced_cpu_data(), proto);
+  } else {
+    const double* data_vec = cpu_data();
+    for (int i = 0; i < count_; ++i) {
+      proto->add_double_data(data_vec[i]);
+    }
   }
   if (write_diff) {
     const double* diff_vec = cpu_diff();
@@ -546,9 +629,15 @@ void Blob<float>::ToProto(BlobProto* proto, bool write_diff) const {
   }
   proto->clear_data();
   proto->clear_diff();
-  const float* data_vec = cpu_data();
-  for (int i = 0; i < count_; ++i) {
-    proto->add_data(data_vec[i]);
+  proto->clear_storage();
+  proto->clear_reduced_data();
+  if (data_storage() != FP32) {
+    WriteReducedData(count_, data_storage(), reduced_cpu_data(), proto);
+  } else {
+    const float* data_vec = cpu_data();
+    for (int i = 0; i < count_; ++i) {
+      proto->add_data(data_vec[i]);
+    }
   }
   if (write_diff) {
     const float* diff_vec = cpu_diff();
@@ -1,11 +1,15 @@
+#include <boost/atomic.hpp>
 #include <boost/thread.hpp>
 #include <glog/logging.h>
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
 #include <ctime>
 
 #include "caffe/common.hpp"
 #include "caffe/util/rng.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
@@ -52,6 +56,87 @@ void GlobalInit(int* pargc, char*** pargv) {
   ::google::InstallFailureSignalHandler();
 }
 
+// The process-wide thread pool. Unlike the rest of the Caffe state it is not
+// per thread, so it lives here under its own mutex. It is leaked on purpose
+// so that no worker outlives the thread-local state it uses during static
+// destruction. Each thread keeps the pool it last saw, with the generation
+// it had; thread_pool() only takes the mutex once the pool is replaced.
+static boost::mutex thread_pool_mutex_;
+static shared_ptr<ThreadPool>* thread_pool_ = NULL;
+static boost::atomic<unsigned int> thread_pool_generation_(0);
+
+struct ThreadPoolRef {
+  shared_ptr<ThreadPool> pool;
+  unsigned int generation;
+};
+
+static boost::thread_specific_ptr<ThreadPoolRef>& thread_pool_ref() {
+  static boost::thread_specific_ptr<ThreadPoolRef>* ref =
+      new boost::thread_specific_ptr<ThreadPoolRef>();
+  return *ref;
+}
+
+// The size of the pool made on first use: the thread count asked of the
+// BLAS library through the environment, or else the one it runs with, so
+// that both use the same threads; all cores if neither is known.
+static int DefaultNumThreads() {
+  const char* vars[] = {
+    "OMP_NUM_THREADS", "OPENBLAS_NUM_THREADS", "MKL_NUM_THREADS"
+  };
+  for (int i = 0; i < sizeof(vars) / sizeof(vars[0]); ++i) {
+    const char* value = getenv(vars[i]);
+    if (value && atoi(value) > 0) {
+      return atoi(value);
+    }
+  }
+  if (blas_num_threads() > 0) {
+    return blas_num_threads();
+  }
+  return std::max(1U, boost::thread::hardware_concurrency());
+}
+
+/**thread_pool() 返回共享线程池 第一次调用时按环境变量或BLAS的线程数创建 之后不加锁*/
+shared_ptr<ThreadPool> Caffe::thread_pool() {
+  const unsigned int generation =
+      thread_pool_generation_.load(boost::memory_order_acquire);
+  ThreadPoolRef* ref = thread_pool_ref().get();
+  if (ref && ref->generation == generation) {
+    return ref->pool;
+  }
+  boost::lock_guard<boost::mutex> lock(thread_pool_mutex_);
+  if (!thread_pool_) {
+    thread_pool_ =
+        new shared_ptr<ThreadPool>(new ThreadPool(DefaultNumThreads()));
+    thread_pool_generation_.fetch_add(1, boost::memory_order_release);
+  }
+  if (!ref) {
+    ref = new ThreadPoolRef();
+    thread_pool_ref().reset(ref);
+  }
+  ref->pool = *thread_pool_;
+  ref->generation = thread_pool_generation_.load(boost::memory_order_relaxed);
+  return ref->pool;
+}
+
+/**set_num_threads() 用新的线程数重建线程池 并同步设置BLAS的线程数*/
+void Caffe::set_num_threads(const int num_threads) {
+  CHECK_GE(num_threads, 1);
+  boost::lock_guard<boost::mutex> lock(thread_pool_mutex_);
+  set_blas_num_threads(num_threads);
+  if (!thread_pool_) {
+    thread_pool_ = new shared_ptr<ThreadPool>();
+  } else if ((*thread_pool_)->num_threads() == num_threads) {
+    return;
+  }
+  // Loops still running keep their own reference to the old pool.
+  thread_pool_->reset(new ThreadPool(num_threads));
+  thread_pool_generation_.fetch_add(1, boost::memory_order_release);
+}
+
+int Caffe::num_threads() {
+  return thread_pool()->num_threads();
+}
+
 #ifdef CPU_ONLY  // CPU-only Caffe. CPU模式的Caffe
 
 Caffe::Caffe()
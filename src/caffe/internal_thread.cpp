@@ -32,10 +32,11 @@ void InternalThread::StartInternalThread() {
   int rand_seed = caffe_rng_rand();        //获得随机数种子(rand_seed)
   int solver_count = Caffe::solver_count();//获得当前solver_count
   bool root_solver = Caffe::root_solver(); //获得当前root_solver
+  HostMemoryPolicy host_memory_policy = Caffe::host_memory_policy(); //获得当前主机内存放置策略
 //调用boost库启动线程
   try {
     thread_.reset(new boost::thread(&InternalThread::entry, this, device, mode,
-          rand_seed, solver_count, root_solver));
+          rand_seed, solver_count, root_solver, host_memory_policy));
           // 注意 this 指针在类方法调用时是C++ 自动加入 在这里要手动加入
   } catch (std::exception& e) {
     LOG(FATAL) << "Thread exception: " << e.what();
@@ -46,7 +47,7 @@ void InternalThread::StartInternalThread() {
  *  用于启动线程后的本地状态初始化 用传入的参数初始化线程的本地状态
  */
 void InternalThread::entry(int device, Caffe::Brew mode, int rand_seed,
-    int solver_count, bool root_solver) {
+    int solver_count, bool root_solver, HostMemoryPolicy host_memory_policy) {
 #ifndef CPU_ONLY
   CUDA_CHECK(cudaSetDevice(device));
 #endif
@@ -55,6 +56,7 @@ void InternalThread::entry(int device, Caffe::Brew mode, int rand_seed,
   Caffe::set_random_seed(rand_seed);
   Caffe::set_solver_count(solver_count);
   Caffe::set_root_solver(root_solver);
+  Caffe::set_host_memory_policy(host_memory_policy);
   //运行子类中实现的程序
   InternalThreadEntry();
 }
@@ -25,6 +25,73 @@ void Layer<Dtype>::Unlock() {
   }
 }
 
+/**FuseActivation 在允许融合时记录激活层 */
+template <typename Dtype>
+bool Layer<Dtype>::FuseActivation(Layer<Dtype>* activation, bool keep_input) {
+  if (!AllowActivationFusion() || !activation->AllowElementwiseFusion() ||
+      layer_param_.top_size() > 1) {
+    return false;
+  }
+  fused_activations_.push_back(activation);
+  fused_activation_keep_input_.push_back(keep_input);
+  return true;
+}
+
+/**forward_cpu_activations_begin 一次前向计算开始时准备融合的激活层 */
+template <typename Dtype>
+void Layer<Dtype>::forward_cpu_activations_begin(const Blob<Dtype>& top) {
+  if (!runs_fused_activations()) { return; }
+  for (int i = 0; i < fused_activations_.size(); ++i) {
+    fused_activations_[i]->Forward_cpu_fused_begin(top,
+        fused_activation_keep_input_[i]);
+  }
+}
+
+/**forward_cpu_activations 对输出的[begin, end)区间依次执行融合的激活层 */
+template <typename Dtype>
+void Layer<Dtype>::forward_cpu_activations(Dtype* top_data, int begin,
+    int end) {
+  if (!runs_fused_activations()) { return; }
+  for (int i = 0; i < fused_activations_.size(); ++i) {
+    fused_activations_[i]->Forward_cpu_fused(top_data + begin, begin, end);
+  }
+}
+
+/**DetachStaleView 视图不在base中的offset处时 为其复制一份独立内存 */
+template <typename Dtype>
+void Layer<Dtype>::DetachStaleView(Blob<Dtype>* view,
+    const Blob<Dtype>& base, int offset) {
+  SyncedMemory* view_memory[2] = { view->data().get(), view->diff().get() };
+  SyncedMemory* base_memory[2] = { base.data().get(), base.diff().get() };
+  for (int i = 0; i < 2; ++i) {
+    SyncedMemory* memory = view_memory[i];
+    SyncedMemory* base_mem = base_memory[i];
+    // Only memory already on the CPU can be a view; reading the pointers of
+    // other memory would allocate or sync it.
+    if (!memory || !base_mem || memory == base_mem ||
+        (memory->head() != SyncedMemory::HEAD_AT_CPU &&
+         memory->head() != SyncedMemory::SYNCED) ||
+        (base_mem->head() != SyncedMemory::HEAD_AT_CPU &&
+         base_mem->head() != SyncedMemory::SYNCED)) {
+      continue;
+    }
+    const Dtype* data = static_cast<const Dtype*>(memory->cpu_data());
+    const Dtype* base_data = static_cast<const Dtype*>(base_mem->cpu_data());
+    const Dtype* base_end = base_data + base_mem->size() / sizeof(Dtype);
+    if (data < base_data || data >= base_end ||
+        (offset >= 0 && data == base_data + offset)) {
+      continue;
+    }
+    shared_ptr<SyncedMemory>& detached = detached_views_[memory];
+    detached.reset(new SyncedMemory(memory->size()));
+    Dtype* detached_data =
+        static_cast<Dtype*>(detached->mutable_cpu_data_uninitialized());
+    caffe_copy(std::min(view->count(), static_cast<int>(base_end - data)),
+        data, detached_data);
+    memory->set_cpu_data(detached_data);
+  }
+}
+
 INSTANTIATE_CLASS(Layer); //宏操作 将模板类Layer在float和double上实例化 也就是说 只有float和double的Layer
 
 }  // namespace caffe
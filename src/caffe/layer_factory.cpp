@@ -7,13 +7,23 @@
 
 #include "caffe/layer.hpp"
 #include "caffe/layer_factory.hpp"
+#include "caffe/layers/auto_conv_layer.hpp"
+#include "caffe/layers/blocked_conv_layer.hpp"
 #include "caffe/layers/conv_layer.hpp"
+#include "caffe/layers/direct_conv_layer.hpp"
+#include "caffe/layers/fft_conv_layer.hpp"
+#include "caffe/layers/implicit_gemm_conv_layer.hpp"
+#include "caffe/layers/inner_product_layer.hpp"
 #include "caffe/layers/lrn_layer.hpp"
 #include "caffe/layers/pooling_layer.hpp"
+#include "caffe/layers/quantized_conv_layer.hpp"
+#include "caffe/layers/quantized_inner_product_layer.hpp"
 #include "caffe/layers/relu_layer.hpp"
 #include "caffe/layers/sigmoid_layer.hpp"
 #include "caffe/layers/softmax_layer.hpp"
+#include "caffe/layers/sparse_inner_product_layer.hpp"
 #include "caffe/layers/tanh_layer.hpp"
+#include "caffe/layers/winograd_conv_layer.hpp"
 #include "caffe/proto/caffe.pb.h"
 
 #ifdef USE_CUDNN
@@ -49,14 +59,43 @@ shared_ptr<Layer<Dtype> > GetConvolutionLayer(
 #endif
   if (engine == ConvolutionParameter_Engine_DEFAULT) {
     engine = ConvolutionParameter_Engine_CAFFE;
+    // Depthwise convolutions are one tiny GEMM per channel with im2col. The
+    // channels are only known at Reshape, where DirectConvolutionLayer
+    // keeps the im2col path of other grouped convolutions.
+    if (conv_param.group() > 1) {
+      engine = ConvolutionParameter_Engine_DIRECT;
+    }
 #ifdef USE_CUDNN
     if (!use_dilation) {
       engine = ConvolutionParameter_Engine_CUDNN;
     }
 #endif
   }
+  // Calibrated layers run in int8 whatever the engine.
+  if (param.quantization_param().precision() ==
+      QuantizationParameter_Precision_INT8) {
+    return shared_ptr<Layer<Dtype> >(
+        new QuantizedConvolutionLayer<Dtype>(param));
+  }
+  // The Net asks for a blocked top only within the chains it lays out.
+  if (conv_param.channel_block() > 0) {
+    return shared_ptr<Layer<Dtype> >(
+        new BlockedConvolutionLayer<Dtype>(param));
+  }
   if (engine == ConvolutionParameter_Engine_CAFFE) {
     return shared_ptr<Layer<Dtype> >(new ConvolutionLayer<Dtype>(param));
+  } else if (engine == ConvolutionParameter_Engine_WINOGRAD) {
+    return shared_ptr<Layer<Dtype> >(
+        new WinogradConvolutionLayer<Dtype>(param));
+  } else if (engine == ConvolutionParameter_Engine_IMPLICIT_GEMM) {
+    return shared_ptr<Layer<Dtype> >(
+        new ImplicitGemmConvolutionLayer<Dtype>(param));
+  } else if (engine == ConvolutionParameter_Engine_DIRECT) {
+    return shared_ptr<Layer<Dtype> >(new DirectConvolutionLayer<Dtype>(param));
+  } else if (engine == ConvolutionParameter_Engine_FFT) {
+    return shared_ptr<Layer<Dtype> >(new FFTConvolutionLayer<Dtype>(param));
+  } else if (engine == ConvolutionParameter_Engine_AUTO) {
+    return shared_ptr<Layer<Dtype> >(new AutoConvolutionLayer<Dtype>(param));
 #ifdef USE_CUDNN
   } else if (engine == ConvolutionParameter_Engine_CUDNN) {
     if (use_dilation) {
@@ -72,6 +111,23 @@ shared_ptr<Layer<Dtype> > GetConvolutionLayer(
 
 REGISTER_LAYER_CREATOR(Convolution, GetConvolutionLayer);
 
+// Get inner product layer according to precision.
+template <typename Dtype>
+shared_ptr<Layer<Dtype> > GetInnerProductLayer(const LayerParameter& param) {
+  if (param.quantization_param().precision() ==
+      QuantizationParameter_Precision_INT8) {
+    return shared_ptr<Layer<Dtype> >(
+        new QuantizedInnerProductLayer<Dtype>(param));
+  }
+  if (param.inner_product_param().sparse_threshold() > 0) {
+    return shared_ptr<Layer<Dtype> >(
+        new SparseInnerProductLayer<Dtype>(param));
+  }
+  return shared_ptr<Layer<Dtype> >(new InnerProductLayer<Dtype>(param));
+}
+
+REGISTER_LAYER_CREATOR(InnerProduct, GetInnerProductLayer);
+
 // Get pooling layer according to engine.
 template <typename Dtype>
 shared_ptr<Layer<Dtype> > GetPoolingLayer(const LayerParameter& param) {
@@ -34,6 +34,19 @@ void AbsValLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   }
 }
 
+template <typename Dtype>
+void AbsValLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  caffe_abs(end - begin, data, data);
+}
+
+template <typename Dtype>
+void AbsValLayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  for (int i = 0; i < end - begin; ++i) {
+    diff[i] *= (Dtype(0) < bottom_data[i]) - (bottom_data[i] < Dtype(0));
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(AbsValLayer);
 #endif
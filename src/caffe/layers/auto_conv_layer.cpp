@@ -0,0 +1,229 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "caffe/layers/auto_conv_layer.hpp"
+#include "caffe/layers/direct_conv_layer.hpp"
+#include "caffe/layers/fft_conv_layer.hpp"
+#include "caffe/layers/implicit_gemm_conv_layer.hpp"
+#include "caffe/layers/winograd_conv_layer.hpp"
+#include "caffe/util/benchmark.hpp"
+#include "caffe/util/conv_autotune.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+// Forward passes timed per candidate, after one untimed warm-up pass.
+static const int kTuneIterations = 3;
+
+template <typename Dtype>
+string AutoConvolutionLayer<Dtype>::shape_key(const Blob<Dtype>& bottom) {
+  std::ostringstream key;
+  key << cpu_model_name() << " | "
+      << (sizeof(Dtype) == sizeof(float) ? "float" : "double")
+      << " threads=" << Caffe::thread_pool()->num_threads()
+      << " bottom=" << bottom.shape_string()
+      << " axis=" << this->channel_axis_
+      << " out=" << this->num_output_ << " group=" << this->group_;
+  const Blob<int>* params[] = { &this->kernel_shape_, &this->stride_,
+      &this->pad_, &this->dilation_ };
+  const char* names[] = { " kernel=", " stride=", " pad=", " dilation=" };
+  for (int p = 0; p < 4; ++p) {
+    key << names[p];
+    for (int i = 0; i < this->num_spatial_axes_; ++i) {
+      key << (i ? "x" : "") << params[p]->cpu_data()[i];
+    }
+  }
+  return key.str();
+}
+
+template <typename Dtype>
+vector<ConvolutionParameter_Engine>
+AutoConvolutionLayer<Dtype>::candidates() {
+  vector<ConvolutionParameter_Engine> engines;
+  engines.push_back(ConvolutionParameter_Engine_CAFFE);
+  if (this->num_spatial_axes_ != 2) {
+    return engines;
+  }
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  const bool unit_stride = stride[0] == 1 && stride[1] == 1;
+  // The same conditions the engines check before leaving the im2col path.
+  if (this->group_ > 1 && this->channels_ / this->group_ <=
+      DirectConvolutionLayer<Dtype>::kMaxGroupChannels) {
+    engines.push_back(ConvolutionParameter_Engine_DIRECT);
+  }
+  if (kernel[0] == 3 && kernel[1] == 3 && unit_stride &&
+      dilation[0] == 1 && dilation[1] == 1) {
+    engines.push_back(ConvolutionParameter_Engine_WINOGRAD);
+  }
+  if (!this->force_nd_im2col_ && !this->is_1x1_) {
+    engines.push_back(ConvolutionParameter_Engine_IMPLICIT_GEMM);
+  }
+  if (unit_stride) {
+    engines.push_back(ConvolutionParameter_Engine_FFT);
+  }
+  return engines;
+}
+
+template <typename Dtype>
+shared_ptr<ConvolutionLayer<Dtype> > AutoConvolutionLayer<Dtype>::CreateEngine(
+    ConvolutionParameter_Engine engine, const vector<Blob<Dtype>*>& bottom,
+    const vector<Blob<Dtype>*>& top) {
+  LayerParameter param(this->layer_param_);
+  param.mutable_convolution_param()->set_engine(engine);
+  shared_ptr<ConvolutionLayer<Dtype> > layer;
+  switch (engine) {
+  case ConvolutionParameter_Engine_DIRECT:
+    layer.reset(new DirectConvolutionLayer<Dtype>(param));
+    break;
+  case ConvolutionParameter_Engine_WINOGRAD:
+    layer.reset(new WinogradConvolutionLayer<Dtype>(param));
+    break;
+  case ConvolutionParameter_Engine_IMPLICIT_GEMM:
+    layer.reset(new ImplicitGemmConvolutionLayer<Dtype>(param));
+    break;
+  case ConvolutionParameter_Engine_FFT:
+    layer.reset(new FFTConvolutionLayer<Dtype>(param));
+    break;
+  default:
+    layer.reset(new ConvolutionLayer<Dtype>(param));
+  }
+  // With the blobs already there, set up leaves the weights alone.
+  layer->blobs() = this->blobs_;
+  layer->LayerSetUp(bottom, top);
+  if (this->shared_workspace_) {
+    layer->set_shared_workspace(this->shared_workspace_);
+  }
+  for (int i = 0; i < this->fused_activations_.size(); ++i) {
+    layer->FuseActivation(this->fused_activations_[i],
+        this->fused_activation_keep_input_[i]);
+  }
+  layer->SuspendActivationFusion(this->activation_fusion_suspended_);
+  layer->Reshape(bottom, top);
+  return layer;
+}
+
+template <typename Dtype>
+ConvolutionParameter_Engine AutoConvolutionLayer<Dtype>::Tune(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  const vector<ConvolutionParameter_Engine> engines = candidates();
+  ConvolutionParameter_Engine best = engines[0];
+  float best_time = 0;
+  CPUTimer timer;
+  for (int i = 0; i < engines.size(); ++i) {
+    shared_ptr<ConvolutionLayer<Dtype> > layer =
+        CreateEngine(engines[i], bottom, top);
+    layer->Forward(bottom, top);
+    timer.Start();
+    for (int iter = 0; iter < kTuneIterations; ++iter) {
+      layer->Forward(bottom, top);
+    }
+    timer.Stop();
+    const float time = timer.MicroSeconds();
+    if (i == 0 || time < best_time) {
+      best = engines[i];
+      best_time = time;
+      engine_ = layer;
+    }
+  }
+  return best;
+}
+
+template <typename Dtype>
+void AutoConvolutionLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
+    const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  if (Caffe::mode() != Caffe::CPU) {
+    return;
+  }
+  const string key = shape_key(*bottom[0]);
+  // engine_ reshapes itself on every pass, so only a new shape needs work.
+  if (engine_ && key == engine_key_) {
+    return;
+  }
+  const ConvolutionParameter& conv_param =
+      this->layer_param_.convolution_param();
+  const string& file = conv_param.autotune_cache();
+  ConvAlgorithmCache& cache = ConvAlgorithmCache::Get();
+  ConvolutionParameter_Engine engine = ConvolutionParameter_Engine_CAFFE;
+  string name;
+  if (cache.Lookup(file, key, &name) &&
+      ConvolutionParameter_Engine_Parse(name, &engine) &&
+      engine != ConvolutionParameter_Engine_DEFAULT &&
+      engine != ConvolutionParameter_Engine_CUDNN &&
+      engine != ConvolutionParameter_Engine_AUTO) {
+    engine_ = CreateEngine(engine, bottom, top);
+  } else if (conv_param.autotune() == ConvolutionParameter_AutotuneMode_TUNE) {
+    engine = Tune(bottom, top);
+    LOG(INFO) << "Layer " << this->layer_param_.name() << " picked engine "
+        << ConvolutionParameter_Engine_Name(engine) << " for "
+        << bottom[0]->shape_string();
+    cache.Store(file, key, ConvolutionParameter_Engine_Name(engine));
+  } else {
+    engine = this->group_ > 1 && this->group_ == this->channels_ ?
+        ConvolutionParameter_Engine_DIRECT : ConvolutionParameter_Engine_CAFFE;
+    engine_ = CreateEngine(engine, bottom, top);
+  }
+  engine_type_ = engine;
+  engine_key_ = key;
+}
+
+template <typename Dtype>
+void AutoConvolutionLayer<Dtype>::set_shared_workspace(
+    const shared_ptr<Workspace>& workspace) {
+  ConvolutionLayer<Dtype>::set_shared_workspace(workspace);
+  if (engine_) {
+    engine_->set_shared_workspace(workspace);
+  }
+}
+
+template <typename Dtype>
+bool AutoConvolutionLayer<Dtype>::FuseActivation(Layer<Dtype>* activation,
+    bool keep_input) {
+  if (!ConvolutionLayer<Dtype>::FuseActivation(activation, keep_input)) {
+    return false;
+  }
+  // Every engine fuses what the base layer does.
+  if (engine_) {
+    engine_->FuseActivation(activation, keep_input);
+  }
+  return true;
+}
+
+template <typename Dtype>
+void AutoConvolutionLayer<Dtype>::SuspendActivationFusion(bool suspend) {
+  ConvolutionLayer<Dtype>::SuspendActivationFusion(suspend);
+  if (engine_) {
+    engine_->SuspendActivationFusion(suspend);
+  }
+}
+
+template <typename Dtype>
+void AutoConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (!engine_) {
+    ConvolutionLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  engine_->Forward(bottom, top);
+}
+
+template <typename Dtype>
+void AutoConvolutionLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  if (!engine_) {
+    ConvolutionLayer<Dtype>::Backward_cpu(top, propagate_down, bottom);
+    return;
+  }
+  for (int i = 0; i < this->blobs_.size(); ++i) {
+    engine_->set_param_propagate_down(i, this->param_propagate_down_[i]);
+  }
+  engine_->Backward(top, propagate_down, bottom);
+}
+
+INSTANTIATE_CLASS(AutoConvolutionLayer);
+
+}  // namespace caffe
@@ -1,10 +1,12 @@
 #include <algorithm>
+#include <climits>
 #include <vector>
 
 #include "caffe/filler.hpp"
 #include "caffe/layers/base_conv_layer.hpp"
 #include "caffe/util/im2col.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/reduced_precision.hpp"
 
 namespace caffe {
 
@@ -256,18 +258,67 @@ void BaseConvolutionLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
 template <typename Dtype>
 void BaseConvolutionLayer<Dtype>::forward_cpu_gemm(const Dtype* input,
     const Dtype* weights, Dtype* output, bool skip_im2col) {
+  forward_cpu_gemm(input, weights, output,
+      is_1x1_ ? NULL : col_buffer_cpu(), skip_im2col);
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::forward_cpu_gemm(const Dtype* input,
+    const Dtype* weights, Dtype* output, Dtype* col_data, bool skip_im2col,
+    Dtype* weight_panel) {
   const Dtype* col_buff = input;
   if (!is_1x1_) {
     if (!skip_im2col) {
-      conv_im2col_cpu(input, col_buffer_.mutable_cpu_data());
+      conv_im2col_cpu(input, col_data);
+    }
+    col_buff = col_data;
+  }
+  forward_cpu_group_gemms(weights, col_buff, col_offset_, output,
+      output_offset_, conv_out_spatial_dim_, weight_panel);
+}
+
+template <typename Dtype>
+int BaseConvolutionLayer<Dtype>::weight_panel_rows() const {
+  return std::max(1, std::min(conv_out_channels_ / group_,
+      65536 / kernel_dim_));
+}
+
+template <typename Dtype>
+int BaseConvolutionLayer<Dtype>::weight_panel_size() const {
+  if (!this->blobs_[0]->reduced_cpu_data()) {
+    return 0;
+  }
+  return weight_panel_rows() * kernel_dim_;
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::forward_cpu_group_gemms(
+    const Dtype* weights, const Dtype* col, int col_step, Dtype* output,
+    int output_step, int n, Dtype* weight_panel) {
+  const int group_channels = conv_out_channels_ / group_;
+  if (weights) {
+    for (int g = 0; g < group_; ++g) {
+      caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, group_channels, n,
+          kernel_dim_, (Dtype)1., weights + weight_offset_ * g,
+          col + col_step * g, (Dtype)0., output + output_step * g);
     }
-    col_buff = col_buffer_.cpu_data();
+    return;
   }
+  // 16-bit weights: widen the rows of a few output channels at a time, so
+  // that no full precision copy of the weights is ever made.
+  const uint16_t* reduced = this->blobs_[0]->reduced_cpu_data();
+  const StoragePrecision precision = this->blobs_[0]->data_storage();
+  const int panel_rows = weight_panel_rows();
   for (int g = 0; g < group_; ++g) {
-    caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, conv_out_channels_ /
-        group_, conv_out_spatial_dim_, kernel_dim_,
-        (Dtype)1., weights + weight_offset_ * g, col_buff + col_offset_ * g,
-        (Dtype)0., output + output_offset_ * g);
+    for (int r = 0; r < group_channels; r += panel_rows) {
+      const int rows = std::min(panel_rows, group_channels - r);
+      caffe_cpu_expand_precision(rows * kernel_dim_,
+          reduced + weight_offset_ * g + r * kernel_dim_, precision,
+          weight_panel);
+      caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, rows, n, kernel_dim_,
+          (Dtype)1., weight_panel, col + col_step * g, (Dtype)0.,
+          output + output_step * g + r * n);
+    }
   }
 }
 
@@ -279,13 +330,40 @@ void BaseConvolutionLayer<Dtype>::forward_cpu_bias(Dtype* output,
       (Dtype)1., output);
 }
 
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::forward_cpu_epilogue(Dtype* top_data,
+    int n) {
+  Dtype* output = top_data + n * top_dim_;
+  const Dtype* bias = bias_term_ ? this->blobs_[1]->cpu_data() : NULL;
+  if (!this->runs_fused_activations()) {
+    if (bias) {
+      forward_cpu_bias(output, bias);
+    }
+    return;
+  }
+  for (int c = 0; c < num_output_; ++c) {
+    if (bias) {
+      Dtype* channel = output + c * out_spatial_dim_;
+      for (int i = 0; i < out_spatial_dim_; ++i) {
+        channel[i] += bias[c];
+      }
+    }
+    const int begin = n * top_dim_ + c * out_spatial_dim_;
+    this->forward_cpu_activations(top_data, begin, begin + out_spatial_dim_);
+  }
+}
+
 template <typename Dtype>
 void BaseConvolutionLayer<Dtype>::backward_cpu_gemm(const Dtype* output,
     const Dtype* weights, Dtype* input) {
-  Dtype* col_buff = col_buffer_.mutable_cpu_data();
-  if (is_1x1_) {
-    col_buff = input;
-  }
+  backward_cpu_gemm(output, weights, input,
+      is_1x1_ ? NULL : col_buffer_cpu());
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::backward_cpu_gemm(const Dtype* output,
+    const Dtype* weights, Dtype* input, Dtype* col_data) {
+  Dtype* col_buff = is_1x1_ ? input : col_data;
   for (int g = 0; g < group_; ++g) {
     caffe_cpu_gemm<Dtype>(CblasTrans, CblasNoTrans, kernel_dim_,
         conv_out_spatial_dim_, conv_out_channels_ / group_,
@@ -300,10 +378,17 @@ void BaseConvolutionLayer<Dtype>::backward_cpu_gemm(const Dtype* output,
 template <typename Dtype>
 void BaseConvolutionLayer<Dtype>::weight_cpu_gemm(const Dtype* input,
     const Dtype* output, Dtype* weights) {
+  weight_cpu_gemm(input, output, weights,
+      is_1x1_ ? NULL : col_buffer_cpu());
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::weight_cpu_gemm(const Dtype* input,
+    const Dtype* output, Dtype* weights, Dtype* col_data) {
   const Dtype* col_buff = input;
   if (!is_1x1_) {
-    conv_im2col_cpu(input, col_buffer_.mutable_cpu_data());
-    col_buff = col_buffer_.cpu_data();
+    conv_im2col_cpu(input, col_data);
+    col_buff = col_data;
   }
   for (int g = 0; g < group_; ++g) {
     caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasTrans, conv_out_channels_ / group_,
@@ -320,6 +405,117 @@ void BaseConvolutionLayer<Dtype>::backward_cpu_bias(Dtype* bias,
       input, bias_multiplier_.cpu_data(), 1., bias);
 }
 
+template <typename Dtype>
+int BaseConvolutionLayer<Dtype>::batch_gemm_images() const {
+  const int64_t budget =
+      this->layer_param_.convolution_param().batch_gemm_memory();
+  // Each image takes its columns and its output rows, on top of the columns
+  // of the single image being im2col'ed. The count of the whole buffer must
+  // also fit in an int.
+  const int64_t col_count = col_buffer_.count();
+  const int64_t image_count = col_count +
+      static_cast<int64_t>(conv_out_channels_) * conv_out_spatial_dim_;
+  const int64_t images = std::min(
+      (budget - col_count * static_cast<int64_t>(sizeof(Dtype))) /
+      (image_count * static_cast<int64_t>(sizeof(Dtype))),
+      (INT_MAX - col_count) / image_count);
+  return static_cast<int>(std::max<int64_t>(1,
+      std::min<int64_t>(num_, images)));
+}
+
+template <typename Dtype>
+int BaseConvolutionLayer<Dtype>::batch_gemm_buffer_size(int num) const {
+  // The wide column and output matrices, then the columns of one image.
+  const int64_t count = num * (col_buffer_.count() +
+      static_cast<int64_t>(conv_out_channels_) * conv_out_spatial_dim_) +
+      col_buffer_.count();
+  CHECK_LE(count, INT_MAX) << "batch_gemm_images() exceeds the int range.";
+  return static_cast<int>(count);
+}
+
+// Copies rows x row_size elements between matrices of the given row pitches;
+// used to move the matrices of single images in and out of the wide ones.
+template <typename Dtype>
+static void copy_rows_cpu(int rows, int row_size, const Dtype* src,
+    int src_pitch, Dtype* dst, int dst_pitch) {
+  for (int r = 0; r < rows; ++r) {
+    caffe_copy(row_size, src + r * src_pitch, dst + r * dst_pitch);
+  }
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::forward_cpu_gemm_batch(const Dtype* input,
+    const Dtype* weights, Dtype* output, int num, Dtype* buff,
+    Dtype* weight_panel) {
+  const int input_dim = reverse_dimensions() ? top_dim_ : bottom_dim_;
+  const int output_dim = conv_out_channels_ * conv_out_spatial_dim_;
+  const int wide_dim = num * conv_out_spatial_dim_;
+  Dtype* col_wide = buff;
+  Dtype* output_wide = col_wide + num * col_buffer_.count();
+  Dtype* col_buff = output_wide + num * output_dim;
+  for (int n = 0; n < num; ++n) {
+    const Dtype* col = input + n * input_dim;
+    if (!is_1x1_) {
+      conv_im2col_cpu(col, col_buff);
+      col = col_buff;
+    }
+    copy_rows_cpu(kernel_dim_ * group_, conv_out_spatial_dim_, col,
+        conv_out_spatial_dim_, col_wide + n * conv_out_spatial_dim_, wide_dim);
+  }
+  forward_cpu_group_gemms(weights, col_wide, kernel_dim_ * wide_dim,
+      output_wide, output_offset_ * num, wide_dim, weight_panel);
+  for (int n = 0; n < num; ++n) {
+    copy_rows_cpu(conv_out_channels_, conv_out_spatial_dim_,
+        output_wide + n * conv_out_spatial_dim_, wide_dim,
+        output + n * output_dim, conv_out_spatial_dim_);
+  }
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::weight_cpu_gemm_batch(const Dtype* input,
+    const Dtype* output, Dtype* weights, int num, Dtype* buff) {
+  const int input_dim = reverse_dimensions() ? top_dim_ : bottom_dim_;
+  const int output_dim = conv_out_channels_ * conv_out_spatial_dim_;
+  const int wide_dim = num * conv_out_spatial_dim_;
+  Dtype* col_wide = buff;
+  Dtype* output_wide = col_wide + num * col_buffer_.count();
+  Dtype* col_buff = output_wide + num * output_dim;
+  for (int n = 0; n < num; ++n) {
+    const Dtype* col = input + n * input_dim;
+    if (!is_1x1_) {
+      conv_im2col_cpu(col, col_buff);
+      col = col_buff;
+    }
+    copy_rows_cpu(kernel_dim_ * group_, conv_out_spatial_dim_, col,
+        conv_out_spatial_dim_, col_wide + n * conv_out_spatial_dim_, wide_dim);
+    copy_rows_cpu(conv_out_channels_, conv_out_spatial_dim_,
+        output + n * output_dim, conv_out_spatial_dim_,
+        output_wide + n * conv_out_spatial_dim_, wide_dim);
+  }
+  for (int g = 0; g < group_; ++g) {
+    caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasTrans, conv_out_channels_ / group_,
+        kernel_dim_, wide_dim,
+        (Dtype)1., output_wide + output_offset_ * num * g,
+        col_wide + kernel_dim_ * wide_dim * g,
+        (Dtype)1., weights + weight_offset_ * g);
+  }
+}
+
+template <typename Dtype>
+Dtype* BaseConvolutionLayer<Dtype>::scratch_cpu(int count) {
+  if (count == 0) {
+    return NULL;
+  }
+  if (shared_workspace_) {
+    return static_cast<Dtype*>(
+        shared_workspace_->mutable_cpu_data(count * sizeof(Dtype)));
+  }
+  if (scratch_.count() < count) {
+    scratch_.Reshape(vector<int>(1, count));
+  }
+  return scratch_.mutable_cpu_data_uninitialized();
+}
+
 #ifndef CPU_ONLY
 
 template <typename Dtype>
@@ -327,10 +523,11 @@ void BaseConvolutionLayer<Dtype>::forward_gpu_gemm(const Dtype* input,
     const Dtype* weights, Dtype* output, bool skip_im2col) {
   const Dtype* col_buff = input;
   if (!is_1x1_) {
+    Dtype* col_data = col_buffer_gpu();
     if (!skip_im2col) {
-      conv_im2col_gpu(input, col_buffer_.mutable_gpu_data());
+      conv_im2col_gpu(input, col_data);
     }
-    col_buff = col_buffer_.gpu_data();
+    col_buff = col_data;
   }
   for (int g = 0; g < group_; ++g) {
     caffe_gpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, conv_out_channels_ /
@@ -351,10 +548,7 @@ void BaseConvolutionLayer<Dtype>::forward_gpu_bias(Dtype* output,
 template <typename Dtype>
 void BaseConvolutionLayer<Dtype>::backward_gpu_gemm(const Dtype* output,
     const Dtype* weights, Dtype* input) {
-  Dtype* col_buff = col_buffer_.mutable_gpu_data();
-  if (is_1x1_) {
-    col_buff = input;
-  }
+  Dtype* col_buff = is_1x1_ ? input : col_buffer_gpu();
   for (int g = 0; g < group_; ++g) {
     caffe_gpu_gemm<Dtype>(CblasTrans, CblasNoTrans, kernel_dim_,
         conv_out_spatial_dim_, conv_out_channels_ / group_,
@@ -371,8 +565,9 @@ void BaseConvolutionLayer<Dtype>::weight_gpu_gemm(const Dtype* input,
     const Dtype* output, Dtype* weights) {
   const Dtype* col_buff = input;
   if (!is_1x1_) {
-    conv_im2col_gpu(input, col_buffer_.mutable_gpu_data());
-    col_buff = col_buffer_.gpu_data();
+    Dtype* col_data = col_buffer_gpu();
+    conv_im2col_gpu(input, col_data);
+    col_buff = col_data;
   }
   for (int g = 0; g < group_; ++g) {
     caffe_gpu_gemm<Dtype>(CblasNoTrans, CblasTrans, conv_out_channels_ / group_,
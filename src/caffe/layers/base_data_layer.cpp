@@ -52,10 +52,12 @@ void BasePrefetchingDataLayer<Dtype>::LayerSetUp(
   // seems to cause failures if we do not so.
   // 在开始预取线程之前 我们先调用cpu_data 和 gpu_data 所以这样预取线程就不会在主进程进行时意外的同时调用cudaMalloc
   // 这段的意义是顺序初始化内存
+  // The prefetch thread overwrites every batch completely, so there is no
+  // need to zero-fill them here.
   for (int i = 0; i < PREFETCH_COUNT; ++i) {
-    prefetch_[i].data_.mutable_cpu_data();
+    prefetch_[i].data_.mutable_cpu_data_uninitialized();
     if (this->output_labels_) {
-      prefetch_[i].label_.mutable_cpu_data();
+      prefetch_[i].label_.mutable_cpu_data_uninitialized();
     }
   }
 #ifndef CPU_ONLY
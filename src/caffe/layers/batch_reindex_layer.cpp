@@ -15,6 +15,21 @@ void BatchReindexLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
     newshape.push_back(bottom[0]->shape()[i]);
   }
   top[0]->Reshape(newshape);
+  bool identity = bottom[1]->count() == bottom[0]->shape(0);
+  const Dtype* permut = bottom[1]->cpu_data();
+  for (int i = 0; identity && i < bottom[1]->count(); ++i) {
+    identity = static_cast<int>(permut[i]) == i;
+  }
+  if (identity && this->share_bottom_data_) {
+    // The batch is forwarded as it is, with no copy.
+    top[0]->ShareData(*bottom[0]);
+    top[0]->ShareDiff(*bottom[0]);
+  } else if (top[0]->data() == bottom[0]->data()) {
+    // Shared for earlier indices: the top needs memory of its own again.
+    Blob<Dtype> own(newshape);
+    top[0]->ShareData(own);
+    top[0]->ShareDiff(own);
+  }
 }
 
 template<typename Dtype>
@@ -34,7 +49,7 @@ void BatchReindexLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
                                            const vector<Blob<Dtype>*>& top) {
   check_batch_reindex(bottom[0]->shape(0), bottom[1]->count(),
                       bottom[1]->cpu_data());
-  if (top[0]->count() == 0) {
+  if (top[0]->count() == 0 || top[0]->data() == bottom[0]->data()) {
     return;
   }
   int inner_dim = bottom[0]->count() / bottom[0]->shape(0);
@@ -53,7 +68,7 @@ void BatchReindexLayer<Dtype>::Backward_cpu(
     const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
     const vector<Blob<Dtype>*>& bottom) {
   CHECK(!propagate_down[1]) << "Cannot backprop to index.";
-  if (!propagate_down[0]) {
+  if (!propagate_down[0] || top[0]->diff() == bottom[0]->diff()) {
     return;
   }
   int inner_dim = bottom[0]->count() / bottom[0]->shape(0);
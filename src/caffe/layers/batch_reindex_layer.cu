@@ -22,7 +22,7 @@ void BatchReindexLayer<Dtype>::Forward_gpu(const vector<Blob<Dtype>*>& bottom,
                                            const vector<Blob<Dtype>*>& top) {
   check_batch_reindex(bottom[0]->shape(0), bottom[1]->count(),
                       bottom[1]->cpu_data());
-  if (top[0]->count() == 0) {
+  if (top[0]->count() == 0 || top[0]->data() == bottom[0]->data()) {
     return;
   }
   int threads = top[0]->count();
@@ -55,7 +55,7 @@ void BatchReindexLayer<Dtype>::Backward_gpu(
     const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
     const vector<Blob<Dtype>*>& bottom) {
   CHECK(!propagate_down[1]) << "Cannot backprop to index.";
-  if (!propagate_down[0]) {
+  if (!propagate_down[0] || top[0]->diff() == bottom[0]->diff()) {
     return;
   }
 
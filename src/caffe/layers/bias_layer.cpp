@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 
 #include "caffe/filler.hpp"
@@ -111,6 +112,53 @@ void BiasLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   }
 }
 
+template <typename Dtype>
+void BiasLayer<Dtype>::Forward_cpu_fused_begin(const Blob<Dtype>& blob,
+    bool keep_input) {
+  const Blob<Dtype>& bias = *this->blobs_[0];
+  const int axis = (bias.num_axes() == 0) ?
+      0 : blob.CanonicalAxisIndex(this->layer_param_.bias_param().axis());
+  fused_bias_dim_ = bias.count();
+  fused_inner_dim_ = blob.count(axis + bias.num_axes());
+}
+
+template <typename Dtype>
+void BiasLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  const Dtype* bias_data = this->blobs_[0]->cpu_data();
+  // Runs of values [i, i + n) that share the bias of channel d.
+  int d = (begin / fused_inner_dim_) % fused_bias_dim_;
+  for (int i = 0, j = begin % fused_inner_dim_; i < end - begin; j = 0) {
+    const int n = std::min(fused_inner_dim_ - j, end - begin - i);
+    const Dtype bias = bias_data[d];
+    for (int k = i; k < i + n; ++k) {
+      data[k] += bias;
+    }
+    i += n;
+    d = (d + 1 == fused_bias_dim_) ? 0 : d + 1;
+  }
+}
+
+template <typename Dtype>
+void BiasLayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  // The diff passes through unchanged.
+  if (!this->param_propagate_down_[0]) {
+    return;
+  }
+  Dtype* bias_diff = this->blobs_[0]->mutable_cpu_diff();
+  int d = (begin / fused_inner_dim_) % fused_bias_dim_;
+  for (int i = 0, j = begin % fused_inner_dim_; i < end - begin; j = 0) {
+    const int n = std::min(fused_inner_dim_ - j, end - begin - i);
+    Dtype sum = 0;
+    for (int k = i; k < i + n; ++k) {
+      sum += diff[k];
+    }
+    bias_diff[d] += sum;
+    i += n;
+    d = (d + 1 == fused_bias_dim_) ? 0 : d + 1;
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(BiasLayer);
 #endif
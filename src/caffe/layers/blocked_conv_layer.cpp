@@ -0,0 +1,97 @@
+#include <boost/bind.hpp>
+#include <vector>
+
+#include "caffe/layers/blocked_conv_layer.hpp"
+#include "caffe/util/blocked_layout.hpp"
+#include "caffe/util/reduced_precision.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void BlockedConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  block_ = this->layer_param_.convolution_param().channel_block();
+  CHECK_GT(block_, 0);
+  CHECK_EQ(2, this->num_spatial_axes_)
+      << "The blocked layout takes 2D convolutions only.";
+  CHECK_EQ(1, this->group_)
+      << "The blocked layout takes ungrouped convolutions only.";
+  for (int i = 0; i < top.size(); ++i) {
+    top[i]->set_channel_block(block_);
+  }
+  if (packed_weights_.shape() != this->blobs_[0]->shape()) {
+    packed_weights_.Reshape(this->blobs_[0]->shape());
+    weight_memory_ = NULL;
+  }
+}
+
+template <typename Dtype>
+void BlockedConvolutionLayer<Dtype>::forward_cpu_blocks(
+    const Dtype* bottom_data, int in_block, Dtype* top_data, int begin,
+    int end) {
+  const int num_blocks = this->num_output_ / block_;
+  const int kernel_dim = this->blobs_[0]->count(1);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  const Dtype* packed = packed_weights_.cpu_data();
+  const Dtype* bias = this->bias_term_ ? this->blobs_[1]->cpu_data() : NULL;
+  for (int i = begin; i < end; ++i) {
+    const int n = i / num_blocks;
+    const int b = i % num_blocks;
+    blocked_conv_cpu(bottom_data + n * this->bottom_dim_, this->channels_,
+        in_block, this->input_shape(1), this->input_shape(2), kernel[0],
+        kernel[1], pad[0], pad[1], stride[0], stride[1], dilation[0],
+        dilation[1], packed + b * kernel_dim * block_,
+        bias ? bias + b * block_ : NULL, block_, top_data + n * this->top_dim_ +
+        b * this->out_spatial_dim_ * block_);
+  }
+}
+
+template <typename Dtype>
+void BlockedConvolutionLayer<Dtype>::PackWeights() {
+  const Blob<Dtype>& weights = *this->blobs_[0];
+  const SyncedMemory* memory = weights.data().get();
+  if (memory == weight_memory_ && memory->version() == weight_version_) {
+    return;
+  }
+  // Weights held at 16 bits are widened here only, not on every pass.
+  const uint16_t* reduced_weight = weights.reduced_cpu_data();
+  vector<Dtype> widened(reduced_weight ? weights.count() : 0);
+  if (reduced_weight) {
+    caffe_cpu_expand_precision(weights.count(), reduced_weight,
+        weights.data_storage(), &widened[0]);
+  }
+  blocked_conv_pack_weights_cpu(
+      reduced_weight ? &widened[0] : weights.cpu_data(), this->num_output_,
+      weights.count(1), block_,
+      packed_weights_.mutable_cpu_data_uninitialized());
+  weight_memory_ = memory;
+  weight_version_ = memory->version();
+}
+
+template <typename Dtype>
+void BlockedConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  PackWeights();
+  for (int i = 0; i < bottom.size(); ++i) {
+    parallel_for(0, this->num_ * this->num_output_ / block_, 1, boost::bind(
+        &BlockedConvolutionLayer<Dtype>::forward_cpu_blocks, this,
+        bottom[i]->cpu_data(), bottom[i]->channel_block(),
+        top[i]->mutable_cpu_data_uninitialized(), _1, _2));
+  }
+}
+
+template <typename Dtype>
+void BlockedConvolutionLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  LOG(FATAL) << "The blocked layout is for inference only.";
+}
+
+INSTANTIATE_CLASS(BlockedConvolutionLayer);
+
+}  // namespace caffe
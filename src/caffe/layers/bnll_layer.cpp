@@ -37,6 +37,25 @@ void BNLLLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   }
 }
 
+template <typename Dtype>
+void BNLLLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  for (int i = 0; i < end - begin; ++i) {
+    data[i] = data[i] > 0 ?
+        data[i] + log(1. + exp(-data[i])) :
+        log(1. + exp(data[i]));
+  }
+}
+
+template <typename Dtype>
+void BNLLLayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  Dtype expval;
+  for (int i = 0; i < end - begin; ++i) {
+    expval = exp(std::min(bottom_data[i], Dtype(kBNLL_THRESHOLD)));
+    diff[i] *= expval / (expval + 1.);
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(BNLLLayer);
 #endif
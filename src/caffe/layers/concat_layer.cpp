@@ -50,7 +50,24 @@ void ConcatLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
   if (bottom.size() == 1) {
     top[0]->ShareData(*bottom[0]);
     top[0]->ShareDiff(*bottom[0]);
+    return;
   }
+  // Layer::Forward reshapes without the Net re-pointing its views.
+  for (int i = 0; i < bottom.size(); ++i) {
+    this->DetachStaleView(bottom[i], *top[0],
+        BottomViewOffset(bottom, top, i));
+  }
+}
+
+template <typename Dtype>
+int ConcatLayer<Dtype>::BottomViewOffset(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top, int bottom_id) const {
+  if (bottom.size() == 1 || num_concats_ != 1) { return -1; }
+  int offset = 0;
+  for (int i = 0; i < bottom_id; ++i) {
+    offset += bottom[i]->count();
+  }
+  return offset;
 }
 
 template <typename Dtype>
@@ -63,6 +80,12 @@ void ConcatLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   for (int i = 0; i < bottom.size(); ++i) {
     const Dtype* bottom_data = bottom[i]->cpu_data();
     const int bottom_concat_axis = bottom[i]->shape(concat_axis_);
+    // A bottom made a view into the top by the Net is already in place.
+    if (num_concats_ == 1 &&
+        bottom_data == top_data + offset_concat_axis * concat_input_size_) {
+      offset_concat_axis += bottom_concat_axis;
+      continue;
+    }
     for (int n = 0; n < num_concats_; ++n) {
       caffe_copy(bottom_concat_axis * concat_input_size_,
           bottom_data + n * bottom_concat_axis * concat_input_size_,
@@ -84,6 +107,11 @@ void ConcatLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
     const int bottom_concat_axis = bottom[i]->shape(concat_axis_);
     if (propagate_down[i]) {
       Dtype* bottom_diff = bottom[i]->mutable_cpu_diff();
+      if (num_concats_ == 1 &&
+          bottom_diff == top_diff + offset_concat_axis * concat_input_size_) {
+        offset_concat_axis += bottom_concat_axis;
+        continue;
+      }
       for (int n = 0; n < num_concats_; ++n) {
         caffe_copy(bottom_concat_axis * concat_input_size_, top_diff +
             (n * top_concat_axis + offset_concat_axis) * concat_input_size_,
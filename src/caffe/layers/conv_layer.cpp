@@ -1,6 +1,9 @@
+#include <boost/bind.hpp>
+#include <algorithm>
 #include <vector>
 
 #include "caffe/layers/conv_layer.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
@@ -21,19 +24,96 @@ void ConvolutionLayer<Dtype>::compute_output_shape() {
   }
 }
 
+template <typename Dtype>
+int ConvolutionLayer<Dtype>::num_batch_shares() const {
+  if (!this->layer_param_.convolution_param().batch_parallel() ||
+      ThreadPool::in_parallel_region()) {
+    return 1;
+  }
+  return std::max(1, std::min(this->num_,
+      Caffe::thread_pool()->num_threads()));
+}
+
+template <typename Dtype>
+void ConvolutionLayer<Dtype>::forward_cpu_shares(const Dtype* weight,
+    const Dtype* bottom_data, Dtype* top_data, Dtype* col_buffers,
+    Dtype* weight_panels, int begin, int end) {
+  const int panel_size = this->weight_panel_size();
+  for (int share = begin; share < end; ++share) {
+    Dtype* col_buff = col_buffers ?
+        col_buffers + share * this->col_buffer_size() : NULL;
+    Dtype* weight_panel = weight_panels ?
+        weight_panels + share * panel_size : NULL;
+    for (int n = share * this->num_ / num_shares_;
+         n < (share + 1) * this->num_ / num_shares_; ++n) {
+      this->forward_cpu_gemm(bottom_data + n * this->bottom_dim_, weight,
+          top_data + n * this->top_dim_, col_buff, false, weight_panel);
+      this->forward_cpu_epilogue(top_data, n);
+    }
+  }
+}
+
 template <typename Dtype>
 void ConvolutionLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
-  const Dtype* weight = this->blobs_[0]->cpu_data();
+  // Either one wide GEMM for every batch images, if the batch_gemm_memory
+  // budget allows, or split the images of the batch into shares that run
+  // concurrently, each with its own column buffer.
+  num_shares_ = num_batch_shares();
+  const int batch = this->batch_gemm_images();
+  const int buffer_count = batch > 1 ? this->batch_gemm_buffer_size(batch) :
+      (this->is_1x1_ ? 0 : num_shares_ * this->col_buffer_size());
+  // Weights held at 16 bits are widened a panel at a time by the GEMMs,
+  // into a panel per share placed after the buffers, so that they are
+  // never kept at full precision.
+  const int panel_count = this->weight_panel_size() *
+      (batch > 1 ? 1 : num_shares_);
+  Dtype* scratch = this->scratch_cpu(buffer_count + panel_count);
+  const Dtype* weight =
+      panel_count ? NULL : this->blobs_[0]->cpu_data();
+  Dtype* buff = buffer_count ? scratch : NULL;
+  Dtype* weight_panels = panel_count ? scratch + buffer_count : NULL;
   for (int i = 0; i < bottom.size(); ++i) {
     const Dtype* bottom_data = bottom[i]->cpu_data();
-    Dtype* top_data = top[i]->mutable_cpu_data();
-    for (int n = 0; n < this->num_; ++n) {
-      this->forward_cpu_gemm(bottom_data + n * this->bottom_dim_, weight,
-          top_data + n * this->top_dim_);
-      if (this->bias_term_) {
-        const Dtype* bias = this->blobs_[1]->cpu_data();
-        this->forward_cpu_bias(top_data + n * this->top_dim_, bias);
+    Dtype* top_data = top[i]->mutable_cpu_data_uninitialized();
+    this->forward_cpu_activations_begin(*top[i]);
+    if (batch > 1) {
+      for (int n = 0; n < this->num_; n += batch) {
+        this->forward_cpu_gemm_batch(bottom_data + n * this->bottom_dim_,
+            weight, top_data + n * this->top_dim_,
+            std::min(batch, this->num_ - n), buff, weight_panels);
+      }
+      for (int n = 0; n < this->num_; ++n) {
+        this->forward_cpu_epilogue(top_data, n);
+      }
+      continue;
+    }
+    parallel_for(0, num_shares_, 1, boost::bind(
+        &ConvolutionLayer<Dtype>::forward_cpu_shares, this, weight,
+        bottom_data, top_data, buff, weight_panels, _1, _2));
+  }
+}
+
+template <typename Dtype>
+void ConvolutionLayer<Dtype>::backward_cpu_shares(const Dtype* weight,
+    const Dtype* top_diff, const Dtype* bottom_data, Dtype* bottom_diff,
+    Dtype* weight_diffs, Dtype* col_buffers, int begin, int end) {
+  const int weight_count = this->blobs_[0]->count();
+  for (int share = begin; share < end; ++share) {
+    Dtype* col_buff = col_buffers ?
+        col_buffers + share * this->col_buffer_size() : NULL;
+    for (int n = share * this->num_ / num_shares_;
+         n < (share + 1) * this->num_ / num_shares_; ++n) {
+      // gradient w.r.t. weight. Note that we will accumulate diffs.
+      if (weight_diffs) {
+        this->weight_cpu_gemm(bottom_data + n * this->bottom_dim_,
+            top_diff + n * this->top_dim_,
+            weight_diffs + share * weight_count, col_buff);
+      }
+      // gradient w.r.t. bottom data, if necessary.
+      if (bottom_diff) {
+        this->backward_cpu_gemm(top_diff + n * this->top_dim_, weight,
+            bottom_diff + n * this->bottom_dim_, col_buff);
       }
     }
   }
@@ -44,6 +124,9 @@ void ConvolutionLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom) {
   const Dtype* weight = this->blobs_[0]->cpu_data();
   Dtype* weight_diff = this->blobs_[0]->mutable_cpu_diff();
+  const int weight_count = this->blobs_[0]->count();
+  num_shares_ = num_batch_shares();
+  const int batch = this->batch_gemm_images();
   for (int i = 0; i < top.size(); ++i) {
     const Dtype* top_diff = top[i]->cpu_diff();
     const Dtype* bottom_data = bottom[i]->cpu_data();
@@ -55,17 +138,44 @@ void ConvolutionLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
         this->backward_cpu_bias(bias_diff, top_diff + n * this->top_dim_);
       }
     }
-    if (this->param_propagate_down_[0] || propagate_down[i]) {
-      for (int n = 0; n < this->num_; ++n) {
-        // gradient w.r.t. weight. Note that we will accumulate diffs.
-        if (this->param_propagate_down_[0]) {
-          this->weight_cpu_gemm(bottom_data + n * this->bottom_dim_,
-              top_diff + n * this->top_dim_, weight_diff);
-        }
-        // gradient w.r.t. bottom data, if necessary.
-        if (propagate_down[i]) {
-          this->backward_cpu_gemm(top_diff + n * this->top_dim_, weight,
-              bottom_diff + n * this->bottom_dim_);
+    // Weight gradient from one wide GEMM for every batch images, if enabled;
+    // the shares below then only compute the bottom gradient.
+    const bool weight_gemm_batch = this->param_propagate_down_[0] && batch > 1;
+    if (weight_gemm_batch) {
+      Dtype* buff = this->scratch_cpu(this->batch_gemm_buffer_size(batch));
+      for (int n = 0; n < this->num_; n += batch) {
+        this->weight_cpu_gemm_batch(bottom_data + n * this->bottom_dim_,
+            top_diff + n * this->top_dim_, weight_diff,
+            std::min(batch, this->num_ - n), buff);
+      }
+    }
+    const bool weight_shares =
+        this->param_propagate_down_[0] && !weight_gemm_batch;
+    if (weight_shares || propagate_down[i]) {
+      // The scratch memory holds a column buffer per share, then, with more
+      // than one share, a weight gradient per share. Those are summed into
+      // weight_diff in share order, so the result does not depend on how
+      // the shares were scheduled.
+      const int col_count = this->is_1x1_ ? 0 :
+          num_shares_ * this->col_buffer_size();
+      const bool split_weight_diff = weight_shares && num_shares_ > 1;
+      Dtype* scratch = this->scratch_cpu(col_count +
+          (split_weight_diff ? num_shares_ * weight_count : 0));
+      Dtype* weight_diffs = NULL;
+      if (split_weight_diff) {
+        weight_diffs = scratch + col_count;
+        caffe_set(num_shares_ * weight_count, Dtype(0), weight_diffs);
+      } else if (weight_shares) {
+        weight_diffs = weight_diff;
+      }
+      parallel_for(0, num_shares_, 1, boost::bind(
+          &ConvolutionLayer<Dtype>::backward_cpu_shares, this, weight,
+          top_diff, bottom_data, propagate_down[i] ? bottom_diff : NULL,
+          weight_diffs, col_count ? scratch : NULL, _1, _2));
+      if (split_weight_diff) {
+        for (int share = 0; share < num_shares_; ++share) {
+          caffe_axpy(weight_count, Dtype(1),
+              weight_diffs + share * weight_count, weight_diff);
         }
       }
     }
@@ -66,6 +66,8 @@ void CropLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
     offsets[i] = crop_offset;
   }
   top[0]->Reshape(new_shape);
+  // Layer::Forward reshapes without the Net re-pointing its views.
+  this->DetachStaleView(top[0], *bottom[0], TopViewOffset(bottom, top, 0));
 }
 
 template <typename Dtype>
@@ -111,12 +113,32 @@ void CropLayer<Dtype>::crop_copy(const vector<Blob<Dtype>*>& bottom,
   }
 }
 
+template <typename Dtype>
+int CropLayer<Dtype>::TopViewOffset(const vector<Blob<Dtype>*>& bottom,
+    const vector<Blob<Dtype>*>& top, int top_id) const {
+  int last_cropped = -1;
+  for (int i = 0; i < top[0]->num_axes(); ++i) {
+    if (top[0]->shape(i) != bottom[0]->shape(i)) { last_cropped = i; }
+  }
+  for (int i = 0; i < last_cropped; ++i) {
+    if (top[0]->shape(i) != 1) { return -1; }
+  }
+  return bottom[0]->offset(offsets);
+}
+
 template <typename Dtype>
 void CropLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
-  std::vector<int> indices(top[0]->num_axes(), 0);
   const Dtype* bottom_data = bottom[0]->cpu_data();
   Dtype* top_data = top[0]->mutable_cpu_data();
+  const int offset = TopViewOffset(bottom, top, 0);
+  if (offset >= 0) {
+    // One copy, which caffe_copy skips for a top the Net made a view into
+    // the bottom.
+    caffe_copy(top[0]->count(), bottom_data + offset, top_data);
+    return;
+  }
+  std::vector<int> indices(top[0]->num_axes(), 0);
   crop_copy(bottom, top, offsets, indices, 0, bottom_data, top_data, true);
 }
 
@@ -127,6 +149,17 @@ void CropLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   Dtype* bottom_diff = bottom[0]->mutable_cpu_diff();
 
   if (propagate_down[0]) {
+    const int offset = TopViewOffset(bottom, top, 0);
+    if (offset >= 0) {
+      // Only the values around the crop are zeroed, as the diff of a top
+      // made a view is already in place.
+      const int end = offset + top[0]->count();
+      caffe_set(offset, static_cast<Dtype>(0), bottom_diff);
+      caffe_set(bottom[0]->count() - end, static_cast<Dtype>(0),
+          bottom_diff + end);
+      caffe_copy(top[0]->count(), top_diff, bottom_diff + offset);
+      return;
+    }
     caffe_set(bottom[0]->count(), static_cast<Dtype>(0), bottom_diff);
     std::vector<int> indices(top[0]->num_axes(), 0);
     crop_copy(bottom, top, offsets, indices, 0, top_diff, bottom_diff, false);
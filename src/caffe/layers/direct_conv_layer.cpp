@@ -0,0 +1,154 @@
+#include <boost/bind.hpp>
+#include <vector>
+
+#include "caffe/layers/direct_conv_layer.hpp"
+#include "caffe/util/direct_conv.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  // Without an explicit DIRECT engine, only depthwise convolutions leave
+  // the im2col path.
+  const bool explicit_engine = this->layer_param_.convolution_param().engine()
+      == ConvolutionParameter_Engine_DIRECT;
+  use_direct_ = this->num_spatial_axes_ == 2 && this->group_ > 1 &&
+      (explicit_engine ? this->channels_ / this->group_ <= kMaxGroupChannels :
+      this->group_ == this->channels_);
+}
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::forward_cpu_groups(
+    const Dtype* bottom_data, const Dtype* weight, Dtype* top_data,
+    int begin, int end) {
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int height = this->input_shape(1);
+  const int width = this->input_shape(2);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  for (int i = begin; i < end; ++i) {
+    const int n = i / this->group_;
+    const int g = i % this->group_;
+    direct_conv_cpu(bottom_data + n * this->bottom_dim_ +
+        g * in_channels * height * width, in_channels, height, width,
+        kernel[0], kernel[1], pad[0], pad[1], stride[0], stride[1],
+        dilation[0], dilation[1], weight + g * this->weight_offset_,
+        out_channels, top_data + n * this->top_dim_ +
+        g * out_channels * this->out_spatial_dim_);
+  }
+}
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::backward_cpu_groups(
+    const Dtype* top_diff, const Dtype* weight, Dtype* bottom_diff,
+    int begin, int end) {
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int height = this->input_shape(1);
+  const int width = this->input_shape(2);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  for (int i = begin; i < end; ++i) {
+    const int n = i / this->group_;
+    const int g = i % this->group_;
+    direct_conv_data_cpu(top_diff + n * this->top_dim_ +
+        g * out_channels * this->out_spatial_dim_, in_channels, height,
+        width, kernel[0], kernel[1], pad[0], pad[1], stride[0], stride[1],
+        dilation[0], dilation[1], weight + g * this->weight_offset_,
+        out_channels, bottom_diff + n * this->bottom_dim_ +
+        g * in_channels * height * width);
+  }
+}
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::weight_cpu_groups(
+    const Dtype* bottom_data, const Dtype* top_diff, Dtype* weight_diff,
+    int begin, int end) {
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int height = this->input_shape(1);
+  const int width = this->input_shape(2);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  for (int g = begin; g < end; ++g) {
+    // Images in order, so that the sum does not depend on the threads.
+    for (int n = 0; n < this->num_; ++n) {
+      direct_conv_weight_cpu(bottom_data + n * this->bottom_dim_ +
+          g * in_channels * height * width, in_channels, height, width,
+          kernel[0], kernel[1], pad[0], pad[1], stride[0], stride[1],
+          dilation[0], dilation[1], top_diff + n * this->top_dim_ +
+          g * out_channels * this->out_spatial_dim_, out_channels,
+          weight_diff + g * this->weight_offset_);
+    }
+  }
+}
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (!use_direct_) {
+    ConvolutionLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  for (int i = 0; i < bottom.size(); ++i) {
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    Dtype* top_data = top[i]->mutable_cpu_data_uninitialized();
+    this->forward_cpu_activations_begin(*top[i]);
+    parallel_for(0, this->num_ * this->group_, 1, boost::bind(
+        &DirectConvolutionLayer<Dtype>::forward_cpu_groups, this,
+        bottom_data, weight, top_data, _1, _2));
+    for (int n = 0; n < this->num_; ++n) {
+      this->forward_cpu_epilogue(top_data, n);
+    }
+  }
+}
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  if (!use_direct_) {
+    ConvolutionLayer<Dtype>::Backward_cpu(top, propagate_down, bottom);
+    return;
+  }
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  for (int i = 0; i < top.size(); ++i) {
+    const Dtype* top_diff = top[i]->cpu_diff();
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    // Bias gradient, if necessary.
+    if (this->bias_term_ && this->param_propagate_down_[1]) {
+      Dtype* bias_diff = this->blobs_[1]->mutable_cpu_diff();
+      for (int n = 0; n < this->num_; ++n) {
+        this->backward_cpu_bias(bias_diff, top_diff + n * this->top_dim_);
+      }
+    }
+    // Gradient w.r.t. weight. Note that we accumulate diffs.
+    if (this->param_propagate_down_[0]) {
+      parallel_for(0, this->group_, 1, boost::bind(
+          &DirectConvolutionLayer<Dtype>::weight_cpu_groups, this,
+          bottom_data, top_diff, this->blobs_[0]->mutable_cpu_diff(),
+          _1, _2));
+    }
+    // Gradient w.r.t. bottom data, if necessary.
+    if (propagate_down[i]) {
+      parallel_for(0, this->num_ * this->group_, 1, boost::bind(
+          &DirectConvolutionLayer<Dtype>::backward_cpu_groups, this,
+          top_diff, weight, bottom[i]->mutable_cpu_diff(), _1, _2));
+    }
+  }
+}
+
+INSTANTIATE_CLASS(DirectConvolutionLayer);
+
+}  // namespace caffe
@@ -0,0 +1,135 @@
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "caffe/layers/elementwise_chain_layer.hpp"
+#include "caffe/util/math_functions.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+const int ElementwiseChainLayer<Dtype>::kBlockSize;
+
+template <typename Dtype>
+ElementwiseChainLayer<Dtype>::ElementwiseChainLayer(
+    const LayerParameter& param, const vector<Layer<Dtype>*>& layers,
+    bool keep_input)
+    : NeuronLayer<Dtype>(param), layers_(layers), keep_input_(keep_input) {
+  CHECK(!layers_.empty());
+  for (int i = 0; i < layers_.size(); ++i) {
+    CHECK(layers_[i]->AllowElementwiseFusion()) << layers_[i]->type()
+        << " Layer cannot run in an ElementwiseChain.";
+  }
+}
+
+template <typename Dtype>
+void ElementwiseChainLayer<Dtype>::forward_cpu_blocks(
+    const Dtype* bottom_data, Dtype* top_data, Dtype* input_data, int count,
+    int begin, int end) {
+  for (int b = begin; b < end; ++b) {
+    const int offset = b * kBlockSize;
+    const int n = std::min(count - offset, static_cast<int>(kBlockSize));
+    Dtype* data = top_data + offset;
+    if (input_data) {
+      caffe_copy(n, data, input_data + offset);
+    } else if (top_data != bottom_data) {
+      caffe_copy(n, bottom_data + offset, data);
+    }
+    for (int i = 0; i < layers_.size(); ++i) {
+      layers_[i]->Forward_cpu_fused(data, offset, offset + n);
+    }
+  }
+}
+
+template <typename Dtype>
+void ElementwiseChainLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  const int count = bottom[0]->count();
+  for (int i = 0; i < layers_.size(); ++i) {
+    layers_[i]->Forward_cpu_fused_begin(*bottom[0], false);
+  }
+  const Dtype* bottom_data = bottom[0]->cpu_data();
+  Dtype* top_data = top[0]->mutable_cpu_data();
+  Dtype* input_data = NULL;
+  if (bottom[0] == top[0] && keep_input_) {
+    input_.ReshapeLike(*bottom[0]);
+    input_data = input_.mutable_cpu_data();
+  }
+  const int num_blocks = (count + kBlockSize - 1) / kBlockSize;
+  parallel_for(0, num_blocks, 4, boost::bind(
+      &ElementwiseChainLayer<Dtype>::forward_cpu_blocks, this,
+      bottom_data, top_data, input_data, count, _1, _2));
+}
+
+template <typename Dtype>
+void ElementwiseChainLayer<Dtype>::backward_cpu_blocks(
+    const Dtype* bottom_data, const Dtype* top_data, const Dtype* top_diff,
+    Dtype* bottom_diff, int count, int begin, int end) {
+  const int num_layers = layers_.size();
+  // The values between the layers of a block, then its diff if bottom_diff
+  // is not to be written.
+  vector<Dtype> buffer(num_layers * kBlockSize);
+  vector<const Dtype*> values(num_layers + 1);
+  for (int b = begin; b < end; ++b) {
+    const int offset = b * kBlockSize;
+    const int n = std::min(count - offset, static_cast<int>(kBlockSize));
+    values[0] = bottom_data + offset;
+    for (int i = 1; i < num_layers; ++i) {
+      Dtype* data = &buffer[(i - 1) * kBlockSize];
+      caffe_copy(n, values[i - 1], data);
+      layers_[i - 1]->Forward_cpu_fused(data, offset, offset + n);
+      values[i] = data;
+    }
+    values[num_layers] = top_data + offset;
+    Dtype* diff = bottom_diff ?
+        bottom_diff + offset : &buffer[(num_layers - 1) * kBlockSize];
+    if (diff != top_diff + offset) {
+      caffe_copy(n, top_diff + offset, diff);
+    }
+    for (int i = num_layers - 1; i >= 0; --i) {
+      layers_[i]->Backward_cpu_fused(values[i], values[i + 1], diff, offset,
+          offset + n);
+    }
+  }
+}
+
+template <typename Dtype>
+void ElementwiseChainLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  bool param_propagate_down = false;
+  for (int i = 0; i < layers_.size(); ++i) {
+    for (int j = 0; j < layers_[i]->blobs().size(); ++j) {
+      param_propagate_down |= layers_[i]->param_propagate_down(j);
+    }
+  }
+  if (!propagate_down[0] && !param_propagate_down) {
+    return;
+  }
+  const int count = bottom[0]->count();
+  for (int i = 0; i < layers_.size(); ++i) {
+    layers_[i]->Forward_cpu_fused_begin(*bottom[0], false);
+  }
+  const bool in_place = bottom[0] == top[0];
+  CHECK(!in_place || keep_input_)
+      << "In-place ElementwiseChain did not keep its input for Backward.";
+  const Dtype* bottom_data = (in_place ? &input_ : bottom[0])->cpu_data();
+  const Dtype* top_data = top[0]->cpu_data();
+  const Dtype* top_diff = top[0]->cpu_diff();
+  Dtype* bottom_diff = propagate_down[0] ? bottom[0]->mutable_cpu_diff() : NULL;
+  const int num_blocks = (count + kBlockSize - 1) / kBlockSize;
+  if (param_propagate_down) {
+    // The layers add to their parameter gradients, one block at a time.
+    backward_cpu_blocks(bottom_data, top_data, top_diff, bottom_diff, count,
+        0, num_blocks);
+  } else {
+    parallel_for(0, num_blocks, 4, boost::bind(
+        &ElementwiseChainLayer<Dtype>::backward_cpu_blocks, this,
+        bottom_data, top_data, top_diff, bottom_diff, count, _1, _2));
+  }
+}
+
+INSTANTIATE_CLASS(ElementwiseChainLayer);
+
+}  // namespace caffe
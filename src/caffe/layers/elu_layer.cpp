@@ -37,6 +37,25 @@ void ELULayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
 }
 
 
+template <typename Dtype>
+void ELULayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  Dtype alpha = this->layer_param_.elu_param().alpha();
+  for (int i = 0; i < end - begin; ++i) {
+    data[i] = std::max(data[i], Dtype(0))
+        + alpha * (exp(std::min(data[i], Dtype(0))) - Dtype(1));
+  }
+}
+
+template <typename Dtype>
+void ELULayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  Dtype alpha = this->layer_param_.elu_param().alpha();
+  for (int i = 0; i < end - begin; ++i) {
+    diff[i] *= (bottom_data[i] > 0)
+        + (alpha + top_data[i]) * (bottom_data[i] <= 0);
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(ELULayer);
 #endif
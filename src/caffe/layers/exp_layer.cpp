@@ -58,6 +58,28 @@ void ExpLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   }
 }
 
+template <typename Dtype>
+void ExpLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  const int count = end - begin;
+  if (inner_scale_ != Dtype(1)) {
+    caffe_scal(count, inner_scale_, data);
+  }
+  caffe_exp(count, data, data);
+  if (outer_scale_ != Dtype(1)) {
+    caffe_scal(count, outer_scale_, data);
+  }
+}
+
+template <typename Dtype>
+void ExpLayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  const int count = end - begin;
+  caffe_mul(count, top_data, diff, diff);
+  if (inner_scale_ != Dtype(1)) {
+    caffe_scal(count, inner_scale_, diff);
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(ExpLayer);
 #endif
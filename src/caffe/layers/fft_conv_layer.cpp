@@ -0,0 +1,232 @@
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "caffe/layers/fft_conv_layer.hpp"
+#include "caffe/util/fft_conv.hpp"
+#include "caffe/util/math_functions.hpp"
+#include "caffe/util/reduced_precision.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+namespace {
+
+// Estimates the multiply-adds of the FFT convolution of one image and group:
+// a 2D FFT of n points takes about 2.5 n log2(n), a complex multiply-add 4.
+double FftOps(const int channels, const int num_output, const int output_h,
+    const int output_w, const int extent_h, const int extent_w,
+    const int fft_h, const int fft_w) {
+  const int tile_h = fft_h - extent_h + 1;
+  const int tile_w = fft_w - extent_w + 1;
+  const double tiles = static_cast<double>((output_h + tile_h - 1) / tile_h) *
+      ((output_w + tile_w - 1) / tile_w);
+  const double fft_size = static_cast<double>(fft_h) * fft_w;
+  return tiles * ((channels + num_output) * 2.5 * fft_size *
+      std::log(fft_size) / std::log(2.) +
+      4. * channels * num_output * fft_size);
+}
+
+}  // namespace
+
+template <typename Dtype>
+void FFTConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  use_fft_ = false;
+  use_fft_backward_ = false;
+  if (this->num_spatial_axes_ != 2 || stride[0] != 1 || stride[1] != 1) {
+    return;
+  }
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int extent_h = dilation[0] * (kernel[0] - 1) + 1;
+  const int extent_w = dilation[1] * (kernel[1] - 1) + 1;
+  const int output_h = this->output_shape_[0];
+  const int output_w = this->output_shape_[1];
+  const int fft_h = fft_conv_size(output_h, extent_h);
+  const int fft_w = fft_conv_size(output_w, extent_w);
+  const double gemm_ops = static_cast<double>(in_channels) * out_channels *
+      kernel[0] * kernel[1] * output_h * output_w;
+  use_fft_ = FftOps(in_channels, out_channels, output_h, output_w, extent_h,
+      extent_w, fft_h, fft_w) < gemm_ops;
+  if (!use_fft_) {
+    return;
+  }
+  if (fft_h != fft_h_ || fft_w != fft_w_) {
+    fft_h_ = fft_h;
+    fft_w_ = fft_w;
+    transformed_valid_ = false;
+  }
+  use_fft_backward_ = pad[0] < extent_h && pad[1] < extent_w;
+  if (use_fft_backward_) {
+    const int backward_h = fft_conv_size(this->input_shape(1), extent_h);
+    const int backward_w = fft_conv_size(this->input_shape(2), extent_w);
+    if (backward_h != fft_backward_h_ || backward_w != fft_backward_w_) {
+      fft_backward_h_ = backward_h;
+      fft_backward_w_ = backward_w;
+      flipped_valid_ = false;
+    }
+  }
+}
+
+template <typename Dtype>
+const Dtype* FFTConvolutionLayer<Dtype>::transformed_weights(bool flipped) {
+  const Blob<Dtype>& weights = *this->blobs_[0];
+  const SyncedMemory* memory = weights.data().get();
+  if (memory != weight_memory_ || memory->version() != weight_version_) {
+    weight_memory_ = memory;
+    weight_version_ = memory->version();
+    transformed_valid_ = false;
+    flipped_valid_ = false;
+  }
+  Blob<Dtype>& transformed = flipped ? flipped_weights_ : transformed_weights_;
+  bool& valid = flipped ? flipped_valid_ : transformed_valid_;
+  if (!valid) {
+    // Weights held at 16 bits are widened here only, not on every pass.
+    const uint16_t* reduced_weight = weights.reduced_cpu_data();
+    vector<Dtype> widened(reduced_weight ? weights.count() : 0);
+    if (reduced_weight) {
+      caffe_cpu_expand_precision(weights.count(), reduced_weight,
+          weights.data_storage(), &widened[0]);
+    }
+    const Dtype* weight = reduced_weight ? &widened[0] : weights.cpu_data();
+    const int in_channels = this->channels_ / this->group_;
+    const int out_channels = this->num_output_ / this->group_;
+    const int fft_h = flipped ? fft_backward_h_ : fft_h_;
+    const int fft_w = flipped ? fft_backward_w_ : fft_w_;
+    const int* kernel = this->kernel_shape_.cpu_data();
+    const int* dilation = this->dilation_.cpu_data();
+    const int group_size = fft_conv_transformed_size(out_channels,
+        in_channels, fft_h, fft_w);
+    transformed.Reshape(vector<int>(1, this->group_ * group_size));
+    for (int g = 0; g < this->group_; ++g) {
+      fft_conv_transform_weights_cpu(
+          weight + g * this->weight_offset_, out_channels,
+          in_channels, kernel[0], kernel[1], dilation[0], dilation[1], fft_h,
+          fft_w, flipped, transformed.mutable_cpu_data() + g * group_size);
+    }
+    valid = true;
+  }
+  return transformed.cpu_data();
+}
+
+template <typename Dtype>
+void FFTConvolutionLayer<Dtype>::fft_cpu_shares(bool backward,
+    const Dtype* input, const Dtype* transformed, Dtype* output,
+    Dtype* workspace, int begin, int end) {
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int height = this->input_shape(1);
+  const int width = this->input_shape(2);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  const int extent_h = dilation[0] * (kernel[0] - 1) + 1;
+  const int extent_w = dilation[1] * (kernel[1] - 1) + 1;
+  const int fft_h = backward ? fft_backward_h_ : fft_h_;
+  const int fft_w = backward ? fft_backward_w_ : fft_w_;
+  const int group_size = fft_conv_transformed_size(out_channels, in_channels,
+      fft_h, fft_w);
+  const int workspace_size = fft_conv_workspace_size(
+      backward ? out_channels : in_channels, fft_h, fft_w);
+  const int items = this->num_ * this->group_;
+  for (int share = begin; share < end; ++share) {
+    Dtype* share_workspace = workspace + share * workspace_size;
+    for (int i = share * items / this->num_shares_;
+         i < (share + 1) * items / this->num_shares_; ++i) {
+      const int n = i / this->group_;
+      const int g = i % this->group_;
+      const int bottom_offset = n * this->bottom_dim_ +
+          g * in_channels * height * width;
+      const int top_offset = n * this->top_dim_ +
+          g * out_channels * this->out_spatial_dim_;
+      if (!backward) {
+        fft_conv_cpu(input + bottom_offset, in_channels, height, width,
+            pad[0], pad[1], extent_h, extent_w, fft_h, fft_w,
+            transformed + g * group_size, out_channels, output + top_offset,
+            share_workspace);
+      } else {
+        // The top diff correlated with the flipped filters, padded so that
+        // the result has the bottom's shape.
+        fft_conv_cpu(input + top_offset, out_channels,
+            this->output_shape_[0], this->output_shape_[1],
+            extent_h - 1 - pad[0], extent_w - 1 - pad[1], extent_h, extent_w,
+            fft_h, fft_w, transformed + g * group_size, in_channels,
+            output + bottom_offset, share_workspace);
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+int FFTConvolutionLayer<Dtype>::num_fft_shares() const {
+  // The (image, group) pairs are split into shares that run concurrently,
+  // each with its own workspace, as in the other CPU engines; batch_parallel
+  // only applies to the im2col path.
+  const int items = this->num_ * this->group_;
+  return ThreadPool::in_parallel_region() ? 1 :
+      std::max(1, std::min(items, Caffe::thread_pool()->num_threads()));
+}
+
+template <typename Dtype>
+void FFTConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (!use_fft_) {
+    ConvolutionLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  const Dtype* transformed = transformed_weights(false);
+  this->num_shares_ = num_fft_shares();
+  const int workspace_size = fft_conv_workspace_size(
+      this->channels_ / this->group_, fft_h_, fft_w_);
+  for (int i = 0; i < bottom.size(); ++i) {
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    Dtype* top_data = top[i]->mutable_cpu_data_uninitialized();
+    this->forward_cpu_activations_begin(*top[i]);
+    Dtype* workspace = this->scratch_cpu(this->num_shares_ * workspace_size);
+    parallel_for(0, this->num_shares_, 1, boost::bind(
+        &FFTConvolutionLayer<Dtype>::fft_cpu_shares, this, false,
+        bottom_data, transformed, top_data, workspace, _1, _2));
+    for (int n = 0; n < this->num_; ++n) {
+      this->forward_cpu_epilogue(top_data, n);
+    }
+  }
+}
+
+template <typename Dtype>
+void FFTConvolutionLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  if (!use_fft_backward_) {
+    ConvolutionLayer<Dtype>::Backward_cpu(top, propagate_down, bottom);
+    return;
+  }
+  // Bias and weight gradients through im2col.
+  ConvolutionLayer<Dtype>::Backward_cpu(top,
+      vector<bool>(propagate_down.size(), false), bottom);
+  this->num_shares_ = num_fft_shares();
+  const int workspace_size = fft_conv_workspace_size(
+      this->num_output_ / this->group_, fft_backward_h_, fft_backward_w_);
+  for (int i = 0; i < top.size(); ++i) {
+    if (!propagate_down[i]) {
+      continue;
+    }
+    const Dtype* transformed = transformed_weights(true);
+    const Dtype* top_diff = top[i]->cpu_diff();
+    Dtype* bottom_diff = bottom[i]->mutable_cpu_diff();
+    Dtype* workspace = this->scratch_cpu(this->num_shares_ * workspace_size);
+    parallel_for(0, this->num_shares_, 1, boost::bind(
+        &FFTConvolutionLayer<Dtype>::fft_cpu_shares, this, true, top_diff,
+        transformed, bottom_diff, workspace, _1, _2));
+  }
+}
+
+INSTANTIATE_CLASS(FFTConvolutionLayer);
+
+}  // namespace caffe
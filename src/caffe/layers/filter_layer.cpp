@@ -54,6 +54,17 @@ void FilterLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
     for (int ts = 1; ts < num_axes; ++ts)
       shape_top[ts] = bottom[t]->shape(ts);
     top[t]->Reshape(shape_top);
+    if (this->share_bottom_data_ &&
+        static_cast<int>(indices_to_forward_.size()) == bottom[t]->shape(0)) {
+      // Every item is selected and forwarded as it is, with no copy.
+      top[t]->ShareData(*bottom[t]);
+      top[t]->ShareDiff(*bottom[t]);
+    } else if (top[t]->data() == bottom[t]->data()) {
+      // Shared for an earlier selection: the top needs memory of its own.
+      Blob<Dtype> own(shape_top);
+      top[t]->ShareData(own);
+      top[t]->ShareDiff(own);
+    }
   }
 }
 
@@ -63,6 +74,7 @@ void FilterLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   int new_tops_num = indices_to_forward_.size();
   // forward all filtered items for all bottoms but the Selector (bottom[last])
   for (int t = 0; t < top.size(); ++t) {
+    if (top[t]->data() == bottom[t]->data()) { continue; }
     const Dtype* bottom_data = bottom[t]->cpu_data();
     Dtype* top_data = top[t]->mutable_cpu_data();
     int dim = bottom[t]->count() / bottom[t]->shape(0);
@@ -85,7 +97,7 @@ void FilterLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   for (int i = 0; i < top.size(); i++) {
     // bottom[last] is the selector and never needs backpropagation
     // so we can iterate over top vector because top.size() == bottom.size() -1
-    if (propagate_down[i]) {
+    if (propagate_down[i] && top[i]->diff() != bottom[i]->diff()) {
       const int dim = top[i]->count() / top[i]->shape(0);
       int next_to_backward_offset = 0;
       int batch_offset = 0;
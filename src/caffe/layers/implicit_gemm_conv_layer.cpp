@@ -0,0 +1,124 @@
+#include <vector>
+
+#include "caffe/layers/implicit_gemm_conv_layer.hpp"
+#include "caffe/util/implicit_gemm.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void ImplicitGemmConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  // The base class reshapes the column buffer too, but it only takes memory
+  // once touched, which this layer never does on its own path.
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  use_implicit_gemm_ = this->num_spatial_axes_ == 2 &&
+      !this->force_nd_im2col_ && !this->is_1x1_;
+  if (use_implicit_gemm_) {
+    const int kernel_dim = this->blobs_[0]->count(1);
+    packed_weights_.Reshape(vector<int>(1, this->group_ *
+        implicit_gemm_packed_size(this->num_output_ / this->group_,
+            kernel_dim)));
+  }
+}
+
+template <typename Dtype>
+void ImplicitGemmConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (!use_implicit_gemm_) {
+    ConvolutionLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int kernel_dim = this->blobs_[0]->count(1);
+  const int packed_offset = implicit_gemm_packed_size(out_channels,
+      kernel_dim);
+  const int height = this->input_shape(1);
+  const int width = this->input_shape(2);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  // Packing is linear in the weights, so redo it on every pass rather than
+  // track weight updates.
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  Dtype* packed = packed_weights_.mutable_cpu_data_uninitialized();
+  for (int g = 0; g < this->group_; ++g) {
+    implicit_gemm_pack_weights_cpu(weight + g * this->weight_offset_,
+        out_channels, kernel_dim, packed + g * packed_offset);
+  }
+  for (int i = 0; i < bottom.size(); ++i) {
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    Dtype* top_data = top[i]->mutable_cpu_data_uninitialized();
+    this->forward_cpu_activations_begin(*top[i]);
+    for (int n = 0; n < this->num_; ++n) {
+      for (int g = 0; g < this->group_; ++g) {
+        implicit_gemm_conv_cpu(bottom_data + n * this->bottom_dim_ +
+            g * in_channels * height * width, in_channels, height, width,
+            kernel[0], kernel[1], pad[0], pad[1], stride[0], stride[1],
+            dilation[0], dilation[1], packed + g * packed_offset,
+            out_channels, top_data + n * this->top_dim_ +
+            g * out_channels * this->out_spatial_dim_);
+      }
+      this->forward_cpu_epilogue(top_data, n);
+    }
+  }
+}
+
+template <typename Dtype>
+void ImplicitGemmConvolutionLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  if (!use_implicit_gemm_) {
+    ConvolutionLayer<Dtype>::Backward_cpu(top, propagate_down, bottom);
+    return;
+  }
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int height = this->input_shape(1);
+  const int width = this->input_shape(2);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  for (int i = 0; i < top.size(); ++i) {
+    const Dtype* top_diff = top[i]->cpu_diff();
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    // Bias gradient, if necessary.
+    if (this->bias_term_ && this->param_propagate_down_[1]) {
+      Dtype* bias_diff = this->blobs_[1]->mutable_cpu_diff();
+      for (int n = 0; n < this->num_; ++n) {
+        this->backward_cpu_bias(bias_diff, top_diff + n * this->top_dim_);
+      }
+    }
+    for (int n = 0; n < this->num_; ++n) {
+      for (int g = 0; g < this->group_; ++g) {
+        const int bottom_offset = n * this->bottom_dim_ +
+            g * in_channels * height * width;
+        const int top_offset = n * this->top_dim_ +
+            g * out_channels * this->out_spatial_dim_;
+        // Gradient w.r.t. weight. Note that we accumulate diffs.
+        if (this->param_propagate_down_[0]) {
+          implicit_gemm_conv_weight_cpu(bottom_data + bottom_offset,
+              in_channels, height, width, kernel[0], kernel[1], pad[0],
+              pad[1], stride[0], stride[1], dilation[0], dilation[1],
+              top_diff + top_offset, out_channels,
+              this->blobs_[0]->mutable_cpu_diff() + g * this->weight_offset_);
+        }
+        // Gradient w.r.t. bottom data, if necessary.
+        if (propagate_down[i]) {
+          implicit_gemm_conv_data_cpu(top_diff + top_offset, in_channels,
+              height, width, kernel[0], kernel[1], pad[0], pad[1], stride[0],
+              stride[1], dilation[0], dilation[1],
+              weight + g * this->weight_offset_, out_channels,
+              bottom[i]->mutable_cpu_diff() + bottom_offset);
+        }
+      }
+    }
+  }
+}
+
+INSTANTIATE_CLASS(ImplicitGemmConvolutionLayer);
+
+}  // namespace caffe
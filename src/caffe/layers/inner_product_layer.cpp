@@ -1,8 +1,12 @@
+#include <boost/bind.hpp>
+#include <algorithm>
 #include <vector>
 
 #include "caffe/filler.hpp"
 #include "caffe/layers/inner_product_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/reduced_precision.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
@@ -80,15 +84,77 @@ void InnerProductLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
   }
 }
 
+template <typename Dtype>
+void InnerProductLayer<Dtype>::forward_cpu_reduced_panels(
+    const Dtype* bottom_data, Dtype* top_data, int panel_cols, int begin,
+    int end) {
+  const uint16_t* weight = this->blobs_[0]->reduced_cpu_data();
+  const StoragePrecision precision = this->blobs_[0]->data_storage();
+  const Dtype* bias = bias_term_ ? this->blobs_[1]->cpu_data() : NULL;
+  vector<Dtype> panel(K_ * panel_cols);
+  vector<Dtype> out(M_ * panel_cols);
+  for (int p = begin; p < end; ++p) {
+    const int j0 = p * panel_cols;
+    const int cols = std::min(panel_cols, N_ - j0);
+    if (transpose_) {
+      // K_ x N_ weights: a slice of each row makes up the K_ x cols panel.
+      for (int k = 0; k < K_; ++k) {
+        caffe_cpu_expand_precision(cols, weight + k * N_ + j0, precision,
+            &panel[k * cols]);
+      }
+    } else {
+      // N_ x K_ weights: the panel is cols consecutive rows.
+      caffe_cpu_expand_precision(cols * K_, weight + j0 * K_, precision,
+          &panel[0]);
+    }
+    caffe_cpu_gemm<Dtype>(CblasNoTrans, transpose_ ? CblasNoTrans : CblasTrans,
+        M_, cols, K_, (Dtype)1., bottom_data, &panel[0], (Dtype)0., &out[0]);
+    for (int i = 0; i < M_; ++i) {
+      Dtype* top_row = top_data + i * N_ + j0;
+      const Dtype* out_row = &out[i * cols];
+      for (int j = 0; j < cols; ++j) {
+        top_row[j] = out_row[j] + (bias ? bias[j0 + j] : Dtype(0));
+      }
+      this->forward_cpu_activations(top_data, i * N_ + j0, i * N_ + j0 + cols);
+    }
+  }
+}
+
 template <typename Dtype>
 void InnerProductLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
   const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  Dtype* top_data = top[0]->mutable_cpu_data_uninitialized();
+  this->forward_cpu_activations_begin(*top[0]);
+  if (this->blobs_[0]->reduced_cpu_data()) {
+    // 16-bit weights are read as they are, a panel of about 256KB of full
+    // precision values at a time, so that the whole matrix is never widened
+    // and the memory traffic of the weights stays halved.
+    const int panel_cols = std::max(1, std::min(N_, 65536 / K_));
+    const int num_panels = (N_ + panel_cols - 1) / panel_cols;
+    parallel_for(0, num_panels, 1, boost::bind(
+        &InnerProductLayer<Dtype>::forward_cpu_reduced_panels, this,
+        bottom_data, top_data, panel_cols, _1, _2));
+    return;
+  }
   const Dtype* weight = this->blobs_[0]->cpu_data();
   caffe_cpu_gemm<Dtype>(CblasNoTrans, transpose_ ? CblasNoTrans : CblasTrans,
       M_, N_, K_, (Dtype)1.,
       bottom_data, weight, (Dtype)0., top_data);
+  if (this->runs_fused_activations()) {
+    // The bias and the activations in one pass, a row at a time.
+    const Dtype* bias = bias_term_ ? this->blobs_[1]->cpu_data() : NULL;
+    for (int i = 0; i < M_; ++i) {
+      Dtype* top_row = top_data + i * N_;
+      if (bias) {
+        for (int j = 0; j < N_; ++j) {
+          top_row[j] += bias[j];
+        }
+      }
+      this->forward_cpu_activations(top_data, i * N_, (i + 1) * N_);
+    }
+    return;
+  }
   if (bias_term_) {
     caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, M_, N_, 1, (Dtype)1.,
         bias_multiplier_.cpu_data(),
@@ -130,12 +196,12 @@ void InnerProductLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
       caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasTrans,
           M_, K_, N_,
           (Dtype)1., top_diff, this->blobs_[0]->cpu_data(),
-          (Dtype)0., bottom[0]->mutable_cpu_diff());
+          (Dtype)0., bottom[0]->mutable_cpu_diff_uninitialized());
     } else {
       caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans,
           M_, K_, N_,
           (Dtype)1., top_diff, this->blobs_[0]->cpu_data(),
-          (Dtype)0., bottom[0]->mutable_cpu_diff());
+          (Dtype)0., bottom[0]->mutable_cpu_diff_uninitialized());
     }
   }
 }
@@ -145,6 +211,5 @@ STUB_GPU(InnerProductLayer);
 #endif
 
 INSTANTIATE_CLASS(InnerProductLayer);
-REGISTER_LAYER_CLASS(InnerProduct);
 
 }  // namespace caffe
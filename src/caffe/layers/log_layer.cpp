@@ -75,6 +75,30 @@ void LogLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   caffe_mul(count, top_diff, bottom_diff, bottom_diff);
 }
 
+template <typename Dtype>
+void LogLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  const int count = end - begin;
+  if (input_scale_ != Dtype(1)) {
+    caffe_scal(count, input_scale_, data);
+  }
+  if (input_shift_ != Dtype(0)) {
+    caffe_add_scalar(count, input_shift_, data);
+  }
+  caffe_log(count, data, data);
+  if (base_scale_ != Dtype(1)) {
+    caffe_scal(count, base_scale_, data);
+  }
+}
+
+template <typename Dtype>
+void LogLayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  for (int i = 0; i < end - begin; ++i) {
+    diff[i] *= backward_num_scale_
+        / (input_scale_ * bottom_data[i] + input_shift_);
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(LogLayer);
 #endif
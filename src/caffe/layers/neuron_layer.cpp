@@ -8,6 +8,8 @@ template <typename Dtype>
 void NeuronLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
   top[0]->ReshapeLike(*bottom[0]);
+  // Element-wise, so any memory layout goes through.
+  top[0]->set_channel_block(bottom[0]->channel_block());
 }
 
 INSTANTIATE_CLASS(NeuronLayer);
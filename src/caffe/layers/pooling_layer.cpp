@@ -105,6 +105,11 @@ void PoolingLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
   }
   top[0]->Reshape(bottom[0]->num(), channels_, pooled_height_,
       pooled_width_);
+  // Pooling is per channel, so the top keeps the layout of the bottom.
+  if (bottom[0]->channel_block() > 0) {
+    CHECK_EQ(1, top.size()) << "No mask top in the blocked layout.";
+  }
+  top[0]->set_channel_block(bottom[0]->channel_block());
   if (top.size() > 1) {
     top[1]->ReshapeLike(*top[0]);
   }
@@ -127,8 +132,12 @@ void PoolingLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
 template <typename Dtype>
 void PoolingLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
+  if (bottom[0]->channel_block() > 0) {
+    Forward_blocked_cpu(bottom, top);
+    return;
+  }
   const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  Dtype* top_data = top[0]->mutable_cpu_data_uninitialized();
   const int top_count = top[0]->count();
   // We'll output the mask to top[1] if it's of size >1.
   const bool use_top_mask = top.size() > 1;
@@ -140,10 +149,10 @@ void PoolingLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   case PoolingParameter_PoolMethod_MAX:
     // Initialize
     if (use_top_mask) {
-      top_mask = top[1]->mutable_cpu_data();
+      top_mask = top[1]->mutable_cpu_data_uninitialized();
       caffe_set(top_count, Dtype(-1), top_mask);
     } else {
-      mask = max_idx_.mutable_cpu_data();
+      mask = max_idx_.mutable_cpu_data_uninitialized();
       caffe_set(top_count, -1, mask);
     }
     caffe_set(top_count, Dtype(-FLT_MAX), top_data);
@@ -226,12 +235,70 @@ void PoolingLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   }
 }
 
+// The blocked layout keeps the channels of a block innermost, so every
+// pooling window reduces block-wide vectors of contiguous values.
+template <typename Dtype>
+void PoolingLayer<Dtype>::Forward_blocked_cpu(
+      const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  const int block = bottom[0]->channel_block();
+  const int num_blocks = bottom[0]->num() * channels_ / block;
+  const int bottom_offset = height_ * width_ * block;
+  const int top_offset = pooled_height_ * pooled_width_ * block;
+  const bool max_pool = this->layer_param_.pooling_param().pool() ==
+      PoolingParameter_PoolMethod_MAX;
+  CHECK(max_pool || this->layer_param_.pooling_param().pool() ==
+      PoolingParameter_PoolMethod_AVE)
+      << "Only MAX and AVE pooling take the blocked layout.";
+  const Dtype* bottom_data = bottom[0]->cpu_data();
+  Dtype* top_data = top[0]->mutable_cpu_data_uninitialized();
+  for (int b = 0; b < num_blocks; ++b) {
+    for (int ph = 0; ph < pooled_height_; ++ph) {
+      for (int pw = 0; pw < pooled_width_; ++pw) {
+        int hstart = ph * stride_h_ - pad_h_;
+        int wstart = pw * stride_w_ - pad_w_;
+        int hend = min(hstart + kernel_h_, height_ + pad_h_);
+        int wend = min(wstart + kernel_w_, width_ + pad_w_);
+        const int pool_size = (hend - hstart) * (wend - wstart);
+        hstart = max(hstart, 0);
+        wstart = max(wstart, 0);
+        hend = min(hend, height_);
+        wend = min(wend, width_);
+        Dtype* out = top_data + (ph * pooled_width_ + pw) * block;
+        caffe_set(block, max_pool ? Dtype(-FLT_MAX) : Dtype(0), out);
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            const Dtype* in = bottom_data + (h * width_ + w) * block;
+            if (max_pool) {
+              for (int k = 0; k < block; ++k) {
+                out[k] = max(out[k], in[k]);
+              }
+            } else {
+              for (int k = 0; k < block; ++k) {
+                out[k] += in[k];
+              }
+            }
+          }
+        }
+        if (!max_pool) {
+          for (int k = 0; k < block; ++k) {
+            out[k] /= pool_size;
+          }
+        }
+      }
+    }
+    bottom_data += bottom_offset;
+    top_data += top_offset;
+  }
+}
+
 template <typename Dtype>
 void PoolingLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom) {
   if (!propagate_down[0]) {
     return;
   }
+  CHECK_EQ(0, bottom[0]->channel_block())
+      << "The blocked layout is for inference only.";
   const Dtype* top_diff = top[0]->cpu_diff();
   Dtype* bottom_diff = bottom[0]->mutable_cpu_diff();
   // Different pooling methods. We explicitly do the switch outside the for
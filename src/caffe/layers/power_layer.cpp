@@ -92,6 +92,46 @@ void PowerLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   }
 }
 
+template <typename Dtype>
+void PowerLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  const int count = end - begin;
+  if (diff_scale_ == Dtype(0)) {
+    Dtype value = (power_ == 0) ? Dtype(1) : pow(shift_, power_);
+    caffe_set(count, value, data);
+    return;
+  }
+  if (scale_ != Dtype(1)) {
+    caffe_scal(count, scale_, data);
+  }
+  if (shift_ != Dtype(0)) {
+    caffe_add_scalar(count, shift_, data);
+  }
+  if (power_ != Dtype(1)) {
+    caffe_powx(count, data, power_, data);
+  }
+}
+
+template <typename Dtype>
+void PowerLayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  const int count = end - begin;
+  if (diff_scale_ == Dtype(0) || power_ == Dtype(1)) {
+    caffe_scal(count, diff_scale_, diff);
+  } else if (power_ == Dtype(2)) {
+    for (int i = 0; i < count; ++i) {
+      diff[i] *= diff_scale_ * scale_ * bottom_data[i] + diff_scale_ * shift_;
+    }
+  } else if (shift_ == Dtype(0)) {
+    for (int i = 0; i < count; ++i) {
+      diff[i] *= power_ * top_data[i] / bottom_data[i];
+    }
+  } else {
+    for (int i = 0; i < count; ++i) {
+      diff[i] *= diff_scale_ * top_data[i] / (shift_ + scale_ * bottom_data[i]);
+    }
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(PowerLayer);
 #endif
@@ -88,6 +88,54 @@ void PReLULayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   }
 }
 
+template <typename Dtype>
+void PReLULayer<Dtype>::Forward_cpu_fused_begin(const Blob<Dtype>& blob,
+    bool keep_input) {
+  // Fused layers work in place, so if Backward_cpu follows it reads the
+  // inputs from bottom_memory_, which is taken here rather than from several
+  // threads.
+  fused_dim_ = blob.count(2);
+  fused_channels_ = blob.channels();
+  fused_bottom_memory_ = NULL;
+  if (keep_input) {
+    bottom_memory_.ReshapeLike(blob);
+    fused_bottom_memory_ = bottom_memory_.mutable_cpu_data();
+  }
+}
+
+template <typename Dtype>
+void PReLULayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  const Dtype* slope_data = this->blobs_[0]->cpu_data();
+  if (fused_bottom_memory_) {
+    caffe_copy(end - begin, data, fused_bottom_memory_ + begin);
+  }
+  const int div_factor = channel_shared_ ? fused_channels_ : 1;
+  for (int i = 0; i < end - begin; ++i) {
+    int c = ((begin + i) / fused_dim_) % fused_channels_ / div_factor;
+    data[i] = std::max(data[i], Dtype(0))
+        + slope_data[c] * std::min(data[i], Dtype(0));
+  }
+}
+
+template <typename Dtype>
+void PReLULayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  const Dtype* slope_data = this->blobs_[0]->cpu_data();
+  const int div_factor = channel_shared_ ? fused_channels_ : 1;
+  // As in Backward_cpu, the slope gradient takes the top diff.
+  if (this->param_propagate_down_[0]) {
+    Dtype* slope_diff = this->blobs_[0]->mutable_cpu_diff();
+    for (int i = 0; i < end - begin; ++i) {
+      int c = ((begin + i) / fused_dim_) % fused_channels_ / div_factor;
+      slope_diff[c] += diff[i] * bottom_data[i] * (bottom_data[i] <= 0);
+    }
+  }
+  for (int i = 0; i < end - begin; ++i) {
+    int c = ((begin + i) / fused_dim_) % fused_channels_ / div_factor;
+    diff[i] *= (bottom_data[i] > 0) + slope_data[c] * (bottom_data[i] <= 0);
+  }
+}
+
 template <typename Dtype>
 void PReLULayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
     const vector<bool>& propagate_down,
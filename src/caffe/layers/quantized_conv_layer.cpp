@@ -0,0 +1,143 @@
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "caffe/layers/quantized_conv_layer.hpp"
+#include "caffe/util/im2col.hpp"
+#include "caffe/util/int8_gemm.hpp"
+#include "caffe/util/reduced_precision.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void QuantizedConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  use_int8_ = this->num_spatial_axes_ == 2 && !this->force_nd_im2col_;
+  if (use_int8_) {
+    weights_int8_.resize(this->blobs_[0]->count());
+    bottom_int8_.resize(this->num_ * this->bottom_dim_);
+    weight_scale_.Reshape(vector<int>(1, this->num_output_));
+    output_scale_.Reshape(vector<int>(1, this->num_output_));
+  }
+}
+
+template <typename Dtype>
+void QuantizedConvolutionLayer<Dtype>::QuantizeWeights() {
+  const SyncedMemory* memory = this->blobs_[0]->data().get();
+  if (memory == weight_memory_ && memory->version() == weight_version_) {
+    return;
+  }
+  // Weights held at 16 bits are widened here only, not on every pass.
+  const Blob<Dtype>& weights = *this->blobs_[0];
+  const uint16_t* reduced_weight = weights.reduced_cpu_data();
+  vector<Dtype> widened(reduced_weight ? weights.count() : 0);
+  if (reduced_weight) {
+    caffe_cpu_expand_precision(weights.count(), reduced_weight,
+        weights.data_storage(), &widened[0]);
+  }
+  int8_quantize_rows_cpu(this->num_output_, weights.count(1),
+      reduced_weight ? &widened[0] : weights.cpu_data(),
+      weight_scale_.mutable_cpu_data(), &weights_int8_[0]);
+  weight_memory_ = memory;
+  weight_version_ = memory->version();
+}
+
+template <typename Dtype>
+int QuantizedConvolutionLayer<Dtype>::share_buffer_size() const {
+  const int kernel_dim = this->blobs_[0]->count(1);
+  return (this->is_1x1_ ? 0 : kernel_dim * this->out_spatial_dim_) +
+      int8_packed_size(kernel_dim, this->out_spatial_dim_);
+}
+
+template <typename Dtype>
+void QuantizedConvolutionLayer<Dtype>::forward_cpu_int8(Dtype* top_data,
+    int begin, int end) {
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int kernel_dim = this->blobs_[0]->count(1);
+  const int height = this->input_shape(1);
+  const int width = this->input_shape(2);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  const Dtype* scale = output_scale_.cpu_data();
+  const Dtype* bias = this->bias_term_ ? this->blobs_[1]->cpu_data() : NULL;
+  const int items = this->num_ * this->group_;
+  for (int share = begin; share < end; ++share) {
+    int8_t* col_buffer = &buffer_int8_[share * share_buffer_size()];
+    int8_t* packed = col_buffer +
+        (this->is_1x1_ ? 0 : kernel_dim * this->out_spatial_dim_);
+    for (int i = share * items / this->num_shares_;
+         i < (share + 1) * items / this->num_shares_; ++i) {
+      const int n = i / this->group_;
+      const int g = i % this->group_;
+      const int8_t* im = &bottom_int8_[n * this->bottom_dim_ +
+          g * in_channels * height * width];
+      const int8_t* col = im;
+      if (!this->is_1x1_) {
+        im2col_cpu(im, in_channels, height, width, kernel[0], kernel[1],
+            pad[0], pad[1], stride[0], stride[1], dilation[0], dilation[1],
+            col_buffer);
+        col = col_buffer;
+      }
+      int8_pack_cpu(kernel_dim, this->out_spatial_dim_, col,
+          this->out_spatial_dim_, 1, packed);
+      const int top_offset = n * this->top_dim_ +
+          g * out_channels * this->out_spatial_dim_;
+      int8_gemm_cpu(out_channels, this->out_spatial_dim_, kernel_dim,
+          &weights_int8_[g * this->weight_offset_], packed,
+          scale + g * out_channels, bias ? bias + g * out_channels : NULL,
+          false, top_data + top_offset);
+      this->forward_cpu_activations(top_data, top_offset,
+          top_offset + out_channels * this->out_spatial_dim_);
+    }
+  }
+}
+
+template <typename Dtype>
+void QuantizedConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (!use_int8_) {
+    ConvolutionLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  QuantizeWeights();
+  const Dtype* weight_scale = weight_scale_.cpu_data();
+  const float calibrated_range =
+      this->layer_param_.quantization_param().bottom_range();
+  // The (image, group) pairs are split into shares that run concurrently,
+  // each with its own column buffers.
+  const int items = this->num_ * this->group_;
+  this->num_shares_ = ThreadPool::in_parallel_region() ? 1 :
+      std::max(1, std::min(items, Caffe::thread_pool()->num_threads()));
+  buffer_int8_.resize(this->num_shares_ * share_buffer_size());
+  for (int i = 0; i < bottom.size(); ++i) {
+    const int count = bottom[i]->count();
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    const Dtype bottom_scale = int8_scale(calibrated_range > 0 ?
+        Dtype(calibrated_range) : int8_max_abs(count, bottom_data));
+    int8_quantize_cpu(count, bottom_data, bottom_scale, &bottom_int8_[0]);
+    Dtype* output_scale = output_scale_.mutable_cpu_data();
+    for (int o = 0; o < this->num_output_; ++o) {
+      output_scale[o] = Dtype(1) / (bottom_scale * weight_scale[o]);
+    }
+    this->forward_cpu_activations_begin(*top[i]);
+    parallel_for(0, this->num_shares_, 1, boost::bind(
+        &QuantizedConvolutionLayer<Dtype>::forward_cpu_int8, this,
+        top[i]->mutable_cpu_data_uninitialized(), _1, _2));
+  }
+}
+
+template <typename Dtype>
+void QuantizedConvolutionLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  LOG(FATAL) << "INT8 quantization is for inference only.";
+}
+
+INSTANTIATE_CLASS(QuantizedConvolutionLayer);
+
+}  // namespace caffe
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <cmath>
+#include <vector>
+
+#include "caffe/layers/quantized_inner_product_layer.hpp"
+#include "caffe/util/int8_gemm.hpp"
+#include "caffe/util/reduced_precision.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void QuantizedInnerProductLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  InnerProductLayer<Dtype>::Reshape(bottom, top);
+  bottom_int8_.resize(this->M_ * this->K_);
+  weight_scale_.Reshape(vector<int>(1, this->N_));
+  output_scale_.Reshape(vector<int>(1, this->N_));
+}
+
+template <typename Dtype>
+void QuantizedInnerProductLayer<Dtype>::QuantizeWeights() {
+  const SyncedMemory* memory = this->blobs_[0]->data().get();
+  if (memory == weight_memory_ && memory->version() == weight_version_) {
+    return;
+  }
+  // Weights held at 16 bits are widened here only, not on every pass.
+  const Blob<Dtype>& weights = *this->blobs_[0];
+  const uint16_t* reduced_weight = weights.reduced_cpu_data();
+  vector<Dtype> widened(reduced_weight ? weights.count() : 0);
+  if (reduced_weight) {
+    caffe_cpu_expand_precision(weights.count(), reduced_weight,
+        weights.data_storage(), &widened[0]);
+  }
+  const Dtype* weight = reduced_weight ? &widened[0] : weights.cpu_data();
+  // Quantize each output of the weights with its own scale. Weight (o, k) is
+  // at o * K_ + k, or k * N_ + o if transposed.
+  const int output_stride = this->transpose_ ? 1 : this->K_;
+  const int input_stride = this->transpose_ ? this->N_ : 1;
+  std::vector<int8_t> weights_int8(this->K_ * this->N_);
+  Dtype* weight_scale = weight_scale_.mutable_cpu_data();
+  for (int o = 0; o < this->N_; ++o) {
+    const Dtype* w = weight + o * output_stride;
+    Dtype range = 0;
+    for (int k = 0; k < this->K_; ++k) {
+      range = std::max(range, static_cast<Dtype>(
+          std::fabs(w[k * input_stride])));
+    }
+    weight_scale[o] = int8_scale(range);
+    for (int k = 0; k < this->K_; ++k) {
+      const Dtype value = w[k * input_stride];
+      int8_quantize_cpu(1, &value, weight_scale[o],
+          &weights_int8[o * output_stride + k * input_stride]);
+    }
+  }
+  // Packed as the K_ x N_ matrix B of int8_gemm_cpu.
+  weights_packed_.resize(int8_packed_size(this->K_, this->N_));
+  int8_pack_cpu(this->K_, this->N_, &weights_int8[0], input_stride,
+      output_stride, &weights_packed_[0]);
+  weight_memory_ = memory;
+  weight_version_ = memory->version();
+}
+
+template <typename Dtype>
+void QuantizedInnerProductLayer<Dtype>::forward_cpu_rows(Dtype* top_data,
+    int begin, int end) {
+  int8_gemm_cpu(end - begin, this->N_, this->K_,
+      &bottom_int8_[begin * this->K_], &weights_packed_[0],
+      output_scale_.cpu_data(),
+      this->bias_term_ ? this->blobs_[1]->cpu_data() : NULL, true,
+      top_data + begin * this->N_);
+  this->forward_cpu_activations(top_data, begin * this->N_,
+      end * this->N_);
+}
+
+template <typename Dtype>
+void QuantizedInnerProductLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  QuantizeWeights();
+  const float calibrated_range =
+      this->layer_param_.quantization_param().bottom_range();
+  const Dtype* bottom_data = bottom[0]->cpu_data();
+  const Dtype bottom_scale = int8_scale(calibrated_range > 0 ?
+      Dtype(calibrated_range) : int8_max_abs(this->M_ * this->K_,
+      bottom_data));
+  int8_quantize_cpu(this->M_ * this->K_, bottom_data, bottom_scale,
+      &bottom_int8_[0]);
+  const Dtype* weight_scale = weight_scale_.cpu_data();
+  Dtype* output_scale = output_scale_.mutable_cpu_data();
+  for (int o = 0; o < this->N_; ++o) {
+    output_scale[o] = Dtype(1) / (bottom_scale * weight_scale[o]);
+  }
+  this->forward_cpu_activations_begin(*top[0]);
+  parallel_for(0, this->M_, 1, boost::bind(
+      &QuantizedInnerProductLayer<Dtype>::forward_cpu_rows, this,
+      top[0]->mutable_cpu_data_uninitialized(), _1, _2));
+}
+
+template <typename Dtype>
+void QuantizedInnerProductLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  LOG(FATAL) << "INT8 quantization is for inference only.";
+}
+
+INSTANTIATE_CLASS(QuantizedInnerProductLayer);
+
+}  // namespace caffe
@@ -0,0 +1,42 @@
+#include <vector>
+
+#include "caffe/layers/reorder_layer.hpp"
+#include "caffe/util/blocked_layout.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void ReorderLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top) {
+  CHECK_NE(top[0], bottom[0]) << this->type() << " Layer does not "
+      "allow in-place computation.";
+  CHECK_EQ(4, bottom[0]->num_axes()) << "Input must have 4 axes, "
+      << "corresponding to (num, channels, height, width)";
+  top[0]->ReshapeLike(*bottom[0]);
+  top[0]->set_channel_block(
+      this->layer_param_.reorder_param().channel_block());
+}
+
+template <typename Dtype>
+void ReorderLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top) {
+  reorder_channels_cpu(bottom[0]->num(), bottom[0]->channels(),
+      bottom[0]->count(2), bottom[0]->channel_block(), top[0]->channel_block(),
+      bottom[0]->cpu_data(), top[0]->mutable_cpu_data_uninitialized());
+}
+
+template <typename Dtype>
+void ReorderLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom) {
+  if (!propagate_down[0]) {
+    return;
+  }
+  reorder_channels_cpu(top[0]->num(), top[0]->channels(), top[0]->count(2),
+      top[0]->channel_block(), bottom[0]->channel_block(), top[0]->cpu_diff(),
+      bottom[0]->mutable_cpu_diff_uninitialized());
+}
+
+INSTANTIATE_CLASS(ReorderLayer);
+REGISTER_LAYER_CLASS(Reorder);
+
+}  // namespace caffe
@@ -209,6 +209,81 @@ void ScaleLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   }
 }
 
+template <typename Dtype>
+void ScaleLayer<Dtype>::Forward_cpu_fused_begin(const Blob<Dtype>& blob,
+    bool keep_input) {
+  const Blob<Dtype>& scale = *this->blobs_[0];
+  const int axis = (scale.num_axes() == 0) ?
+      0 : blob.CanonicalAxisIndex(this->layer_param_.scale_param().axis());
+  fused_scale_dim_ = scale.count();
+  fused_inner_dim_ = blob.count(axis + scale.num_axes());
+  // Fused layers work in place, so if Backward_cpu follows it reads the
+  // inputs from temp_.
+  fused_temp_ = NULL;
+  if (keep_input) {
+    temp_.ReshapeLike(blob);
+    fused_temp_ = temp_.mutable_cpu_data();
+  }
+}
+
+template <typename Dtype>
+void ScaleLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  if (fused_temp_) {
+    caffe_copy(end - begin, data, fused_temp_ + begin);
+  }
+  const Dtype* scale_data = this->blobs_[0]->cpu_data();
+  const Dtype* bias_data = bias_layer_ ?
+      this->blobs_[bias_param_id_]->cpu_data() : NULL;
+  // Runs of values [i, i + n) that share the scale of channel d.
+  int d = (begin / fused_inner_dim_) % fused_scale_dim_;
+  for (int i = 0, j = begin % fused_inner_dim_; i < end - begin; j = 0) {
+    const int n = std::min(fused_inner_dim_ - j, end - begin - i);
+    const Dtype factor = scale_data[d];
+    if (bias_data) {
+      const Dtype bias = bias_data[d];
+      for (int k = i; k < i + n; ++k) {
+        data[k] = data[k] * factor + bias;
+      }
+    } else {
+      for (int k = i; k < i + n; ++k) {
+        data[k] *= factor;
+      }
+    }
+    i += n;
+    d = (d + 1 == fused_scale_dim_) ? 0 : d + 1;
+  }
+}
+
+template <typename Dtype>
+void ScaleLayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  const Dtype* scale_data = this->blobs_[0]->cpu_data();
+  Dtype* scale_diff = this->param_propagate_down_[0] ?
+      this->blobs_[0]->mutable_cpu_diff() : NULL;
+  Dtype* bias_diff =
+      (bias_layer_ && this->param_propagate_down_[bias_param_id_]) ?
+      this->blobs_[bias_param_id_]->mutable_cpu_diff() : NULL;
+  int d = (begin / fused_inner_dim_) % fused_scale_dim_;
+  for (int i = 0, j = begin % fused_inner_dim_; i < end - begin; j = 0) {
+    const int n = std::min(fused_inner_dim_ - j, end - begin - i);
+    Dtype scale_sum = 0, bias_sum = 0;
+    const Dtype factor = scale_data[d];
+    for (int k = i; k < i + n; ++k) {
+      scale_sum += diff[k] * bottom_data[k];
+      bias_sum += diff[k];
+      diff[k] *= factor;
+    }
+    if (scale_diff) {
+      scale_diff[d] += scale_sum;
+    }
+    if (bias_diff) {
+      bias_diff[d] += bias_sum;
+    }
+    i += n;
+    d = (d + 1 == fused_scale_dim_) ? 0 : d + 1;
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(ScaleLayer);
 #endif
@@ -14,7 +14,7 @@ template <typename Dtype>
 void SigmoidLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
   const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  Dtype* top_data = top[0]->mutable_cpu_data_uninitialized();
   const int count = bottom[0]->count();
   for (int i = 0; i < count; ++i) {
     top_data[i] = sigmoid(bottom_data[i]);
@@ -28,7 +28,7 @@ void SigmoidLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   if (propagate_down[0]) {
     const Dtype* top_data = top[0]->cpu_data();
     const Dtype* top_diff = top[0]->cpu_diff();
-    Dtype* bottom_diff = bottom[0]->mutable_cpu_diff();
+    Dtype* bottom_diff = bottom[0]->mutable_cpu_diff_uninitialized();
     const int count = bottom[0]->count();
     for (int i = 0; i < count; ++i) {
       const Dtype sigmoid_x = top_data[i];
@@ -37,6 +37,22 @@ void SigmoidLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   }
 }
 
+template <typename Dtype>
+void SigmoidLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  for (int i = 0; i < end - begin; ++i) {
+    data[i] = sigmoid(data[i]);
+  }
+}
+
+template <typename Dtype>
+void SigmoidLayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  for (int i = 0; i < end - begin; ++i) {
+    const Dtype sigmoid_x = top_data[i];
+    diff[i] *= sigmoid_x * (1. - sigmoid_x);
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(SigmoidLayer);
 #endif
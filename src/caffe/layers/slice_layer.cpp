@@ -69,7 +69,23 @@ void SliceLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
   if (top.size() == 1) {
     top[0]->ShareData(*bottom[0]);
     top[0]->ShareDiff(*bottom[0]);
+    return;
   }
+  // Layer::Forward reshapes without the Net re-pointing its views.
+  for (int i = 0; i < top.size(); ++i) {
+    this->DetachStaleView(top[i], *bottom[0], TopViewOffset(bottom, top, i));
+  }
+}
+
+template <typename Dtype>
+int SliceLayer<Dtype>::TopViewOffset(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top, int top_id) const {
+  if (top.size() == 1 || num_slices_ != 1) { return -1; }
+  int offset = 0;
+  for (int i = 0; i < top_id; ++i) {
+    offset += top[i]->count();
+  }
+  return offset;
 }
 
 template <typename Dtype>
@@ -82,6 +98,12 @@ void SliceLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   for (int i = 0; i < top.size(); ++i) {
     Dtype* top_data = top[i]->mutable_cpu_data();
     const int top_slice_axis = top[i]->shape(slice_axis_);
+    // A top made a view into the bottom by the Net is already in place.
+    if (num_slices_ == 1 &&
+        top_data == bottom_data + offset_slice_axis * slice_size_) {
+      offset_slice_axis += top_slice_axis;
+      continue;
+    }
     for (int n = 0; n < num_slices_; ++n) {
       const int top_offset = n * top_slice_axis * slice_size_;
       const int bottom_offset =
@@ -103,6 +125,11 @@ void SliceLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   for (int i = 0; i < top.size(); ++i) {
     const Dtype* top_diff = top[i]->cpu_diff();
     const int top_slice_axis = top[i]->shape(slice_axis_);
+    if (num_slices_ == 1 &&
+        top_diff == bottom_diff + offset_slice_axis * slice_size_) {
+      offset_slice_axis += top_slice_axis;
+      continue;
+    }
     for (int n = 0; n < num_slices_; ++n) {
       const int top_offset = n * top_slice_axis * slice_size_;
       const int bottom_offset =
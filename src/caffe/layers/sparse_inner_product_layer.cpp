@@ -0,0 +1,179 @@
+#include <boost/bind.hpp>
+#include <vector>
+
+#include "caffe/layers/sparse_inner_product_layer.hpp"
+#include "caffe/util/math_functions.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void SparseInnerProductLayer<Dtype>::UpdateSparseWeights() {
+  // Training updates the weights on every iteration, so it keeps to the
+  // dense GEMM rather than rebuild the CSR form each time.
+  if (this->phase_ != TEST) {
+    use_sparse_ = false;
+    return;
+  }
+  const SyncedMemory* memory = this->blobs_[0]->data().get();
+  if (memory == weight_memory_ && memory->version() == weight_version_) {
+    return;
+  }
+  dense_released_ = false;
+  // Weight (o, k) is at o * K_ + k, or k * N_ + o if transposed.
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  const int output_stride = this->transpose_ ? 1 : this->K_;
+  const int input_stride = this->transpose_ ? this->N_ : 1;
+  row_start_.resize(this->N_ + 1);
+  columns_.clear();
+  values_.clear();
+  row_start_[0] = 0;
+  for (int o = 0; o < this->N_; ++o) {
+    const Dtype* w = weight + o * output_stride;
+    for (int k = 0; k < this->K_; ++k) {
+      if (w[k * input_stride] != Dtype(0)) {
+        columns_.push_back(k);
+        values_.push_back(w[k * input_stride]);
+      }
+    }
+    row_start_[o + 1] = columns_.size();
+  }
+  const float zeros = 1.f - static_cast<float>(values_.size()) /
+      (static_cast<float>(this->N_) * this->K_);
+  use_sparse_ =
+      zeros >= this->layer_param_.inner_product_param().sparse_threshold();
+  if (!use_sparse_) {
+    vector<int>().swap(columns_);
+    vector<Dtype>().swap(values_);
+  }
+  weight_memory_ = memory;
+  weight_version_ = memory->version();
+  // The dense weights are not read again on the CPU: release them, unless
+  // another blob (a shared parameter, or the net this one tests) uses them.
+  if (use_sparse_ && Caffe::mode() == Caffe::CPU &&
+      this->blobs_[0]->data().use_count() == 1) {
+    Blob<Dtype> released(this->blobs_[0]->shape());
+    this->blobs_[0]->ShareData(released);
+    weight_memory_ = this->blobs_[0]->data().get();
+    weight_version_ = weight_memory_->version();
+    dense_released_ = true;
+  }
+}
+
+template <typename Dtype>
+void SparseInnerProductLayer<Dtype>::RestoreDenseWeights() {
+  if (!dense_released_) {
+    return;
+  }
+  Dtype* weight = this->blobs_[0]->mutable_cpu_data();
+  const int output_stride = this->transpose_ ? 1 : this->K_;
+  const int input_stride = this->transpose_ ? this->N_ : 1;
+  caffe_set(this->blobs_[0]->count(), Dtype(0), weight);
+  for (int o = 0; o < this->N_; ++o) {
+    for (int i = row_start_[o]; i < row_start_[o + 1]; ++i) {
+      weight[o * output_stride + columns_[i] * input_stride] = values_[i];
+    }
+  }
+  // The CSR form still matches.
+  weight_version_ = this->blobs_[0]->data()->version();
+  dense_released_ = false;
+}
+
+template <typename Dtype>
+void SparseInnerProductLayer<Dtype>::ToProto(LayerParameter* param,
+    bool write_diff) {
+  RestoreDenseWeights();
+  InnerProductLayer<Dtype>::ToProto(param, write_diff);
+}
+
+template <typename Dtype>
+void SparseInnerProductLayer<Dtype>::forward_cpu_outputs(
+    const Dtype* bottom_data, Dtype* top_data, int begin, int end) {
+  const Dtype* bias = this->bias_term_ ? this->blobs_[1]->cpu_data() : NULL;
+  // The nonzeros of an output stay in cache across the rows of the bottom.
+  for (int o = begin; o < end; ++o) {
+    for (int m = 0; m < this->M_; ++m) {
+      const Dtype* x = bottom_data + m * this->K_;
+      Dtype sum = bias ? bias[o] : Dtype(0);
+      for (int i = row_start_[o]; i < row_start_[o + 1]; ++i) {
+        sum += values_[i] * x[columns_[i]];
+      }
+      top_data[m * this->N_ + o] = sum;
+    }
+  }
+}
+
+template <typename Dtype>
+void SparseInnerProductLayer<Dtype>::backward_cpu_rows(const Dtype* top_diff,
+    Dtype* bottom_diff, int begin, int end) {
+  // Each row of the bottom gradient gathers the nonzeros of every output,
+  // scaled by the gradient of that output.
+  for (int m = begin; m < end; ++m) {
+    const Dtype* dy = top_diff + m * this->N_;
+    Dtype* dx = bottom_diff + m * this->K_;
+    caffe_set(this->K_, Dtype(0), dx);
+    for (int o = 0; o < this->N_; ++o) {
+      const Dtype scale = dy[o];
+      if (scale == Dtype(0)) {
+        continue;
+      }
+      for (int i = row_start_[o]; i < row_start_[o + 1]; ++i) {
+        dx[columns_[i]] += values_[i] * scale;
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void SparseInnerProductLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  UpdateSparseWeights();
+  if (!use_sparse_) {
+    InnerProductLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  Dtype* top_data = top[0]->mutable_cpu_data_uninitialized();
+  parallel_for(0, this->N_, 1, boost::bind(
+      &SparseInnerProductLayer<Dtype>::forward_cpu_outputs, this,
+      bottom[0]->cpu_data(), top_data, _1, _2));
+  // The outputs are written a column at a time, so the activations follow
+  // in a pass of their own.
+  this->forward_cpu_activations_begin(*top[0]);
+  this->forward_cpu_activations(top_data, 0, this->M_ * this->N_);
+}
+
+template <typename Dtype>
+void SparseInnerProductLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  UpdateSparseWeights();
+  if (!use_sparse_ || !propagate_down[0]) {
+    InnerProductLayer<Dtype>::Backward_cpu(top, propagate_down, bottom);
+    return;
+  }
+  // The parameter gradients are dense; only the bottom one is sparse.
+  InnerProductLayer<Dtype>::Backward_cpu(top, vector<bool>(1, false), bottom);
+  parallel_for(0, this->M_, 1, boost::bind(
+      &SparseInnerProductLayer<Dtype>::backward_cpu_rows, this,
+      top[0]->cpu_diff(), bottom[0]->mutable_cpu_diff_uninitialized(),
+      _1, _2));
+}
+
+template <typename Dtype>
+void SparseInnerProductLayer<Dtype>::Forward_gpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  RestoreDenseWeights();
+  InnerProductLayer<Dtype>::Forward_gpu(bottom, top);
+}
+
+template <typename Dtype>
+void SparseInnerProductLayer<Dtype>::Backward_gpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  RestoreDenseWeights();
+  InnerProductLayer<Dtype>::Backward_gpu(top, propagate_down, bottom);
+}
+
+INSTANTIATE_CLASS(SparseInnerProductLayer);
+
+}  // namespace caffe
@@ -11,7 +11,7 @@ template <typename Dtype>
 void TanHLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
   const Dtype* bottom_data = bottom[0]->cpu_data();
-  Dtype* top_data = top[0]->mutable_cpu_data();
+  Dtype* top_data = top[0]->mutable_cpu_data_uninitialized();
   const int count = bottom[0]->count();
   for (int i = 0; i < count; ++i) {
     top_data[i] = tanh(bottom_data[i]);
@@ -25,7 +25,7 @@ void TanHLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   if (propagate_down[0]) {
     const Dtype* top_data = top[0]->cpu_data();
     const Dtype* top_diff = top[0]->cpu_diff();
-    Dtype* bottom_diff = bottom[0]->mutable_cpu_diff();
+    Dtype* bottom_diff = bottom[0]->mutable_cpu_diff_uninitialized();
     const int count = bottom[0]->count();
     Dtype tanhx;
     for (int i = 0; i < count; ++i) {
@@ -35,6 +35,23 @@ void TanHLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   }
 }
 
+template <typename Dtype>
+void TanHLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin, int end) {
+  for (int i = 0; i < end - begin; ++i) {
+    data[i] = tanh(data[i]);
+  }
+}
+
+template <typename Dtype>
+void TanHLayer<Dtype>::Backward_cpu_fused(const Dtype* bottom_data,
+    const Dtype* top_data, Dtype* diff, int begin, int end) {
+  Dtype tanhx;
+  for (int i = 0; i < end - begin; ++i) {
+    tanhx = top_data[i];
+    diff[i] *= 1 - tanhx * tanhx;
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(TanHLayer);
 #endif
@@ -22,6 +22,14 @@ void ThresholdLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   }
 }
 
+template <typename Dtype>
+void ThresholdLayer<Dtype>::Forward_cpu_fused(Dtype* data, int begin,
+    int end) {
+  for (int i = 0; i < end - begin; ++i) {
+    data[i] = (data[i] > threshold_) ? Dtype(1) : Dtype(0);
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU_FORWARD(ThresholdLayer, Forward);
 #endif
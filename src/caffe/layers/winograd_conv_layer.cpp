@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <vector>
+
+#include "caffe/layers/winograd_conv_layer.hpp"
+#include "caffe/util/math_functions.hpp"
+#include "caffe/util/reduced_precision.hpp"
+#include "caffe/util/winograd.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::LayerSetUp(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::LayerSetUp(bottom, top);
+  tile_ = this->layer_param_.convolution_param().winograd_tile();
+  CHECK(tile_ == 2 || tile_ == 4) << "winograd_tile must be 2 or 4.";
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  const int* kernel = this->kernel_shape_.cpu_data();
+  const int* stride = this->stride_.cpu_data();
+  const int* pad = this->pad_.cpu_data();
+  const int* dilation = this->dilation_.cpu_data();
+  use_winograd_ = this->num_spatial_axes_ == 2 &&
+      kernel[0] == 3 && kernel[1] == 3 && stride[0] == 1 && stride[1] == 1 &&
+      dilation[0] == 1 && dilation[1] == 1;
+  use_winograd_backward_ = use_winograd_ && pad[0] <= 2 && pad[1] <= 2;
+  if (!use_winograd_) {
+    return;
+  }
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  int workspace_size = winograd_workspace_size(tile_, in_channels,
+      out_channels, this->output_shape_[0], this->output_shape_[1]);
+  if (use_winograd_backward_) {
+    workspace_size = std::max(workspace_size, winograd_workspace_size(tile_,
+        out_channels, in_channels, this->input_shape(1),
+        this->input_shape(2)));
+  }
+  workspace_.Reshape(vector<int>(1, workspace_size));
+}
+
+template <typename Dtype>
+Dtype* WinogradConvolutionLayer<Dtype>::winograd_workspace() {
+  if (this->shared_workspace_) {
+    return static_cast<Dtype*>(this->shared_workspace_->mutable_cpu_data(
+        workspace_.count() * sizeof(Dtype)));
+  }
+  return workspace_.mutable_cpu_data_uninitialized();
+}
+
+template <typename Dtype>
+const Dtype* WinogradConvolutionLayer<Dtype>::transformed_weights(
+    bool flipped) {
+  const Blob<Dtype>& weights = *this->blobs_[0];
+  const SyncedMemory* memory = weights.data().get();
+  if (memory != weight_memory_ || memory->version() != weight_version_) {
+    weight_memory_ = memory;
+    weight_version_ = memory->version();
+    transformed_valid_ = false;
+    flipped_valid_ = false;
+  }
+  Blob<Dtype>& transformed = flipped ? flipped_weights_ : transformed_weights_;
+  bool& valid = flipped ? flipped_valid_ : transformed_valid_;
+  if (!valid) {
+    // Weights held at 16 bits are widened here only, not on every pass.
+    const uint16_t* reduced_weight = weights.reduced_cpu_data();
+    vector<Dtype> widened(reduced_weight ? weights.count() : 0);
+    if (reduced_weight) {
+      caffe_cpu_expand_precision(weights.count(), reduced_weight,
+          weights.data_storage(), &widened[0]);
+    }
+    const Dtype* weight = reduced_weight ? &widened[0] : weights.cpu_data();
+    const int in_channels = this->channels_ / this->group_;
+    const int out_channels = this->num_output_ / this->group_;
+    const int group_size = (tile_ + 2) * (tile_ + 2) * in_channels *
+        out_channels;
+    transformed.Reshape(vector<int>(1, this->group_ * group_size));
+    for (int g = 0; g < this->group_; ++g) {
+      winograd_transform_filter_cpu(tile_,
+          weight + g * out_channels * in_channels * 9,
+          out_channels, in_channels, flipped,
+          transformed.mutable_cpu_data() + g * group_size);
+    }
+    valid = true;
+  }
+  return transformed.cpu_data();
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (!use_winograd_) {
+    ConvolutionLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  const Dtype* weight = transformed_weights(false);
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int weight_offset = (tile_ + 2) * (tile_ + 2) * in_channels *
+      out_channels;
+  const int height = this->input_shape(1);
+  const int width = this->input_shape(2);
+  const int* pad = this->pad_.cpu_data();
+  Dtype* workspace = winograd_workspace();
+  for (int i = 0; i < bottom.size(); ++i) {
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    Dtype* top_data = top[i]->mutable_cpu_data_uninitialized();
+    this->forward_cpu_activations_begin(*top[i]);
+    for (int n = 0; n < this->num_; ++n) {
+      for (int g = 0; g < this->group_; ++g) {
+        winograd_conv_cpu(tile_, bottom_data + n * this->bottom_dim_ +
+            g * in_channels * height * width, in_channels, height, width,
+            pad[0], pad[1], weight + g * weight_offset, out_channels,
+            top_data + n * this->top_dim_ +
+            g * out_channels * this->out_spatial_dim_, workspace);
+      }
+      this->forward_cpu_epilogue(top_data, n);
+    }
+  }
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  if (!use_winograd_backward_) {
+    ConvolutionLayer<Dtype>::Backward_cpu(top, propagate_down, bottom);
+    return;
+  }
+  const int in_channels = this->channels_ / this->group_;
+  const int out_channels = this->num_output_ / this->group_;
+  const int weight_offset = (tile_ + 2) * (tile_ + 2) * in_channels *
+      out_channels;
+  const int height = this->input_shape(1);
+  const int width = this->input_shape(2);
+  const int* pad = this->pad_.cpu_data();
+  for (int i = 0; i < top.size(); ++i) {
+    const Dtype* top_diff = top[i]->cpu_diff();
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    // Bias gradient, if necessary.
+    if (this->bias_term_ && this->param_propagate_down_[1]) {
+      Dtype* bias_diff = this->blobs_[1]->mutable_cpu_diff();
+      for (int n = 0; n < this->num_; ++n) {
+        this->backward_cpu_bias(bias_diff, top_diff + n * this->top_dim_);
+      }
+    }
+    // Gradient w.r.t. weight through im2col. Note that we accumulate diffs.
+    if (this->param_propagate_down_[0]) {
+      Dtype* weight_diff = this->blobs_[0]->mutable_cpu_diff();
+      for (int n = 0; n < this->num_; ++n) {
+        this->weight_cpu_gemm(bottom_data + n * this->bottom_dim_,
+            top_diff + n * this->top_dim_, weight_diff);
+      }
+    }
+    // Gradient w.r.t. bottom data: the top diff convolved with the flipped
+    // filters, padded so that the result has the bottom's shape.
+    if (propagate_down[i]) {
+      const Dtype* weight = transformed_weights(true);
+      Dtype* bottom_diff = bottom[i]->mutable_cpu_diff();
+      Dtype* workspace = winograd_workspace();
+      for (int n = 0; n < this->num_; ++n) {
+        for (int g = 0; g < this->group_; ++g) {
+          winograd_conv_cpu(tile_, top_diff + n * this->top_dim_ +
+              g * out_channels * this->out_spatial_dim_, out_channels,
+              this->output_shape_[0], this->output_shape_[1],
+              2 - pad[0], 2 - pad[1], weight + g * weight_offset,
+              in_channels, bottom_diff + n * this->bottom_dim_ +
+              g * in_channels * height * width, workspace);
+        }
+      }
+    }
+  }
+}
+
+INSTANTIATE_CLASS(WinogradConvolutionLayer);
+
+}  // namespace caffe
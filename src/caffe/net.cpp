@@ -9,18 +9,48 @@
 
 #include "caffe/common.hpp"
 #include "caffe/layer.hpp"
+#include "caffe/layers/elementwise_chain_layer.hpp"
 #include "caffe/net.hpp"
 #include "caffe/parallel.hpp"
 #include "caffe/proto/caffe.pb.h"
 #include "caffe/util/hdf5.hpp"
+#include "caffe/util/insert_reorders.hpp"
 #include "caffe/util/insert_splits.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/memory_planner.hpp"
+#include "caffe/util/remove_identities.hpp"
 #include "caffe/util/upgrade_proto.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
 
 namespace caffe {
 
+namespace {
+
+// Sets the host memory policy of the calling thread until the end of the
+// scope, if enabled.
+class HostMemoryPolicyScope {
+ public:
+  HostMemoryPolicyScope(const bool enabled, const HostMemoryPolicy& policy)
+      : enabled_(enabled) {
+    if (enabled_) {
+      saved_policy_ = Caffe::host_memory_policy();
+      Caffe::set_host_memory_policy(policy);
+    }
+  }
+  ~HostMemoryPolicyScope() {
+    if (enabled_) {
+      Caffe::set_host_memory_policy(saved_policy_);
+    }
+  }
+
+ private:
+  const bool enabled_;
+  HostMemoryPolicy saved_policy_;
+};
+
+}  // namespace
+
 template <typename Dtype>
 Net<Dtype>::Net(const NetParameter& param, const Net* root_net)
     : root_net_(root_net) {
@@ -50,15 +80,52 @@ void Net<Dtype>::Init(const NetParameter& in_param) {
   LOG_IF(INFO, Caffe::root_solver()) //如果是根网络 开始输出调试信息
       << "Initializing net from parameters: " << std::endl
       << filtered_param.DebugString();
+  // Forward-only inference nets pass blobs on by name rather than through
+  // Dropout and Split layers.
+  // 只做前向的推理网络去掉Dropout/Split等只传递输入的层 也不插入Split层
+  const bool remove_identities = filtered_param.remove_identities() &&
+      phase_ == TEST && !filtered_param.force_backward();
+  if (remove_identities) {
+    NetParameter removed_param;
+    RemoveIdentityLayers(filtered_param, &removed_param);
+    filtered_param.Swap(&removed_param);
+  }
+  // CPU inference nets may keep chains of layers in the blocked layout, with
+  // reorders at the chain boundaries.
+  // CPU推理网络可以让卷积/池化等层组成的链使用通道分块布局 在链的边界插入Reorder层
+  if (filtered_param.channel_block() > 0 && phase_ == TEST &&
+      !filtered_param.force_backward() && Caffe::mode() == Caffe::CPU) {
+    NetParameter blocked_param;
+    InsertReorders(filtered_param, &blocked_param);
+    filtered_param.Swap(&blocked_param);
+  }
   // Create a copy of filtered_param with splits added where necessary.
   NetParameter param;
-  InsertSplits(filtered_param, &param);
+  shared_readers_ = remove_identities;
+  if (remove_identities) {
+    param.CopyFrom(filtered_param);
+  } else {
+    InsertSplits(filtered_param, &param);
+  }
   // Basically, build all the layers and set up their connections.
   // 建立所有的layers并且设置它们的连接
   name_ = param.name(); //设置网络名称
   map<string, int> blob_name_to_idx; //声明 blob的名称的索引
   set<string> available_blobs;       //集合 可用的blob
   memory_used_ = 0; //初始化内存大小
+  // 设置主机内存放置策略 可学习参数主要在层初始化时分配
+  // Host memory placement. The learnable parameters are mostly allocated
+  // while the layers are set up, the activations during Forward.
+  has_host_memory_policy_ = param.has_host_memory();
+  const HostMemoryParameter& host_memory_param = param.host_memory();
+  activation_memory_policy_.huge_pages = host_memory_param.huge_pages();
+  activation_memory_policy_.numa_node = host_memory_param.numa_node();
+  param_memory_policy_ = activation_memory_policy_;
+  param_memory_policy_.interleave = host_memory_param.interleave_params();
+  const HostMemoryPolicy thread_memory_policy = Caffe::host_memory_policy();
+  if (has_host_memory_policy_) {
+    Caffe::set_host_memory_policy(param_memory_policy_);
+  }
   // For each layer, set up its input and output
   //  按层数设置输入输出有关向量的大小
   bottom_vecs_.resize(param.layer_size());
@@ -294,7 +361,42 @@ void Net<Dtype>::Init(const NetParameter& in_param) {
     layer_names_index_[layer_names_[layer_id]] = layer_id;
   }
   ShareWeights();
+  // Layers run one at a time, so their scratch buffers can be one.
+  if (param.share_workspace()) {
+    workspace_.reset(new Workspace());
+    for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+      layers_[layer_id]->set_shared_workspace(workspace_);
+    }
+  }
+  layer_fused_.assign(layers_.size(), false);
+  if (param.fuse_activations()) {
+    FuseActivations();
+  }
+  chains_.clear();
+  chain_first_layer_.clear();
+  chain_last_layer_.clear();
+  chain_ran_fused_.clear();
+  layer_chain_.assign(layers_.size(), -1);
+  if (param.fuse_elementwise()) {
+    FuseElementwiseChains();
+  }
+  blob_views_.clear();
+  blob_view_base_.assign(blobs_.size(), -1);
+  if (param.blob_views() && Caffe::mode() == Caffe::CPU) {
+    PlanBlobViews();
+  }
+  blob_view_data_.assign(blob_views_.size(), shared_ptr<SyncedMemory>());
+  blob_view_diff_.assign(blob_views_.size(), shared_ptr<SyncedMemory>());
+  Caffe::set_host_memory_policy(thread_memory_policy);
   debug_info_ = param.debug_info();
+  activation_naive_bytes_ = 0;
+  optimize_memory_ = param.optimize_memory();
+  if (optimize_memory_) {
+    PlanActivationMemory();
+  }
+  ApplyBlobViews();
+  param_storage_ = param.param_storage();
+  ApplyParamStorage();
   LOG_IF(INFO, Caffe::root_solver()) << "Network initialization done.";
 }
 
@@ -442,7 +544,12 @@ template <typename Dtype>
 int Net<Dtype>::AppendBottom(const NetParameter& param, const int layer_id, const int bottom_id, set<string>* available_blobs, map<string, int>* blob_name_to_idx) {
   const LayerParameter& layer_param = param.layer(layer_id);
   const string& blob_name = layer_param.bottom(bottom_id);
-  if (available_blobs->find(blob_name) == available_blobs->end()) {
+  // A blob may have several readers only in nets without Split layers
+  // (NetParameter.remove_identities); it is then no longer available as an
+  // output after the first, but still known.
+  if (shared_readers_ ?
+      blob_name_to_idx->find(blob_name) == blob_name_to_idx->end() :
+      available_blobs->find(blob_name) == available_blobs->end()) {
     LOG(FATAL) << "Unknown bottom blob '" << blob_name << "' (layer '"
                << layer_param.name() << "', bottom index " << bottom_id << ")";
   }
@@ -560,9 +667,55 @@ template <typename Dtype>
 Dtype Net<Dtype>::ForwardFromTo(int start, int end) {
   CHECK_GE(start, 0);
   CHECK_LT(end, layers_.size());
+  HostMemoryPolicyScope memory_policy_scope(has_host_memory_policy_,
+      activation_memory_policy_);
   Dtype loss = 0;
+  // Whether the layer last run here ran the fused activations after it.
+  bool ran_activations = false;
   for (int i = start; i <= end; ++i) {
     // LOG(ERROR) << "Forwarding " << layer_names_[i];
+    if (layer_fused_[i] && Caffe::mode() == Caffe::CPU) {
+      if (ran_activations) {
+        // Already run by the layer before it.
+        if (debug_info_) { ForwardDebugInfo(i); }
+        continue;
+      }
+    } else {
+      // A pass that stops among the activations fused into the layer runs
+      // them one by one, as it does when it starts among them.
+      int last_fused = i;
+      while (last_fused + 1 < layers_.size() && layer_fused_[last_fused + 1]) {
+        ++last_fused;
+      }
+      ran_activations = last_fused > i && last_fused <= end;
+      if (last_fused > i && !ran_activations) {
+        layers_[i]->SuspendActivationFusion(true);
+        loss += layers_[i]->Forward(bottom_vecs_[i], top_vecs_[i]);
+        layers_[i]->SuspendActivationFusion(false);
+        if (debug_info_) { ForwardDebugInfo(i); }
+        continue;
+      }
+    }
+    if (layer_chain_[i] >= 0 && Caffe::mode() == Caffe::CPU) {
+      const int chain = layer_chain_[i];
+      const int first = chain_first_layer_[chain];
+      if (start <= first && chain_last_layer_[chain] <= end) {
+        // The whole chain runs at its first layer.
+        if (i == first) {
+          chains_[chain]->Forward(bottom_vecs_[i],
+              top_vecs_[chain_last_layer_[chain]]);
+          chain_ran_fused_[chain] = true;
+        }
+        if (debug_info_) { ForwardDebugInfo(i); }
+        continue;
+      }
+      // A pass over part of the chain runs its layers one by one, from the
+      // blobs between them.
+      if (i == start && start > first) {
+        UnfuseChain(chain);
+      }
+      chain_ran_fused_[chain] = false;
+    }
     Dtype layer_loss = layers_[i]->Forward(bottom_vecs_[i], top_vecs_[i]);
     loss += layer_loss;
     if (debug_info_) { ForwardDebugInfo(i); }
@@ -606,7 +759,28 @@ template <typename Dtype>
 void Net<Dtype>::BackwardFromTo(int start, int end) {
   CHECK_GE(end, 0);
   CHECK_LT(start, layers_.size());
+  HostMemoryPolicyScope memory_policy_scope(has_host_memory_policy_,
+      activation_memory_policy_);
   for (int i = start; i >= end; --i) {
+    if (layer_chain_[i] >= 0 && Caffe::mode() == Caffe::CPU) {
+      const int chain = layer_chain_[i];
+      const int first = chain_first_layer_[chain];
+      const int last = chain_last_layer_[chain];
+      if (end <= first && last <= start && chain_ran_fused_[chain]) {
+        // The whole chain runs backward at its last layer.
+        if (i == last && layer_need_backward_[i]) {
+          chains_[chain]->Backward(
+              top_vecs_[i], bottom_need_backward_[first], bottom_vecs_[first]);
+        }
+        if (layer_need_backward_[i] && debug_info_) { BackwardDebugInfo(i); }
+        continue;
+      }
+      // Otherwise its layers run backward one by one, which needs the blobs
+      // between them.
+      if (i == std::min(start, last)) {
+        UnfuseChain(chain);
+      }
+    }
     if (layer_need_backward_[i]) {
       layers_[i]->Backward(
           top_vecs_[i], bottom_need_backward_[i], bottom_vecs_[i]);
@@ -760,6 +934,123 @@ void Net<Dtype>::Reshape() {
   for (int i = 0; i < layers_.size(); ++i) {
     layers_[i]->Reshape(bottom_vecs_[i], top_vecs_[i]);
   }
+  if (optimize_memory_) {
+    PlanActivationMemory();
+  }
+  ApplyBlobViews();
+}
+
+template <typename Dtype>
+void Net<Dtype>::PlanActivationMemory() {
+  if (Caffe::mode() != Caffe::CPU) {
+    LOG_IF(INFO, Caffe::root_solver())
+        << "Skipping activation memory planning outside of CPU mode.";
+    return;
+  }
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    if (layer_need_backward_[layer_id]) {
+      LOG_IF(INFO, Caffe::root_solver())
+          << "Skipping activation memory planning: layer "
+          << layer_names_[layer_id] << " needs backward computation.";
+      return;
+    }
+  }
+  // Blobs computed in-place or sharing data (Split, Flatten, Reshape, ...)
+  // alias one SyncedMemory, so plan per SyncedMemory rather than per blob.
+  map<SyncedMemory*, int> memory_to_block;
+  vector<SyncedMemory*> block_memory;
+  vector<MemoryBlock> blocks;
+  vector<bool> block_pinned;
+  set<int> pinned_blobs(net_input_blob_indices_.begin(),
+      net_input_blob_indices_.end());
+  pinned_blobs.insert(net_output_blob_indices_.begin(),
+      net_output_blob_indices_.end());
+  vector<int> shared_bottom(blobs_.size(), -1);
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    if (!layers_[layer_id]->MayShareBottomData() ||
+        !layers_[layer_id]->share_bottom_data()) {
+      continue;
+    }
+    const vector<int>& bottom_ids = bottom_id_vecs_[layer_id];
+    const vector<int>& top_ids = top_id_vecs_[layer_id];
+    for (int i = 0; i < top_ids.size() && i < bottom_ids.size(); ++i) {
+      if (top_ids[i] != bottom_ids[i]) {
+        shared_bottom[top_ids[i]] = bottom_ids[i];
+      }
+    }
+  }
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    // Sources fill their tops during SetUp or only on demand (e.g. constant
+    // DummyData), so their contents must survive across passes.
+    if (bottom_id_vecs_[layer_id].size() == 0) {
+      pinned_blobs.insert(top_id_vecs_[layer_id].begin(),
+          top_id_vecs_[layer_id].end());
+    }
+    vector<int> blob_ids(bottom_id_vecs_[layer_id]);
+    blob_ids.insert(blob_ids.end(), top_id_vecs_[layer_id].begin(),
+        top_id_vecs_[layer_id].end());
+    // An element-wise chain reads and writes all its blobs at its first
+    // layer, so they live throughout it.
+    const int chain = layer_chain_[layer_id];
+    const int first = chain >= 0 ? chain_first_layer_[chain] : layer_id;
+    const int last = chain >= 0 ? chain_last_layer_[chain] : layer_id;
+    for (int i = 0; i < blob_ids.size(); ++i) {
+      // A view lives inside its base blob, and a top that may share its
+      // bottom needs that bottom, so their lifetimes are one.
+      const bool pinned = pinned_blobs.count(blob_ids[i]) > 0;
+      for (int blob_id = blob_ids[i]; blob_id >= 0;
+          blob_id = shared_bottom[blob_id]) {
+        while (blob_view_base_[blob_id] >= 0) {
+          blob_id = blob_view_base_[blob_id];
+        }
+        const Blob<Dtype>* blob = blobs_[blob_id].get();
+        if (blob->count() == 0) { continue; }
+        SyncedMemory* memory = blob->data().get();
+        map<SyncedMemory*, int>::iterator it = memory_to_block.find(memory);
+        if (it == memory_to_block.end()) {
+          it = memory_to_block.insert(make_pair(memory,
+              static_cast<int>(blocks.size()))).first;
+          block_memory.push_back(memory);
+          blocks.push_back(MemoryBlock(memory->size(), first, last));
+          block_pinned.push_back(false);
+        }
+        blocks[it->second].last = std::max(blocks[it->second].last, last);
+        if (pinned || pinned_blobs.count(blob_id)) {
+          block_pinned[it->second] = true;
+        }
+      }
+    }
+  }
+  vector<MemoryBlock> planned_blocks;
+  vector<SyncedMemory*> planned_memory;
+  for (int i = 0; i < blocks.size(); ++i) {
+    if (block_pinned[i]) { continue; }
+    planned_blocks.push_back(blocks[i]);
+    planned_memory.push_back(block_memory[i]);
+  }
+  const size_t kAlignment = 64;
+  vector<size_t> offsets;
+  const size_t arena_size =
+      PlanMemoryBlocks(planned_blocks, kAlignment, &offsets);
+  activation_naive_bytes_ = 0;
+  for (int i = 0; i < planned_blocks.size(); ++i) {
+    activation_naive_bytes_ += planned_blocks[i].size;
+  }
+  if (arena_size == 0) { return; }
+  // Keep the previous arena alive until every block points into the new one.
+  HostMemoryPolicyScope memory_policy_scope(has_host_memory_policy_,
+      activation_memory_policy_);
+  shared_ptr<SyncedMemory> arena(new SyncedMemory(arena_size));
+  char* arena_data = static_cast<char*>(arena->mutable_cpu_data());
+  for (int i = 0; i < planned_memory.size(); ++i) {
+    planned_memory[i]->set_cpu_data(arena_data + offsets[i]);
+  }
+  activation_arena_ = arena;
+  LOG_IF(INFO, Caffe::root_solver())
+      << "Activation memory planned for " << planned_blocks.size()
+      << " blobs: " << arena_size << " bytes shared (naive: "
+      << activation_naive_bytes_ << " bytes, peak live: "
+      << PeakLiveBytes(planned_blocks) << " bytes)";
 }
 
 template <typename Dtype>
@@ -798,6 +1089,7 @@ void Net<Dtype>::CopyTrainedLayersFrom(const NetParameter& param) {
       target_blobs[j]->FromProto(source_layer.blobs(j), kReshape);
     }
   }
+  ApplyParamStorage();
 }
 
 template <typename Dtype>
@@ -866,6 +1158,7 @@ void Net<Dtype>::CopyTrainedLayersFromHDF5(const string trained_filename) {
   }
   H5Gclose(data_hid);
   H5Fclose(file_hid);
+  ApplyParamStorage();
 }
 
 template <typename Dtype>
@@ -974,6 +1267,320 @@ void Net<Dtype>::ShareWeights() {
   }
 }
 
+template <typename Dtype>
+void Net<Dtype>::FuseActivations() {
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    if (top_id_vecs_[layer_id].size() != 1 ||
+        layers_[layer_id]->loss(0) != 0) {
+      continue;
+    }
+    const int blob_id = top_id_vecs_[layer_id][0];
+    // The activations in place on the top, right after the layer.
+    int next_id = layer_id + 1;
+    for (; next_id < layers_.size(); ++next_id) {
+      Layer<Dtype>* activation = layers_[next_id].get();
+      if (bottom_id_vecs_[next_id].size() != 1 ||
+          top_id_vecs_[next_id].size() != 1 ||
+          bottom_id_vecs_[next_id][0] != blob_id ||
+          top_id_vecs_[next_id][0] != blob_id ||
+          activation->loss(0) != 0 ||
+          !layers_[layer_id]->FuseActivation(activation,
+              layer_need_backward_[next_id])) {
+        break;
+      }
+      layer_fused_[next_id] = true;
+      LOG_IF(INFO, Caffe::root_solver()) << "Fusing " << layer_names_[next_id]
+          << " into " << layer_names_[layer_id];
+    }
+    layer_id = next_id - 1;
+  }
+}
+
+template <typename Dtype>
+void Net<Dtype>::FuseElementwiseChains() {
+  vector<bool> fusable(layers_.size());
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    fusable[layer_id] = !layer_fused_[layer_id] &&
+        bottom_id_vecs_[layer_id].size() == 1 &&
+        top_id_vecs_[layer_id].size() == 1 &&
+        layers_[layer_id]->loss(0) == 0 &&
+        layers_[layer_id]->AllowElementwiseFusion();
+  }
+  // The last layer to read each blob, and whether it is an output.
+  vector<int> last_reader(blobs_.size(), -1);
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    for (int i = 0; i < bottom_id_vecs_[layer_id].size(); ++i) {
+      last_reader[bottom_id_vecs_[layer_id][i]] = layer_id;
+    }
+  }
+  vector<bool> is_output(blobs_.size(), false);
+  for (int i = 0; i < net_output_blob_indices_.size(); ++i) {
+    is_output[net_output_blob_indices_[i]] = true;
+  }
+  for (int first = 0; first < layers_.size(); ++first) {
+    if (!fusable[first]) {
+      continue;
+    }
+    int last = first;
+    while (last + 1 < layers_.size() && fusable[last + 1]) {
+      const int next = last + 1;
+      const int blob_id = top_id_vecs_[last][0];
+      // The chain does not write the blob between last and next, unless
+      // next works in place on it.
+      const bool between = top_id_vecs_[next][0] != blob_id;
+      if (bottom_id_vecs_[next][0] != blob_id ||
+          layer_need_backward_[next] != layer_need_backward_[first] ||
+          bottom_need_backward_[next][0] != layer_need_backward_[next] ||
+          (between && (last_reader[blob_id] > next || is_output[blob_id]))) {
+        break;
+      }
+      last = next;
+    }
+    if (last == first) {
+      continue;
+    }
+    vector<Layer<Dtype>*> chain_layers;
+    LayerParameter chain_param;
+    string chain_name;
+    for (int layer_id = first; layer_id <= last; ++layer_id) {
+      chain_layers.push_back(layers_[layer_id].get());
+      chain_name += (layer_id > first ? "+" : "") + layer_names_[layer_id];
+      layer_chain_[layer_id] = chains_.size();
+    }
+    chain_param.set_name(chain_name);
+    chain_param.set_type("ElementwiseChain");
+    chain_param.set_phase(phase_);
+    chain_param.add_bottom(blob_names_[bottom_id_vecs_[first][0]]);
+    chain_param.add_top(blob_names_[top_id_vecs_[last][0]]);
+    // A chain that ends on its own bottom overwrites its input, which the
+    // layers need again to run one by one unless each works in place.
+    bool keep_input = layer_need_backward_[first];
+    if (top_id_vecs_[last][0] == bottom_id_vecs_[first][0]) {
+      for (int layer_id = first; layer_id <= last; ++layer_id) {
+        keep_input |= top_id_vecs_[layer_id][0] != bottom_id_vecs_[layer_id][0];
+      }
+    }
+    shared_ptr<Layer<Dtype> > chain(new ElementwiseChainLayer<Dtype>(
+        chain_param, chain_layers, keep_input));
+    chain->SetUp(bottom_vecs_[first], top_vecs_[last]);
+    chains_.push_back(chain);
+    chain_first_layer_.push_back(first);
+    chain_last_layer_.push_back(last);
+    chain_ran_fused_.push_back(false);
+    LOG_IF(INFO, Caffe::root_solver()) << "Running " << chain_name
+        << " as an ElementwiseChain";
+    first = last;
+  }
+}
+
+template <typename Dtype>
+void Net<Dtype>::UnfuseChain(int chain) {
+  if (!chain_ran_fused_[chain]) {
+    return;
+  }
+  chain_ran_fused_[chain] = false;
+  const int first = chain_first_layer_[chain];
+  const int last = chain_last_layer_[chain];
+  if (bottom_vecs_[first][0] == top_vecs_[last][0]) {
+    const Blob<Dtype>* input = static_cast<ElementwiseChainLayer<Dtype>*>(
+        chains_[chain].get())->kept_input();
+    if (!input) {
+      // Every layer works in place: the blob already holds what running
+      // them one by one leaves in it.
+      return;
+    }
+    caffe_copy(input->count(), input->cpu_data(),
+        bottom_vecs_[first][0]->mutable_cpu_data());
+  }
+  for (int layer_id = first; layer_id <= last; ++layer_id) {
+    layers_[layer_id]->Forward(bottom_vecs_[layer_id], top_vecs_[layer_id]);
+  }
+}
+
+template <typename Dtype>
+void Net<Dtype>::PlanBlobViews() {
+  // The first and last layers to write each blob, and the last to read it.
+  vector<int> first_writer(blobs_.size(), -1);
+  vector<int> last_writer(blobs_.size(), -1);
+  vector<int> last_reader(blobs_.size(), -1);
+  map<SyncedMemory*, int> memory_blobs;
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    for (int i = 0; i < bottom_id_vecs_[layer_id].size(); ++i) {
+      last_reader[bottom_id_vecs_[layer_id][i]] = layer_id;
+    }
+    for (int i = 0; i < top_id_vecs_[layer_id].size(); ++i) {
+      const int blob_id = top_id_vecs_[layer_id][i];
+      if (first_writer[blob_id] < 0) {
+        first_writer[blob_id] = layer_id;
+      }
+      last_writer[blob_id] = layer_id;
+    }
+  }
+  for (int blob_id = 0; blob_id < blobs_.size(); ++blob_id) {
+    ++memory_blobs[blobs_[blob_id]->data().get()];
+    ++memory_blobs[blobs_[blob_id]->diff().get()];
+  }
+  // Whether a blob can share memory with others: it shares none now, holds
+  // no loss weight in its diff, and its producer reads bottoms, is not a
+  // Split and swaps no memory in.
+  vector<bool> viewable(blobs_.size(), false);
+  for (int blob_id = 0; blob_id < blobs_.size(); ++blob_id) {
+    const int producer = first_writer[blob_id];
+    const Blob<Dtype>& blob = *blobs_[blob_id];
+    viewable[blob_id] = producer >= 0 &&
+        bottom_id_vecs_[producer].size() > 0 &&
+        layers_[producer]->layer_param().type() != "Split" &&
+        !layers_[producer]->MayShareBottomData() &&
+        (blob_id >= blob_loss_weights_.size() ||
+         blob_loss_weights_[blob_id] == 0) &&
+        memory_blobs[blob.data().get()] == 1 &&
+        memory_blobs[blob.diff().get()] == 1;
+  }
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    const vector<int>& bottom_ids = bottom_id_vecs_[layer_id];
+    const vector<int>& top_ids = top_id_vecs_[layer_id];
+    for (int i = 0; i < bottom_ids.size(); ++i) {
+      // With backward, writing the base in place afterwards would change
+      // values the producer of the view still needs.
+      const int blob_id = bottom_ids[i];
+      if (layers_[layer_id]->BottomViewOffset(bottom_vecs_[layer_id],
+              top_vecs_[layer_id], i) < 0 || !viewable[blob_id] ||
+          blob_view_base_[blob_id] >= 0 ||
+          std::count(bottom_ids.begin(), bottom_ids.end(), blob_id) != 1 ||
+          last_reader[blob_id] != layer_id ||
+          last_writer[blob_id] >= layer_id ||
+          (last_writer[top_ids[0]] > layer_id &&
+           layer_need_backward_[first_writer[blob_id]])) {
+        continue;
+      }
+      blob_views_.push_back(make_pair(layer_id, blob_id));
+      blob_view_base_[blob_id] = top_ids[0];
+      LOG_IF(INFO, Caffe::root_solver()) << layer_names_[first_writer[blob_id]]
+          << " writes " << blob_names_[blob_id] << " in place into "
+          << blob_names_[top_ids[0]];
+    }
+    if (bottom_ids.size() == 0) { continue; }
+    const int base_id = bottom_ids[0];
+    for (int i = 0; i < top_ids.size(); ++i) {
+      // A top written in place afterwards changes the base, which must
+      // then have no later reader and no producer that needs backward.
+      const int blob_id = top_ids[i];
+      if (layers_[layer_id]->TopViewOffset(bottom_vecs_[layer_id],
+              top_vecs_[layer_id], i) < 0 || !viewable[blob_id] ||
+          !viewable[base_id] || blob_id == base_id ||
+          first_writer[blob_id] != layer_id ||
+          last_writer[base_id] >= layer_id ||
+          (last_writer[blob_id] > layer_id &&
+           (last_reader[base_id] > layer_id ||
+            layer_need_backward_[first_writer[base_id]]))) {
+        continue;
+      }
+      blob_views_.push_back(make_pair(layer_id, blob_id));
+      blob_view_base_[blob_id] = base_id;
+      LOG_IF(INFO, Caffe::root_solver()) << layer_names_[layer_id]
+          << " leaves " << blob_names_[blob_id] << " in place in "
+          << blob_names_[base_id];
+    }
+    // A layer that may forward its bottoms as they are shares them under
+    // the conditions of a top view, for every top.
+    if (!layers_[layer_id]->MayShareBottomData()) { continue; }
+    bool share = true;
+    for (int i = 0; share && i < top_ids.size(); ++i) {
+      const int blob_id = top_ids[i];
+      const int base_id = bottom_ids[i];
+      share = viewable[base_id] && blob_id != base_id &&
+          (blob_id >= blob_loss_weights_.size() ||
+           blob_loss_weights_[blob_id] == 0) &&
+          memory_blobs[blobs_[blob_id]->data().get()] == 1 &&
+          memory_blobs[blobs_[blob_id]->diff().get()] == 1 &&
+          first_writer[blob_id] == layer_id &&
+          last_writer[base_id] < layer_id &&
+          !(last_writer[blob_id] > layer_id &&
+            (last_reader[base_id] > layer_id ||
+             layer_need_backward_[first_writer[base_id]]));
+    }
+    layers_[layer_id]->set_share_bottom_data(share);
+    LOG_IF(INFO, Caffe::root_solver() && share) << layer_names_[layer_id]
+        << " may forward its bottoms as they are";
+  }
+  // The views into views are made after the views they are in.
+  vector<pair<int, int> > depth_views;
+  for (int v = 0; v < blob_views_.size(); ++v) {
+    int depth = 0;
+    for (int blob_id = blob_views_[v].second; blob_view_base_[blob_id] >= 0;
+        blob_id = blob_view_base_[blob_id]) {
+      ++depth;
+    }
+    depth_views.push_back(make_pair(depth, v));
+  }
+  std::stable_sort(depth_views.begin(), depth_views.end());
+  vector<pair<int, int> > blob_views(blob_views_);
+  for (int v = 0; v < blob_views_.size(); ++v) {
+    blob_views_[v] = blob_views[depth_views[v].second];
+  }
+}
+
+template <typename Dtype>
+void Net<Dtype>::ApplyBlobViews() {
+  if (blob_views_.empty() || Caffe::mode() != Caffe::CPU) {
+    return;
+  }
+  HostMemoryPolicyScope memory_policy_scope(has_host_memory_policy_,
+      activation_memory_policy_);
+  for (int v = 0; v < blob_views_.size(); ++v) {
+    const int layer_id = blob_views_[v].first;
+    const vector<Blob<Dtype>*>& bottom = bottom_vecs_[layer_id];
+    const vector<Blob<Dtype>*>& top = top_vecs_[layer_id];
+    Blob<Dtype>* view = blobs_[blob_views_[v].second].get();
+    if (view->count() == 0) { continue; }
+    // A bottom lives in the top of the layer, a top in its bottom.
+    const vector<int>& bottom_ids = bottom_id_vecs_[layer_id];
+    const int bottom_id = std::find(bottom_ids.begin(), bottom_ids.end(),
+        blob_views_[v].second) - bottom_ids.begin();
+    Blob<Dtype>* base;
+    int offset;
+    if (bottom_id < bottom_ids.size()) {
+      base = top[0];
+      offset = layers_[layer_id]->BottomViewOffset(bottom, top, bottom_id);
+    } else {
+      const vector<int>& top_ids = top_id_vecs_[layer_id];
+      base = bottom[0];
+      offset = layers_[layer_id]->TopViewOffset(bottom, top,
+          std::find(top_ids.begin(), top_ids.end(), blob_views_[v].second) -
+          top_ids.begin());
+    }
+    const bool need_diff = layer_need_backward_[layer_id];
+    if (offset >= 0) {
+      blob_view_data_[v] = base->data();
+      view->data()->set_cpu_data(base->mutable_cpu_data() + offset);
+      if (need_diff) {
+        blob_view_diff_[v] = base->diff();
+        view->diff()->set_cpu_data(base->mutable_cpu_diff() + offset);
+      }
+    } else if (blob_view_data_[v]) {
+      // Not contiguous for these shapes: a view made before gets memory of
+      // its own again, as the base may be planned elsewhere.
+      blob_view_data_[v].reset(new SyncedMemory(view->data()->size()));
+      view->data()->set_cpu_data(blob_view_data_[v]->mutable_cpu_data());
+      if (blob_view_diff_[v]) {
+        blob_view_diff_[v].reset(new SyncedMemory(view->diff()->size()));
+        view->diff()->set_cpu_data(blob_view_diff_[v]->mutable_cpu_data());
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void Net<Dtype>::ApplyParamStorage() {
+  // Shared parameters are converted once, through their owner.
+  for (int i = 0; i < params_.size(); ++i) {
+    if (param_owners_[i] >= 0) { continue; }
+    if (params_[i]->data_storage() != param_storage_) {
+      params_[i]->set_data_storage(param_storage_);
+    }
+  }
+}
+
 template <typename Dtype>
 bool Net<Dtype>::has_blob(const string& blob_name) const {
   return blob_names_index_.find(blob_name) != blob_names_index_.end();
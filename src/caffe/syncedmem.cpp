@@ -1,12 +1,19 @@
 #include "caffe/common.hpp"
 #include "caffe/syncedmem.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/reduced_precision.hpp"
 
 namespace caffe {
 
+#ifdef DEBUG
+bool SyncedMemory::poison_uninitialized_ = true;
+#else
+bool SyncedMemory::poison_uninitialized_ = false;
+#endif
+
 SyncedMemory::~SyncedMemory() {
   if (cpu_ptr_ && own_cpu_data_) {
-    CaffeFreeHost(cpu_ptr_, cpu_malloc_use_cuda_);
+    CaffeFreeHost(cpu_ptr_, size_, cpu_malloc_use_cuda_, cpu_malloc_policy_);
   }
 
 #ifndef CPU_ONLY
@@ -23,18 +30,24 @@ SyncedMemory::~SyncedMemory() {
 }
 
 /**to_cpu() 将数据向CPU同步 将head_ 设为HEAD_AT_CPU*/
-inline void SyncedMemory::to_cpu() {
+inline void SyncedMemory::to_cpu(bool zero_fill) {
   switch (head_) {
   case UNINITIALIZED:
-    CaffeMallocHost(&cpu_ptr_, size_, &cpu_malloc_use_cuda_);
-    caffe_memset(size_, 0, cpu_ptr_);
+    CaffeMallocHost(&cpu_ptr_, size_, &cpu_malloc_use_cuda_,
+        &cpu_malloc_policy_);
+    if (zero_fill) {
+      caffe_memset(size_, 0, cpu_ptr_);
+    } else if (poison_uninitialized_) {
+      caffe_memset(size_, 0xFF, cpu_ptr_);
+    }
     head_ = HEAD_AT_CPU;
     own_cpu_data_ = true;
     break;
   case HEAD_AT_GPU:
 #ifndef CPU_ONLY
     if (cpu_ptr_ == NULL) {
-      CaffeMallocHost(&cpu_ptr_, size_, &cpu_malloc_use_cuda_);
+      CaffeMallocHost(&cpu_ptr_, size_, &cpu_malloc_use_cuda_,
+          &cpu_malloc_policy_);
       own_cpu_data_ = true;
     }
     caffe_gpu_memcpy(size_, gpu_ptr_, cpu_ptr_);
@@ -43,6 +56,25 @@ inline void SyncedMemory::to_cpu() {
     NO_GPU;
 #endif
     break;
+  case HEAD_AT_REDUCED:
+    if (cpu_ptr_ == NULL) {
+      CaffeMallocHost(&cpu_ptr_, size_, &cpu_malloc_use_cuda_,
+          &cpu_malloc_policy_);
+      own_cpu_data_ = true;
+    }
+    if (reduced_.empty()) {
+      // Nothing to widen.
+    } else if (reduced_element_size_ == sizeof(double)) {
+      caffe_cpu_expand_precision(reduced_.size(), &reduced_[0],
+          reduced_precision_, static_cast<double*>(cpu_ptr_));
+    } else {
+      caffe_cpu_expand_precision(reduced_.size(), &reduced_[0],
+          reduced_precision_, static_cast<float*>(cpu_ptr_));
+    }
+    // 展开后丢弃16位副本 不同时保留两份
+    drop_reduced();
+    head_ = HEAD_AT_CPU;
+    break;
   case HEAD_AT_CPU:
   case SYNCED:
     break;
@@ -68,6 +100,10 @@ inline void SyncedMemory::to_gpu() {
     caffe_gpu_memcpy(size_, cpu_ptr_, gpu_ptr_);
     head_ = SYNCED;
     break;
+  case HEAD_AT_REDUCED:
+    to_cpu();
+    to_gpu();
+    break;
   case HEAD_AT_GPU:
   case SYNCED:
     break;
@@ -77,6 +113,48 @@ inline void SyncedMemory::to_gpu() {
 #endif
 }
 
+/**drop_reduced() 丢弃16位副本 数据将被改写时调用*/
+inline void SyncedMemory::drop_reduced() {
+  if (reduced_precision_ != FP32) {
+    std::vector<uint16_t>().swap(reduced_);
+    reduced_precision_ = FP32;
+  }
+}
+
+/**set_storage() 将数据转为16位副本 释放CPU端内存 FP32则展开并丢弃副本*/
+template <typename Dtype>
+void SyncedMemory::set_storage(StoragePrecision precision) {
+  CHECK_EQ(size_ % sizeof(Dtype), 0) << "size is not a multiple of Dtype.";
+  ++version_;
+  if (precision == FP32) {
+    to_cpu();
+    drop_reduced();
+    return;
+  }
+  // Writes drop the copy, so one of the same precision is up to date.
+  if (reduced_precision_ != precision) {
+    const Dtype* data = static_cast<const Dtype*>(cpu_data());
+    const int count = size_ / sizeof(Dtype);
+    reduced_.resize(count);
+    if (count > 0) {
+      caffe_cpu_reduce_precision(count, data, precision, &reduced_[0]);
+    }
+    reduced_precision_ = precision;
+    reduced_element_size_ = sizeof(Dtype);
+  }
+  if (own_cpu_data_) {
+    CaffeFreeHost(cpu_ptr_, size_, cpu_malloc_use_cuda_, cpu_malloc_policy_);
+    cpu_ptr_ = NULL;
+    own_cpu_data_ = false;
+  }
+  // Any device copy holds the full precision values, which no longer match
+  // the rounded ones.
+  head_ = HEAD_AT_REDUCED;
+}
+
+template void SyncedMemory::set_storage<float>(StoragePrecision precision);
+template void SyncedMemory::set_storage<double>(StoragePrecision precision);
+
 /**cpu_data() 返回CPU端数据指针 只读 不变动head_状态*/
 const void* SyncedMemory::cpu_data() {
   to_cpu();
@@ -85,8 +163,10 @@ const void* SyncedMemory::cpu_data() {
 /**set_cpu_data() 设置CPU端数据指针 将指针设置到data 将head_ 设为CPU*/
 void SyncedMemory::set_cpu_data(void* data) {
   CHECK(data);
+  drop_reduced();
+  ++version_;
   if (own_cpu_data_) {
-    CaffeFreeHost(cpu_ptr_, cpu_malloc_use_cuda_);
+    CaffeFreeHost(cpu_ptr_, size_, cpu_malloc_use_cuda_, cpu_malloc_policy_);
   }
   cpu_ptr_ = data;
   head_ = HEAD_AT_CPU;
@@ -108,6 +188,8 @@ const void* SyncedMemory::gpu_data() {
 void SyncedMemory::set_gpu_data(void* data) {
 #ifndef CPU_ONLY
   CHECK(data);
+  drop_reduced();
+  ++version_;
   if (own_gpu_data_) {
     int initial_device;
     cudaGetDevice(&initial_device);
@@ -128,6 +210,17 @@ void SyncedMemory::set_gpu_data(void* data) {
 /**mutable_cpu_data() 返回CPU端数据指针 读写 将head_ 设为CPU*/
 void* SyncedMemory::mutable_cpu_data() {
   to_cpu();
+  drop_reduced();
+  ++version_;
+  head_ = HEAD_AT_CPU;
+  return cpu_ptr_;
+}
+
+/**mutable_cpu_data_uninitialized() 同mutable_cpu_data 但首次分配的内存不清零*/
+void* SyncedMemory::mutable_cpu_data_uninitialized() {
+  to_cpu(false);
+  drop_reduced();
+  ++version_;
   head_ = HEAD_AT_CPU;
   return cpu_ptr_;
 }
@@ -136,6 +229,8 @@ void* SyncedMemory::mutable_cpu_data() {
 void* SyncedMemory::mutable_gpu_data() {
 #ifndef CPU_ONLY
   to_gpu();
+  drop_reduced();
+  ++version_;
   head_ = HEAD_AT_GPU;
   return gpu_ptr_;
 #else
@@ -106,6 +106,52 @@ TYPED_TEST(BatchReindexLayerTest, TestForward) {
   this->TestForward();
 }
 
+TYPED_TEST(BatchReindexLayerTest, TestForwardIdentity) {
+  typedef typename TypeParam::Dtype Dtype;
+  // Indices 0, ..., N - 1 forward the bottom itself; others copy again.
+  vector<int> permsz(1, 5);
+  this->blob_bottom_permute_->Reshape(permsz);
+  for (int i = 0; i < 5; ++i) {
+    this->blob_bottom_permute_->mutable_cpu_data()[i] = i;
+  }
+  LayerParameter layer_param;
+  BatchReindexLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  // Only once allowed to.
+  EXPECT_NE(this->blob_bottom_->cpu_data(), this->blob_top_->cpu_data());
+  layer.set_share_bottom_data(true);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(this->blob_bottom_->cpu_data(), this->blob_top_->cpu_data());
+  EXPECT_EQ(this->blob_bottom_->cpu_diff(), this->blob_top_->cpu_diff());
+  this->blob_bottom_permute_->mutable_cpu_data()[0] = 1;
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_NE(this->blob_bottom_->cpu_data(), this->blob_top_->cpu_data());
+  const int inner_dim = this->blob_bottom_->count(1);
+  const Dtype* bottom_data = this->blob_bottom_->cpu_data();
+  const Dtype* top_data = this->blob_top_->cpu_data();
+  for (int i = 0; i < this->blob_top_->count(); ++i) {
+    const int n = i / inner_dim;
+    EXPECT_EQ(bottom_data[(n == 0 ? 1 : n) * inner_dim + i % inner_dim],
+        top_data[i]);
+  }
+}
+
+TYPED_TEST(BatchReindexLayerTest, TestGradientIdentity) {
+  typedef typename TypeParam::Dtype Dtype;
+  vector<int> permsz(1, 5);
+  this->blob_bottom_permute_->Reshape(permsz);
+  for (int i = 0; i < 5; ++i) {
+    this->blob_bottom_permute_->mutable_cpu_data()[i] = i;
+  }
+  LayerParameter layer_param;
+  BatchReindexLayer<Dtype> layer(layer_param);
+  layer.set_share_bottom_data(true);
+  GradientChecker<Dtype> checker(1e-4, 1e-2);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_, 0);
+}
+
 TYPED_TEST(BatchReindexLayerTest, TestGradient) {
   typedef typename TypeParam::Dtype Dtype;
   LayerParameter layer_param;
@@ -17,6 +17,9 @@ using caffe::CAFFE_TEST_CUDA_PROP;
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   caffe::GlobalInit(&argc, &argv);
+  // Make layers that skip zero-filling their outputs fail loudly if they
+  // read anything they did not write first.
+  caffe::SyncedMemory::set_poison_uninitialized(true);
 #ifndef CPU_ONLY
   // Before starting testing, let's first print out a few cuda defice info.
   int device;
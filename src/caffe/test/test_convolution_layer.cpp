@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -5,7 +9,20 @@
 #include "caffe/blob.hpp"
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
+#include "caffe/layer_factory.hpp"
+#include "caffe/layers/auto_conv_layer.hpp"
+#include "caffe/layers/blocked_conv_layer.hpp"
 #include "caffe/layers/conv_layer.hpp"
+#include "caffe/layers/direct_conv_layer.hpp"
+#include "caffe/layers/fft_conv_layer.hpp"
+#include "caffe/layers/implicit_gemm_conv_layer.hpp"
+#include "caffe/layers/prelu_layer.hpp"
+#include "caffe/layers/quantized_conv_layer.hpp"
+#include "caffe/layers/winograd_conv_layer.hpp"
+#include "caffe/util/blocked_layout.hpp"
+#include "caffe/util/conv_autotune.hpp"
+#include "caffe/util/int8_gemm.hpp"
+#include "caffe/util/io.hpp"
 
 #ifdef USE_CUDNN
 #include "caffe/layers/cudnn_conv_layer.hpp"
@@ -811,6 +828,1399 @@ TYPED_TEST(ConvolutionLayerTest, TestGradientGroup) {
       this->blob_top_vec_);
 }
 
+template <typename Dtype>
+class WinogradConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  WinogradConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 4, 11, 9)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillerParameter filler_param;
+    filler_param.set_value(1.);
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+
+  virtual ~WinogradConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  LayerParameter MakeParam(int tile, int pad, int stride, int group) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->add_kernel_size(3);
+    convolution_param->add_pad(pad);
+    convolution_param->add_stride(stride);
+    convolution_param->set_num_output(6);
+    convolution_param->set_group(group);
+    convolution_param->set_winograd_tile(tile);
+    convolution_param->set_engine(ConvolutionParameter_Engine_WINOGRAD);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  void ExpectNear(const Dtype* expected, const Dtype* actual, int count,
+      Dtype tolerance) {
+    for (int i = 0; i < count; ++i) {
+      EXPECT_NEAR(expected[i], actual[i],
+          tolerance * std::max(Dtype(1), std::fabs(expected[i])));
+    }
+  }
+
+  // Runs forward and backward through the Winograd and the im2col layers
+  // with the same weights and compares all results.
+  void CompareWithIm2col(const LayerParameter& layer_param,
+      Dtype tolerance) {
+    ConvolutionLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    WinogradConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    ASSERT_EQ(ref_blob_top_->count(), blob_top_->count());
+    ExpectNear(ref_blob_top_->cpu_data(), blob_top_->cpu_data(),
+        blob_top_->count(), tolerance);
+    // Backward, from the same top diff.
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(ref_blob_top_);
+    caffe_copy(blob_top_->count(), ref_blob_top_->cpu_data(),
+        blob_top_->mutable_cpu_diff());
+    caffe_copy(ref_blob_top_->count(), ref_blob_top_->cpu_data(),
+        ref_blob_top_->mutable_cpu_diff());
+    const vector<bool> propagate_down(1, true);
+    ref_layer.Backward(ref_blob_top_vec_, propagate_down, blob_bottom_vec_);
+    Blob<Dtype> ref_bottom_diff;
+    ref_bottom_diff.CopyFrom(*blob_bottom_, true, true);
+    layer.Backward(blob_top_vec_, propagate_down, blob_bottom_vec_);
+    ExpectNear(ref_bottom_diff.cpu_diff(), blob_bottom_->cpu_diff(),
+        blob_bottom_->count(), tolerance);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      ExpectNear(ref_layer.blobs()[i]->cpu_diff(),
+          layer.blobs()[i]->cpu_diff(), layer.blobs()[i]->count(),
+          tolerance);
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(WinogradConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(WinogradConvolutionLayerTest, TestF2x2AgainstIm2col) {
+  this->CompareWithIm2col(this->MakeParam(2, 1, 1, 1), 1e-4);
+  this->CompareWithIm2col(this->MakeParam(2, 0, 1, 1), 1e-4);
+  this->CompareWithIm2col(this->MakeParam(2, 2, 1, 2), 1e-4);
+}
+
+TYPED_TEST(WinogradConvolutionLayerTest, TestF4x4AgainstIm2col) {
+  this->CompareWithIm2col(this->MakeParam(4, 1, 1, 1), 1e-3);
+  this->CompareWithIm2col(this->MakeParam(4, 0, 1, 1), 1e-3);
+  this->CompareWithIm2col(this->MakeParam(4, 2, 1, 2), 1e-3);
+}
+
+TYPED_TEST(WinogradConvolutionLayerTest, TestFallback) {
+  // Strided, and padded too much for the Winograd backward pass.
+  this->CompareWithIm2col(this->MakeParam(4, 1, 2, 1), 1e-6);
+  this->CompareWithIm2col(this->MakeParam(4, 3, 1, 1), 1e-3);
+}
+
+TYPED_TEST(WinogradConvolutionLayerTest, TestWeightUpdate) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(4, 1, 1, 1);
+  ConvolutionLayer<Dtype> ref_layer(layer_param);
+  ref_layer.SetUp(this->blob_bottom_vec_, this->ref_blob_top_vec_);
+  WinogradConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  // The cached filter transforms must follow new weights.
+  for (int i = 0; i < layer.blobs().size(); ++i) {
+    layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+  }
+  ref_layer.Forward(this->blob_bottom_vec_, this->ref_blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  this->ExpectNear(this->ref_blob_top_->cpu_data(),
+      this->blob_top_->cpu_data(), this->blob_top_->count(), 1e-3);
+  // Weights held at 16 bits are transformed without being widened in place.
+  layer.blobs()[0]->set_data_storage(BF16);
+  ref_layer.blobs()[0]->set_data_storage(BF16);
+  ref_layer.blobs()[0]->set_data_storage(FP32);
+  ref_layer.Forward(this->blob_bottom_vec_, this->ref_blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(SyncedMemory::HEAD_AT_REDUCED, layer.blobs()[0]->data()->head());
+  this->ExpectNear(this->ref_blob_top_->cpu_data(),
+      this->blob_top_->cpu_data(), this->blob_top_->count(), 1e-3);
+}
+
+TYPED_TEST(WinogradConvolutionLayerTest, TestGradient) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(2, 1, 1, 2);
+  // A smaller bottom keeps the exhaustive check fast; 5x6 still leaves
+  // partial tiles.
+  this->blob_bottom_->Reshape(2, 2, 5, 6);
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(this->blob_bottom_);
+  WinogradConvolutionLayer<Dtype> layer(layer_param);
+  GradientChecker<Dtype> checker(1e-2, 1e-3);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_);
+}
+
+template <typename Dtype>
+class ImplicitGemmConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  ImplicitGemmConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 8, 19, 17)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillBottom();
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+
+  virtual ~ImplicitGemmConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  void FillBottom() {
+    FillerParameter filler_param;
+    filler_param.set_value(1.);
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+  }
+
+  LayerParameter MakeParam(int kernel_h, int kernel_w, int pad, int stride,
+      int dilation, int group) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->set_kernel_h(kernel_h);
+    convolution_param->set_kernel_w(kernel_w);
+    convolution_param->add_pad(pad);
+    convolution_param->add_stride(stride);
+    convolution_param->add_dilation(dilation);
+    convolution_param->set_num_output(6);
+    convolution_param->set_group(group);
+    convolution_param->set_engine(ConvolutionParameter_Engine_IMPLICIT_GEMM);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  void ExpectNear(const Dtype* expected, const Dtype* actual, int count) {
+    const Dtype tolerance = 1e-4;
+    for (int i = 0; i < count; ++i) {
+      EXPECT_NEAR(expected[i], actual[i],
+          tolerance * std::max(Dtype(1), std::fabs(expected[i])));
+    }
+  }
+
+  // Runs forward and backward through the implicit-GEMM and the im2col layers
+  // with the same weights and compares all results.
+  void CompareWithIm2col(const LayerParameter& layer_param) {
+    ConvolutionLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    ImplicitGemmConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    ASSERT_EQ(ref_blob_top_->count(), blob_top_->count());
+    ExpectNear(ref_blob_top_->cpu_data(), blob_top_->cpu_data(),
+        blob_top_->count());
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(ref_blob_top_);
+    caffe_copy(blob_top_->count(), ref_blob_top_->cpu_data(),
+        blob_top_->mutable_cpu_diff());
+    caffe_copy(ref_blob_top_->count(), ref_blob_top_->cpu_data(),
+        ref_blob_top_->mutable_cpu_diff());
+    const vector<bool> propagate_down(1, true);
+    ref_layer.Backward(ref_blob_top_vec_, propagate_down, blob_bottom_vec_);
+    Blob<Dtype> ref_bottom_diff;
+    ref_bottom_diff.CopyFrom(*blob_bottom_, true, true);
+    layer.Backward(blob_top_vec_, propagate_down, blob_bottom_vec_);
+    ExpectNear(ref_bottom_diff.cpu_diff(), blob_bottom_->cpu_diff(),
+        blob_bottom_->count());
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      ExpectNear(ref_layer.blobs()[i]->cpu_diff(),
+          layer.blobs()[i]->cpu_diff(), layer.blobs()[i]->count());
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(ImplicitGemmConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(ImplicitGemmConvolutionLayerTest, TestAgainstIm2col) {
+  // Several output pixel panels, with a partial last one.
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 1, 1, 1));
+  this->CompareWithIm2col(this->MakeParam(3, 3, 0, 1, 1, 2));
+  this->CompareWithIm2col(this->MakeParam(5, 3, 2, 2, 1, 1));
+  this->CompareWithIm2col(this->MakeParam(3, 3, 2, 1, 2, 2));
+  this->CompareWithIm2col(this->MakeParam(1, 1, 0, 2, 1, 1));
+  this->CompareWithIm2col(this->MakeParam(1, 1, 0, 1, 1, 1));
+}
+
+TYPED_TEST(ImplicitGemmConvolutionLayerTest, TestDeepReduction) {
+  // More im2col rows than fit in one cache block.
+  this->blob_bottom_->Reshape(2, 40, 7, 6);
+  this->FillBottom();
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 1, 1, 1));
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 2, 1, 2));
+}
+
+TYPED_TEST(ImplicitGemmConvolutionLayerTest, TestGradient) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(3, 2, 1, 2, 1, 2);
+  this->blob_bottom_->Reshape(2, 2, 6, 5);
+  this->FillBottom();
+  ImplicitGemmConvolutionLayer<Dtype> layer(layer_param);
+  GradientChecker<Dtype> checker(1e-2, 1e-3);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_);
+}
+
+template <typename Dtype>
+class BatchParallelConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  BatchParallelConvolutionLayerTest()
+      : num_threads_(Caffe::num_threads()),
+        blob_bottom_(new Blob<Dtype>(5, 4, 9, 8)),
+        blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillerParameter filler_param;
+    filler_param.set_value(1.);
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    // More threads than images would leave shares empty: 5 images over 4
+    // threads gives shares of unequal size.
+    Caffe::set_num_threads(4);
+  }
+
+  virtual ~BatchParallelConvolutionLayerTest() {
+    Caffe::set_num_threads(num_threads_);
+    delete blob_bottom_;
+    delete blob_top_;
+  }
+
+  LayerParameter MakeParam(int kernel, int pad, int stride, int group) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->add_kernel_size(kernel);
+    convolution_param->add_pad(pad);
+    convolution_param->add_stride(stride);
+    convolution_param->set_num_output(6);
+    convolution_param->set_group(group);
+    convolution_param->set_batch_parallel(true);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  // Runs forward and backward with the given weights and top diff, and
+  // returns the top data, the bottom diff and the parameter diffs.
+  void Run(const LayerParameter& layer_param,
+      const vector<shared_ptr<Blob<Dtype> > >& weights,
+      const Blob<Dtype>& top_diff, vector<shared_ptr<Blob<Dtype> > >* out) {
+    ConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*weights[i]);
+    }
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    caffe_copy(top_diff.count(), top_diff.cpu_data(),
+        blob_top_->mutable_cpu_diff());
+    layer.Backward(blob_top_vec_, vector<bool>(1, true), blob_bottom_vec_);
+    out->clear();
+    out->push_back(shared_ptr<Blob<Dtype> >(new Blob<Dtype>()));
+    out->back()->CopyFrom(*blob_top_, false, true);
+    out->push_back(shared_ptr<Blob<Dtype> >(new Blob<Dtype>()));
+    out->back()->CopyFrom(*blob_bottom_, true, true);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      out->push_back(shared_ptr<Blob<Dtype> >(new Blob<Dtype>()));
+      out->back()->CopyFrom(*layer.blobs()[i], true, true);
+    }
+  }
+
+  // Checks that splitting the batch across threads, or batching its GEMMs,
+  // gives the serial per-image results, and the same results from one run
+  // to the next.
+  void CompareWithSerial(const LayerParameter& layer_param) {
+    LayerParameter serial_param = layer_param;
+    serial_param.mutable_convolution_param()->set_batch_parallel(false);
+    serial_param.mutable_convolution_param()->clear_batch_gemm_memory();
+    ConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    Blob<Dtype> top_diff(blob_top_->shape());
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(&top_diff);
+    vector<shared_ptr<Blob<Dtype> > > serial, parallel, again;
+    Run(serial_param, layer.blobs(), top_diff, &serial);
+    Run(layer_param, layer.blobs(), top_diff, &parallel);
+    Run(layer_param, layer.blobs(), top_diff, &again);
+    ASSERT_EQ(serial.size(), parallel.size());
+    const Dtype tolerance = 1e-4;
+    for (int i = 0; i < serial.size(); ++i) {
+      const Dtype* expected = i == 0 ? serial[i]->cpu_data() :
+          serial[i]->cpu_diff();
+      const Dtype* actual = i == 0 ? parallel[i]->cpu_data() :
+          parallel[i]->cpu_diff();
+      const Dtype* repeated = i == 0 ? again[i]->cpu_data() :
+          again[i]->cpu_diff();
+      for (int j = 0; j < serial[i]->count(); ++j) {
+        EXPECT_NEAR(expected[j], actual[j],
+            tolerance * std::max(Dtype(1), std::fabs(expected[j])));
+        EXPECT_EQ(actual[j], repeated[j]);
+      }
+    }
+  }
+
+  const int num_threads_;
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+};
+
+TYPED_TEST_CASE(BatchParallelConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(BatchParallelConvolutionLayerTest, TestAgainstSerial) {
+  this->CompareWithSerial(this->MakeParam(3, 1, 1, 1));
+  this->CompareWithSerial(this->MakeParam(3, 0, 2, 2));
+  this->CompareWithSerial(this->MakeParam(1, 0, 1, 1));
+}
+
+TYPED_TEST(BatchParallelConvolutionLayerTest, TestFewerImagesThanThreads) {
+  this->blob_bottom_->Reshape(2, 4, 9, 8);
+  this->CompareWithSerial(this->MakeParam(3, 1, 1, 1));
+}
+
+TYPED_TEST(BatchParallelConvolutionLayerTest, TestBatchGemm) {
+  typedef TypeParam Dtype;
+  // The columns and output of one image of the 3x3 convolution, and the
+  // columns of the image being im2col'ed.
+  const int image_bytes = (4 * 3 * 3 + 6) * 9 * 8 * sizeof(Dtype);
+  const int col_bytes = 4 * 3 * 3 * 9 * 8 * sizeof(Dtype);
+  LayerParameter layer_param = this->MakeParam(3, 1, 1, 1);
+  // Two images per GEMM, with a single one left at the end.
+  layer_param.mutable_convolution_param()->set_batch_gemm_memory(
+      2 * image_bytes + col_bytes);
+  this->CompareWithSerial(layer_param);
+  // The whole batch in one GEMM, even for a budget past the int range.
+  layer_param.mutable_convolution_param()->set_batch_gemm_memory(
+      100 * image_bytes);
+  this->CompareWithSerial(layer_param);
+  layer_param.mutable_convolution_param()->set_batch_gemm_memory(1LL << 40);
+  this->CompareWithSerial(layer_param);
+  layer_param = this->MakeParam(3, 0, 2, 2);
+  layer_param.mutable_convolution_param()->set_batch_gemm_memory(
+      100 * image_bytes);
+  this->CompareWithSerial(layer_param);
+  layer_param = this->MakeParam(1, 0, 1, 1);
+  layer_param.mutable_convolution_param()->set_batch_gemm_memory(
+      100 * image_bytes);
+  this->CompareWithSerial(layer_param);
+}
+
+TYPED_TEST(BatchParallelConvolutionLayerTest, TestGradient) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(3, 1, 2, 2);
+  this->blob_bottom_->Reshape(3, 2, 5, 4);
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(this->blob_bottom_);
+  ConvolutionLayer<Dtype> layer(layer_param);
+  GradientChecker<Dtype> checker(1e-2, 1e-3);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_);
+}
+
+template <typename Dtype>
+class DirectConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  DirectConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 8, 11, 10)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillBottom();
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+
+  virtual ~DirectConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  void FillBottom() {
+    FillerParameter filler_param;
+    filler_param.set_value(1.);
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+  }
+
+  LayerParameter MakeParam(int kernel_h, int kernel_w, int pad, int stride,
+      int dilation, int group, int num_output) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->set_kernel_h(kernel_h);
+    convolution_param->set_kernel_w(kernel_w);
+    convolution_param->add_pad(pad);
+    convolution_param->add_stride(stride);
+    convolution_param->add_dilation(dilation);
+    convolution_param->set_num_output(num_output);
+    convolution_param->set_group(group);
+    convolution_param->set_engine(ConvolutionParameter_Engine_DIRECT);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  void ExpectNear(const Dtype* expected, const Dtype* actual, int count) {
+    const Dtype tolerance = 1e-4;
+    for (int i = 0; i < count; ++i) {
+      EXPECT_NEAR(expected[i], actual[i],
+          tolerance * std::max(Dtype(1), std::fabs(expected[i])));
+    }
+  }
+
+  // Runs forward and backward through the direct and the im2col layers with
+  // the same weights and compares all results.
+  void CompareWithIm2col(const LayerParameter& layer_param) {
+    ConvolutionLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    DirectConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    ASSERT_EQ(ref_blob_top_->count(), blob_top_->count());
+    ExpectNear(ref_blob_top_->cpu_data(), blob_top_->cpu_data(),
+        blob_top_->count());
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(ref_blob_top_);
+    caffe_copy(blob_top_->count(), ref_blob_top_->cpu_data(),
+        blob_top_->mutable_cpu_diff());
+    caffe_copy(ref_blob_top_->count(), ref_blob_top_->cpu_data(),
+        ref_blob_top_->mutable_cpu_diff());
+    const vector<bool> propagate_down(1, true);
+    ref_layer.Backward(ref_blob_top_vec_, propagate_down, blob_bottom_vec_);
+    Blob<Dtype> ref_bottom_diff;
+    ref_bottom_diff.CopyFrom(*blob_bottom_, true, true);
+    layer.Backward(blob_top_vec_, propagate_down, blob_bottom_vec_);
+    ExpectNear(ref_bottom_diff.cpu_diff(), blob_bottom_->cpu_diff(),
+        blob_bottom_->count());
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      ExpectNear(ref_layer.blobs()[i]->cpu_diff(),
+          layer.blobs()[i]->cpu_diff(), layer.blobs()[i]->count());
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(DirectConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(DirectConvolutionLayerTest, TestDepthwiseAgainstIm2col) {
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 1, 1, 8, 8));
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 2, 1, 8, 8));
+  this->CompareWithIm2col(this->MakeParam(5, 3, 2, 1, 2, 8, 8));
+  this->CompareWithIm2col(this->MakeParam(3, 3, 0, 3, 1, 8, 8));
+  // Two outputs per channel.
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 1, 1, 8, 16));
+}
+
+TYPED_TEST(DirectConvolutionLayerTest, TestGroupAgainstIm2col) {
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 1, 1, 4, 8));
+  // The DEFAULT engine keeps im2col for groups that are not depthwise.
+  LayerParameter default_param = this->MakeParam(3, 3, 1, 1, 1, 4, 8);
+  default_param.mutable_convolution_param()->clear_engine();
+  this->CompareWithIm2col(default_param);
+  this->CompareWithIm2col(this->MakeParam(3, 2, 2, 2, 1, 2, 6));
+  // Wider than the direct kernels handle.
+  this->blob_bottom_->Reshape(2, 18, 7, 6);
+  this->FillBottom();
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 1, 1, 2, 4));
+}
+
+TYPED_TEST(DirectConvolutionLayerTest, TestDefaultEngine) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(3, 3, 1, 1, 1, 8, 8);
+  layer_param.set_type("Convolution");
+  layer_param.mutable_convolution_param()->clear_engine();
+  shared_ptr<Layer<Dtype> > layer =
+      LayerRegistry<Dtype>::CreateLayer(layer_param);
+#ifndef USE_CUDNN
+  EXPECT_TRUE(dynamic_cast<DirectConvolutionLayer<Dtype>*>(layer.get()));
+#endif
+  layer_param.mutable_convolution_param()->set_group(1);
+  layer = LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_FALSE(dynamic_cast<DirectConvolutionLayer<Dtype>*>(layer.get()));
+}
+
+TYPED_TEST(DirectConvolutionLayerTest, TestGradient) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(3, 2, 1, 2, 1, 2, 4);
+  this->blob_bottom_->Reshape(2, 4, 6, 5);
+  this->FillBottom();
+  DirectConvolutionLayer<Dtype> layer(layer_param);
+  GradientChecker<Dtype> checker(1e-2, 1e-3);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_);
+}
+
+template <typename Dtype>
+class FFTConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  FFTConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 8, 24, 20)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillBottom();
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+
+  virtual ~FFTConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  void FillBottom() {
+    FillerParameter filler_param;
+    filler_param.set_value(1.);
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+  }
+
+  LayerParameter MakeParam(int kernel_h, int kernel_w, int pad_h, int pad_w,
+      int dilation, int group, int num_output) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->set_kernel_h(kernel_h);
+    convolution_param->set_kernel_w(kernel_w);
+    convolution_param->set_pad_h(pad_h);
+    convolution_param->set_pad_w(pad_w);
+    convolution_param->add_dilation(dilation);
+    convolution_param->set_num_output(num_output);
+    convolution_param->set_group(group);
+    convolution_param->set_engine(ConvolutionParameter_Engine_FFT);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  void ExpectNear(const Dtype* expected, const Dtype* actual, int count) {
+    const Dtype tolerance = 1e-4;
+    for (int i = 0; i < count; ++i) {
+      EXPECT_NEAR(expected[i], actual[i],
+          tolerance * std::max(Dtype(1), std::fabs(expected[i])));
+    }
+  }
+
+  // Runs forward and backward through the FFT and the im2col layers with the
+  // same weights and compares all results; checks that the FFT layer took
+  // the FFT path if expected to.
+  void CompareWithIm2col(const LayerParameter& layer_param, bool fft) {
+    ConvolutionLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    FFTConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    EXPECT_EQ(fft, layer.use_fft());
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    ASSERT_EQ(ref_blob_top_->count(), blob_top_->count());
+    ExpectNear(ref_blob_top_->cpu_data(), blob_top_->cpu_data(),
+        blob_top_->count());
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(ref_blob_top_);
+    caffe_copy(blob_top_->count(), ref_blob_top_->cpu_data(),
+        blob_top_->mutable_cpu_diff());
+    caffe_copy(ref_blob_top_->count(), ref_blob_top_->cpu_data(),
+        ref_blob_top_->mutable_cpu_diff());
+    const vector<bool> propagate_down(1, true);
+    ref_layer.Backward(ref_blob_top_vec_, propagate_down, blob_bottom_vec_);
+    Blob<Dtype> ref_bottom_diff;
+    ref_bottom_diff.CopyFrom(*blob_bottom_, true, true);
+    layer.Backward(blob_top_vec_, propagate_down, blob_bottom_vec_);
+    ExpectNear(ref_bottom_diff.cpu_diff(), blob_bottom_->cpu_diff(),
+        blob_bottom_->count());
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      ExpectNear(ref_layer.blobs()[i]->cpu_diff(),
+          layer.blobs()[i]->cpu_diff(), layer.blobs()[i]->count());
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(FFTConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(FFTConvolutionLayerTest, Test2DAgainstIm2col) {
+  this->CompareWithIm2col(this->MakeParam(7, 7, 3, 3, 1, 1, 8), true);
+  // One tile across the width, several down the height.
+  this->CompareWithIm2col(this->MakeParam(11, 11, 5, 5, 1, 1, 8), true);
+  this->CompareWithIm2col(this->MakeParam(9, 5, 0, 2, 1, 1, 8), true);
+  this->CompareWithIm2col(this->MakeParam(5, 5, 4, 4, 2, 1, 8), true);
+  this->CompareWithIm2col(this->MakeParam(7, 7, 3, 3, 1, 2, 16), true);
+}
+
+TYPED_TEST(FFTConvolutionLayerTest, Test1DAgainstIm2col) {
+  this->blob_bottom_->Reshape(2, 8, 1, 200);
+  this->FillBottom();
+  this->CompareWithIm2col(this->MakeParam(1, 15, 0, 7, 1, 1, 8), true);
+  this->CompareWithIm2col(this->MakeParam(1, 13, 0, 0, 1, 1, 8), true);
+}
+
+TYPED_TEST(FFTConvolutionLayerTest, TestCrossover) {
+  // Small kernels are cheaper through im2col + GEMM.
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 1, 1, 1, 8), false);
+  this->CompareWithIm2col(this->MakeParam(1, 1, 0, 0, 1, 1, 8), false);
+  // Strided convolutions do not go through the FFT.
+  LayerParameter layer_param = this->MakeParam(7, 7, 3, 3, 1, 1, 8);
+  layer_param.mutable_convolution_param()->set_stride_h(2);
+  layer_param.mutable_convolution_param()->set_stride_w(2);
+  this->CompareWithIm2col(layer_param, false);
+}
+
+TYPED_TEST(FFTConvolutionLayerTest, TestWeightUpdate) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(7, 7, 3, 3, 1, 1, 8);
+  ConvolutionLayer<Dtype> ref_layer(layer_param);
+  ref_layer.SetUp(this->blob_bottom_vec_, this->ref_blob_top_vec_);
+  FFTConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  // The cached filter transforms must follow new weights.
+  for (int i = 0; i < layer.blobs().size(); ++i) {
+    layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+  }
+  ref_layer.Forward(this->blob_bottom_vec_, this->ref_blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  this->ExpectNear(this->ref_blob_top_->cpu_data(),
+      this->blob_top_->cpu_data(), this->blob_top_->count());
+  // Weights held at 16 bits are transformed without being widened in place.
+  layer.blobs()[0]->set_data_storage(BF16);
+  ref_layer.blobs()[0]->set_data_storage(BF16);
+  ref_layer.blobs()[0]->set_data_storage(FP32);
+  ref_layer.Forward(this->blob_bottom_vec_, this->ref_blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(SyncedMemory::HEAD_AT_REDUCED, layer.blobs()[0]->data()->head());
+  this->ExpectNear(this->ref_blob_top_->cpu_data(),
+      this->blob_top_->cpu_data(), this->blob_top_->count());
+}
+
+TYPED_TEST(FFTConvolutionLayerTest, TestGradient) {
+  typedef TypeParam Dtype;
+  // The FFT only pays off for shapes too large for an exhaustive check, so
+  // check the gradient of the sum of squares of the outputs. That is
+  // quadratic in every input and weight, so central differences are exact
+  // even with a large step; that and small weights keep float rounding out
+  // of the way.
+  LayerParameter layer_param = this->MakeParam(1, 15, 0, 7, 1, 1, 4);
+  layer_param.mutable_convolution_param()->mutable_weight_filler()->set_std(
+      0.1);
+  this->blob_bottom_->Reshape(2, 4, 1, 50);
+  this->FillBottom();
+  FFTConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_TRUE(layer.use_fft());
+  GradientChecker<Dtype> checker(1e-1, 1e-3);
+  checker.CheckGradient(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_);
+}
+
+template <typename Dtype>
+class AutoConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  AutoConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 4, 10, 9)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillerParameter filler_param;
+    filler_param.set_value(1.);
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+    ConvAlgorithmCache::Get().Clear();
+  }
+
+  virtual ~AutoConvolutionLayerTest() {
+    ConvAlgorithmCache::Get().Clear();
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  LayerParameter MakeParam(int group, int num_output) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->add_kernel_size(3);
+    convolution_param->add_pad(1);
+    convolution_param->set_num_output(num_output);
+    convolution_param->set_group(group);
+    convolution_param->set_engine(ConvolutionParameter_Engine_AUTO);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  void ExpectNear(const Dtype* expected, const Dtype* actual, int count) {
+    const Dtype tolerance = 1e-4;
+    for (int i = 0; i < count; ++i) {
+      EXPECT_NEAR(expected[i], actual[i],
+          tolerance * std::max(Dtype(1), std::fabs(expected[i])));
+    }
+  }
+
+  // Runs forward and backward through the AUTO and the im2col layers with
+  // the same weights and compares all results.
+  void CompareWithIm2col(const LayerParameter& layer_param) {
+    LayerParameter ref_param(layer_param);
+    ref_param.mutable_convolution_param()->set_engine(
+        ConvolutionParameter_Engine_CAFFE);
+    ConvolutionLayer<Dtype> ref_layer(ref_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    AutoConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    ASSERT_EQ(ref_blob_top_->count(), blob_top_->count());
+    ExpectNear(ref_blob_top_->cpu_data(), blob_top_->cpu_data(),
+        blob_top_->count());
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(ref_blob_top_);
+    caffe_copy(blob_top_->count(), ref_blob_top_->cpu_data(),
+        blob_top_->mutable_cpu_diff());
+    caffe_copy(ref_blob_top_->count(), ref_blob_top_->cpu_data(),
+        ref_blob_top_->mutable_cpu_diff());
+    const vector<bool> propagate_down(1, true);
+    ref_layer.Backward(ref_blob_top_vec_, propagate_down, blob_bottom_vec_);
+    Blob<Dtype> ref_bottom_diff;
+    ref_bottom_diff.CopyFrom(*blob_bottom_, true, true);
+    layer.Backward(blob_top_vec_, propagate_down, blob_bottom_vec_);
+    ExpectNear(ref_bottom_diff.cpu_diff(), blob_bottom_->cpu_diff(),
+        blob_bottom_->count());
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      ExpectNear(ref_layer.blobs()[i]->cpu_diff(),
+          layer.blobs()[i]->cpu_diff(), layer.blobs()[i]->count());
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(AutoConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(AutoConvolutionLayerTest, TestAgainstIm2col) {
+  this->CompareWithIm2col(this->MakeParam(1, 8));
+  this->CompareWithIm2col(this->MakeParam(4, 4));
+}
+
+TYPED_TEST(AutoConvolutionLayerTest, TestCacheFile) {
+  typedef TypeParam Dtype;
+  string filename;
+  MakeTempFilename(&filename);
+  LayerParameter layer_param = this->MakeParam(1, 8);
+  layer_param.mutable_convolution_param()->set_autotune_cache(filename);
+  string key;
+  {
+    AutoConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+    std::ifstream file(filename.c_str());
+    string line;
+    ASSERT_TRUE(static_cast<bool>(std::getline(file, line)));
+    const size_t tab = line.rfind('\t');
+    ASSERT_NE(string::npos, tab);
+    EXPECT_EQ(ConvolutionParameter_Engine_Name(layer.engine()),
+        line.substr(tab + 1));
+    key = line.substr(0, tab);
+    EXPECT_FALSE(static_cast<bool>(std::getline(file, line)));
+  }
+  // A later run takes the choice from the file instead of timing again.
+  {
+    std::ofstream file(filename.c_str(), std::ios::app);
+    file << key << "\tIMPLICIT_GEMM\n";
+  }
+  ConvAlgorithmCache::Get().Clear();
+  layer_param.mutable_convolution_param()->set_autotune(
+      ConvolutionParameter_AutotuneMode_NEVER_TUNE);
+  AutoConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(ConvolutionParameter_Engine_IMPLICIT_GEMM, layer.engine());
+  this->CompareWithIm2col(layer_param);
+}
+
+TYPED_TEST(AutoConvolutionLayerTest, TestNeverTune) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(1, 8);
+  layer_param.mutable_convolution_param()->set_autotune(
+      ConvolutionParameter_AutotuneMode_NEVER_TUNE);
+  AutoConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(ConvolutionParameter_Engine_CAFFE, layer.engine());
+  LayerParameter group_param = this->MakeParam(4, 4);
+  group_param.mutable_convolution_param()->set_autotune(
+      ConvolutionParameter_AutotuneMode_NEVER_TUNE);
+  AutoConvolutionLayer<Dtype> group_layer(group_param);
+  group_layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(ConvolutionParameter_Engine_DIRECT, group_layer.engine());
+  // Grouped convolutions that are not depthwise stay on im2col.
+  LayerParameter wide_group_param = this->MakeParam(2, 4);
+  wide_group_param.mutable_convolution_param()->set_autotune(
+      ConvolutionParameter_AutotuneMode_NEVER_TUNE);
+  AutoConvolutionLayer<Dtype> wide_group_layer(wide_group_param);
+  wide_group_layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(ConvolutionParameter_Engine_CAFFE, wide_group_layer.engine());
+}
+
+template <typename Dtype>
+class BlockedConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  BlockedConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 16, 9, 8)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillBottom();
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+
+  virtual ~BlockedConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  void FillBottom() {
+    FillerParameter filler_param;
+    filler_param.set_value(1.);
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+  }
+
+  LayerParameter MakeParam(int kernel_h, int kernel_w, int pad, int stride,
+      int dilation, int num_output) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->set_kernel_h(kernel_h);
+    convolution_param->set_kernel_w(kernel_w);
+    convolution_param->add_pad(pad);
+    convolution_param->add_stride(stride);
+    convolution_param->add_dilation(dilation);
+    convolution_param->set_num_output(num_output);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  // Runs the blocked layer, with its bottom in the layout of in_block, and
+  // the im2col layer with the same weights, and compares the outputs.
+  void CompareWithIm2col(const LayerParameter& layer_param, int in_block,
+      int out_block) {
+    ConvolutionLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    Blob<Dtype> bottom(blob_bottom_->shape());
+    reorder_channels_cpu(blob_bottom_->num(), blob_bottom_->channels(),
+        blob_bottom_->count(2), 0, in_block, blob_bottom_->cpu_data(),
+        bottom.mutable_cpu_data());
+    bottom.set_channel_block(in_block);
+    vector<Blob<Dtype>*> bottom_vec(1, &bottom);
+    LayerParameter blocked_param(layer_param);
+    blocked_param.mutable_convolution_param()->set_channel_block(out_block);
+    BlockedConvolutionLayer<Dtype> layer(blocked_param);
+    layer.SetUp(bottom_vec, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    layer.Forward(bottom_vec, blob_top_vec_);
+    EXPECT_EQ(out_block, blob_top_->channel_block());
+    ASSERT_TRUE(ref_blob_top_->shape() == blob_top_->shape());
+    Blob<Dtype> expected(ref_blob_top_->shape());
+    reorder_channels_cpu(ref_blob_top_->num(), ref_blob_top_->channels(),
+        ref_blob_top_->count(2), 0, out_block, ref_blob_top_->cpu_data(),
+        expected.mutable_cpu_data());
+    const Dtype tolerance = 1e-4;
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_data()[i], blob_top_->cpu_data()[i],
+          tolerance * std::max(Dtype(1), std::fabs(expected.cpu_data()[i])));
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(BlockedConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(BlockedConvolutionLayerTest, TestAgainstIm2col) {
+  const int in_blocks[] = { 0, 8, 4 };
+  for (int b = 0; b < 3; ++b) {
+    this->CompareWithIm2col(this->MakeParam(3, 3, 1, 1, 1, 16),
+        in_blocks[b], 8);
+    this->CompareWithIm2col(this->MakeParam(5, 3, 2, 2, 1, 8),
+        in_blocks[b], 8);
+    this->CompareWithIm2col(this->MakeParam(3, 3, 2, 1, 2, 16),
+        in_blocks[b], 4);
+    this->CompareWithIm2col(this->MakeParam(1, 1, 0, 1, 1, 24),
+        in_blocks[b], 8);
+  }
+}
+
+TYPED_TEST(BlockedConvolutionLayerTest, TestImageInput) {
+  // The first convolution of a chain reads the plain image.
+  this->blob_bottom_->Reshape(2, 3, 9, 8);
+  this->FillBottom();
+  this->CompareWithIm2col(this->MakeParam(3, 3, 1, 1, 1, 16), 0, 8);
+  this->CompareWithIm2col(this->MakeParam(7, 7, 3, 2, 1, 16), 0, 8);
+}
+
+TYPED_TEST(BlockedConvolutionLayerTest, TestWeightUpdate) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(3, 3, 1, 1, 1, 16);
+  ConvolutionLayer<Dtype> ref_layer(layer_param);
+  ref_layer.SetUp(this->blob_bottom_vec_, this->ref_blob_top_vec_);
+  LayerParameter blocked_param(layer_param);
+  blocked_param.mutable_convolution_param()->set_channel_block(8);
+  BlockedConvolutionLayer<Dtype> layer(blocked_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  Blob<Dtype>& ref_weights = *ref_layer.blobs()[0];
+  // The packed weights follow new weights, then weights held at 16 bits.
+  for (int pass = 0; pass < 3; ++pass) {
+    if (pass == 1) {
+      caffe_scal(ref_weights.count(), Dtype(-2),
+          ref_weights.mutable_cpu_data());
+    } else if (pass == 2) {
+      ref_weights.set_data_storage(BF16);
+      ref_weights.set_data_storage(FP32);
+    }
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    if (pass == 2) {
+      layer.blobs()[0]->set_data_storage(BF16);
+    }
+    ref_layer.Forward(this->blob_bottom_vec_, this->ref_blob_top_vec_);
+    layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+    Blob<Dtype> expected(this->ref_blob_top_->shape());
+    reorder_channels_cpu(expected.num(), expected.channels(),
+        expected.count(2), 0, 8, this->ref_blob_top_->cpu_data(),
+        expected.mutable_cpu_data());
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_data()[i], this->blob_top_->cpu_data()[i],
+          1e-4 * std::max(Dtype(1), std::fabs(expected.cpu_data()[i])));
+    }
+  }
+  EXPECT_EQ(SyncedMemory::HEAD_AT_REDUCED, layer.blobs()[0]->data()->head());
+}
+
+TYPED_TEST(BlockedConvolutionLayerTest, TestFactory) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(3, 3, 1, 1, 1, 16);
+  layer_param.set_type("Convolution");
+  layer_param.mutable_convolution_param()->set_channel_block(8);
+  shared_ptr<Layer<Dtype> > layer =
+      LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_TRUE(dynamic_cast<BlockedConvolutionLayer<Dtype>*>(layer.get()));
+}
+
+template <typename Dtype>
+class QuantizedConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  QuantizedConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 8, 9, 8)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillerParameter filler_param;
+    filler_param.set_value(1.);
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+
+  virtual ~QuantizedConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  LayerParameter MakeParam(int kernel, int pad, int stride, int dilation,
+      int group, int num_output) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->add_kernel_size(kernel);
+    convolution_param->add_pad(pad);
+    convolution_param->add_stride(stride);
+    convolution_param->add_dilation(dilation);
+    convolution_param->set_group(group);
+    convolution_param->set_num_output(num_output);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    layer_param.mutable_quantization_param()->set_precision(
+        QuantizationParameter_Precision_INT8);
+    return layer_param;
+  }
+
+  // Runs the int8 layer and the im2col layer with the same weights, and
+  // checks that the outputs agree within the quantization error.
+  void CompareWithIm2col(const LayerParameter& layer_param) {
+    ConvolutionLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    QuantizedConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    ASSERT_TRUE(ref_blob_top_->shape() == blob_top_->shape());
+    const Dtype* expected = ref_blob_top_->cpu_data();
+    const Dtype* actual = blob_top_->cpu_data();
+    Dtype diff_norm = 0, norm = 0;
+    for (int i = 0; i < blob_top_->count(); ++i) {
+      diff_norm += (actual[i] - expected[i]) * (actual[i] - expected[i]);
+      norm += expected[i] * expected[i];
+    }
+    EXPECT_LT(std::sqrt(diff_norm / norm), 0.03);
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(QuantizedConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(QuantizedConvolutionLayerTest, TestAgainstIm2col) {
+  this->CompareWithIm2col(this->MakeParam(3, 1, 1, 1, 1, 16));
+  this->CompareWithIm2col(this->MakeParam(3, 2, 2, 2, 1, 8));
+  this->CompareWithIm2col(this->MakeParam(1, 0, 1, 1, 1, 12));
+  this->CompareWithIm2col(this->MakeParam(5, 2, 2, 1, 4, 8));
+}
+
+TYPED_TEST(QuantizedConvolutionLayerTest, TestCalibratedRange) {
+  typedef TypeParam Dtype;
+  // Calibrated on this very bottom, the layer quantizes as it would on its
+  // own; a wider range loses precision but stays close.
+  LayerParameter layer_param = this->MakeParam(3, 1, 1, 1, 1, 16);
+  QuantizedConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  Blob<Dtype> dynamic;
+  dynamic.CopyFrom(*this->blob_top_, false, true);
+  const Dtype range = int8_max_abs(this->blob_bottom_->count(),
+      this->blob_bottom_->cpu_data());
+  layer_param.mutable_quantization_param()->set_bottom_range(range);
+  QuantizedConvolutionLayer<Dtype> calibrated(layer_param);
+  calibrated.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  for (int i = 0; i < layer.blobs().size(); ++i) {
+    calibrated.blobs()[i]->CopyFrom(*layer.blobs()[i]);
+  }
+  calibrated.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  for (int i = 0; i < dynamic.count(); ++i) {
+    EXPECT_NEAR(dynamic.cpu_data()[i], this->blob_top_->cpu_data()[i],
+        1e-4 * std::max(Dtype(1), std::fabs(dynamic.cpu_data()[i])));
+  }
+  layer_param.mutable_quantization_param()->set_bottom_range(range * 2);
+  this->CompareWithIm2col(layer_param);
+}
+
+TYPED_TEST(QuantizedConvolutionLayerTest, TestFactory) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(3, 1, 1, 1, 1, 16);
+  layer_param.set_type("Convolution");
+  layer_param.mutable_convolution_param()->set_engine(
+      ConvolutionParameter_Engine_WINOGRAD);
+  shared_ptr<Layer<Dtype> > layer =
+      LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_TRUE(dynamic_cast<QuantizedConvolutionLayer<Dtype>*>(layer.get()));
+  layer_param.clear_quantization_param();
+  layer = LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_FALSE(dynamic_cast<QuantizedConvolutionLayer<Dtype>*>(layer.get()));
+}
+
+template <typename Dtype>
+class ReducedStorageConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  ReducedStorageConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 6, 7, 8)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+
+  virtual ~ReducedStorageConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  // Runs ConvolutionLayer with weights held at 16 bits against one with the
+  // same weights rounded to that precision and widened back.
+  void CompareWithFloat(int kernel, int pad, int group,
+      StoragePrecision precision, bool batch_gemm = false) {
+    LayerParameter layer_param;
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    if (batch_gemm) {
+      convolution_param->set_batch_gemm_memory(1 << 30);
+    }
+    convolution_param->add_kernel_size(kernel);
+    convolution_param->add_pad(pad);
+    convolution_param->set_group(group);
+    convolution_param->set_num_output(12);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    ConvolutionLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    ConvolutionLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    layer.blobs()[0]->set_data_storage(precision);
+    ref_layer.blobs()[0]->set_data_storage(precision);
+    ref_layer.blobs()[0]->set_data_storage(FP32);
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    EXPECT_EQ(SyncedMemory::HEAD_AT_REDUCED, layer.blobs()[0]->data()->head());
+    const Dtype* expected = ref_blob_top_->cpu_data();
+    const Dtype* actual = blob_top_->cpu_data();
+    for (int i = 0; i < blob_top_->count(); ++i) {
+      EXPECT_NEAR(expected[i], actual[i], 1e-4 * (1 + std::fabs(expected[i])));
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(ReducedStorageConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(ReducedStorageConvolutionLayerTest, TestForward) {
+  this->CompareWithFloat(3, 1, 1, FP16);
+  this->CompareWithFloat(3, 1, 2, BF16);
+  this->CompareWithFloat(1, 0, 1, FP16);
+  this->CompareWithFloat(3, 1, 2, FP16, true);
+}
+
+TYPED_TEST(ReducedStorageConvolutionLayerTest, TestForwardPanels) {
+  // Enough input channels that the weights of a group are widened in more
+  // than one panel.
+  this->blob_bottom_->Reshape(2, 1024, 4, 4);
+  FillerParameter filler_param;
+  GaussianFiller<TypeParam> filler(filler_param);
+  filler.Fill(this->blob_bottom_);
+  this->CompareWithFloat(3, 1, 1, BF16);
+  this->CompareWithFloat(3, 1, 1, BF16, true);
+}
+
+template <typename Dtype>
+class FusedActivationConvolutionLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  FusedActivationConvolutionLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 4, 9, 8)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+
+  virtual ~FusedActivationConvolutionLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  LayerParameter MakeParam(ConvolutionParameter_Engine engine, int group) {
+    LayerParameter layer_param;
+    layer_param.set_type("Convolution");
+    ConvolutionParameter* convolution_param =
+        layer_param.mutable_convolution_param();
+    convolution_param->add_kernel_size(3);
+    convolution_param->add_pad(1);
+    convolution_param->set_group(group);
+    convolution_param->set_num_output(8);
+    convolution_param->set_engine(engine);
+    convolution_param->mutable_weight_filler()->set_type("gaussian");
+    convolution_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  // Runs the convolution of layer_param with a PReLU fused into it against
+  // the same convolution followed by the PReLU.
+  void CompareWithUnfused(const LayerParameter& layer_param) {
+    shared_ptr<Layer<Dtype> > ref_layer =
+        LayerRegistry<Dtype>::CreateLayer(layer_param);
+    ref_layer->SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    shared_ptr<Layer<Dtype> > layer =
+        LayerRegistry<Dtype>::CreateLayer(layer_param);
+    layer->SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer->blobs().size(); ++i) {
+      layer->blobs()[i]->CopyFrom(*ref_layer->blobs()[i]);
+    }
+    LayerParameter prelu_param;
+    prelu_param.mutable_prelu_param()->mutable_filler()->set_type("gaussian");
+    PReLULayer<Dtype> ref_prelu(prelu_param);
+    ref_prelu.SetUp(ref_blob_top_vec_, ref_blob_top_vec_);
+    PReLULayer<Dtype> prelu(prelu_param);
+    prelu.SetUp(blob_top_vec_, blob_top_vec_);
+    prelu.blobs()[0]->CopyFrom(*ref_prelu.blobs()[0]);
+    ASSERT_TRUE(layer->FuseActivation(&prelu, false));
+    ref_layer->Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    ref_prelu.Forward(ref_blob_top_vec_, ref_blob_top_vec_);
+    layer->Forward(blob_bottom_vec_, blob_top_vec_);
+    const Dtype* expected = ref_blob_top_->cpu_data();
+    const Dtype* actual = blob_top_->cpu_data();
+    for (int i = 0; i < blob_top_->count(); ++i) {
+      EXPECT_NEAR(expected[i], actual[i], 1e-4 * (1 + std::fabs(expected[i])));
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(FusedActivationConvolutionLayerTest, TestDtypes);
+
+TYPED_TEST(FusedActivationConvolutionLayerTest, TestEngines) {
+  this->CompareWithUnfused(this->MakeParam(
+      ConvolutionParameter_Engine_CAFFE, 1));
+  this->CompareWithUnfused(this->MakeParam(
+      ConvolutionParameter_Engine_DIRECT, 2));
+  this->CompareWithUnfused(this->MakeParam(
+      ConvolutionParameter_Engine_WINOGRAD, 1));
+  this->CompareWithUnfused(this->MakeParam(
+      ConvolutionParameter_Engine_IMPLICIT_GEMM, 1));
+  this->CompareWithUnfused(this->MakeParam(
+      ConvolutionParameter_Engine_FFT, 1));
+  this->CompareWithUnfused(this->MakeParam(
+      ConvolutionParameter_Engine_AUTO, 1));
+}
+
+TYPED_TEST(FusedActivationConvolutionLayerTest, TestBatchGemm) {
+  LayerParameter layer_param =
+      this->MakeParam(ConvolutionParameter_Engine_CAFFE, 1);
+  layer_param.mutable_convolution_param()->set_batch_gemm_memory(1 << 24);
+  this->CompareWithUnfused(layer_param);
+}
+
+TYPED_TEST(FusedActivationConvolutionLayerTest, TestInt8) {
+  LayerParameter layer_param =
+      this->MakeParam(ConvolutionParameter_Engine_CAFFE, 2);
+  layer_param.mutable_quantization_param()->set_precision(
+      QuantizationParameter_Precision_INT8);
+  this->CompareWithUnfused(layer_param);
+}
+
 #ifdef USE_CUDNN
 
 template <typename Dtype>
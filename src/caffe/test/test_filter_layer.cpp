@@ -112,6 +112,34 @@ TYPED_TEST(FilterLayerTest, TestForward) {
     EXPECT_EQ(top_data[n], bottom_data[n]);
 }
 
+TYPED_TEST(FilterLayerTest, TestForwardAllSelected) {
+  typedef typename TypeParam::Dtype Dtype;
+  // With every item selected, and sharing allowed, the tops are the
+  // bottoms; once some are not, the tops get memory of their own again.
+  Dtype* selector = this->blob_bottom_selector_->mutable_cpu_data();
+  caffe_set(this->blob_bottom_selector_->count(), Dtype(1), selector);
+  LayerParameter layer_param;
+  FilterLayer<Dtype> layer(layer_param);
+  layer.set_share_bottom_data(true);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(this->blob_bottom_data_->cpu_data(),
+      this->blob_top_data_->cpu_data());
+  EXPECT_EQ(this->blob_bottom_labels_->cpu_diff(),
+      this->blob_top_labels_->cpu_diff());
+  this->blob_bottom_selector_->mutable_cpu_data()[0] = 0;
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_NE(this->blob_bottom_data_->cpu_data(),
+      this->blob_top_data_->cpu_data());
+  EXPECT_EQ(3, this->blob_top_data_->shape(0));
+  const int dim = this->blob_top_data_->count(1);
+  const Dtype* bottom_data = this->blob_bottom_data_->cpu_data() + dim;
+  const Dtype* top_data = this->blob_top_data_->cpu_data();
+  for (int i = 0; i < this->blob_top_data_->count(); ++i) {
+    EXPECT_EQ(bottom_data[i], top_data[i]);
+  }
+}
+
 TYPED_TEST(FilterLayerTest, TestGradient) {
   typedef typename TypeParam::Dtype Dtype;
   LayerParameter layer_param;
@@ -0,0 +1,120 @@
+#include <string>
+#include <vector>
+
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/net.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/fold_batch_norm.hpp"
+#include "caffe/util/quantization.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+class FoldBatchNormTest : public CPUDeviceTest<Dtype> {
+ protected:
+  virtual void SetUp() {
+    // conv1 folds an in-place BatchNorm and Scale, conv2 a BatchNorm with
+    // a top of its own and a Bias. The output of conv3 is also read by
+    // pool, so its BatchNorm stays.
+    const string& proto =
+        "name: 'TestNetwork' "
+        "state { phase: TEST } "
+        "layer { name: 'data' type: 'DummyData' top: 'data' "
+        "  dummy_data_param { shape { dim: 2 dim: 3 dim: 8 dim: 8 } "
+        "    data_filler { type: 'gaussian' std: 2 } } } "
+        "layer { name: 'conv1' type: 'Convolution' bottom: 'data' "
+        "  top: 'conv1' "
+        "  convolution_param { num_output: 8 kernel_size: 3 pad: 1 "
+        "    bias_term: false weight_filler { type: 'gaussian' std: 0.3 } } } "
+        "layer { name: 'bn1' type: 'BatchNorm' bottom: 'conv1' top: 'conv1' } "
+        "layer { name: 'scale1' type: 'Scale' bottom: 'conv1' top: 'conv1' "
+        "  scale_param { bias_term: true filler { type: 'gaussian' } "
+        "    bias_filler { type: 'gaussian' } } } "
+        "layer { name: 'relu1' type: 'ReLU' bottom: 'conv1' top: 'conv1' } "
+        "layer { name: 'conv2' type: 'Convolution' bottom: 'conv1' "
+        "  top: 'conv2' "
+        "  convolution_param { num_output: 6 kernel_size: 1 "
+        "    weight_filler { type: 'gaussian' std: 0.3 } "
+        "    bias_filler { type: 'gaussian' std: 0.3 } } } "
+        "layer { name: 'bn2' type: 'BatchNorm' bottom: 'conv2' top: 'bn2' } "
+        "layer { name: 'bias2' type: 'Bias' bottom: 'bn2' top: 'bn2' "
+        "  bias_param { filler { type: 'gaussian' } } } "
+        "layer { name: 'conv3' type: 'Convolution' bottom: 'bn2' "
+        "  top: 'conv3' "
+        "  convolution_param { num_output: 4 kernel_size: 3 "
+        "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+        "layer { name: 'bn3' type: 'BatchNorm' bottom: 'conv3' top: 'bn3' } "
+        "layer { name: 'pool' type: 'Pooling' bottom: 'conv3' top: 'pool' "
+        "  pooling_param { pool: MAX kernel_size: 2 stride: 2 } } ";
+    NetParameter param;
+    CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param));
+    net_.reset(new Net<Dtype>(param));
+    // Statistics as BatchNormLayer accumulates them: sums with a scale.
+    const char* batch_norms[] = { "bn1", "bn2", "bn3" };
+    for (int i = 0; i < 3; ++i) {
+      const vector<shared_ptr<Blob<Dtype> > >& blobs =
+          net_->layer_by_name(batch_norms[i])->blobs();
+      caffe_rng_gaussian<Dtype>(blobs[0]->count(), 0, 2,
+          blobs[0]->mutable_cpu_data());
+      caffe_rng_uniform<Dtype>(blobs[1]->count(), 0.5, 6,
+          blobs[1]->mutable_cpu_data());
+      blobs[2]->mutable_cpu_data()[0] = 2;
+    }
+  }
+
+  shared_ptr<Net<Dtype> > net_;
+};
+
+TYPED_TEST_CASE(FoldBatchNormTest, TestDtypes);
+
+TYPED_TEST(FoldBatchNormTest, TestFold) {
+  typedef TypeParam Dtype;
+  NetParameter trained, folded;
+  this->net_->ToProto(&trained);
+  FoldBatchNorm(trained, &folded);
+  // Net::ToProto keeps the split of conv3, which is not folded through.
+  const char* expected_names[] = { "data", "conv1", "relu1", "conv2",
+      "conv3", "conv3_conv3_0_split", "bn3", "pool" };
+  ASSERT_EQ(8, folded.layer_size());
+  for (int i = 0; i < folded.layer_size(); ++i) {
+    EXPECT_EQ(expected_names[i], folded.layer(i).name());
+  }
+  EXPECT_EQ("conv1", folded.layer(1).top(0));
+  EXPECT_TRUE(folded.layer(1).convolution_param().bias_term());
+  ASSERT_EQ(2, folded.layer(1).blobs_size());
+  EXPECT_EQ(8, folded.layer(1).blobs(1).shape().dim(0));
+  EXPECT_EQ("bn2", folded.layer(3).top(0));
+  EXPECT_EQ(2, folded.layer(4).blobs_size());
+
+  // The folded net computes the same.
+  Net<Dtype> net(folded);
+  const vector<QuantizationError> errors =
+      CompareQuantizedNet(this->net_.get(), &net, 2);
+  ASSERT_EQ(2, errors.size());
+  for (int i = 0; i < errors.size(); ++i) {
+    EXPECT_LT(errors[i].relative_error, 1e-5) << errors[i].blob_name;
+  }
+}
+
+TYPED_TEST(FoldBatchNormTest, TestBatchStatisticsNotFolded) {
+  NetParameter trained, folded;
+  this->net_->ToProto(&trained);
+  for (int i = 0; i < trained.layer_size(); ++i) {
+    if (trained.layer(i).type() == "BatchNorm") {
+      trained.mutable_layer(i)->mutable_batch_norm_param()->
+          set_use_global_stats(false);
+    }
+  }
+  FoldBatchNorm(trained, &folded);
+  // bias2 does not follow conv2 directly, so nothing is folded.
+  EXPECT_EQ(trained.layer_size(), folded.layer_size());
+}
+
+}  // namespace caffe
@@ -0,0 +1,221 @@
+#include <boost/thread.hpp>
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/syncedmem.hpp"
+#include "caffe/util/host_allocator.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class HostAllocatorTest : public ::testing::Test {
+ protected:
+  HostAllocatorTest()
+      : max_held_bytes_(HostAllocator::max_held_bytes()) {}
+  virtual void SetUp() {
+    HostAllocator::Trim();
+    HostAllocator::ResetStats();
+  }
+  virtual void TearDown() {
+    HostAllocator::set_max_held_bytes(max_held_bytes_);
+    HostAllocator::Trim();
+  }
+  const size_t max_held_bytes_;
+};
+
+TEST_F(HostAllocatorTest, TestSizeClass) {
+  EXPECT_EQ(64, HostAllocator::SizeClass(0));
+  EXPECT_EQ(64, HostAllocator::SizeClass(1));
+  EXPECT_EQ(64, HostAllocator::SizeClass(64));
+  EXPECT_EQ(80, HostAllocator::SizeClass(65));
+  EXPECT_EQ(128, HostAllocator::SizeClass(128));
+  EXPECT_EQ(160, HostAllocator::SizeClass(129));
+  EXPECT_EQ(1024, HostAllocator::SizeClass(1000));
+  for (size_t size = 65; size < 100000; size += 37) {
+    const size_t block_size = HostAllocator::SizeClass(size);
+    EXPECT_GE(block_size, size);
+    EXPECT_LE(block_size, size + size / 4);
+  }
+}
+
+TEST_F(HostAllocatorTest, TestReuse) {
+  void* ptr = HostAllocator::Allocate(1000);
+  HostAllocator::Free(ptr, 1000);
+  // Any size in the same class gets the cached block back.
+  void* other_ptr = HostAllocator::Allocate(1010);
+  EXPECT_EQ(ptr, other_ptr);
+  HostAllocator::Free(other_ptr, 1010);
+  HostAllocator::Stats stats = HostAllocator::GetStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(1024, stats.bytes_held);
+}
+
+TEST_F(HostAllocatorTest, TestBytesInUse) {
+  const size_t in_use = HostAllocator::GetStats().bytes_in_use;
+  void* small_ptr = HostAllocator::Allocate(100);
+  void* large_ptr = HostAllocator::Allocate(4 << 20);
+  EXPECT_EQ(in_use + 112 + (4 << 20), HostAllocator::GetStats().bytes_in_use);
+  HostAllocator::Free(small_ptr, 100);
+  HostAllocator::Free(large_ptr, 4 << 20);
+  EXPECT_EQ(in_use, HostAllocator::GetStats().bytes_in_use);
+}
+
+TEST_F(HostAllocatorTest, TestTrim) {
+  void* small_ptr = HostAllocator::Allocate(100);
+  void* large_ptr = HostAllocator::Allocate(4 << 20);
+  HostAllocator::Free(small_ptr, 100);
+  HostAllocator::Free(large_ptr, 4 << 20);
+  EXPECT_EQ(112 + (4 << 20), HostAllocator::GetStats().bytes_held);
+  HostAllocator::Trim();
+  EXPECT_EQ(0, HostAllocator::GetStats().bytes_held);
+}
+
+TEST_F(HostAllocatorTest, TestMaxHeldBytes) {
+  HostAllocator::set_max_held_bytes(0);
+  void* ptr = HostAllocator::Allocate(100);
+  HostAllocator::Free(ptr, 100);
+  HostAllocator::Stats stats = HostAllocator::GetStats();
+  EXPECT_EQ(0, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(0, stats.bytes_held);
+  // Large blocks beyond the cap are released as well.
+  HostAllocator::set_max_held_bytes(1 << 20);
+  ptr = HostAllocator::Allocate(4 << 20);
+  HostAllocator::Free(ptr, 4 << 20);
+  EXPECT_EQ(0, HostAllocator::GetStats().bytes_held);
+}
+
+void AllocateAndFree(void* shared_ptr, bool* reused) {
+  // Large blocks are cached process-wide, so another thread can reuse them.
+  void* ptr = HostAllocator::Allocate(4 << 20);
+  *reused = (ptr == shared_ptr);
+  HostAllocator::Free(ptr, 4 << 20);
+  for (int i = 0; i < 1000; ++i) {
+    void* small_ptr = HostAllocator::Allocate(64 * (i % 32 + 1));
+    HostAllocator::Free(small_ptr, 64 * (i % 32 + 1));
+  }
+}
+
+TEST_F(HostAllocatorTest, TestThreads) {
+  const size_t in_use = HostAllocator::GetStats().bytes_in_use;
+  void* ptr = HostAllocator::Allocate(4 << 20);
+  HostAllocator::Free(ptr, 4 << 20);
+  bool reused = false;
+  boost::thread thread(AllocateAndFree, ptr, &reused);
+  thread.join();
+  EXPECT_TRUE(reused);
+  HostAllocator::Stats stats = HostAllocator::GetStats();
+  EXPECT_EQ(in_use, stats.bytes_in_use);
+  EXPECT_GT(stats.hits, 1000 - 32);
+}
+
+TEST_F(HostAllocatorTest, TestHugePages) {
+  HostMemoryPolicy policy;
+  policy.huge_pages = true;
+  const HostAllocator::Stats stats = HostAllocator::GetStats();
+  const size_t size = (3 << 20) + 5;
+  char* ptr = static_cast<char*>(HostAllocator::Allocate(size, policy));
+  EXPECT_EQ(0, reinterpret_cast<size_t>(ptr) % (2 << 20));
+  // Placed buffers bypass the caches.
+  EXPECT_EQ(stats.misses, HostAllocator::GetStats().misses);
+  EXPECT_EQ(stats.bytes_in_use, HostAllocator::GetStats().bytes_in_use);
+  for (size_t i = 0; i < size; ++i) {
+    ptr[i] = static_cast<char>(i);
+  }
+  EXPECT_EQ(static_cast<char>(size - 1), ptr[size - 1]);
+  HostAllocator::Free(ptr, size, policy);
+}
+
+TEST_F(HostAllocatorTest, TestNodeBytes) {
+  const int num_nodes = HostAllocator::num_numa_nodes();
+  ASSERT_GE(num_nodes, 1);
+  const vector<size_t> node_bytes = HostAllocator::NodeBytes();
+  ASSERT_EQ(num_nodes, node_bytes.size());
+  HostMemoryPolicy policy;
+  policy.numa_node = 0;
+  const size_t size = 1 << 20;
+  void* ptr = HostAllocator::Allocate(size, policy);
+  memset(ptr, 1, size);
+  EXPECT_EQ(node_bytes[0] + size, HostAllocator::NodeBytes()[0]);
+  HostAllocator::Free(ptr, size, policy);
+  EXPECT_EQ(node_bytes[0], HostAllocator::NodeBytes()[0]);
+  // Interleaved buffers are spread over every node.
+  policy.interleave = true;
+  ptr = HostAllocator::Allocate(size, policy);
+  memset(ptr, 1, size);
+  size_t total_bytes = 0;
+  for (int i = 0; i < num_nodes; ++i) {
+    total_bytes += HostAllocator::NodeBytes()[i] - node_bytes[i];
+  }
+  EXPECT_GT(total_bytes, 0);
+  EXPECT_LE(total_bytes, size);
+  HostAllocator::Free(ptr, size, policy);
+  EXPECT_EQ(node_bytes, HostAllocator::NodeBytes());
+}
+
+TEST_F(HostAllocatorTest, TestPooledPlacement) {
+  const vector<size_t> node_bytes = HostAllocator::NodeBytes();
+  HostMemoryPolicy policy;
+  policy.huge_pages = true;
+  policy.numa_node = 0;
+  // Small placed blocks are pooled rather than mapped a page each.
+  const size_t size = 1000;
+  char* ptr = static_cast<char*>(HostAllocator::Allocate(size, policy));
+  char* other_ptr = static_cast<char*>(HostAllocator::Allocate(size, policy));
+  memset(ptr, 1, size);
+  memset(other_ptr, 2, size);
+  EXPECT_EQ(1, ptr[size - 1]);
+  EXPECT_EQ(node_bytes[0] + 2 * HostAllocator::SizeClass(size),
+      HostAllocator::NodeBytes()[0]);
+  HostAllocator::Free(other_ptr, size, policy);
+  EXPECT_EQ(node_bytes[0] + HostAllocator::SizeClass(size),
+      HostAllocator::NodeBytes()[0]);
+  // The freed block is reused by the same policy only.
+  void* default_ptr = HostAllocator::Allocate(size);
+  EXPECT_NE(other_ptr, default_ptr);
+  EXPECT_EQ(other_ptr, HostAllocator::Allocate(size, policy));
+  HostAllocator::Free(default_ptr, size);
+  HostAllocator::Free(other_ptr, size, policy);
+  HostAllocator::Free(ptr, size, policy);
+  EXPECT_EQ(node_bytes, HostAllocator::NodeBytes());
+}
+
+TEST_F(HostAllocatorTest, TestSyncedMemoryPolicy) {
+  Caffe::set_mode(Caffe::CPU);
+  const HostMemoryPolicy default_policy = Caffe::host_memory_policy();
+  const vector<size_t> node_bytes = HostAllocator::NodeBytes();
+  HostMemoryPolicy policy;
+  policy.numa_node = 0;
+  Caffe::set_host_memory_policy(policy);
+  {
+    SyncedMemory mem(1 << 20);
+    mem.mutable_cpu_data();
+    // The policy in effect at allocation time sticks with the memory.
+    Caffe::set_host_memory_policy(default_policy);
+    EXPECT_EQ(node_bytes[0] + (1 << 20), HostAllocator::NodeBytes()[0]);
+  }
+  EXPECT_EQ(node_bytes[0], HostAllocator::NodeBytes()[0]);
+}
+
+TEST_F(HostAllocatorTest, TestSyncedMemory) {
+  Caffe::set_mode(Caffe::CPU);
+  void* ptr;
+  {
+    SyncedMemory mem(1000);
+    ptr = mem.mutable_cpu_data();
+  }
+  SyncedMemory mem(1000);
+  EXPECT_EQ(ptr, mem.cpu_data());
+  // Memory handed out again must still be zero-filled.
+  const char* data = static_cast<const char*>(mem.cpu_data());
+  for (int i = 0; i < mem.size(); ++i) {
+    EXPECT_EQ(0, data[i]);
+  }
+}
+
+}  // namespace caffe
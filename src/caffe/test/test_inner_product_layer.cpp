@@ -1,3 +1,4 @@
+#include <cmath>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -5,7 +6,12 @@
 #include "caffe/blob.hpp"
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
+#include "caffe/layer_factory.hpp"
 #include "caffe/layers/inner_product_layer.hpp"
+#include "caffe/layers/prelu_layer.hpp"
+#include "caffe/layers/quantized_inner_product_layer.hpp"
+#include "caffe/layers/sparse_inner_product_layer.hpp"
+#include "caffe/util/benchmark.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
 #include "caffe/test/test_gradient_check_util.hpp"
@@ -388,4 +394,484 @@ TYPED_TEST(InnerProductLayerTest, TestBackwardTranspose) {
   }
 }
 
+template <typename Dtype>
+class QuantizedInnerProductLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  QuantizedInnerProductLayerTest()
+      : blob_bottom_(new Blob<Dtype>(6, 3, 4, 5)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+  virtual ~QuantizedInnerProductLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  LayerParameter MakeParam(bool transpose) {
+    LayerParameter layer_param;
+    InnerProductParameter* inner_product_param =
+        layer_param.mutable_inner_product_param();
+    inner_product_param->set_num_output(20);
+    inner_product_param->set_transpose(transpose);
+    inner_product_param->mutable_weight_filler()->set_type("gaussian");
+    inner_product_param->mutable_bias_filler()->set_type("gaussian");
+    layer_param.mutable_quantization_param()->set_precision(
+        QuantizationParameter_Precision_INT8);
+    return layer_param;
+  }
+
+  // Runs the int8 layer and InnerProductLayer with the same weights, and
+  // checks that the outputs agree within the quantization error.
+  void CompareWithFloat(const LayerParameter& layer_param) {
+    InnerProductLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    QuantizedInnerProductLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    ASSERT_TRUE(ref_blob_top_->shape() == blob_top_->shape());
+    const Dtype* expected = ref_blob_top_->cpu_data();
+    const Dtype* actual = blob_top_->cpu_data();
+    Dtype diff_norm = 0, norm = 0;
+    for (int i = 0; i < blob_top_->count(); ++i) {
+      diff_norm += (actual[i] - expected[i]) * (actual[i] - expected[i]);
+      norm += expected[i] * expected[i];
+    }
+    EXPECT_LT(std::sqrt(diff_norm / norm), 0.03);
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(QuantizedInnerProductLayerTest, TestDtypes);
+
+TYPED_TEST(QuantizedInnerProductLayerTest, TestForward) {
+  this->CompareWithFloat(this->MakeParam(false));
+}
+
+TYPED_TEST(QuantizedInnerProductLayerTest, TestForwardTranspose) {
+  this->CompareWithFloat(this->MakeParam(true));
+}
+
+TYPED_TEST(QuantizedInnerProductLayerTest, TestFactory) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(false);
+  layer_param.set_type("InnerProduct");
+  shared_ptr<Layer<Dtype> > layer =
+      LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_TRUE(dynamic_cast<QuantizedInnerProductLayer<Dtype>*>(layer.get()));
+  layer_param.clear_quantization_param();
+  layer = LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_FALSE(
+      dynamic_cast<QuantizedInnerProductLayer<Dtype>*>(layer.get()));
+}
+
+template <typename Dtype>
+class ReducedStorageInnerProductLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  ReducedStorageInnerProductLayerTest()
+      : blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+  virtual ~ReducedStorageInnerProductLayerTest() {
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  // Runs InnerProductLayer with weights held at 16 bits against one with the
+  // same weights rounded to that precision and widened back.
+  void CompareWithFloat(const vector<int>& bottom_shape, bool transpose,
+      StoragePrecision precision) {
+    Blob<Dtype> bottom(bottom_shape);
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(&bottom);
+    vector<Blob<Dtype>*> bottom_vec(1, &bottom);
+    LayerParameter layer_param;
+    InnerProductParameter* inner_product_param =
+        layer_param.mutable_inner_product_param();
+    inner_product_param->set_num_output(7);
+    inner_product_param->set_transpose(transpose);
+    inner_product_param->mutable_weight_filler()->set_type("gaussian");
+    inner_product_param->mutable_bias_filler()->set_type("gaussian");
+    InnerProductLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(bottom_vec, ref_blob_top_vec_);
+    InnerProductLayer<Dtype> layer(layer_param);
+    layer.SetUp(bottom_vec, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    layer.blobs()[0]->set_data_storage(precision);
+    ref_layer.blobs()[0]->set_data_storage(precision);
+    ref_layer.blobs()[0]->set_data_storage(FP32);
+    ref_layer.Forward(bottom_vec, ref_blob_top_vec_);
+    layer.Forward(bottom_vec, blob_top_vec_);
+    // The weights were read without being widened as a whole.
+    EXPECT_EQ(SyncedMemory::HEAD_AT_REDUCED, layer.blobs()[0]->data()->head());
+    const Dtype* expected = ref_blob_top_->cpu_data();
+    const Dtype* actual = blob_top_->cpu_data();
+    for (int i = 0; i < blob_top_->count(); ++i) {
+      EXPECT_NEAR(expected[i], actual[i], 1e-4 * (1 + std::fabs(expected[i])));
+    }
+  }
+
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(ReducedStorageInnerProductLayerTest, TestDtypes);
+
+TYPED_TEST(ReducedStorageInnerProductLayerTest, TestForwardFp16) {
+  vector<int> shape(2);
+  shape[0] = 6;
+  shape[1] = 60;
+  this->CompareWithFloat(shape, false, FP16);
+  this->CompareWithFloat(shape, true, FP16);
+}
+
+TYPED_TEST(ReducedStorageInnerProductLayerTest, TestForwardBf16) {
+  vector<int> shape(2);
+  shape[0] = 6;
+  shape[1] = 60;
+  this->CompareWithFloat(shape, false, BF16);
+  this->CompareWithFloat(shape, true, BF16);
+}
+
+// Inputs long enough that every output is a panel of its own.
+TYPED_TEST(ReducedStorageInnerProductLayerTest, TestForwardPanels) {
+  vector<int> shape(2);
+  shape[0] = 3;
+  shape[1] = 70000;
+  this->CompareWithFloat(shape, false, FP16);
+  this->CompareWithFloat(shape, true, BF16);
+}
+
+template <typename Dtype>
+class SparseInnerProductLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  SparseInnerProductLayerTest()
+      : blob_bottom_(new Blob<Dtype>(4, 3, 4, 5)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+  virtual ~SparseInnerProductLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  LayerParameter MakeParam(bool transpose) {
+    LayerParameter layer_param;
+    InnerProductParameter* inner_product_param =
+        layer_param.mutable_inner_product_param();
+    inner_product_param->set_num_output(20);
+    inner_product_param->set_transpose(transpose);
+    inner_product_param->set_sparse_threshold(0.7);
+    inner_product_param->mutable_weight_filler()->set_type("gaussian");
+    inner_product_param->mutable_bias_filler()->set_type("gaussian");
+    layer_param.set_phase(TEST);
+    return layer_param;
+  }
+
+  // Zeros all but one in every keep of the weights.
+  static void Prune(Blob<Dtype>* weights, int keep) {
+    Dtype* data = weights->mutable_cpu_data();
+    for (int i = 0; i < weights->count(); ++i) {
+      if (i % keep != 0) {
+        data[i] = 0;
+      }
+    }
+  }
+
+  // Runs the sparse layer and InnerProductLayer with the same pruned
+  // weights, forward and backward.
+  void CompareWithDense(const LayerParameter& layer_param) {
+    InnerProductLayer<Dtype> ref_layer(layer_param);
+    ref_layer.SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    Prune(ref_layer.blobs()[0].get(), 5);
+    SparseInnerProductLayer<Dtype> layer(layer_param);
+    layer.SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer.blobs().size(); ++i) {
+      layer.blobs()[i]->CopyFrom(*ref_layer.blobs()[i]);
+    }
+    EXPECT_TRUE(layer.use_sparse());
+    EXPECT_TRUE(layer.dense_released());
+    ref_layer.Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    layer.Forward(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < blob_top_->count(); ++i) {
+      EXPECT_NEAR(ref_blob_top_->cpu_data()[i], blob_top_->cpu_data()[i],
+          1e-4);
+    }
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(blob_top_);
+    ref_blob_top_->CopyFrom(*blob_top_, true);
+    Blob<Dtype> ref_bottom_diff;
+    vector<bool> propagate_down(1, true);
+    ref_layer.Backward(ref_blob_top_vec_, propagate_down, blob_bottom_vec_);
+    ref_bottom_diff.CopyFrom(*blob_bottom_, true, true);
+    layer.Backward(blob_top_vec_, propagate_down, blob_bottom_vec_);
+    for (int i = 0; i < blob_bottom_->count(); ++i) {
+      EXPECT_NEAR(ref_bottom_diff.cpu_diff()[i], blob_bottom_->cpu_diff()[i],
+          1e-4);
+    }
+    // Saving writes the released weights back.
+    LayerParameter saved;
+    layer.ToProto(&saved);
+    EXPECT_FALSE(layer.dense_released());
+    EXPECT_TRUE(layer.use_sparse());
+    const Blob<Dtype>& weights = *layer.blobs()[0];
+    for (int i = 0; i < weights.count(); ++i) {
+      EXPECT_EQ(ref_layer.blobs()[0]->cpu_data()[i], weights.cpu_data()[i]);
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(SparseInnerProductLayerTest, TestDtypes);
+
+TYPED_TEST(SparseInnerProductLayerTest, TestForwardBackward) {
+  this->CompareWithDense(this->MakeParam(false));
+}
+
+TYPED_TEST(SparseInnerProductLayerTest, TestForwardBackwardTranspose) {
+  this->CompareWithDense(this->MakeParam(true));
+}
+
+TYPED_TEST(SparseInnerProductLayerTest, TestThreshold) {
+  typedef TypeParam Dtype;
+  SparseInnerProductLayer<Dtype> layer(this->MakeParam(false));
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  // Dense weights stay dense, until pruning rewrites them.
+  EXPECT_FALSE(layer.use_sparse());
+  this->Prune(layer.blobs()[0].get(), 2);
+  EXPECT_FALSE(layer.use_sparse());
+  this->Prune(layer.blobs()[0].get(), 4);
+  EXPECT_TRUE(layer.use_sparse());
+  // Training keeps to the dense weights.
+  LayerParameter train_param = this->MakeParam(false);
+  train_param.set_phase(TRAIN);
+  SparseInnerProductLayer<Dtype> train_layer(train_param);
+  train_layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  this->Prune(train_layer.blobs()[0].get(), 4);
+  EXPECT_FALSE(train_layer.use_sparse());
+  EXPECT_FALSE(train_layer.dense_released());
+}
+
+TYPED_TEST(SparseInnerProductLayerTest, TestSharedWeightsKept) {
+  typedef TypeParam Dtype;
+  SparseInnerProductLayer<Dtype> layer(this->MakeParam(false));
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  this->Prune(layer.blobs()[0].get(), 5);
+  Blob<Dtype> shared(layer.blobs()[0]->shape());
+  shared.ShareData(*layer.blobs()[0]);
+  EXPECT_TRUE(layer.use_sparse());
+  EXPECT_FALSE(layer.dense_released());
+  EXPECT_NE(Dtype(0), shared.asum_data());
+}
+
+TYPED_TEST(SparseInnerProductLayerTest, TestGradient) {
+  typedef TypeParam Dtype;
+  SparseInnerProductLayer<Dtype> layer(this->MakeParam(false));
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  this->Prune(layer.blobs()[0].get(), 5);
+  // The checker perturbs the dense weights, so they must not be released.
+  Blob<Dtype> shared(layer.blobs()[0]->shape());
+  shared.ShareData(*layer.blobs()[0]);
+  GradientChecker<Dtype> checker(1e-2, 1e-3);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_);
+}
+
+TYPED_TEST(SparseInnerProductLayerTest, TestFactory) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param = this->MakeParam(false);
+  layer_param.set_type("InnerProduct");
+  shared_ptr<Layer<Dtype> > layer =
+      LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_TRUE(dynamic_cast<SparseInnerProductLayer<Dtype>*>(layer.get()));
+  layer_param.mutable_inner_product_param()->clear_sparse_threshold();
+  layer = LayerRegistry<Dtype>::CreateLayer(layer_param);
+  EXPECT_FALSE(dynamic_cast<SparseInnerProductLayer<Dtype>*>(layer.get()));
+}
+
+// Forward time of the dense and the CSR layer as the weights get sparser,
+// for a ranking-net sized layer. Run with --gtest_also_run_disabled_tests.
+TYPED_TEST(SparseInnerProductLayerTest, DISABLED_Benchmark) {
+  typedef TypeParam Dtype;
+  const int iterations = 20;
+  Blob<Dtype> bottom(32, 2048, 1, 1);
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(&bottom);
+  vector<Blob<Dtype>*> bottom_vec(1, &bottom);
+  LayerParameter layer_param = this->MakeParam(false);
+  layer_param.mutable_inner_product_param()->set_num_output(2048);
+  layer_param.mutable_inner_product_param()->set_sparse_threshold(1e-6);
+  InnerProductLayer<Dtype> dense(layer_param);
+  dense.SetUp(bottom_vec, this->blob_top_vec_);
+  SparseInnerProductLayer<Dtype> sparse(layer_param);
+  sparse.SetUp(bottom_vec, this->blob_top_vec_);
+  const int keeps[] = { 2, 3, 5, 10, 20, 100 };
+  for (int k = 0; k < sizeof(keeps) / sizeof(keeps[0]); ++k) {
+    filler.Fill(dense.blobs()[0].get());
+    this->Prune(dense.blobs()[0].get(), keeps[k]);
+    sparse.blobs()[0]->ShareData(*dense.blobs()[0]);
+    sparse.blobs()[1]->ShareData(*dense.blobs()[1]);
+    Layer<Dtype>* layers[] = { &dense, &sparse };
+    float ms[2];
+    for (int l = 0; l < 2; ++l) {
+      layers[l]->Forward(bottom_vec, this->blob_top_vec_);
+      Timer timer;
+      timer.Start();
+      for (int i = 0; i < iterations; ++i) {
+        layers[l]->Forward(bottom_vec, this->blob_top_vec_);
+      }
+      ms[l] = timer.MilliSeconds() / iterations;
+    }
+    LOG(INFO) << "zeros " << 1 - 1. / keeps[k] << " dense " << ms[0]
+        << " ms sparse " << ms[1] << " ms";
+  }
+}
+
+template <typename Dtype>
+class FusedActivationInnerProductLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  FusedActivationInnerProductLayerTest()
+      : blob_bottom_(new Blob<Dtype>(6, 3, 4, 5)),
+        blob_top_(new Blob<Dtype>()),
+        ref_blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+    ref_blob_top_vec_.push_back(ref_blob_top_);
+  }
+
+  virtual ~FusedActivationInnerProductLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+    delete ref_blob_top_;
+  }
+
+  LayerParameter MakeParam(bool bias_term) {
+    LayerParameter layer_param;
+    layer_param.set_type("InnerProduct");
+    InnerProductParameter* inner_product_param =
+        layer_param.mutable_inner_product_param();
+    inner_product_param->set_num_output(10);
+    inner_product_param->set_bias_term(bias_term);
+    inner_product_param->mutable_weight_filler()->set_type("gaussian");
+    inner_product_param->mutable_bias_filler()->set_type("gaussian");
+    return layer_param;
+  }
+
+  // Runs the layer of layer_param with a PReLU fused into it against the
+  // same layer followed by the PReLU. Only every zero_period-th weight is
+  // kept, and the weights are held at precision.
+  void CompareWithUnfused(const LayerParameter& layer_param,
+      int zero_period = 1, StoragePrecision precision = FP32) {
+    shared_ptr<Layer<Dtype> > ref_layer =
+        LayerRegistry<Dtype>::CreateLayer(layer_param);
+    ref_layer->SetUp(blob_bottom_vec_, ref_blob_top_vec_);
+    Dtype* weight = ref_layer->blobs()[0]->mutable_cpu_data();
+    for (int i = 0; i < ref_layer->blobs()[0]->count(); ++i) {
+      if (i % zero_period) {
+        weight[i] = 0;
+      }
+    }
+    shared_ptr<Layer<Dtype> > layer =
+        LayerRegistry<Dtype>::CreateLayer(layer_param);
+    layer->SetUp(blob_bottom_vec_, blob_top_vec_);
+    for (int i = 0; i < layer->blobs().size(); ++i) {
+      layer->blobs()[i]->CopyFrom(*ref_layer->blobs()[i]);
+    }
+    if (precision != FP32) {
+      ref_layer->blobs()[0]->set_data_storage(precision);
+      layer->blobs()[0]->set_data_storage(precision);
+    }
+    LayerParameter prelu_param;
+    prelu_param.mutable_prelu_param()->mutable_filler()->set_type("gaussian");
+    PReLULayer<Dtype> ref_prelu(prelu_param);
+    ref_prelu.SetUp(ref_blob_top_vec_, ref_blob_top_vec_);
+    PReLULayer<Dtype> prelu(prelu_param);
+    prelu.SetUp(blob_top_vec_, blob_top_vec_);
+    prelu.blobs()[0]->CopyFrom(*ref_prelu.blobs()[0]);
+    ASSERT_TRUE(layer->FuseActivation(&prelu, false));
+    ref_layer->Forward(blob_bottom_vec_, ref_blob_top_vec_);
+    ref_prelu.Forward(ref_blob_top_vec_, ref_blob_top_vec_);
+    layer->Forward(blob_bottom_vec_, blob_top_vec_);
+    const Dtype* expected = ref_blob_top_->cpu_data();
+    const Dtype* actual = blob_top_->cpu_data();
+    for (int i = 0; i < blob_top_->count(); ++i) {
+      EXPECT_NEAR(expected[i], actual[i], 1e-4 * (1 + std::fabs(expected[i])));
+    }
+  }
+
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  Blob<Dtype>* const ref_blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+  vector<Blob<Dtype>*> ref_blob_top_vec_;
+};
+
+TYPED_TEST_CASE(FusedActivationInnerProductLayerTest, TestDtypes);
+
+TYPED_TEST(FusedActivationInnerProductLayerTest, TestForward) {
+  this->CompareWithUnfused(this->MakeParam(true));
+  this->CompareWithUnfused(this->MakeParam(false));
+}
+
+TYPED_TEST(FusedActivationInnerProductLayerTest, TestReducedStorage) {
+  this->CompareWithUnfused(this->MakeParam(true), 1, FP16);
+}
+
+TYPED_TEST(FusedActivationInnerProductLayerTest, TestSparse) {
+  LayerParameter layer_param = this->MakeParam(true);
+  layer_param.mutable_inner_product_param()->set_sparse_threshold(0.5);
+  layer_param.set_phase(TEST);
+  this->CompareWithUnfused(layer_param, 4);
+}
+
+TYPED_TEST(FusedActivationInnerProductLayerTest, TestInt8) {
+  LayerParameter layer_param = this->MakeParam(true);
+  layer_param.mutable_quantization_param()->set_precision(
+      QuantizationParameter_Precision_INT8);
+  this->CompareWithUnfused(layer_param);
+}
+
 }  // namespace caffe
@@ -119,6 +119,53 @@ TYPED_TEST(CPUMathFunctionsTest, TestCopy) {
   }
 }
 
+TYPED_TEST(CPUMathFunctionsTest, TestParallelElementwise) {
+  const int n = this->blob_bottom_->count();
+  const TypeParam* x = this->blob_bottom_->cpu_data();
+  const TypeParam* y = this->blob_top_->cpu_data();
+  const int threshold = caffe_cpu_parallel_threshold();
+  Blob<TypeParam> serial(this->blob_top_->shape());
+  Blob<TypeParam> parallel(this->blob_top_->shape());
+  // Serial reference.
+  caffe_cpu_set_parallel_threshold(INT_MAX);
+  caffe_copy(n, y, serial.mutable_cpu_data());
+  caffe_cpu_axpby<TypeParam>(n, 0.5, x, -2, serial.mutable_cpu_data());
+  caffe_mul<TypeParam>(n, x, serial.cpu_data(), serial.mutable_cpu_data());
+  caffe_add_scalar<TypeParam>(n, 3, serial.mutable_cpu_data());
+  caffe_exp<TypeParam>(n, x, serial.mutable_cpu_diff());
+  // Parallel, with more threads than cores and no size threshold.
+  Caffe::set_num_threads(4);
+  caffe_cpu_set_parallel_threshold(0);
+  caffe_copy(n, y, parallel.mutable_cpu_data());
+  caffe_cpu_axpby<TypeParam>(n, 0.5, x, -2, parallel.mutable_cpu_data());
+  caffe_mul<TypeParam>(n, x, parallel.cpu_data(), parallel.mutable_cpu_data());
+  caffe_add_scalar<TypeParam>(n, 3, parallel.mutable_cpu_data());
+  caffe_exp<TypeParam>(n, x, parallel.mutable_cpu_diff());
+  caffe_cpu_set_parallel_threshold(threshold);
+  for (int i = 0; i < n; ++i) {
+    EXPECT_EQ(serial.cpu_data()[i], parallel.cpu_data()[i]);
+    EXPECT_EQ(serial.cpu_diff()[i], parallel.cpu_diff()[i]);
+  }
+}
+
+TYPED_TEST(CPUMathFunctionsTest, TestParallelReductionDeterministic) {
+  const int n = this->blob_bottom_->count();
+  const TypeParam* x = this->blob_bottom_->cpu_data();
+  const TypeParam* y = this->blob_top_->cpu_data();
+  Caffe::set_num_threads(1);
+  const TypeParam asum = caffe_cpu_asum<TypeParam>(n, x);
+  const TypeParam dot = caffe_cpu_dot<TypeParam>(n, x, y);
+  const TypeParam strided_dot =
+      caffe_cpu_strided_dot<TypeParam>(n / 3, x, 3, y, 2);
+  for (int num_threads = 2; num_threads <= 8; num_threads *= 2) {
+    Caffe::set_num_threads(num_threads);
+    EXPECT_EQ(asum, caffe_cpu_asum<TypeParam>(n, x));
+    EXPECT_EQ(dot, caffe_cpu_dot<TypeParam>(n, x, y));
+    EXPECT_EQ(strided_dot,
+        caffe_cpu_strided_dot<TypeParam>(n / 3, x, 3, y, 2));
+  }
+}
+
 #ifndef CPU_ONLY
 
 template <typename Dtype>
@@ -0,0 +1,97 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/memory_planner.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class MemoryPlannerTest : public ::testing::Test {
+ protected:
+  // Checks that no two blocks alive at the same step overlap in memory.
+  void CheckNoConflicts(const vector<MemoryBlock>& blocks,
+      const vector<size_t>& offsets) {
+    ASSERT_EQ(blocks.size(), offsets.size());
+    for (int i = 0; i < blocks.size(); ++i) {
+      for (int j = i + 1; j < blocks.size(); ++j) {
+        const bool alive_together = blocks[i].first <= blocks[j].last &&
+            blocks[j].first <= blocks[i].last;
+        if (!alive_together) { continue; }
+        const bool disjoint = offsets[i] + blocks[i].size <= offsets[j] ||
+            offsets[j] + blocks[j].size <= offsets[i];
+        EXPECT_TRUE(disjoint) << "blocks " << i << " and " << j;
+      }
+    }
+  }
+};
+
+TEST_F(MemoryPlannerTest, TestEmpty) {
+  vector<MemoryBlock> blocks;
+  vector<size_t> offsets;
+  EXPECT_EQ(0, PlanMemoryBlocks(blocks, 1, &offsets));
+  EXPECT_EQ(0, offsets.size());
+  EXPECT_EQ(0, PeakLiveBytes(blocks));
+}
+
+TEST_F(MemoryPlannerTest, TestChainReuse) {
+  // A linear chain: each activation lives from its producer to its consumer.
+  vector<MemoryBlock> blocks;
+  blocks.push_back(MemoryBlock(100, 0, 1));
+  blocks.push_back(MemoryBlock(100, 1, 2));
+  blocks.push_back(MemoryBlock(100, 2, 3));
+  blocks.push_back(MemoryBlock(100, 3, 4));
+  vector<size_t> offsets;
+  const size_t arena_size = PlanMemoryBlocks(blocks, 1, &offsets);
+  CheckNoConflicts(blocks, offsets);
+  EXPECT_EQ(200, arena_size);
+  EXPECT_EQ(200, PeakLiveBytes(blocks));
+  EXPECT_EQ(offsets[0], offsets[2]);
+  EXPECT_EQ(offsets[1], offsets[3]);
+}
+
+TEST_F(MemoryPlannerTest, TestAllAlive) {
+  vector<MemoryBlock> blocks;
+  blocks.push_back(MemoryBlock(10, 0, 5));
+  blocks.push_back(MemoryBlock(20, 1, 4));
+  blocks.push_back(MemoryBlock(30, 2, 3));
+  vector<size_t> offsets;
+  const size_t arena_size = PlanMemoryBlocks(blocks, 1, &offsets);
+  CheckNoConflicts(blocks, offsets);
+  EXPECT_EQ(60, arena_size);
+  EXPECT_EQ(60, PeakLiveBytes(blocks));
+}
+
+TEST_F(MemoryPlannerTest, TestAlignment) {
+  vector<MemoryBlock> blocks;
+  blocks.push_back(MemoryBlock(3, 0, 1));
+  blocks.push_back(MemoryBlock(5, 0, 1));
+  blocks.push_back(MemoryBlock(7, 2, 3));
+  vector<size_t> offsets;
+  const size_t kAlignment = 64;
+  const size_t arena_size = PlanMemoryBlocks(blocks, kAlignment, &offsets);
+  CheckNoConflicts(blocks, offsets);
+  EXPECT_EQ(2 * kAlignment, arena_size);
+  for (int i = 0; i < offsets.size(); ++i) {
+    EXPECT_EQ(0, offsets[i] % kAlignment);
+  }
+}
+
+TEST_F(MemoryPlannerTest, TestBestFitGap) {
+  // Blocks 0 and 2 leave a gap once block 1 dies; block 3 fits in it.
+  vector<MemoryBlock> blocks;
+  blocks.push_back(MemoryBlock(400, 0, 4));
+  blocks.push_back(MemoryBlock(300, 0, 1));
+  blocks.push_back(MemoryBlock(200, 0, 4));
+  blocks.push_back(MemoryBlock(100, 2, 4));
+  vector<size_t> offsets;
+  const size_t arena_size = PlanMemoryBlocks(blocks, 1, &offsets);
+  CheckNoConflicts(blocks, offsets);
+  EXPECT_EQ(900, arena_size);
+  EXPECT_EQ(offsets[1], offsets[3]);
+  EXPECT_EQ(900, PeakLiveBytes(blocks));
+}
+
+}  // namespace caffe
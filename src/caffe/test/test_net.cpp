@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <utility>
 #include <vector>
@@ -9,6 +11,7 @@
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
 #include "caffe/net.hpp"
+#include "caffe/util/host_allocator.hpp"
 #include "caffe/util/math_functions.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
@@ -552,8 +555,10 @@ class NetTest : public MultiDeviceTest<TypeParam> {
     InitNetFromProtoString(proto);
   }
 
-  virtual void InitReshapableNet() {
-    const string& proto =
+  // net_options are appended to the NetParameter text, e.g. to turn on
+  // memory optimizations.
+  virtual void InitReshapableNet(const string& net_options = "") {
+    string proto =
         "name: 'ReshapableNetwork' "
         "layer { "
         "  name: 'data' "
@@ -614,7 +619,7 @@ class NetTest : public MultiDeviceTest<TypeParam> {
         "  bottom: 'norm1' "
         "  top: 'softmax' "
         "} ";
-    InitNetFromProtoString(proto);
+    InitNetFromProtoString(proto + net_options);
   }
 
   virtual void InitSkipPropNet(bool test_skip_true) {
@@ -2378,6 +2383,1128 @@ TYPED_TEST(NetTest, TestReshape) {
   EXPECT_FALSE(same_spatial_shape);
 }
 
+TYPED_TEST(NetTest, TestOptimizeMemory) {
+  typedef typename TypeParam::Dtype Dtype;
+  // Run the same input through a plain net and a memory-planned copy sharing
+  // its weights, and check that the outputs agree for both input shapes.
+  Caffe::set_random_seed(this->seed_);
+  Caffe::set_mode(Caffe::CPU);
+  FillerParameter filler_param;
+  filler_param.set_std(1);
+  GaussianFiller<Dtype> filler(filler_param);
+  Blob<Dtype> blob1(2, 3, 12, 10);
+  Blob<Dtype> blob2(4, 3, 9, 11);
+  filler.Fill(&blob1);
+  filler.Fill(&blob2);
+
+  this->InitReshapableNet();
+  shared_ptr<Net<Dtype> > plain_net = this->net_;
+  EXPECT_EQ(0, plain_net->activation_arena_bytes());
+  this->InitReshapableNet("optimize_memory: true ");
+  shared_ptr<Net<Dtype> > planned_net = this->net_;
+  planned_net->ShareTrainedLayersWith(plain_net.get());
+  EXPECT_GT(planned_net->activation_arena_bytes(), 0);
+  EXPECT_LT(planned_net->activation_arena_bytes(),
+      planned_net->activation_naive_bytes());
+
+  Blob<Dtype>* blobs[] = { &blob1, &blob2, &blob1 };
+  for (int b = 0; b < 3; ++b) {
+    const Blob<Dtype>& input = *blobs[b];
+    shared_ptr<Net<Dtype> > nets[] = { plain_net, planned_net };
+    for (int n = 0; n < 2; ++n) {
+      Blob<Dtype>* input_blob = nets[n]->input_blobs()[0];
+      input_blob->ReshapeLike(input);
+      nets[n]->Reshape();
+      caffe_copy(input.count(), input.cpu_data(),
+          input_blob->mutable_cpu_data());
+      nets[n]->Forward();
+    }
+    const Blob<Dtype>* plain_output = plain_net->output_blobs()[0];
+    const Blob<Dtype>* planned_output = planned_net->output_blobs()[0];
+    ASSERT_EQ(plain_output->shape(), planned_output->shape());
+    for (int i = 0; i < plain_output->count(); ++i) {
+      EXPECT_FLOAT_EQ(plain_output->cpu_data()[i],
+          planned_output->cpu_data()[i]);
+    }
+  }
+}
+
+TYPED_TEST(NetTest, TestHostMemoryPolicy) {
+  typedef typename TypeParam::Dtype Dtype;
+  Caffe::set_mode(Caffe::CPU);
+  const vector<size_t> node_bytes = HostAllocator::NodeBytes();
+  this->InitReshapableNet("host_memory { huge_pages: true numa_node: 0 "
+      "interleave_params: true } ");
+  // The net's policies must not leak into the caller's thread.
+  EXPECT_TRUE(Caffe::host_memory_policy().is_default());
+  // The convolution weights are interleaved over all nodes.
+  size_t total_bytes = 0;
+  for (int i = 0; i < node_bytes.size(); ++i) {
+    EXPECT_GE(HostAllocator::NodeBytes()[i], node_bytes[i]);
+    total_bytes += HostAllocator::NodeBytes()[i] - node_bytes[i];
+  }
+  EXPECT_GT(total_bytes, 0);
+  const size_t node0_bytes = HostAllocator::NodeBytes()[0];
+  this->net_->Forward();
+  EXPECT_TRUE(Caffe::host_memory_policy().is_default());
+  // The activations land on node 0.
+  EXPECT_GE(HostAllocator::NodeBytes()[0], node0_bytes +
+      this->net_->blob_by_name("conv1")->count() * sizeof(Dtype));
+  this->net_.reset();
+  for (int i = 0; i < node_bytes.size(); ++i) {
+    EXPECT_EQ(node_bytes[i], HostAllocator::NodeBytes()[i]);
+  }
+}
+
+TYPED_TEST(NetTest, TestOptimizeMemorySkippedForBackward) {
+  typedef typename TypeParam::Dtype Dtype;
+  Caffe::set_mode(Caffe::CPU);
+  // The tiny net computes a loss, so it needs backward and must not have its
+  // activations packed into a shared arena.
+  this->InitTinyNet();
+  this->net_->PlanActivationMemory();
+  EXPECT_EQ(0, this->net_->activation_arena_bytes());
+  Dtype loss;
+  this->net_->Forward(&loss);
+  this->net_->Backward();
+}
+
+TYPED_TEST(NetTest, TestSharedWorkspace) {
+  typedef typename TypeParam::Dtype Dtype;
+  // Two convolutions with differently sized im2col buffers share one
+  // workspace of the larger size, and compute what unshared ones compute.
+  // The batch is not split across threads, so each needs one buffer.
+  const string proto =
+      "name: 'WorkspaceNetwork' "
+      "force_backward: true "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'Input' "
+      "  top: 'data' "
+      "  input_param { shape: { dim: 2 dim: 3 dim: 10 dim: 9 } } "
+      "} "
+      "layer { "
+      "  name: 'conv1' "
+      "  type: 'Convolution' "
+      "  bottom: 'data' "
+      "  top: 'conv1' "
+      "  convolution_param { "
+      "    num_output: 6 "
+      "    kernel_size: 3 "
+      "    batch_parallel: false "
+      "    weight_filler { type: 'gaussian' std: 0.1 } "
+      "  } "
+      "} "
+      "layer { "
+      "  name: 'conv2' "
+      "  type: 'Convolution' "
+      "  bottom: 'conv1' "
+      "  top: 'conv2' "
+      "  convolution_param { "
+      "    num_output: 4 "
+      "    kernel_size: 5 "
+      "    pad: 2 "
+      "    batch_parallel: false "
+      "    weight_filler { type: 'gaussian' std: 0.1 } "
+      "  } "
+      "} ";
+  this->InitNetFromProtoString(proto + "share_workspace: false ");
+  shared_ptr<Net<Dtype> > plain_net = this->net_;
+  this->InitNetFromProtoString(proto);
+  shared_ptr<Net<Dtype> > shared_net = this->net_;
+  shared_net->ShareTrainedLayersWith(plain_net.get());
+  EXPECT_EQ(0, plain_net->workspace_bytes());
+
+  FillerParameter filler_param;
+  filler_param.set_std(1);
+  GaussianFiller<Dtype> filler(filler_param);
+  Blob<Dtype> input(2, 3, 10, 9);
+  Blob<Dtype> output_diff(2, 4, 8, 7);
+  filler.Fill(&input);
+  filler.Fill(&output_diff);
+  shared_ptr<Net<Dtype> > nets[] = { plain_net, shared_net };
+  for (int n = 0; n < 2; ++n) {
+    caffe_copy(input.count(), input.cpu_data(),
+        nets[n]->input_blobs()[0]->mutable_cpu_data());
+    nets[n]->Forward();
+    caffe_copy(output_diff.count(), output_diff.cpu_data(),
+        nets[n]->output_blobs()[0]->mutable_cpu_diff());
+    nets[n]->Backward();
+  }
+  // conv2 unrolls 6 x 5 x 5 rows of 8 x 7 pixels, conv1 3 x 3 x 3 rows.
+  EXPECT_EQ(6 * 5 * 5 * 8 * 7 * sizeof(Dtype), shared_net->workspace_bytes());
+  const char* blob_names[] = { "conv1", "conv2" };
+  for (int b = 0; b < 2; ++b) {
+    const Blob<Dtype>& plain = *plain_net->blob_by_name(blob_names[b]);
+    const Blob<Dtype>& shared = *shared_net->blob_by_name(blob_names[b]);
+    for (int i = 0; i < plain.count(); ++i) {
+      EXPECT_EQ(plain.cpu_data()[i], shared.cpu_data()[i]);
+    }
+  }
+  const Blob<Dtype>& plain_diff = *plain_net->input_blobs()[0];
+  const Blob<Dtype>& shared_diff = *shared_net->input_blobs()[0];
+  for (int i = 0; i < plain_diff.count(); ++i) {
+    EXPECT_EQ(plain_diff.cpu_diff()[i], shared_diff.cpu_diff()[i]);
+  }
+  for (int i = 0; i < plain_net->learnable_params().size(); ++i) {
+    const Blob<Dtype>& plain_param = *plain_net->learnable_params()[i];
+    const Blob<Dtype>& shared_param = *shared_net->learnable_params()[i];
+    for (int j = 0; j < plain_param.count(); ++j) {
+      EXPECT_EQ(plain_param.cpu_diff()[j], shared_param.cpu_diff()[j]);
+    }
+  }
+}
+
+TYPED_TEST(NetTest, TestBlockedLayout) {
+  typedef typename TypeParam::Dtype Dtype;
+  // The blocked layout is CPU only.
+  if (Caffe::mode() != Caffe::CPU) {
+    return;
+  }
+  // conv1 to sum form a chain; ip reads sum through a reorder, and the
+  // output pool2 leaves the chain at the end. Both nets compute the same.
+  const string proto =
+      "name: 'BlockedNetwork' "
+      "state { phase: TEST } "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'Input' "
+      "  top: 'data' "
+      "  input_param { shape: { dim: 2 dim: 3 dim: 9 dim: 8 } } "
+      "} "
+      "layer { "
+      "  name: 'conv1' "
+      "  type: 'Convolution' "
+      "  bottom: 'data' "
+      "  top: 'conv1' "
+      "  convolution_param { "
+      "    num_output: 16 "
+      "    kernel_size: 3 "
+      "    pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } "
+      "    bias_filler { type: 'gaussian' std: 0.1 } "
+      "  } "
+      "} "
+      "layer { name: 'relu1' type: 'ReLU' bottom: 'conv1' top: 'conv1' } "
+      "layer { "
+      "  name: 'pool1' "
+      "  type: 'Pooling' "
+      "  bottom: 'conv1' "
+      "  top: 'pool1' "
+      "  pooling_param { pool: MAX kernel_size: 2 stride: 2 } "
+      "} "
+      "layer { "
+      "  name: 'conv2' "
+      "  type: 'Convolution' "
+      "  bottom: 'pool1' "
+      "  top: 'conv2' "
+      "  convolution_param { "
+      "    num_output: 16 "
+      "    kernel_size: 3 "
+      "    pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } "
+      "  } "
+      "} "
+      "layer { "
+      "  name: 'sum' "
+      "  type: 'Eltwise' "
+      "  bottom: 'conv2' "
+      "  bottom: 'pool1' "
+      "  top: 'sum' "
+      "} "
+      "layer { "
+      "  name: 'ip' "
+      "  type: 'InnerProduct' "
+      "  bottom: 'sum' "
+      "  top: 'ip' "
+      "  inner_product_param { "
+      "    num_output: 5 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } "
+      "  } "
+      "} "
+      "layer { "
+      "  name: 'pool2' "
+      "  type: 'Pooling' "
+      "  bottom: 'sum' "
+      "  top: 'pool2' "
+      "  pooling_param { pool: AVE global_pooling: true } "
+      "} ";
+  this->InitNetFromProtoString(proto);
+  shared_ptr<Net<Dtype> > plain_net = this->net_;
+  this->InitNetFromProtoString(proto + "channel_block: 8 ");
+  shared_ptr<Net<Dtype> > blocked_net = this->net_;
+  blocked_net->ShareTrainedLayersWith(plain_net.get());
+  EXPECT_FALSE(plain_net->has_layer("sum_to_nchw"));
+  EXPECT_TRUE(blocked_net->has_layer("sum_to_nchw"));
+  EXPECT_TRUE(blocked_net->has_layer("pool2_to_nchw"));
+  EXPECT_EQ(8, blocked_net->blob_by_name("sum_blocked")->channel_block());
+
+  FillerParameter filler_param;
+  filler_param.set_std(1);
+  GaussianFiller<Dtype> filler(filler_param);
+  Blob<Dtype> input(2, 3, 9, 8);
+  filler.Fill(&input);
+  shared_ptr<Net<Dtype> > nets[] = { plain_net, blocked_net };
+  for (int n = 0; n < 2; ++n) {
+    caffe_copy(input.count(), input.cpu_data(),
+        nets[n]->input_blobs()[0]->mutable_cpu_data());
+    nets[n]->Forward();
+  }
+  ASSERT_EQ(2, blocked_net->output_blobs().size());
+  const char* blob_names[] = { "ip", "pool2" };
+  for (int b = 0; b < 2; ++b) {
+    const Blob<Dtype>& plain = *plain_net->blob_by_name(blob_names[b]);
+    const Blob<Dtype>& blocked = *blocked_net->blob_by_name(blob_names[b]);
+    EXPECT_EQ(0, blocked.channel_block());
+    ASSERT_TRUE(plain.shape() == blocked.shape());
+    for (int i = 0; i < plain.count(); ++i) {
+      EXPECT_NEAR(plain.cpu_data()[i], blocked.cpu_data()[i], 1e-4);
+    }
+  }
+}
+
+TYPED_TEST(NetTest, TestParamStorage) {
+  typedef typename TypeParam::Dtype Dtype;
+  const string proto =
+      "name: 'ReducedNetwork' "
+      "layer { "
+      "  name: 'data' "
+      "  type: 'Input' "
+      "  top: 'data' "
+      "  input_param { shape: { dim: 3 dim: 20 } } "
+      "} "
+      "layer { "
+      "  name: 'ip1' "
+      "  type: 'InnerProduct' "
+      "  bottom: 'data' "
+      "  top: 'ip1' "
+      "  param { name: 'shared' } "
+      "  inner_product_param { "
+      "    num_output: 20 "
+      "    bias_term: false "
+      "    weight_filler { type: 'gaussian' std: 0.3 } "
+      "  } "
+      "} "
+      "layer { "
+      "  name: 'ip2' "
+      "  type: 'InnerProduct' "
+      "  bottom: 'ip1' "
+      "  top: 'ip2' "
+      "  param { name: 'shared' } "
+      "  inner_product_param { "
+      "    num_output: 20 "
+      "    bias_term: false "
+      "    weight_filler { type: 'gaussian' std: 0.3 } "
+      "  } "
+      "} ";
+  this->InitNetFromProtoString(proto + "param_storage: FP16 ");
+  shared_ptr<Net<Dtype> > reduced_net = this->net_;
+  // The shared weights are held once, at 16 bits.
+  ASSERT_EQ(2, reduced_net->params().size());
+  EXPECT_EQ(FP16, reduced_net->params()[0]->data_storage());
+  EXPECT_EQ(FP16, reduced_net->params()[1]->data_storage());
+  NetParameter trained;
+  reduced_net->ToProto(&trained);
+  const BlobProto& weights = trained.layer(1).blobs(0);
+  EXPECT_EQ(FP16, weights.storage());
+  EXPECT_EQ(0, weights.data_size());
+  EXPECT_EQ(2 * 20 * 20, weights.reduced_data().size());
+
+  // A full precision net loads the rounded weights and computes the same.
+  this->InitNetFromProtoString(proto);
+  shared_ptr<Net<Dtype> > net = this->net_;
+  net->CopyTrainedLayersFrom(trained);
+  EXPECT_EQ(FP32, net->params()[0]->data_storage());
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  Blob<Dtype> input(3, 20, 1, 1);
+  filler.Fill(&input);
+  shared_ptr<Net<Dtype> > nets[] = { reduced_net, net };
+  for (int n = 0; n < 2; ++n) {
+    caffe_copy(input.count(), input.cpu_data(),
+        nets[n]->input_blobs()[0]->mutable_cpu_data());
+    nets[n]->Forward();
+  }
+  const Blob<Dtype>& expected = *net->blob_by_name("ip2");
+  const Blob<Dtype>& actual = *reduced_net->blob_by_name("ip2");
+  for (int i = 0; i < expected.count(); ++i) {
+    EXPECT_NEAR(expected.cpu_data()[i], actual.cpu_data()[i], 1e-4);
+  }
+}
+
+TYPED_TEST(NetTest, TestFuseActivations) {
+  typedef typename TypeParam::Dtype Dtype;
+  const string proto =
+      "name: 'FusedNetwork' "
+      "force_backward: true "
+      "fuse_activations: true "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape: { dim: 2 dim: 3 dim: 6 dim: 6 } } } "
+      "layer { name: 'target' type: 'Input' top: 'target' "
+      "  input_param { shape: { dim: 2 dim: 5 } } } "
+      "layer { name: 'conv1' type: 'Convolution' bottom: 'data' "
+      "  top: 'conv1' "
+      "  convolution_param { num_output: 4 kernel_size: 3 pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } "
+      "    bias_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'relu1' type: 'ReLU' bottom: 'conv1' top: 'conv1' } "
+      "layer { name: 'conv2' type: 'Convolution' bottom: 'conv1' "
+      "  top: 'conv2' "
+      "  convolution_param { num_output: 3 kernel_size: 1 bias_term: false "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'prelu2' type: 'PReLU' bottom: 'conv2' top: 'conv2' "
+      "  prelu_param { filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'scale2' type: 'Scale' bottom: 'conv2' top: 'conv2' "
+      "  scale_param { filler { type: 'gaussian' } } } "
+      "layer { name: 'ip' type: 'InnerProduct' bottom: 'conv2' top: 'ip' "
+      "  inner_product_param { num_output: 5 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } "
+      "    bias_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'relu3' type: 'ReLU' bottom: 'ip' top: 'ip' "
+      "  relu_param { negative_slope: 0.1 } } "
+      "layer { name: 'prelu3' type: 'PReLU' bottom: 'ip' top: 'ip' "
+      "  prelu_param { channel_shared: true } } "
+      "layer { name: 'relu4' type: 'ReLU' bottom: 'ip' top: 'relu4' } "
+      "layer { name: 'loss' type: 'EuclideanLoss' bottom: 'relu4' "
+      "  bottom: 'target' top: 'loss' } ";
+  this->InitNetFromProtoString(proto);
+  shared_ptr<Net<Dtype> > fused_net = this->net_;
+  const char* fused_names[] = { "relu1", "prelu2", "scale2", "relu3",
+      "prelu3" };
+  for (int i = 0; i < 5; ++i) {
+    const vector<string>& names = fused_net->layer_names();
+    const int layer_id =
+        std::find(names.begin(), names.end(), fused_names[i]) - names.begin();
+    EXPECT_TRUE(fused_net->layer_fused(layer_id)) << fused_names[i];
+  }
+  // relu4 does not work in place.
+  EXPECT_FALSE(fused_net->layer_fused(fused_net->layers().size() - 2));
+
+  // The same weights without fusion compute the same, forward and backward.
+  NetParameter trained;
+  fused_net->ToProto(&trained);
+  trained.set_fuse_activations(false);
+  trained.set_fuse_elementwise(false);
+  shared_ptr<Net<Dtype> > net(new Net<Dtype>(trained));
+  for (int i = 0; i < net->layers().size(); ++i) {
+    EXPECT_FALSE(net->layer_fused(i));
+  }
+  FillerParameter filler_param;
+  filler_param.set_std(2);
+  GaussianFiller<Dtype> filler(filler_param);
+  Blob<Dtype> data(2, 3, 6, 6), target(2, 5, 1, 1);
+  filler.Fill(&data);
+  filler.Fill(&target);
+  shared_ptr<Net<Dtype> > nets[] = { fused_net, net };
+  Dtype loss[2];
+  for (int n = 0; n < 2; ++n) {
+    caffe_copy(data.count(), data.cpu_data(),
+        nets[n]->input_blobs()[0]->mutable_cpu_data());
+    caffe_copy(target.count(), target.cpu_data(),
+        nets[n]->input_blobs()[1]->mutable_cpu_data());
+    nets[n]->ClearParamDiffs();
+    loss[n] = nets[n]->ForwardBackward();
+  }
+  EXPECT_NEAR(loss[1], loss[0], 1e-5);
+  const char* blob_names[] = { "conv1", "conv2", "ip" };
+  for (int b = 0; b < 3; ++b) {
+    const Blob<Dtype>& expected = *net->blob_by_name(blob_names[b]);
+    const Blob<Dtype>& actual = *fused_net->blob_by_name(blob_names[b]);
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_data()[i], actual.cpu_data()[i], 1e-5);
+      EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i], 1e-5);
+    }
+  }
+  ASSERT_EQ(net->params().size(), fused_net->params().size());
+  for (int p = 0; p < net->params().size(); ++p) {
+    const Blob<Dtype>& expected = *net->params()[p];
+    const Blob<Dtype>& actual = *fused_net->params()[p];
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i], 1e-5);
+    }
+  }
+
+  // Partial passes that start or stop among the fused layers run them one
+  // by one: conv1 and conv2 come out before and between their activations.
+  const vector<string>& names = net->layer_names();
+  const char* range_names[][2] = { { "data", "conv1" }, { "relu1", "ip" },
+      { "conv2", "prelu2" }, { "scale2", "loss" } };
+  for (int r = 0; r < 4; ++r) {
+    const int start = std::find(names.begin(), names.end(),
+        range_names[r][0]) - names.begin();
+    const int end = std::find(names.begin(), names.end(),
+        range_names[r][1]) - names.begin();
+    for (int n = 0; n < 2; ++n) {
+      loss[n] = nets[n]->ForwardFromTo(start, end);
+    }
+    EXPECT_NEAR(loss[1], loss[0], 1e-5);
+    for (int b = 0; b < 3; ++b) {
+      const Blob<Dtype>& expected = *net->blob_by_name(blob_names[b]);
+      const Blob<Dtype>& actual = *fused_net->blob_by_name(blob_names[b]);
+      for (int i = 0; i < expected.count(); ++i) {
+        EXPECT_NEAR(expected.cpu_data()[i], actual.cpu_data()[i], 1e-5)
+            << range_names[r][0] << " to " << range_names[r][1];
+      }
+    }
+  }
+}
+
+TYPED_TEST(NetTest, TestFuseElementwiseChains) {
+  typedef typename TypeParam::Dtype Dtype;
+  // scale1 to exp1 make a chain with parameters, over a few blocks; pool is
+  // left with the data of the pooling and power1 is not written. tanh2 and
+  // sig2 make another, which ends where the split of sig2 begins.
+  const string proto =
+      "name: 'ChainNetwork' "
+      "force_backward: true "
+      "fuse_elementwise: true "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape: { dim: 2 dim: 3 dim: 20 dim: 20 } } } "
+      "layer { name: 'target' type: 'Input' top: 'target' "
+      "  input_param { shape: { dim: 2 dim: 5 } } } "
+      "layer { name: 'conv1' type: 'Convolution' bottom: 'data' "
+      "  top: 'conv1' "
+      "  convolution_param { num_output: 6 kernel_size: 3 pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'pool' type: 'Pooling' bottom: 'conv1' top: 'pool' "
+      "  pooling_param { pool: MAX kernel_size: 3 stride: 1 pad: 1 } } "
+      "layer { name: 'scale1' type: 'Scale' bottom: 'pool' top: 'pool' "
+      "  scale_param { filler { type: 'gaussian' } } } "
+      "layer { name: 'bias1' type: 'Bias' bottom: 'pool' top: 'pool' "
+      "  bias_param { filler { type: 'gaussian' } } } "
+      "layer { name: 'prelu1' type: 'PReLU' bottom: 'pool' top: 'pool' "
+      "  prelu_param { filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'power1' type: 'Power' bottom: 'pool' top: 'power1' "
+      "  power_param { power: 2 scale: 0.5 shift: 1 } } "
+      "layer { name: 'exp1' type: 'Exp' bottom: 'power1' top: 'exp1' "
+      "  exp_param { scale: -0.5 } } "
+      "layer { name: 'ip' type: 'InnerProduct' bottom: 'exp1' top: 'ip' "
+      "  inner_product_param { num_output: 5 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'tanh2' type: 'TanH' bottom: 'ip' top: 'tanh2' } "
+      "layer { name: 'sig2' type: 'Sigmoid' bottom: 'tanh2' top: 'sig2' } "
+      "layer { name: 'abs2' type: 'AbsVal' bottom: 'sig2' top: 'abs2' } "
+      "layer { name: 'loss' type: 'EuclideanLoss' bottom: 'abs2' "
+      "  bottom: 'target' top: 'loss' } "
+      "layer { name: 'loss2' type: 'EuclideanLoss' bottom: 'sig2' "
+      "  bottom: 'target' top: 'loss2' } ";
+  this->InitNetFromProtoString(proto);
+  shared_ptr<Net<Dtype> > fused_net = this->net_;
+  const vector<string>& names = fused_net->layer_names();
+  const char* chain_names[] = { "scale1", "prelu1", "power1", "exp1",
+      "tanh2", "sig2" };
+  int chains[6];
+  for (int i = 0; i < 6; ++i) {
+    chains[i] = fused_net->layer_chain(
+        std::find(names.begin(), names.end(), chain_names[i]) - names.begin());
+  }
+  ASSERT_EQ(2, fused_net->chains().size());
+  EXPECT_EQ(0, chains[0]);
+  EXPECT_EQ(0, chains[3]);
+  EXPECT_EQ(1, chains[4]);
+  EXPECT_EQ(1, chains[5]);
+  EXPECT_EQ(-1, fused_net->layer_chain(
+      std::find(names.begin(), names.end(), "abs2") - names.begin()));
+
+  // The same weights without fusion compute the same, forward and backward.
+  NetParameter trained;
+  fused_net->ToProto(&trained);
+  trained.set_fuse_elementwise(false);
+  shared_ptr<Net<Dtype> > net(new Net<Dtype>(trained));
+  EXPECT_EQ(0, net->chains().size());
+  FillerParameter filler_param;
+  filler_param.set_std(2);
+  GaussianFiller<Dtype> filler(filler_param);
+  Blob<Dtype> data(2, 3, 20, 20), target(2, 5, 1, 1);
+  filler.Fill(&data);
+  filler.Fill(&target);
+  shared_ptr<Net<Dtype> > nets[] = { fused_net, net };
+  Dtype loss[2];
+  for (int n = 0; n < 2; ++n) {
+    caffe_copy(data.count(), data.cpu_data(),
+        nets[n]->input_blobs()[0]->mutable_cpu_data());
+    caffe_copy(target.count(), target.cpu_data(),
+        nets[n]->input_blobs()[1]->mutable_cpu_data());
+    nets[n]->ClearParamDiffs();
+    loss[n] = nets[n]->ForwardBackward();
+  }
+  EXPECT_NEAR(loss[1], loss[0], 1e-4);
+  const char* blob_names[] = { "exp1", "ip", "sig2", "abs2" };
+  for (int b = 0; b < 4; ++b) {
+    const Blob<Dtype>& expected = *net->blob_by_name(blob_names[b]);
+    const Blob<Dtype>& actual = *fused_net->blob_by_name(blob_names[b]);
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_data()[i], actual.cpu_data()[i], 1e-5)
+          << blob_names[b];
+      EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i], 1e-5)
+          << blob_names[b];
+    }
+  }
+  const Blob<Dtype>& expected = *net->blob_by_name("pool");
+  const Blob<Dtype>& actual = *fused_net->blob_by_name("pool");
+  for (int i = 0; i < expected.count(); ++i) {
+    EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i], 1e-5);
+  }
+  ASSERT_EQ(net->params().size(), fused_net->params().size());
+  for (int p = 0; p < net->params().size(); ++p) {
+    const Blob<Dtype>& expected = *net->params()[p];
+    const Blob<Dtype>& actual = *fused_net->params()[p];
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i],
+          1e-4 * std::max(Dtype(1), std::fabs(expected.cpu_diff()[i])));
+    }
+  }
+
+  // Partial passes that start or stop inside a chain run its layers one by
+  // one, after writing the blobs between them.
+  const int prelu1 =
+      std::find(names.begin(), names.end(), "prelu1") - names.begin();
+  const int power1 =
+      std::find(names.begin(), names.end(), "power1") - names.begin();
+  const int exp1 = power1 + 1;
+  const int num_layers = names.size();
+  for (int n = 0; n < 2; ++n) {
+    nets[n]->ForwardTo(power1);
+  }
+  const Blob<Dtype>& expected_power = *net->blob_by_name("power1");
+  const Blob<Dtype>& actual_power = *fused_net->blob_by_name("power1");
+  for (int i = 0; i < expected_power.count(); ++i) {
+    EXPECT_NEAR(expected_power.cpu_data()[i], actual_power.cpu_data()[i],
+        1e-5);
+  }
+  for (int n = 0; n < 2; ++n) {
+    nets[n]->Forward();
+    loss[n] = nets[n]->ForwardFrom(exp1);
+    nets[n]->Forward();
+    nets[n]->ClearParamDiffs();
+    nets[n]->BackwardFromTo(num_layers - 1, power1);
+  }
+  EXPECT_NEAR(loss[1], loss[0], 1e-4);
+  for (int i = 0; i < expected.count(); ++i) {
+    EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i], 1e-5);
+  }
+  for (int n = 0; n < 2; ++n) {
+    nets[n]->BackwardFromTo(prelu1, 0);
+  }
+  for (int p = 0; p < net->params().size(); ++p) {
+    const Blob<Dtype>& expected = *net->params()[p];
+    const Blob<Dtype>& actual = *fused_net->params()[p];
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i],
+          1e-4 * std::max(Dtype(1), std::fabs(expected.cpu_diff()[i])));
+    }
+  }
+
+  // With activation memory planned for inference, a chain writes its top
+  // while its bottom is still being read.
+  NetParameter inference;
+  inference.CopyFrom(trained);
+  inference.clear_layer();
+  inference.set_force_backward(false);
+  inference.set_optimize_memory(true);
+  inference.set_fuse_elementwise(true);
+  for (int i = 0; i < trained.layer_size(); ++i) {
+    if (trained.layer(i).type() != "EuclideanLoss") {
+      inference.add_layer()->CopyFrom(trained.layer(i));
+    }
+  }
+  Net<Dtype> planned_net(inference);
+  EXPECT_EQ(2, planned_net.chains().size());
+  EXPECT_GT(planned_net.activation_arena_bytes(), 0);
+  caffe_copy(data.count(), data.cpu_data(),
+      planned_net.input_blobs()[0]->mutable_cpu_data());
+  planned_net.Forward();
+  const Blob<Dtype>& expected_output = *net->blob_by_name("abs2");
+  const Blob<Dtype>& output = *planned_net.blob_by_name("abs2");
+  for (int i = 0; i < expected_output.count(); ++i) {
+    EXPECT_NEAR(expected_output.cpu_data()[i], output.cpu_data()[i], 1e-5);
+  }
+}
+
+TYPED_TEST(NetTest, TestRemoveIdentities) {
+  typedef typename TypeParam::Dtype Dtype;
+  // conv1 is read by pool and drop2, so it has a split; drop1 works in place
+  // and drop2 does not. pool has another reader than silence.
+  const string proto =
+      "name: 'IdentityNetwork' "
+      "state { phase: TEST } "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape: { dim: 2 dim: 3 dim: 8 dim: 8 } } } "
+      "layer { name: 'conv1' type: 'Convolution' bottom: 'data' "
+      "  top: 'conv1' "
+      "  convolution_param { num_output: 4 kernel_size: 3 pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'drop1' type: 'Dropout' bottom: 'conv1' top: 'conv1' } "
+      "layer { name: 'relu1' type: 'ReLU' bottom: 'conv1' top: 'conv1' } "
+      "layer { name: 'pool' type: 'Pooling' bottom: 'conv1' top: 'pool' "
+      "  pooling_param { pool: MAX kernel_size: 2 stride: 2 } } "
+      "layer { name: 'drop2' type: 'Dropout' bottom: 'conv1' top: 'drop2' } "
+      "layer { name: 'ip' type: 'InnerProduct' bottom: 'pool' top: 'ip' "
+      "  inner_product_param { num_output: 5 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'conv2' type: 'Convolution' bottom: 'drop2' "
+      "  top: 'conv2' "
+      "  convolution_param { num_output: 2 kernel_size: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'silence' type: 'Silence' bottom: 'pool' } ";
+  this->InitNetFromProtoString(proto);
+  shared_ptr<Net<Dtype> > net = this->net_;
+  EXPECT_EQ(11, net->layers().size());
+  // Net::ToProto keeps the splits of conv1 and pool, which go as well.
+  NetParameter removed_param;
+  net->ToProto(&removed_param);
+  removed_param.mutable_state()->set_phase(TEST);
+  removed_param.set_remove_identities(true);
+  removed_param.set_optimize_memory(true);
+  Net<Dtype> removed_net(removed_param);
+  const char* expected_names[] = { "data", "conv1", "relu1", "pool", "ip",
+      "conv2" };
+  ASSERT_EQ(6, removed_net.layers().size());
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(expected_names[i], removed_net.layer_names()[i]);
+  }
+  EXPECT_FALSE(removed_net.has_blob("drop2"));
+  EXPECT_EQ("conv1", removed_net.layers()[5]->layer_param().bottom(0));
+  ASSERT_EQ(2, removed_net.output_blobs().size());
+
+  // The outputs are the same.
+  FillerParameter filler_param;
+  filler_param.set_std(2);
+  GaussianFiller<Dtype> filler(filler_param);
+  Blob<Dtype> data(2, 3, 8, 8);
+  filler.Fill(&data);
+  caffe_copy(data.count(), data.cpu_data(),
+      net->input_blobs()[0]->mutable_cpu_data());
+  caffe_copy(data.count(), data.cpu_data(),
+      removed_net.input_blobs()[0]->mutable_cpu_data());
+  net->Forward();
+  removed_net.Forward();
+  ASSERT_EQ(net->output_blobs().size(), removed_net.output_blobs().size());
+  for (int b = 0; b < net->output_blobs().size(); ++b) {
+    const Blob<Dtype>& expected = *net->output_blobs()[b];
+    const Blob<Dtype>& actual = *removed_net.output_blobs()[b];
+    ASSERT_EQ(expected.count(), actual.count());
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_data()[i], actual.cpu_data()[i], 1e-5);
+    }
+  }
+}
+
+TYPED_TEST(NetTest, TestBlobViews) {
+  typedef typename TypeParam::Dtype Dtype;
+  // b and pool are written into cat and cat2, and cat into cat2; a has
+  // another reader, so it is copied.
+  const string proto =
+      "name: 'ViewNetwork' "
+      "blob_views: true "
+      "force_backward: true "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape: { dim: 1 dim: 3 dim: 6 dim: 6 } } } "
+      "layer { name: 'target' type: 'Input' top: 'target' "
+      "  input_param { shape: { dim: 1 dim: 2 dim: 6 dim: 6 } } } "
+      "layer { name: 'conv_a' type: 'Convolution' bottom: 'data' top: 'a' "
+      "  convolution_param { num_output: 4 kernel_size: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'abs_a' type: 'AbsVal' bottom: 'a' top: 'abs_a' } "
+      "layer { name: 'conv_b' type: 'Convolution' bottom: 'data' top: 'b' "
+      "  convolution_param { num_output: 2 kernel_size: 3 pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'relu_b' type: 'ReLU' bottom: 'b' top: 'b' } "
+      "layer { name: 'cat' type: 'Concat' bottom: 'a' bottom: 'b' "
+      "  top: 'cat' } "
+      "layer { name: 'pool' type: 'Pooling' bottom: 'data' top: 'pool' "
+      "  pooling_param { pool: MAX kernel_size: 3 stride: 1 pad: 1 } } "
+      "layer { name: 'cat2' type: 'Concat' bottom: 'cat' bottom: 'pool' "
+      "  top: 'cat2' } "
+      "layer { name: 'conv_c' type: 'Convolution' bottom: 'cat2' top: 'c' "
+      "  convolution_param { num_output: 2 kernel_size: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'loss' type: 'EuclideanLoss' bottom: 'c' "
+      "  bottom: 'target' top: 'loss' } ";
+  this->InitNetFromProtoString(proto);
+  shared_ptr<Net<Dtype> > view_net = this->net_;
+  const char* view_names[] = { "b", "pool", "cat" };
+  const char* base_names[] = { "cat", "cat2", "cat2" };
+  for (int i = 0; i < 3; ++i) {
+    const int blob_id = std::find(view_net->blob_names().begin(),
+        view_net->blob_names().end(), view_names[i]) -
+        view_net->blob_names().begin();
+    ASSERT_GE(view_net->blob_view_base(blob_id), 0);
+    EXPECT_EQ(base_names[i],
+        view_net->blob_names()[view_net->blob_view_base(blob_id)]);
+  }
+  const vector<string>& blob_names = view_net->blob_names();
+  EXPECT_EQ(-1, view_net->blob_view_base(
+      std::find(blob_names.begin(), blob_names.end(), "a") -
+      blob_names.begin()));
+  const Dtype* cat2_data = view_net->blob_by_name("cat2")->cpu_data();
+  EXPECT_EQ(cat2_data, view_net->blob_by_name("cat")->cpu_data());
+  EXPECT_EQ(cat2_data + 6 * 36, view_net->blob_by_name("pool")->cpu_data());
+  EXPECT_EQ(cat2_data + 4 * 36, view_net->blob_by_name("b")->cpu_data());
+  EXPECT_EQ(view_net->blob_by_name("cat2")->cpu_diff() + 4 * 36,
+      view_net->blob_by_name("b")->cpu_diff());
+
+  // The same weights copying into the concatenations compute the same,
+  // forward and backward, and so do both once the batch makes the
+  // concatenations strided.
+  NetParameter trained;
+  view_net->ToProto(&trained);
+  trained.set_force_backward(true);
+  trained.set_blob_views(false);
+  shared_ptr<Net<Dtype> > net(new Net<Dtype>(trained));
+  FillerParameter filler_param;
+  filler_param.set_std(2);
+  GaussianFiller<Dtype> filler(filler_param);
+  shared_ptr<Net<Dtype> > nets[] = { view_net, net };
+  for (int num = 1; num <= 2; ++num) {
+    Blob<Dtype> data(num, 3, 6, 6), target(num, 2, 6, 6);
+    filler.Fill(&data);
+    filler.Fill(&target);
+    Dtype loss[2];
+    for (int n = 0; n < 2; ++n) {
+      nets[n]->input_blobs()[0]->ReshapeLike(data);
+      nets[n]->input_blobs()[1]->ReshapeLike(target);
+      nets[n]->Reshape();
+      caffe_copy(data.count(), data.cpu_data(),
+          nets[n]->input_blobs()[0]->mutable_cpu_data());
+      caffe_copy(target.count(), target.cpu_data(),
+          nets[n]->input_blobs()[1]->mutable_cpu_data());
+      nets[n]->ClearParamDiffs();
+      loss[n] = nets[n]->ForwardBackward();
+    }
+    EXPECT_NEAR(loss[1], loss[0], 1e-4);
+    // relu_b works in place on the diff of b, which is in that of cat2 as
+    // long as b is a view, so the diff of cat2 is not compared.
+    const char* check_names[] = { "cat2", "data", "a", "b", "abs_a" };
+    for (int b = 0; b < 5; ++b) {
+      const Blob<Dtype>& expected = *net->blob_by_name(check_names[b]);
+      const Blob<Dtype>& actual = *view_net->blob_by_name(check_names[b]);
+      ASSERT_EQ(expected.count(), actual.count());
+      for (int i = 0; i < expected.count(); ++i) {
+        EXPECT_NEAR(expected.cpu_data()[i], actual.cpu_data()[i], 1e-5)
+            << check_names[b];
+        if (b > 0) {
+          EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i], 1e-5)
+              << check_names[b];
+        }
+      }
+    }
+    for (int p = 0; p < net->params().size(); ++p) {
+      const Blob<Dtype>& expected = *net->params()[p];
+      const Blob<Dtype>& actual = *view_net->params()[p];
+      for (int i = 0; i < expected.count(); ++i) {
+        EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i],
+            1e-4 * std::max(Dtype(1), std::fabs(expected.cpu_diff()[i])));
+      }
+    }
+  }
+
+  // With activation memory planned, the producers still write into cat2.
+  NetParameter inference;
+  inference.CopyFrom(trained);
+  inference.clear_layer();
+  inference.set_force_backward(false);
+  inference.set_optimize_memory(true);
+  inference.set_blob_views(true);
+  for (int i = 0; i < trained.layer_size(); ++i) {
+    if (trained.layer(i).type() != "EuclideanLoss" &&
+        trained.layer(i).name() != "target") {
+      inference.add_layer()->CopyFrom(trained.layer(i));
+    }
+  }
+  Net<Dtype> planned_net(inference);
+  EXPECT_GT(planned_net.activation_arena_bytes(), 0);
+  Blob<Dtype> data(1, 3, 6, 6);
+  filler.Fill(&data);
+  net->input_blobs()[0]->ReshapeLike(data);
+  net->input_blobs()[1]->Reshape(1, 2, 6, 6);
+  net->Reshape();
+  caffe_copy(data.count(), data.cpu_data(),
+      net->input_blobs()[0]->mutable_cpu_data());
+  net->Forward();
+  caffe_copy(data.count(), data.cpu_data(),
+      planned_net.input_blobs()[0]->mutable_cpu_data());
+  planned_net.Forward();
+  EXPECT_EQ(planned_net.blob_by_name("cat2")->cpu_data() + 4 * 36,
+      planned_net.blob_by_name("b")->cpu_data());
+  const char* output_names[] = { "c", "abs_a" };
+  for (int b = 0; b < 2; ++b) {
+    const Blob<Dtype>& expected = *net->blob_by_name(output_names[b]);
+    const Blob<Dtype>& output = *planned_net.blob_by_name(output_names[b]);
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_data()[i], output.cpu_data()[i], 1e-5);
+    }
+  }
+}
+
+TYPED_TEST(NetTest, TestStaleBlobViews) {
+  typedef typename TypeParam::Dtype Dtype;
+  // a and b are written into cat, and s0 and s1 left in place in it.
+  const string proto =
+      "name: 'StaleViewNetwork' "
+      "blob_views: true "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape: { dim: 1 dim: 3 dim: 6 dim: 6 } } } "
+      "layer { name: 'conv_a' type: 'Convolution' bottom: 'data' top: 'a' "
+      "  convolution_param { num_output: 2 kernel_size: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'conv_b' type: 'Convolution' bottom: 'data' top: 'b' "
+      "  convolution_param { num_output: 3 kernel_size: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'cat' type: 'Concat' bottom: 'a' bottom: 'b' "
+      "  top: 'cat' } "
+      "layer { name: 'slice' type: 'Slice' bottom: 'cat' top: 's0' top: 's1' "
+      "  slice_param { slice_point: 3 } } "
+      "layer { name: 'abs_s0' type: 'AbsVal' bottom: 's0' top: 'o0' } "
+      "layer { name: 'abs_s1' type: 'AbsVal' bottom: 's1' top: 'o1' } ";
+  this->InitNetFromProtoString(proto);
+  shared_ptr<Net<Dtype> > view_net = this->net_;
+  EXPECT_EQ(view_net->blob_by_name("cat")->cpu_data() + 2 * 36,
+      view_net->blob_by_name("b")->cpu_data());
+  EXPECT_EQ(view_net->blob_by_name("cat")->cpu_data() + 3 * 36,
+      view_net->blob_by_name("s1")->cpu_data());
+  NetParameter param;
+  view_net->ToProto(&param);
+  param.set_blob_views(false);
+  Net<Dtype> net(param);
+  // Shapes changed by Layer::Forward alone leave the views at offsets for
+  // the old shapes, and they must not be copied over their base.
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  Blob<Dtype> data(1, 3, 4, 4);
+  filler.Fill(&data);
+  Net<Dtype>* nets[] = { view_net.get(), &net };
+  for (int n = 0; n < 2; ++n) {
+    nets[n]->input_blobs()[0]->ReshapeLike(data);
+    caffe_copy(data.count(), data.cpu_data(),
+        nets[n]->input_blobs()[0]->mutable_cpu_data());
+    nets[n]->Forward();
+  }
+  const char* check_names[] = { "a", "b", "cat", "s0", "s1", "o0", "o1" };
+  for (int b = 0; b < 7; ++b) {
+    const Blob<Dtype>& expected = *net.blob_by_name(check_names[b]);
+    const Blob<Dtype>& actual = *view_net->blob_by_name(check_names[b]);
+    ASSERT_EQ(expected.count(), actual.count());
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_EQ(expected.cpu_data()[i], actual.cpu_data()[i])
+          << check_names[b];
+    }
+  }
+  // Net::Reshape points them into their base again.
+  view_net->Reshape();
+  view_net->Forward();
+  EXPECT_EQ(view_net->blob_by_name("cat")->cpu_data() + 2 * 16,
+      view_net->blob_by_name("b")->cpu_data());
+  EXPECT_EQ(view_net->blob_by_name("cat")->cpu_data() + 3 * 16,
+      view_net->blob_by_name("s1")->cpu_data());
+  const Blob<Dtype>& expected = *net.blob_by_name("o1");
+  const Blob<Dtype>& actual = *view_net->blob_by_name("o1");
+  for (int i = 0; i < expected.count(); ++i) {
+    EXPECT_EQ(expected.cpu_data()[i], actual.cpu_data()[i]);
+  }
+}
+
+TYPED_TEST(NetTest, TestSliceCropViews) {
+  typedef typename TypeParam::Dtype Dtype;
+  // s0 and cb are left in place in a and b; s1 is written in place while
+  // conv_a needs its top for backward, so it is copied.
+  const string proto =
+      "name: 'SliceCropViewNetwork' "
+      "blob_views: true "
+      "force_backward: true "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape: { dim: 1 dim: 4 dim: 5 dim: 6 } } } "
+      "layer { name: 'ref' type: 'Input' top: 'ref' "
+      "  input_param { shape: { dim: 1 dim: 1 dim: 3 dim: 6 } } } "
+      "layer { name: 'target' type: 'Input' top: 'target' "
+      "  input_param { shape: { dim: 1 dim: 2 } } } "
+      "layer { name: 'conv_a' type: 'Convolution' bottom: 'data' top: 'a' "
+      "  convolution_param { num_output: 6 kernel_size: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'slice' type: 'Slice' bottom: 'a' top: 's0' top: 's1' "
+      "  slice_param { slice_point: 2 } } "
+      "layer { name: 'relu_s1' type: 'ReLU' bottom: 's1' top: 's1' } "
+      "layer { name: 'conv_b' type: 'Convolution' bottom: 'data' top: 'b' "
+      "  convolution_param { num_output: 3 kernel_size: 3 pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'crop' type: 'Crop' bottom: 'b' bottom: 'ref' "
+      "  top: 'cb' crop_param { axis: 1 offset: 1 offset: 2 offset: 0 } } "
+      "layer { name: 'ip_s0' type: 'InnerProduct' bottom: 's0' top: 'p0' "
+      "  inner_product_param { num_output: 2 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'ip_s1' type: 'InnerProduct' bottom: 's1' top: 'p1' "
+      "  inner_product_param { num_output: 2 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'ip_cb' type: 'InnerProduct' bottom: 'cb' top: 'p2' "
+      "  inner_product_param { num_output: 2 "
+      "    weight_filler { type: 'gaussian' std: 0.3 } } } "
+      "layer { name: 'sum' type: 'Eltwise' bottom: 'p0' bottom: 'p1' "
+      "  bottom: 'p2' top: 'p' } "
+      "layer { name: 'loss' type: 'EuclideanLoss' bottom: 'p' "
+      "  bottom: 'target' top: 'loss' } ";
+  this->InitNetFromProtoString(proto);
+  shared_ptr<Net<Dtype> > view_net = this->net_;
+  const vector<string>& blob_names = view_net->blob_names();
+  const char* view_names[] = { "s0", "s1", "cb" };
+  const char* base_names[] = { "a", "", "b" };
+  for (int i = 0; i < 3; ++i) {
+    const int base_id = view_net->blob_view_base(std::find(blob_names.begin(),
+        blob_names.end(), view_names[i]) - blob_names.begin());
+    EXPECT_EQ(base_names[i], base_id < 0 ? "" : blob_names[base_id]);
+  }
+  const Blob<Dtype>& b = *view_net->blob_by_name("b");
+  EXPECT_EQ(view_net->blob_by_name("a")->cpu_data(),
+      view_net->blob_by_name("s0")->cpu_data());
+  EXPECT_EQ(view_net->blob_by_name("a")->cpu_diff(),
+      view_net->blob_by_name("s0")->cpu_diff());
+  EXPECT_EQ(b.cpu_data() + b.offset(0, 1, 2),
+      view_net->blob_by_name("cb")->cpu_data());
+  EXPECT_EQ(b.cpu_diff() + b.offset(0, 1, 2),
+      view_net->blob_by_name("cb")->cpu_diff());
+
+  // The same weights copying the slices and crop compute the same, forward
+  // and backward, with a batch of 2 copying again and back to 1.
+  NetParameter trained;
+  view_net->ToProto(&trained);
+  trained.set_force_backward(true);
+  trained.set_blob_views(false);
+  shared_ptr<Net<Dtype> > net(new Net<Dtype>(trained));
+  FillerParameter filler_param;
+  filler_param.set_std(2);
+  GaussianFiller<Dtype> filler(filler_param);
+  shared_ptr<Net<Dtype> > nets[] = { view_net, net };
+  const int nums[] = { 1, 2, 1 };
+  for (int k = 0; k < 3; ++k) {
+    const int num = nums[k];
+    Blob<Dtype> data(num, 4, 5, 6), target(num, 2, 1, 1);
+    filler.Fill(&data);
+    filler.Fill(&target);
+    Dtype loss[2];
+    for (int n = 0; n < 2; ++n) {
+      nets[n]->input_blobs()[0]->ReshapeLike(data);
+      nets[n]->input_blobs()[1]->Reshape(num, 1, 3, 6);
+      nets[n]->input_blobs()[2]->Reshape(num, 2, 1, 1);
+      nets[n]->Reshape();
+      caffe_copy(data.count(), data.cpu_data(),
+          nets[n]->input_blobs()[0]->mutable_cpu_data());
+      caffe_copy(target.count(), target.cpu_data(),
+          nets[n]->input_blobs()[2]->mutable_cpu_data());
+      nets[n]->ClearParamDiffs();
+      loss[n] = nets[n]->ForwardBackward();
+    }
+    EXPECT_NEAR(loss[1], loss[0], 1e-4);
+    EXPECT_EQ(num == 1, view_net->blob_by_name("a")->cpu_data() ==
+        view_net->blob_by_name("s0")->cpu_data());
+    const char* check_names[] = { "a", "s0", "s1", "b", "cb", "data" };
+    for (int c = 0; c < 6; ++c) {
+      const Blob<Dtype>& expected = *net->blob_by_name(check_names[c]);
+      const Blob<Dtype>& actual = *view_net->blob_by_name(check_names[c]);
+      ASSERT_EQ(expected.count(), actual.count());
+      for (int i = 0; i < expected.count(); ++i) {
+        EXPECT_NEAR(expected.cpu_data()[i], actual.cpu_data()[i], 1e-5)
+            << check_names[c];
+        EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i], 1e-5)
+            << check_names[c];
+      }
+    }
+    for (int p = 0; p < net->params().size(); ++p) {
+      const Blob<Dtype>& expected = *net->params()[p];
+      const Blob<Dtype>& actual = *view_net->params()[p];
+      for (int i = 0; i < expected.count(); ++i) {
+        EXPECT_NEAR(expected.cpu_diff()[i], actual.cpu_diff()[i],
+            1e-4 * std::max(Dtype(1), std::fabs(expected.cpu_diff()[i])));
+      }
+    }
+  }
+
+  // Without backward s1 is left in place too, and the slices and crop stay
+  // in a and b as net outputs with activation memory planned.
+  NetParameter inference;
+  inference.CopyFrom(trained);
+  inference.clear_layer();
+  inference.set_force_backward(false);
+  inference.set_optimize_memory(true);
+  inference.set_blob_views(true);
+  for (int i = 0; i < trained.layer_size(); ++i) {
+    const string& type = trained.layer(i).type();
+    if (type != "InnerProduct" && type != "Eltwise" &&
+        type != "EuclideanLoss" && trained.layer(i).name() != "target") {
+      inference.add_layer()->CopyFrom(trained.layer(i));
+    }
+  }
+  Net<Dtype> planned_net(inference);
+  const Blob<Dtype>& a = *planned_net.blob_by_name("a");
+  EXPECT_EQ(a.cpu_data() + a.offset(0, 2),
+      planned_net.blob_by_name("s1")->cpu_data());
+  Blob<Dtype> data(1, 4, 5, 6);
+  filler.Fill(&data);
+  for (int n = 0; n < 2; ++n) {
+    Net<Dtype>& forward_net = n == 0 ? *net : planned_net;
+    forward_net.input_blobs()[0]->ReshapeLike(data);
+    forward_net.input_blobs()[1]->Reshape(1, 1, 3, 6);
+    if (n == 0) {
+      forward_net.input_blobs()[2]->Reshape(1, 2, 1, 1);
+    }
+    forward_net.Reshape();
+    caffe_copy(data.count(), data.cpu_data(),
+        forward_net.input_blobs()[0]->mutable_cpu_data());
+    forward_net.Forward();
+  }
+  for (int c = 0; c < 3; ++c) {
+    const Blob<Dtype>& expected = *net->blob_by_name(view_names[c]);
+    const Blob<Dtype>& output = *planned_net.blob_by_name(view_names[c]);
+    ASSERT_EQ(expected.count(), output.count());
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_NEAR(expected.cpu_data()[i], output.cpu_data()[i], 1e-5)
+          << view_names[c];
+    }
+  }
+}
+
+TYPED_TEST(NetTest, TestShareBottomData) {
+  typedef typename TypeParam::Dtype Dtype;
+  // filter selects every item, but neg writes its top in place while sig
+  // needs its own top for backward, so filter must copy.
+  const string proto =
+      "name: 'ShareNetwork' "
+      "force_backward: true "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape: { dim: 2 dim: 3 } } } "
+      "layer { name: 'sel' type: 'Input' top: 'sel' "
+      "  input_param { shape: { dim: 2 } } } "
+      "layer { name: 'sig' type: 'Sigmoid' bottom: 'data' top: 'sig' } "
+      "layer { name: 'filter' type: 'Filter' bottom: 'sig' bottom: 'sel' "
+      "  top: 'filt' } ";
+  const string neg =
+      "layer { name: 'neg' type: 'Power' bottom: 'filt' top: 'filt' "
+      "  power_param { scale: -1 } } ";
+  const string views = "blob_views: true ";
+  this->InitNetFromProtoString(proto + views + neg);
+  EXPECT_FALSE(this->net_->layer_by_name("filter")->share_bottom_data());
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(this->net_->input_blobs()[0]);
+  Blob<Dtype>* sel = this->net_->input_blobs()[1];
+  caffe_set(sel->count(), Dtype(1), sel->mutable_cpu_data());
+  this->net_->Forward();
+  const Blob<Dtype>& sig = *this->net_->blob_by_name("sig");
+  const Blob<Dtype>& filt = *this->net_->blob_by_name("filt");
+  for (int i = 0; i < sig.count(); ++i) {
+    EXPECT_GT(sig.cpu_data()[i], 0);
+    EXPECT_EQ(-sig.cpu_data()[i], filt.cpu_data()[i]);
+  }
+  // Without neg, filter passes sig on, unless blob views are off.
+  this->InitNetFromProtoString(proto + views);
+  EXPECT_TRUE(this->net_->layer_by_name("filter")->share_bottom_data());
+  sel = this->net_->input_blobs()[1];
+  caffe_set(sel->count(), Dtype(1), sel->mutable_cpu_data());
+  this->net_->Forward();
+  EXPECT_EQ(this->net_->blob_by_name("sig")->cpu_data(),
+      this->net_->blob_by_name("filt")->cpu_data());
+  this->InitNetFromProtoString(proto);
+  EXPECT_FALSE(this->net_->layer_by_name("filter")->share_bottom_data());
+}
+
 TYPED_TEST(NetTest, TestSkipPropagateDown) {
   // check bottom_need_backward if propagate_down is true
   this->InitSkipPropNet(false);
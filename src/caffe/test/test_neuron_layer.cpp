@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "google/protobuf/text_format.h"
@@ -7,10 +8,12 @@
 #include "caffe/blob.hpp"
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
+#include "caffe/layer_factory.hpp"
 
 #include "caffe/layers/absval_layer.hpp"
 #include "caffe/layers/bnll_layer.hpp"
 #include "caffe/layers/dropout_layer.hpp"
+#include "caffe/layers/elementwise_chain_layer.hpp"
 #include "caffe/layers/elu_layer.hpp"
 #include "caffe/layers/exp_layer.hpp"
 #include "caffe/layers/inner_product_layer.hpp"
@@ -805,6 +808,132 @@ TYPED_TEST(NeuronLayerTest, TestPReLUInPlace) {
   }
 }
 
+template <typename Dtype>
+class ElementwiseChainLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  ElementwiseChainLayerTest() {
+    Caffe::set_random_seed(1701);
+    // A few blocks' worth of values through layers with and without
+    // parameters, each on a top of its own.
+    const char* layers[] = {
+      "type: 'Scale' scale_param { bias_term: true "
+      "  filler { type: 'gaussian' } bias_filler { type: 'gaussian' } } ",
+      "type: 'PReLU' prelu_param { filler { type: 'gaussian' std: 0.3 } } ",
+      "type: 'Power' power_param { power: 2 scale: 0.5 shift: 1 } ",
+      "type: 'Exp' exp_param { scale: -0.5 } ",
+      "type: 'Bias' bias_param { axis: 2 filler { type: 'gaussian' } } ",
+      "type: 'TanH' ",
+    };
+    blobs_.push_back(shared_ptr<Blob<Dtype> >(new Blob<Dtype>(2, 3, 40, 20)));
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(blobs_[0].get());
+    for (int i = 0; i < 6; ++i) {
+      LayerParameter layer_param;
+      CHECK(google::protobuf::TextFormat::ParseFromString(layers[i],
+          &layer_param));
+      layers_.push_back(LayerRegistry<Dtype>::CreateLayer(layer_param));
+      blobs_.push_back(shared_ptr<Blob<Dtype> >(new Blob<Dtype>()));
+      layers_[i]->SetUp(bottom_vec(i), bottom_vec(i + 1));
+      chain_layers_.push_back(layers_[i].get());
+    }
+  }
+
+  vector<Blob<Dtype>*> bottom_vec(int i) {
+    return vector<Blob<Dtype>*>(1, blobs_[i].get());
+  }
+
+  // Runs the layers one by one, from a random top diff.
+  void ForwardBackward() {
+    for (int i = 0; i < layers_.size(); ++i) {
+      layers_[i]->Forward(bottom_vec(i), bottom_vec(i + 1));
+    }
+    Blob<Dtype>* top = blobs_.back().get();
+    caffe_rng_gaussian<Dtype>(top->count(), 0, 1, top->mutable_cpu_diff());
+    for (int i = layers_.size() - 1; i >= 0; --i) {
+      layers_[i]->Backward(bottom_vec(i + 1), vector<bool>(1, true),
+          bottom_vec(i));
+    }
+  }
+
+  void ExpectNear(int count, const Dtype* expected, const Dtype* actual) {
+    for (int i = 0; i < count; ++i) {
+      EXPECT_NEAR(expected[i], actual[i],
+          1e-4 * std::max(Dtype(1), std::fabs(expected[i])));
+    }
+  }
+
+  vector<shared_ptr<Layer<Dtype> > > layers_;
+  vector<Layer<Dtype>*> chain_layers_;
+  // The bottom, then the top of each layer.
+  vector<shared_ptr<Blob<Dtype> > > blobs_;
+};
+
+TYPED_TEST_CASE(ElementwiseChainLayerTest, TestDtypes);
+
+TYPED_TEST(ElementwiseChainLayerTest, TestForwardBackward) {
+  typedef TypeParam Dtype;
+  this->ForwardBackward();
+  // The parameter gradients of the layers one by one.
+  vector<Blob<Dtype>*> params;
+  vector<shared_ptr<Blob<Dtype> > > param_diffs;
+  for (int i = 0; i < this->layers_.size(); ++i) {
+    for (int j = 0; j < this->layers_[i]->blobs().size(); ++j) {
+      Blob<Dtype>* param = this->layers_[i]->blobs()[j].get();
+      params.push_back(param);
+      param_diffs.push_back(shared_ptr<Blob<Dtype> >(new Blob<Dtype>()));
+      param_diffs.back()->CopyFrom(*param, true, true);
+      caffe_set(param->count(), Dtype(0), param->mutable_cpu_diff());
+    }
+  }
+  ASSERT_EQ(4, params.size());
+  Blob<Dtype>* bottom = this->blobs_[0].get();
+  Blob<Dtype>* expected_top = this->blobs_.back().get();
+  Blob<Dtype> bottom_diff;
+  bottom_diff.CopyFrom(*bottom, true, true);
+
+  ElementwiseChainLayer<Dtype> layer(LayerParameter(), this->chain_layers_,
+      false);
+  Blob<Dtype> top;
+  vector<Blob<Dtype>*> bottom_vec(1, bottom), top_vec(1, &top);
+  layer.SetUp(bottom_vec, top_vec);
+  layer.Forward(bottom_vec, top_vec);
+  this->ExpectNear(top.count(), expected_top->cpu_data(), top.cpu_data());
+  caffe_copy(top.count(), expected_top->cpu_diff(), top.mutable_cpu_diff());
+  caffe_set(bottom->count(), Dtype(0), bottom->mutable_cpu_diff());
+  layer.Backward(top_vec, vector<bool>(1, true), bottom_vec);
+  this->ExpectNear(bottom->count(), bottom_diff.cpu_diff(),
+      bottom->cpu_diff());
+  for (int i = 0; i < params.size(); ++i) {
+    this->ExpectNear(params[i]->count(), param_diffs[i]->cpu_diff(),
+        params[i]->cpu_diff());
+  }
+}
+
+TYPED_TEST(ElementwiseChainLayerTest, TestInPlace) {
+  typedef TypeParam Dtype;
+  // Without parameter gradients the blocks run backward in parallel.
+  for (int i = 0; i < this->layers_.size(); ++i) {
+    for (int j = 0; j < this->layers_[i]->blobs().size(); ++j) {
+      this->layers_[i]->set_param_propagate_down(j, false);
+    }
+  }
+  this->ForwardBackward();
+  Blob<Dtype> data;
+  data.CopyFrom(*this->blobs_[0], false, true);
+  ElementwiseChainLayer<Dtype> layer(LayerParameter(), this->chain_layers_,
+      true);
+  vector<Blob<Dtype>*> data_vec(1, &data);
+  layer.SetUp(data_vec, data_vec);
+  layer.Forward(data_vec, data_vec);
+  const Blob<Dtype>& expected_top = *this->blobs_.back();
+  this->ExpectNear(data.count(), expected_top.cpu_data(), data.cpu_data());
+  caffe_copy(data.count(), expected_top.cpu_diff(), data.mutable_cpu_diff());
+  layer.Backward(data_vec, vector<bool>(1, true), data_vec);
+  this->ExpectNear(data.count(), this->blobs_[0]->cpu_diff(),
+      data.cpu_diff());
+}
+
 #ifdef USE_CUDNN
 template <typename Dtype>
 class CuDNNNeuronLayerTest : public GPUDeviceTest<Dtype> {
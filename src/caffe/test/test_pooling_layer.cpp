@@ -6,6 +6,7 @@
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
 #include "caffe/layers/pooling_layer.hpp"
+#include "caffe/util/blocked_layout.hpp"
 
 #ifdef USE_CUDNN
 #include "caffe/layers/cudnn_pooling_layer.hpp"
@@ -609,6 +610,49 @@ TYPED_TEST(PoolingLayerTest, TestGradientAvePadded) {
   }
 }
 
+TYPED_TEST(PoolingLayerTest, TestForwardBlocked) {
+  typedef typename TypeParam::Dtype Dtype;
+  // The blocked layout is CPU only.
+  if (Caffe::mode() != Caffe::CPU) {
+    return;
+  }
+  this->blob_bottom_->Reshape(2, 8, 7, 6);
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(this->blob_bottom_);
+  Blob<Dtype> blocked_bottom(2, 8, 7, 6);
+  reorder_channels_cpu(2, 8, 7 * 6, 0, 4, this->blob_bottom_->cpu_data(),
+      blocked_bottom.mutable_cpu_data());
+  blocked_bottom.set_channel_block(4);
+  Blob<Dtype> blocked_top;
+  vector<Blob<Dtype>*> blocked_bottom_vec(1, &blocked_bottom);
+  vector<Blob<Dtype>*> blocked_top_vec(1, &blocked_top);
+  const PoolingParameter_PoolMethod pools[] = {
+      PoolingParameter_PoolMethod_MAX, PoolingParameter_PoolMethod_AVE };
+  for (int p = 0; p < 2; ++p) {
+    LayerParameter layer_param;
+    PoolingParameter* pooling_param = layer_param.mutable_pooling_param();
+    pooling_param->set_kernel_size(3);
+    pooling_param->set_stride(2);
+    pooling_param->set_pad(1);
+    pooling_param->set_pool(pools[p]);
+    PoolingLayer<Dtype> layer(layer_param);
+    layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+    layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+    PoolingLayer<Dtype> blocked_layer(layer_param);
+    blocked_layer.SetUp(blocked_bottom_vec, blocked_top_vec);
+    blocked_layer.Forward(blocked_bottom_vec, blocked_top_vec);
+    EXPECT_EQ(4, blocked_top.channel_block());
+    ASSERT_TRUE(blocked_top.shape() == this->blob_top_->shape());
+    Blob<Dtype> expected(this->blob_top_->shape());
+    reorder_channels_cpu(2, 8, this->blob_top_->count(2), 0, 4,
+        this->blob_top_->cpu_data(), expected.mutable_cpu_data());
+    for (int i = 0; i < expected.count(); ++i) {
+      EXPECT_EQ(expected.cpu_data()[i], blocked_top.cpu_data()[i]);
+    }
+  }
+}
+
 #ifdef USE_CUDNN
 template <typename Dtype>
 class CuDNNPoolingLayerTest : public GPUDeviceTest<Dtype> {
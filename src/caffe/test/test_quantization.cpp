@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/layers/quantized_conv_layer.hpp"
+#include "caffe/layers/quantized_inner_product_layer.hpp"
+#include "caffe/net.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/benchmark.hpp"
+#include "caffe/util/int8_gemm.hpp"
+#include "caffe/util/math_functions.hpp"
+#include "caffe/util/quantization.hpp"
+#include "caffe/util/simd_math.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+class QuantizationTest : public CPUDeviceTest<Dtype> {
+ protected:
+  virtual void SetUp() {
+    const string& proto =
+        "name: 'TestNetwork' "
+        "state { phase: TEST } "
+        "layer { name: 'data' type: 'DummyData' top: 'data' "
+        "  dummy_data_param { shape { dim: 4 dim: 3 dim: 8 dim: 8 } "
+        "    data_filler { type: 'gaussian' std: 2 } } } "
+        "layer { name: 'conv' type: 'Convolution' bottom: 'data' top: 'conv' "
+        "  convolution_param { num_output: 8 kernel_size: 3 pad: 1 "
+        "    weight_filler { type: 'gaussian' std: 0.1 } "
+        "    bias_filler { type: 'gaussian' std: 0.1 } } } "
+        "layer { name: 'relu' type: 'ReLU' bottom: 'conv' top: 'conv' } "
+        "layer { name: 'pool' type: 'Pooling' bottom: 'conv' top: 'pool' "
+        "  pooling_param { pool: MAX kernel_size: 2 stride: 2 } } "
+        "layer { name: 'ip' type: 'InnerProduct' bottom: 'pool' top: 'ip' "
+        "  inner_product_param { num_output: 10 "
+        "    weight_filler { type: 'gaussian' std: 0.1 } "
+        "    bias_filler { type: 'gaussian' std: 0.1 } } } ";
+    NetParameter param;
+    CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param));
+    net_.reset(new Net<Dtype>(param));
+  }
+
+  shared_ptr<Net<Dtype> > net_;
+};
+
+TYPED_TEST_CASE(QuantizationTest, TestDtypes);
+
+TYPED_TEST(QuantizationTest, TestCalibrate) {
+  typedef TypeParam Dtype;
+  NetParameter quantized;
+  CalibrateQuantization(this->net_.get(), 3, &quantized);
+  ASSERT_EQ(this->net_->layers().size(), quantized.layer_size());
+  for (int i = 0; i < quantized.layer_size(); ++i) {
+    const LayerParameter& layer_param = quantized.layer(i);
+    const bool int8 = layer_param.name() == "conv" ||
+        layer_param.name() == "ip";
+    EXPECT_EQ(int8, layer_param.has_quantization_param());
+    if (int8) {
+      EXPECT_EQ(QuantizationParameter_Precision_INT8,
+          layer_param.quantization_param().precision());
+      EXPECT_GT(layer_param.quantization_param().bottom_range(), 0);
+      EXPECT_EQ(this->net_->layers()[i]->blobs().size(),
+          layer_param.blobs_size());
+    }
+  }
+  // The range of conv covers the last batch at least.
+  const Blob<Dtype>& data = *this->net_->blob_by_name("data");
+  EXPECT_GE(quantized.layer(1).quantization_param().bottom_range(),
+      static_cast<float>(int8_max_abs(data.count(), data.cpu_data())));
+  Net<Dtype> net(quantized);
+  EXPECT_TRUE(dynamic_cast<QuantizedConvolutionLayer<Dtype>*>(
+      net.layer_by_name("conv").get()));
+  EXPECT_TRUE(dynamic_cast<QuantizedInnerProductLayer<Dtype>*>(
+      net.layer_by_name("ip").get()));
+}
+
+TYPED_TEST(QuantizationTest, TestCompare) {
+  typedef TypeParam Dtype;
+  NetParameter quantized;
+  CalibrateQuantization(this->net_.get(), 3, &quantized);
+  Net<Dtype> net(quantized);
+  vector<QuantizationError> errors =
+      CompareQuantizedNet(this->net_.get(), &net, 3);
+  ASSERT_EQ(1, errors.size());
+  EXPECT_EQ("ip", errors[0].blob_name);
+  EXPECT_GT(errors[0].max_abs_diff, 0);
+  EXPECT_LT(errors[0].relative_error, 0.05);
+  EXPECT_NEAR(errors[0].reference_mean, errors[0].quantized_mean, 0.05);
+  // Against itself, the reference has no error at all.
+  errors = CompareQuantizedNet(this->net_.get(), this->net_.get(), 1);
+  ASSERT_EQ(1, errors.size());
+  EXPECT_EQ(0, errors[0].max_abs_diff);
+}
+
+TYPED_TEST(QuantizationTest, TestInt8Gemm) {
+  typedef TypeParam Dtype;
+  // Sizes that leave partial groups of k, vectors and panels.
+  const int M = 5, N = 300, K = 37;
+  vector<int8_t> A(M * K), B(K * N);
+  for (int i = 0; i < M * K; ++i) {
+    A[i] = static_cast<int8_t>((i * 37) % 255 - 127);
+  }
+  for (int i = 0; i < K * N; ++i) {
+    B[i] = static_cast<int8_t>((i * 101) % 255 - 127);
+  }
+  vector<Dtype> scale(M), bias(M);
+  for (int i = 0; i < M; ++i) {
+    scale[i] = Dtype(1) / (i + 1);
+    bias[i] = i;
+  }
+  vector<int8_t> packed(int8_packed_size(K, N));
+  int8_pack_cpu(K, N, &B[0], N, 1, &packed[0]);
+  const SimdIsa isa = simd_isa();
+  vector<Dtype> C(M * N), scalar_C(M * N);
+  set_simd_isa(SIMD_SCALAR);
+  int8_gemm_cpu(M, N, K, &A[0], &packed[0], &scale[0], &bias[0], false,
+      &scalar_C[0]);
+  set_simd_isa(simd_best_isa());
+  int8_gemm_cpu(M, N, K, &A[0], &packed[0], &scale[0], &bias[0], false,
+      &C[0]);
+  set_simd_isa(isa);
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < N; ++j) {
+      int sum = 0;
+      for (int k = 0; k < K; ++k) {
+        sum += A[i * K + k] * B[k * N + j];
+      }
+      EXPECT_NEAR(sum * scale[i] + bias[i], scalar_C[i * N + j], 1e-3);
+      EXPECT_EQ(scalar_C[i * N + j], C[i * N + j]);
+    }
+  }
+}
+
+TYPED_TEST(QuantizationTest, TestWeightUpdate) {
+  typedef TypeParam Dtype;
+  // The quantized weights are kept until the weights change.
+  Blob<Dtype> bottom(2, 3, 6, 5), top;
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(&bottom);
+  vector<Blob<Dtype>*> bottom_vec(1, &bottom), top_vec(1, &top);
+  LayerParameter layer_param;
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  convolution_param->add_kernel_size(3);
+  convolution_param->set_num_output(4);
+  convolution_param->set_bias_term(false);
+  convolution_param->mutable_weight_filler()->set_type("gaussian");
+  layer_param.mutable_quantization_param()->set_precision(
+      QuantizationParameter_Precision_INT8);
+  QuantizedConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(bottom_vec, top_vec);
+  layer.Forward(bottom_vec, top_vec);
+  Blob<Dtype> first;
+  first.CopyFrom(top, false, true);
+  caffe_scal(layer.blobs()[0]->count(), Dtype(2),
+      layer.blobs()[0]->mutable_cpu_data());
+  layer.Forward(bottom_vec, top_vec);
+  for (int i = 0; i < top.count(); ++i) {
+    EXPECT_NEAR(2 * first.cpu_data()[i], top.cpu_data()[i],
+        1e-4 * std::max(Dtype(1), std::fabs(top.cpu_data()[i])));
+  }
+}
+
+// Forward time of a float and an int8 convolution of the same shape. Run
+// with --gtest_also_run_disabled_tests.
+TYPED_TEST(QuantizationTest, DISABLED_Benchmark) {
+  typedef TypeParam Dtype;
+  const int iterations = 20;
+  Blob<Dtype> bottom(8, 64, 28, 28), top;
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(&bottom);
+  vector<Blob<Dtype>*> bottom_vec(1, &bottom), top_vec(1, &top);
+  LayerParameter layer_param;
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  convolution_param->add_kernel_size(3);
+  convolution_param->add_pad(1);
+  convolution_param->set_num_output(64);
+  convolution_param->mutable_weight_filler()->set_type("gaussian");
+  ConvolutionLayer<Dtype> fp32(layer_param);
+  fp32.SetUp(bottom_vec, top_vec);
+  layer_param.mutable_quantization_param()->set_precision(
+      QuantizationParameter_Precision_INT8);
+  layer_param.mutable_quantization_param()->set_bottom_range(4);
+  QuantizedConvolutionLayer<Dtype> quantized(layer_param);
+  quantized.SetUp(bottom_vec, top_vec);
+  Layer<Dtype>* layers[] = { &fp32, &quantized };
+  float ms[2];
+  for (int l = 0; l < 2; ++l) {
+    layers[l]->Forward(bottom_vec, top_vec);
+    Timer timer;
+    timer.Start();
+    for (int i = 0; i < iterations; ++i) {
+      layers[l]->Forward(bottom_vec, top_vec);
+    }
+    ms[l] = timer.MilliSeconds() / iterations;
+  }
+  LOG(INFO) << "fp32 " << ms[0] << " ms int8 " << ms[1] << " ms";
+}
+
+}  // namespace caffe
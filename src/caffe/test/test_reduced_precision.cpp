@@ -0,0 +1,199 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/syncedmem.hpp"
+#include "caffe/util/reduced_precision.hpp"
+#include "caffe/util/simd_math.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class ReducedPrecisionTest : public ::testing::Test {};
+
+TEST_F(ReducedPrecisionTest, TestFp16Values) {
+  EXPECT_EQ(0x0000, float_to_fp16(0.f));
+  EXPECT_EQ(0x8000, float_to_fp16(-0.f));
+  EXPECT_EQ(0x3C00, float_to_fp16(1.f));
+  EXPECT_EQ(0xC000, float_to_fp16(-2.f));
+  EXPECT_EQ(0x7BFF, float_to_fp16(65504.f));
+  // Past the largest value, halfway to the next exponent rounds to infinity.
+  EXPECT_EQ(0x7BFF, float_to_fp16(65519.f));
+  EXPECT_EQ(0x7C00, float_to_fp16(65520.f));
+  EXPECT_EQ(0xFC00, float_to_fp16(-std::numeric_limits<float>::infinity()));
+  // The smallest subnormal, and ties to even around it.
+  EXPECT_EQ(0x0001, float_to_fp16(std::ldexp(1.f, -24)));
+  EXPECT_EQ(0x0000, float_to_fp16(std::ldexp(1.f, -25)));
+  EXPECT_EQ(0x0002, float_to_fp16(std::ldexp(3.f, -25)));
+  // 1 + 2^-11 is halfway between 1 and 1 + 2^-10.
+  EXPECT_EQ(0x3C00, float_to_fp16(1.f + std::ldexp(1.f, -11)));
+  EXPECT_EQ(0x3C02, float_to_fp16(1.f + std::ldexp(3.f, -11)));
+  EXPECT_TRUE(std::isnan(fp16_to_float(
+      float_to_fp16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST_F(ReducedPrecisionTest, TestFp16RoundTrip) {
+  // Every finite FP16 value widens exactly and narrows back to itself.
+  for (uint32_t bits = 0; bits < 0x10000; ++bits) {
+    const uint16_t value = static_cast<uint16_t>(bits);
+    if ((value & 0x7C00) == 0x7C00 && (value & 0x03FF) != 0) {
+      EXPECT_TRUE(std::isnan(fp16_to_float(value)));
+      continue;
+    }
+    EXPECT_EQ(value, float_to_fp16(fp16_to_float(value))) << bits;
+  }
+  EXPECT_EQ(65504.f, fp16_to_float(0x7BFF));
+  EXPECT_EQ(std::ldexp(1.f, -24), fp16_to_float(0x0001));
+}
+
+TEST_F(ReducedPrecisionTest, TestBf16Values) {
+  EXPECT_EQ(0x3F80, float_to_bf16(1.f));
+  EXPECT_EQ(0xC000, float_to_bf16(-2.f));
+  // 1 + 2^-8 is halfway between 1 and 1 + 2^-7.
+  EXPECT_EQ(0x3F80, float_to_bf16(1.f + std::ldexp(1.f, -8)));
+  EXPECT_EQ(0x3F82, float_to_bf16(1.f + std::ldexp(3.f, -8)));
+  EXPECT_EQ(0x7F80, float_to_bf16(std::numeric_limits<float>::infinity()));
+  EXPECT_NEAR(1e30f, bf16_to_float(float_to_bf16(1e30f)), 1e30f / 256);
+  EXPECT_TRUE(std::isnan(bf16_to_float(
+      float_to_bf16(std::numeric_limits<float>::quiet_NaN()))));
+  for (uint32_t bits = 0; bits < 0x10000; ++bits) {
+    const uint16_t value = static_cast<uint16_t>(bits);
+    if ((value & 0x7F80) == 0x7F80 && (value & 0x007F) != 0) {
+      continue;
+    }
+    EXPECT_EQ(value, float_to_bf16(bf16_to_float(value))) << bits;
+  }
+}
+
+template <typename Dtype>
+class ReducedPrecisionArrayTest : public ::testing::Test {
+ protected:
+  ReducedPrecisionArrayTest() : isa_(simd_isa()), x_(kCount) {}
+
+  virtual void SetUp() {
+    Caffe::set_random_seed(1701);
+    caffe_rng_gaussian<Dtype>(kCount, 0, 100, x_.data());
+    x_[0] = 1e6;  // FP16 overflow
+    x_[1] = 1e-7;  // FP16 subnormal
+  }
+  virtual void TearDown() {
+    set_simd_isa(isa_);
+  }
+
+  // Odd so that every vector width leaves a tail.
+  static const int kCount = 1003;
+  const SimdIsa isa_;
+  vector<Dtype> x_;
+};
+
+TYPED_TEST_CASE(ReducedPrecisionArrayTest, TestDtypes);
+
+TYPED_TEST(ReducedPrecisionArrayTest, TestArraysMatchScalar) {
+  typedef TypeParam Dtype;
+  const StoragePrecision precisions[] = { FP16, BF16 };
+  for (int isa = SIMD_SCALAR; isa <= simd_best_isa(); ++isa) {
+    set_simd_isa(static_cast<SimdIsa>(isa));
+    for (int p = 0; p < 2; ++p) {
+      vector<uint16_t> reduced(this->kCount);
+      caffe_cpu_reduce_precision(this->kCount, this->x_.data(),
+          precisions[p], reduced.data());
+      vector<Dtype> widened(this->kCount);
+      caffe_cpu_expand_precision(this->kCount, reduced.data(), precisions[p],
+          widened.data());
+      for (int i = 0; i < this->kCount; ++i) {
+        const float x = static_cast<float>(this->x_[i]);
+        const uint16_t expected = precisions[p] == FP16 ?
+            float_to_fp16(x) : float_to_bf16(x);
+        EXPECT_EQ(expected, reduced[i]) << "isa " << isa << " index " << i;
+        EXPECT_EQ(precisions[p] == FP16 ? fp16_to_float(expected) :
+            bf16_to_float(expected), widened[i]);
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+class ReducedStorageBlobTest : public ::testing::Test {
+ protected:
+  ReducedStorageBlobTest() : blob_(new Blob<Dtype>(2, 3, 4, 5)) {}
+  virtual void SetUp() {
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(blob_);
+  }
+  virtual ~ReducedStorageBlobTest() { delete blob_; }
+  Blob<Dtype>* const blob_;
+};
+
+TYPED_TEST_CASE(ReducedStorageBlobTest, TestDtypes);
+
+TYPED_TEST(ReducedStorageBlobTest, TestStorage) {
+  typedef TypeParam Dtype;
+  vector<Dtype> original(this->blob_->cpu_data(),
+      this->blob_->cpu_data() + this->blob_->count());
+  this->blob_->set_data_storage(FP16);
+  EXPECT_EQ(FP16, this->blob_->data_storage());
+  EXPECT_EQ(SyncedMemory::HEAD_AT_REDUCED, this->blob_->data()->head());
+  ASSERT_TRUE(this->blob_->reduced_cpu_data());
+  // Reading widens the data and drops the 16-bit copy.
+  const Dtype* data = this->blob_->cpu_data();
+  for (int i = 0; i < this->blob_->count(); ++i) {
+    EXPECT_EQ(fp16_to_float(float_to_fp16(original[i])), data[i]);
+  }
+  EXPECT_EQ(FP32, this->blob_->data_storage());
+  EXPECT_FALSE(this->blob_->reduced_cpu_data());
+  EXPECT_EQ(SyncedMemory::HEAD_AT_CPU, this->blob_->data()->head());
+  // So does writing.
+  this->blob_->set_data_storage(FP16);
+  this->blob_->mutable_cpu_data();
+  EXPECT_EQ(FP32, this->blob_->data_storage());
+  EXPECT_FALSE(this->blob_->reduced_cpu_data());
+  // So does going back to FP32, which keeps the rounded values.
+  this->blob_->set_data_storage(BF16);
+  this->blob_->set_data_storage(FP32);
+  EXPECT_EQ(FP32, this->blob_->data_storage());
+  for (int i = 0; i < this->blob_->count(); ++i) {
+    const float fp16 = fp16_to_float(float_to_fp16(original[i]));
+    EXPECT_EQ(bf16_to_float(float_to_bf16(fp16)), this->blob_->cpu_data()[i]);
+  }
+  // The reductions see the rounded values.
+  this->blob_->set_data_storage(FP16);
+  Dtype asum = 0;
+  for (int i = 0; i < this->blob_->count(); ++i) {
+    asum += std::fabs(this->blob_->cpu_data()[i]);
+  }
+  this->blob_->set_data_storage(FP16);
+  EXPECT_NEAR(asum, this->blob_->asum_data(), 1e-4);
+}
+
+TYPED_TEST(ReducedStorageBlobTest, TestToFromProto) {
+  typedef TypeParam Dtype;
+  BlobProto full;
+  this->blob_->ToProto(&full);
+  this->blob_->set_data_storage(BF16);
+  BlobProto reduced;
+  this->blob_->ToProto(&reduced);
+  EXPECT_EQ(BF16, reduced.storage());
+  EXPECT_EQ(0, reduced.data_size());
+  EXPECT_EQ(0, reduced.double_data_size());
+  EXPECT_EQ(2 * this->blob_->count(), reduced.reduced_data().size());
+  EXPECT_LT(reduced.SerializeAsString().size(),
+      full.SerializeAsString().size());
+  // Writing the proto left the blob at 16 bits.
+  EXPECT_EQ(SyncedMemory::HEAD_AT_REDUCED, this->blob_->data()->head());
+  Blob<Dtype> copy;
+  copy.FromProto(reduced);
+  EXPECT_TRUE(copy.shape() == this->blob_->shape());
+  EXPECT_EQ(BF16, copy.data_storage());
+  for (int i = 0; i < copy.count(); ++i) {
+    EXPECT_EQ(this->blob_->cpu_data()[i], copy.cpu_data()[i]);
+  }
+}
+
+}  // namespace caffe
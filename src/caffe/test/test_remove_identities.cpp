@@ -0,0 +1,88 @@
+#include <string>
+
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/remove_identities.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class RemoveIdentitiesTest : public ::testing::Test {
+ protected:
+  void RunRemovalTest(
+      const string& input_param_string, const string& output_param_string) {
+    // Test that RemoveIdentityLayers called on the proto specified by
+    // input_param_string results in the proto specified by
+    // output_param_string.
+    NetParameter input_param;
+    CHECK(google::protobuf::TextFormat::ParseFromString(
+        input_param_string, &input_param));
+    NetParameter expected_output_param;
+    CHECK(google::protobuf::TextFormat::ParseFromString(
+        output_param_string, &expected_output_param));
+    NetParameter actual_output_param;
+    RemoveIdentityLayers(input_param, &actual_output_param);
+    EXPECT_EQ(expected_output_param.DebugString(),
+        actual_output_param.DebugString());
+  }
+};
+
+TEST_F(RemoveIdentitiesTest, TestRemoved) {
+  // relu2 works in place on the top of drop2, which now takes ip2; split
+  // passes ip3 on to both its readers. data has a reader besides silence.
+  const string& input_proto =
+      "name: 'TestNetwork' "
+      "state { phase: TEST } "
+      "layer { name: 'data' type: 'Input' top: 'data' } "
+      "layer { name: 'ip1' type: 'InnerProduct' bottom: 'data' top: 'ip1' } "
+      "layer { name: 'drop1' type: 'Dropout' bottom: 'ip1' top: 'ip1' } "
+      "layer { name: 'ip2' type: 'InnerProduct' bottom: 'ip1' top: 'ip2' } "
+      "layer { name: 'drop2' type: 'Dropout' bottom: 'ip2' top: 'drop2' } "
+      "layer { name: 'relu2' type: 'ReLU' bottom: 'drop2' top: 'drop2' } "
+      "layer { name: 'ip3' type: 'InnerProduct' bottom: 'drop2' top: 'ip3' } "
+      "layer { name: 'split' type: 'Split' bottom: 'ip3' top: 'ip3_a' "
+      "  top: 'ip3_b' } "
+      "layer { name: 'sum' type: 'Eltwise' bottom: 'ip3_a' bottom: 'ip3_b' "
+      "  top: 'sum' } "
+      "layer { name: 'silence' type: 'Silence' bottom: 'data' } ";
+  const string& expected_output_proto =
+      "name: 'TestNetwork' "
+      "state { phase: TEST } "
+      "layer { name: 'data' type: 'Input' top: 'data' } "
+      "layer { name: 'ip1' type: 'InnerProduct' bottom: 'data' top: 'ip1' } "
+      "layer { name: 'ip2' type: 'InnerProduct' bottom: 'ip1' top: 'ip2' } "
+      "layer { name: 'relu2' type: 'ReLU' bottom: 'ip2' top: 'ip2' } "
+      "layer { name: 'ip3' type: 'InnerProduct' bottom: 'ip2' top: 'ip3' } "
+      "layer { name: 'sum' type: 'Eltwise' bottom: 'ip3' bottom: 'ip3' "
+      "  top: 'sum' } ";
+  this->RunRemovalTest(input_proto, expected_output_proto);
+}
+
+TEST_F(RemoveIdentitiesTest, TestKept) {
+  // ip1 is changed in place after drop1 copies it; relu2 on drop2 would
+  // change what ip3 reads of ip2; drop3 makes a net output; drop4 runs in
+  // the TRAIN phase, and silence is the only reader of drop2 as relu2
+  // leaves it.
+  const string& input_proto =
+      "name: 'TestNetwork' "
+      "state { phase: TEST } "
+      "layer { name: 'data' type: 'Input' top: 'data' } "
+      "layer { name: 'ip1' type: 'InnerProduct' bottom: 'data' top: 'ip1' } "
+      "layer { name: 'drop1' type: 'Dropout' bottom: 'ip1' top: 'drop1' } "
+      "layer { name: 'relu1' type: 'ReLU' bottom: 'ip1' top: 'ip1' } "
+      "layer { name: 'ip2' type: 'InnerProduct' bottom: 'drop1' top: 'ip2' } "
+      "layer { name: 'drop2' type: 'Dropout' bottom: 'ip2' top: 'drop2' } "
+      "layer { name: 'relu2' type: 'ReLU' bottom: 'drop2' top: 'drop2' } "
+      "layer { name: 'ip3' type: 'InnerProduct' bottom: 'ip2' top: 'ip3' } "
+      "layer { name: 'drop3' type: 'Dropout' bottom: 'ip3' top: 'drop3' } "
+      "layer { name: 'drop4' type: 'Dropout' bottom: 'ip1' top: 'ip1' "
+      "  phase: TRAIN } "
+      "layer { name: 'silence' type: 'Silence' bottom: 'drop2' } ";
+  this->RunRemovalTest(input_proto, input_proto);
+}
+
+}  // namespace caffe
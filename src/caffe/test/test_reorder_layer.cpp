@@ -0,0 +1,226 @@
+#include <string>
+#include <vector>
+
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/layers/reorder_layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/insert_reorders.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+#include "caffe/test/test_gradient_check_util.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+class ReorderLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  ReorderLayerTest()
+      : blob_bottom_(new Blob<Dtype>(2, 16, 3, 5)),
+        blob_top_(new Blob<Dtype>()) {}
+  virtual void SetUp() {
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> filler(filler_param);
+    filler.Fill(this->blob_bottom_);
+    blob_bottom_vec_.push_back(blob_bottom_);
+    blob_top_vec_.push_back(blob_top_);
+  }
+  virtual ~ReorderLayerTest() {
+    delete blob_bottom_;
+    delete blob_top_;
+  }
+  Blob<Dtype>* const blob_bottom_;
+  Blob<Dtype>* const blob_top_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+};
+
+TYPED_TEST_CASE(ReorderLayerTest, TestDtypes);
+
+TYPED_TEST(ReorderLayerTest, TestForward) {
+  typedef TypeParam Dtype;
+  LayerParameter layer_param;
+  layer_param.mutable_reorder_param()->set_channel_block(8);
+  ReorderLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_TRUE(this->blob_top_->shape() == this->blob_bottom_->shape());
+  EXPECT_EQ(8, this->blob_top_->channel_block());
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  const Dtype* top_data = this->blob_top_->cpu_data();
+  for (int n = 0; n < 2; ++n) {
+    for (int c = 0; c < 16; ++c) {
+      for (int i = 0; i < 15; ++i) {
+        EXPECT_EQ(this->blob_bottom_->cpu_data()[(n * 16 + c) * 15 + i],
+            top_data[((n * 2 + c / 8) * 15 + i) * 8 + c % 8]);
+      }
+    }
+  }
+  // Reordering into blocks of 4, and back to NCHW, restores the input.
+  Blob<Dtype> block4, plain;
+  vector<Blob<Dtype>*> block4_vec(1, &block4), plain_vec(1, &plain);
+  layer_param.mutable_reorder_param()->set_channel_block(4);
+  ReorderLayer<Dtype> layer4(layer_param);
+  layer4.SetUp(this->blob_top_vec_, block4_vec);
+  layer4.Forward(this->blob_top_vec_, block4_vec);
+  layer_param.mutable_reorder_param()->set_channel_block(0);
+  ReorderLayer<Dtype> layer0(layer_param);
+  layer0.SetUp(block4_vec, plain_vec);
+  layer0.Forward(block4_vec, plain_vec);
+  EXPECT_EQ(0, plain.channel_block());
+  for (int i = 0; i < plain.count(); ++i) {
+    EXPECT_EQ(this->blob_bottom_->cpu_data()[i], plain.cpu_data()[i]);
+  }
+}
+
+TYPED_TEST(ReorderLayerTest, TestGradient) {
+  typedef TypeParam Dtype;
+  this->blob_bottom_->Reshape(2, 8, 2, 3);
+  LayerParameter layer_param;
+  layer_param.mutable_reorder_param()->set_channel_block(4);
+  ReorderLayer<Dtype> layer(layer_param);
+  GradientChecker<Dtype> checker(1e-2, 1e-3);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_);
+}
+
+class ReorderLayerInsertionTest : public ::testing::Test {
+ protected:
+  void RunInsertionTest(
+      const string& input_param_string, const string& output_param_string) {
+    // Test that InsertReorders called on the proto specified by
+    // input_param_string results in the proto specified by
+    // output_param_string.
+    NetParameter input_param;
+    CHECK(google::protobuf::TextFormat::ParseFromString(
+        input_param_string, &input_param));
+    NetParameter expected_output_param;
+    CHECK(google::protobuf::TextFormat::ParseFromString(
+        output_param_string, &expected_output_param));
+    NetParameter actual_output_param;
+    InsertReorders(input_param, &actual_output_param);
+    EXPECT_EQ(expected_output_param.DebugString(),
+        actual_output_param.DebugString());
+  }
+};
+
+TEST_F(ReorderLayerInsertionTest, TestChain) {
+  // conv1, relu1 and pool1 form a chain. The InnerProduct layer reads pool1
+  // through a reorder; relu2 then runs on that NCHW copy, outside the chain.
+  const string& input_proto =
+      "name: 'TestNetwork' "
+      "channel_block: 8 "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape { dim: 1 dim: 3 dim: 8 dim: 8 } } } "
+      "layer { name: 'conv1' type: 'Convolution' bottom: 'data' "
+      "  top: 'conv1' convolution_param { num_output: 16 kernel_size: 3 } } "
+      "layer { name: 'relu1' type: 'ReLU' bottom: 'conv1' top: 'conv1' } "
+      "layer { name: 'pool1' type: 'Pooling' bottom: 'conv1' top: 'pool1' "
+      "  pooling_param { pool: MAX kernel_size: 2 stride: 2 } } "
+      "layer { name: 'ip' type: 'InnerProduct' bottom: 'pool1' top: 'ip' } "
+      "layer { name: 'relu2' type: 'ReLU' bottom: 'pool1' top: 'pool1' } ";
+  const string& expected_output_proto =
+      "name: 'TestNetwork' "
+      "channel_block: 8 "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape { dim: 1 dim: 3 dim: 8 dim: 8 } } } "
+      "layer { name: 'conv1' type: 'Convolution' bottom: 'data' "
+      "  top: 'conv1_blocked' convolution_param { num_output: 16 "
+      "  kernel_size: 3 channel_block: 8 } } "
+      "layer { name: 'relu1' type: 'ReLU' bottom: 'conv1_blocked' "
+      "  top: 'conv1_blocked' } "
+      "layer { name: 'pool1' type: 'Pooling' bottom: 'conv1_blocked' "
+      "  top: 'pool1_blocked' "
+      "  pooling_param { pool: MAX kernel_size: 2 stride: 2 } } "
+      "layer { name: 'pool1_to_nchw' type: 'Reorder' bottom: 'pool1_blocked' "
+      "  top: 'pool1' reorder_param { channel_block: 0 } } "
+      "layer { name: 'ip' type: 'InnerProduct' bottom: 'pool1' top: 'ip' } "
+      "layer { name: 'relu2' type: 'ReLU' bottom: 'pool1' top: 'pool1' } ";
+  this->RunInsertionTest(input_proto, expected_output_proto);
+}
+
+TEST_F(ReorderLayerInsertionTest, TestJoinAndOutput) {
+  // The eltwise layer joins the chain, so its NCHW input is reordered into
+  // blocks. conv3 has too few outputs for a block and reads sum in NCHW. The
+  // net output conv2 leaves the chain in NCHW at the end.
+  const string& input_proto =
+      "name: 'TestNetwork' "
+      "channel_block: 8 "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape { dim: 1 dim: 3 dim: 8 dim: 8 } } } "
+      "layer { name: 'conv1' type: 'Convolution' bottom: 'data' "
+      "  top: 'conv1' convolution_param { num_output: 8 kernel_size: 1 } } "
+      "layer { name: 'bn' type: 'BatchNorm' bottom: 'data' top: 'bn' } "
+      "layer { name: 'sum' type: 'Eltwise' bottom: 'conv1' bottom: 'bn' "
+      "  top: 'sum' } "
+      "layer { name: 'conv2' type: 'Convolution' bottom: 'sum' "
+      "  top: 'conv2' convolution_param { num_output: 16 kernel_size: 1 } } "
+      "layer { name: 'conv3' type: 'Convolution' bottom: 'sum' "
+      "  top: 'conv3' convolution_param { num_output: 4 kernel_size: 1 } } ";
+  const string& expected_output_proto =
+      "name: 'TestNetwork' "
+      "channel_block: 8 "
+      "layer { name: 'data' type: 'Input' top: 'data' "
+      "  input_param { shape { dim: 1 dim: 3 dim: 8 dim: 8 } } } "
+      "layer { name: 'conv1' type: 'Convolution' bottom: 'data' "
+      "  top: 'conv1_blocked' convolution_param { num_output: 8 "
+      "  kernel_size: 1 channel_block: 8 } } "
+      "layer { name: 'bn' type: 'BatchNorm' bottom: 'data' top: 'bn' } "
+      "layer { name: 'bn_to_blocked' type: 'Reorder' bottom: 'bn' "
+      "  top: 'bn_blocked' reorder_param { channel_block: 8 } } "
+      "layer { name: 'sum' type: 'Eltwise' bottom: 'conv1_blocked' "
+      "  bottom: 'bn_blocked' top: 'sum_blocked' } "
+      "layer { name: 'conv2' type: 'Convolution' bottom: 'sum_blocked' "
+      "  top: 'conv2_blocked' convolution_param { num_output: 16 "
+      "  kernel_size: 1 channel_block: 8 } } "
+      "layer { name: 'sum_to_nchw' type: 'Reorder' bottom: 'sum_blocked' "
+      "  top: 'sum' reorder_param { channel_block: 0 } } "
+      "layer { name: 'conv3' type: 'Convolution' bottom: 'sum' "
+      "  top: 'conv3' convolution_param { num_output: 4 kernel_size: 1 } } "
+      "layer { name: 'conv2_to_nchw' type: 'Reorder' bottom: 'conv2_blocked' "
+      "  top: 'conv2' reorder_param { channel_block: 0 } } ";
+  this->RunInsertionTest(input_proto, expected_output_proto);
+}
+
+TEST_F(ReorderLayerInsertionTest, TestSpatialAxes) {
+  // conv3d reads a 5-axis blob, so it is no 2D convolution; conv_hw is 2D
+  // by its kernel alone. conv1 reads a blob of unknown shape and might be
+  // N-D, so it stays NCHW.
+  const string& input_proto =
+      "name: 'TestNetwork' "
+      "channel_block: 8 "
+      "layer { name: 'data' type: 'Input' top: 'data' top: 'data3d' "
+      "  input_param { shape { dim: 1 dim: 3 dim: 8 dim: 8 } "
+      "  shape { dim: 1 dim: 3 dim: 4 dim: 8 dim: 8 } } } "
+      "layer { name: 'conv3d' type: 'Convolution' bottom: 'data3d' "
+      "  top: 'conv3d' convolution_param { num_output: 8 kernel_size: 3 } } "
+      "layer { name: 'source' type: 'Data' top: 'image' } "
+      "layer { name: 'conv_hw' type: 'Convolution' bottom: 'image' "
+      "  top: 'conv_hw' convolution_param { num_output: 8 kernel_h: 1 "
+      "  kernel_w: 1 } } "
+      "layer { name: 'conv1' type: 'Convolution' bottom: 'image' "
+      "  top: 'conv1' convolution_param { num_output: 8 kernel_size: 1 } } ";
+  const string& expected_output_proto =
+      "name: 'TestNetwork' "
+      "channel_block: 8 "
+      "layer { name: 'data' type: 'Input' top: 'data' top: 'data3d' "
+      "  input_param { shape { dim: 1 dim: 3 dim: 8 dim: 8 } "
+      "  shape { dim: 1 dim: 3 dim: 4 dim: 8 dim: 8 } } } "
+      "layer { name: 'conv3d' type: 'Convolution' bottom: 'data3d' "
+      "  top: 'conv3d' convolution_param { num_output: 8 kernel_size: 3 } } "
+      "layer { name: 'source' type: 'Data' top: 'image' } "
+      "layer { name: 'conv_hw' type: 'Convolution' bottom: 'image' "
+      "  top: 'conv_hw_blocked' convolution_param { num_output: 8 "
+      "  kernel_h: 1 kernel_w: 1 channel_block: 8 } } "
+      "layer { name: 'conv1' type: 'Convolution' bottom: 'image' "
+      "  top: 'conv1' convolution_param { num_output: 8 kernel_size: 1 } } "
+      "layer { name: 'conv_hw_to_nchw' type: 'Reorder' "
+      "  bottom: 'conv_hw_blocked' top: 'conv_hw' "
+      "  reorder_param { channel_block: 0 } } ";
+  this->RunInsertionTest(input_proto, expected_output_proto);
+}
+
+}  // namespace caffe
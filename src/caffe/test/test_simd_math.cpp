@@ -0,0 +1,264 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/benchmark.hpp"
+#include "caffe/util/math_functions.hpp"
+#include "caffe/util/simd_math.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+class SimdMathTest : public ::testing::Test {
+ protected:
+  SimdMathTest() : isa_(simd_isa()), a_(kCount), b_(kCount), y_(kCount) {}
+
+  virtual void SetUp() {
+    Caffe::set_random_seed(1701);
+    caffe_rng_uniform<Dtype>(kCount, -3, 3, a_.data());
+    caffe_rng_uniform<Dtype>(kCount, 0.5, 4, b_.data());
+  }
+  virtual void TearDown() {
+    set_simd_isa(isa_);
+  }
+
+  // Every instruction set this CPU can run, scalar first.
+  vector<SimdIsa> Isas() const {
+    vector<SimdIsa> isas;
+    for (int i = SIMD_SCALAR; i <= simd_best_isa(); ++i) {
+      isas.push_back(static_cast<SimdIsa>(i));
+    }
+    return isas;
+  }
+
+  // Checks y_[i] against a reference within a relative tolerance. NaN and
+  // infinite references must be matched exactly.
+  void ExpectNear(const int n, const double* reference, const double rel_tol,
+      const SimdIsa isa) {
+    for (int i = 0; i < n; ++i) {
+      const double expected = reference[i];
+      const double actual = y_[i];
+      if (std::isnan(expected)) {
+        EXPECT_TRUE(std::isnan(actual)) << "isa " << isa << " index " << i;
+      } else if (std::isinf(expected)) {
+        EXPECT_EQ(expected, actual) << "isa " << isa << " index " << i;
+      } else {
+        EXPECT_NEAR(expected, actual,
+            rel_tol * std::fabs(expected) + 1e-30)
+            << "isa " << isa << " index " << i << " input " << a_[i];
+      }
+    }
+  }
+
+  // Odd so that every vector width leaves a tail.
+  static const int kCount = 1003;
+  const SimdIsa isa_;
+  vector<Dtype> a_;
+  vector<Dtype> b_;
+  vector<Dtype> y_;
+};
+
+TYPED_TEST_CASE(SimdMathTest, TestDtypes);
+
+TYPED_TEST(SimdMathTest, TestSetIsa) {
+  EXPECT_LE(simd_isa(), simd_best_isa());
+  set_simd_isa(SIMD_SCALAR);
+  EXPECT_EQ(SIMD_SCALAR, simd_isa());
+}
+
+TYPED_TEST(SimdMathTest, TestBinary) {
+  const int n = this->kCount;
+  const TypeParam* a = this->a_.data();
+  const TypeParam* b = this->b_.data();
+  TypeParam* y = this->y_.data();
+  const vector<SimdIsa> isas = this->Isas();
+  for (int k = 0; k < isas.size(); ++k) {
+    set_simd_isa(isas[k]);
+    // Every length up to a few vectors, to cover all tail sizes.
+    for (int len = 1; len <= 40; ++len) {
+      caffe_set(n, TypeParam(0), y);
+      simd_vAdd(len, a, b, y);
+      for (int i = 0; i < len; ++i) {
+        EXPECT_EQ(a[i] + b[i], y[i]);
+      }
+      EXPECT_EQ(0, y[len]) << "wrote past the end, length " << len;
+    }
+    simd_vSub(n, a, b, y);
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(a[i] - b[i], y[i]);
+    }
+    simd_vMul(n, a, b, y);
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(a[i] * b[i], y[i]);
+    }
+    simd_vDiv(n, a, b, y);
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(a[i] / b[i], y[i]);
+    }
+  }
+}
+
+TYPED_TEST(SimdMathTest, TestSqrAbs) {
+  const int n = this->kCount;
+  const TypeParam* a = this->a_.data();
+  TypeParam* y = this->y_.data();
+  const vector<SimdIsa> isas = this->Isas();
+  for (int k = 0; k < isas.size(); ++k) {
+    set_simd_isa(isas[k]);
+    simd_vSqr(n, a, y);
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(a[i] * a[i], y[i]);
+    }
+    simd_vAbs(n, a, y);
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(std::fabs(a[i]), y[i]);
+    }
+  }
+}
+
+TYPED_TEST(SimdMathTest, TestExp) {
+  TypeParam* a = this->a_.data();
+  // Spread the inputs over the whole range and add the special cases.
+  caffe_rng_uniform<TypeParam>(this->kCount, -110, 90, a);
+  const TypeParam inf = std::numeric_limits<TypeParam>::infinity();
+  a[0] = 0;
+  a[1] = inf;
+  a[2] = -inf;
+  a[3] = std::numeric_limits<TypeParam>::quiet_NaN();
+  a[4] = 88.5;
+  a[5] = -87.5;
+  a[6] = -100;
+  a[7] = 1000;
+  a[8] = -1000;
+  vector<double> reference(this->kCount);
+  for (int i = 0; i < this->kCount; ++i) {
+    reference[i] = static_cast<TypeParam>(std::exp(static_cast<double>(a[i])));
+  }
+  const vector<SimdIsa> isas = this->Isas();
+  for (int k = 0; k < isas.size(); ++k) {
+    set_simd_isa(isas[k]);
+    simd_vExp(this->kCount, a, this->y_.data());
+    this->ExpectNear(this->kCount, reference.data(), 1e-6, isas[k]);
+  }
+}
+
+TYPED_TEST(SimdMathTest, TestLn) {
+  TypeParam* a = this->a_.data();
+  caffe_rng_uniform<TypeParam>(this->kCount, 0, 1000, a);
+  for (int i = 0; i < this->kCount; i += 3) {
+    a[i] = std::exp(a[i] / 10 - 50);
+  }
+  const TypeParam inf = std::numeric_limits<TypeParam>::infinity();
+  a[0] = 0;
+  a[1] = inf;
+  a[2] = -1;
+  a[3] = std::numeric_limits<TypeParam>::quiet_NaN();
+  a[4] = 1;
+  a[5] = std::numeric_limits<TypeParam>::denorm_min();
+  a[6] = std::numeric_limits<TypeParam>::min() / 3;
+  a[7] = std::numeric_limits<TypeParam>::max();
+  a[8] = 0.7071;
+  vector<double> reference(this->kCount);
+  for (int i = 0; i < this->kCount; ++i) {
+    reference[i] = static_cast<TypeParam>(std::log(static_cast<double>(a[i])));
+  }
+  const vector<SimdIsa> isas = this->Isas();
+  for (int k = 0; k < isas.size(); ++k) {
+    set_simd_isa(isas[k]);
+    simd_vLn(this->kCount, a, this->y_.data());
+    for (int i = 0; i < this->kCount; ++i) {
+      // Absolute tolerance for results close to log(1) = 0.
+      if (std::fabs(reference[i]) < 1e-3) {
+        EXPECT_NEAR(reference[i], this->y_[i], 1e-7);
+        this->y_[i] = reference[i];
+      }
+    }
+    this->ExpectNear(this->kCount, reference.data(), 1e-6, isas[k]);
+  }
+}
+
+TYPED_TEST(SimdMathTest, TestPowx) {
+  TypeParam* a = this->a_.data();
+  caffe_rng_uniform<TypeParam>(this->kCount, 0, 10, a);
+  // Blocks with zero and negative inputs take the pow() path.
+  a[0] = 0;
+  a[17] = -2;
+  a[40] = std::numeric_limits<TypeParam>::infinity();
+  const TypeParam exponents[] = {-2, -0.75, 0.5, 1, 2, 3, 0.75};
+  vector<double> reference(this->kCount);
+  const vector<SimdIsa> isas = this->Isas();
+  for (int e = 0; e < sizeof(exponents) / sizeof(exponents[0]); ++e) {
+    const TypeParam b = exponents[e];
+    for (int i = 0; i < this->kCount; ++i) {
+      reference[i] = static_cast<TypeParam>(
+          std::pow(static_cast<double>(a[i]), static_cast<double>(b)));
+    }
+    for (int k = 0; k < isas.size(); ++k) {
+      set_simd_isa(isas[k]);
+      simd_vPowx(this->kCount, a, b, this->y_.data());
+      this->ExpectNear(this->kCount, reference.data(), 2e-6, isas[k]);
+    }
+  }
+}
+
+TYPED_TEST(SimdMathTest, TestInPlace) {
+  const int n = this->kCount;
+  vector<TypeParam> expected(n);
+  for (int i = 0; i < n; ++i) {
+    expected[i] = this->a_[i] * this->a_[i];
+  }
+  simd_vMul(n, this->a_.data(), this->a_.data(), this->a_.data());
+  for (int i = 0; i < n; ++i) {
+    EXPECT_EQ(expected[i], this->a_[i]);
+  }
+}
+
+// Throughput of the kernels per instruction set, in elements per
+// microsecond. Run with --gtest_also_run_disabled_tests.
+TYPED_TEST(SimdMathTest, DISABLED_Benchmark) {
+  const int n = 1 << 20;
+  const int iterations = 20;
+  vector<TypeParam> a(n);
+  vector<TypeParam> b(n);
+  vector<TypeParam> y(n);
+  caffe_rng_uniform<TypeParam>(n, 0.1, 10, a.data());
+  caffe_rng_uniform<TypeParam>(n, 0.1, 10, b.data());
+  const vector<SimdIsa> isas = this->Isas();
+  for (int k = 0; k < isas.size(); ++k) {
+    set_simd_isa(isas[k]);
+    Timer timer;
+    timer.Start();
+    for (int i = 0; i < iterations; ++i) {
+      caffe_add(n, a.data(), b.data(), y.data());
+    }
+    const float add_ms = timer.MilliSeconds();
+    timer.Start();
+    for (int i = 0; i < iterations; ++i) {
+      caffe_exp(n, a.data(), y.data());
+    }
+    const float exp_ms = timer.MilliSeconds();
+    timer.Start();
+    for (int i = 0; i < iterations; ++i) {
+      caffe_log(n, a.data(), y.data());
+    }
+    const float log_ms = timer.MilliSeconds();
+    timer.Start();
+    for (int i = 0; i < iterations; ++i) {
+      caffe_powx(n, a.data(), TypeParam(0.75), y.data());
+    }
+    const float powx_ms = timer.MilliSeconds();
+    const float elements = static_cast<float>(n) * iterations / 1000;
+    LOG(INFO) << "isa " << isas[k]
+        << " add " << elements / add_ms
+        << " exp " << elements / exp_ms
+        << " log " << elements / log_ms
+        << " powx " << elements / powx_ms;
+  }
+}
+
+}  // namespace caffe
@@ -67,6 +67,29 @@ TEST_F(SyncedMemoryTest, TestCPUWrite) {
   }
 }
 
+TEST_F(SyncedMemoryTest, TestCPUWriteUninitialized) {
+  const bool poison = SyncedMemory::poison_uninitialized();
+  SyncedMemory::set_poison_uninitialized(true);
+  SyncedMemory mem(10);
+  void* cpu_data = mem.mutable_cpu_data_uninitialized();
+  EXPECT_EQ(mem.head(), SyncedMemory::HEAD_AT_CPU);
+  for (int i = 0; i < mem.size(); ++i) {
+    EXPECT_EQ((static_cast<unsigned char*>(cpu_data))[i], 0xFF);
+  }
+  // Once allocated, the memory is not filled again.
+  caffe_memset(mem.size(), 1, cpu_data);
+  EXPECT_EQ(cpu_data, mem.mutable_cpu_data());
+  EXPECT_EQ(cpu_data, mem.mutable_cpu_data_uninitialized());
+  for (int i = 0; i < mem.size(); ++i) {
+    EXPECT_EQ((static_cast<char*>(cpu_data))[i], 1);
+  }
+  // Poisoned floats read as NaN.
+  SyncedMemory float_mem(sizeof(float));
+  EXPECT_TRUE(isnan(*static_cast<float*>(
+      float_mem.mutable_cpu_data_uninitialized())));
+  SyncedMemory::set_poison_uninitialized(poison);
+}
+
 #ifndef CPU_ONLY  // GPU test
 
 TEST_F(SyncedMemoryTest, TestGPURead) {
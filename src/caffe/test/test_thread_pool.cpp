@@ -0,0 +1,173 @@
+#include <boost/thread.hpp>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class ThreadPoolTest : public ::testing::Test {
+ protected:
+  ThreadPoolTest() : num_threads_(Caffe::num_threads()) {}
+  virtual void TearDown() {
+    Caffe::set_num_threads(num_threads_);
+  }
+
+  const int num_threads_;
+};
+
+// Counts how often each task ran, optionally with uneven amounts of work.
+class CountTask {
+ public:
+  CountTask(vector<int>* counts, bool uneven)
+      : counts_(counts), uneven_(uneven) {}
+  void operator()(int i) const {
+    if (uneven_ && i % 7 == 0) {
+      boost::this_thread::sleep(boost::posix_time::milliseconds(2));
+    }
+    ++(*counts_)[i];
+  }
+
+ private:
+  vector<int>* counts_;
+  const bool uneven_;
+};
+
+TEST_F(ThreadPoolTest, TestRunsEveryTaskOnce) {
+  ThreadPool pool(4);
+  EXPECT_EQ(4, pool.num_threads());
+  for (int num_tasks = 1; num_tasks <= 67; num_tasks += 11) {
+    vector<int> counts(num_tasks, 0);
+    pool.Run(num_tasks, CountTask(&counts, false));
+    for (int i = 0; i < num_tasks; ++i) {
+      EXPECT_EQ(1, counts[i]) << "task " << i << " of " << num_tasks;
+    }
+  }
+}
+
+TEST_F(ThreadPoolTest, TestUnevenTasks) {
+  ThreadPool pool(3);
+  vector<int> counts(100, 0);
+  pool.Run(counts.size(), CountTask(&counts, true));
+  for (int i = 0; i < counts.size(); ++i) {
+    EXPECT_EQ(1, counts[i]) << "task " << i;
+  }
+}
+
+// Checks that nested loops run serially inside the task.
+class NestedTask {
+ public:
+  NestedTask(ThreadPool* pool, vector<int>* counts)
+      : pool_(pool), counts_(counts) {}
+  void operator()(int i) const {
+    EXPECT_TRUE(ThreadPool::in_parallel_region());
+    vector<int> inner(8, 0);
+    pool_->Run(inner.size(), CountTask(&inner, false));
+    for (int j = 0; j < inner.size(); ++j) {
+      EXPECT_EQ(1, inner[j]);
+    }
+    ++(*counts_)[i];
+  }
+
+ private:
+  ThreadPool* pool_;
+  vector<int>* counts_;
+};
+
+TEST_F(ThreadPoolTest, TestNestedRun) {
+  ThreadPool pool(4);
+  vector<int> counts(16, 0);
+  EXPECT_FALSE(ThreadPool::in_parallel_region());
+  pool.Run(counts.size(), NestedTask(&pool, &counts));
+  EXPECT_FALSE(ThreadPool::in_parallel_region());
+  for (int i = 0; i < counts.size(); ++i) {
+    EXPECT_EQ(1, counts[i]);
+  }
+}
+
+// Runs loops on a shared pool from several threads at once.
+void RunLoops(ThreadPool* pool, vector<int>* counts) {
+  for (int k = 0; k < 50; ++k) {
+    pool->Run(counts->size(), CountTask(counts, false));
+  }
+}
+
+TEST_F(ThreadPoolTest, TestConcurrentCallers) {
+  ThreadPool pool(4);
+  vector<vector<int> > counts(3, vector<int>(37, 0));
+  boost::thread_group threads;
+  for (int t = 0; t < counts.size(); ++t) {
+    threads.create_thread(boost::bind(&RunLoops, &pool, &counts[t]));
+  }
+  threads.join_all();
+  for (int t = 0; t < counts.size(); ++t) {
+    for (int i = 0; i < counts[t].size(); ++i) {
+      EXPECT_EQ(50, counts[t][i]);
+    }
+  }
+}
+
+// Marks the iterations of each subrange.
+class MarkRange {
+ public:
+  explicit MarkRange(vector<int>* marks) : marks_(marks) {}
+  void operator()(int begin, int end) const {
+    EXPECT_LT(begin, end);
+    for (int i = begin; i < end; ++i) {
+      ++(*marks_)[i];
+    }
+  }
+
+ private:
+  vector<int>* marks_;
+};
+
+TEST_F(ThreadPoolTest, TestParallelFor) {
+  Caffe::set_num_threads(4);
+  EXPECT_EQ(4, Caffe::num_threads());
+  EXPECT_EQ(4, Caffe::thread_pool()->num_threads());
+  const int begin = 13;
+  const int ends[] = {13, 14, 50, 1000, 100003};
+  for (int k = 0; k < sizeof(ends) / sizeof(ends[0]); ++k) {
+    vector<int> marks(ends[k], 0);
+    parallel_for(begin, ends[k], 10, MarkRange(&marks));
+    for (int i = 0; i < ends[k]; ++i) {
+      EXPECT_EQ(i < begin ? 0 : 1, marks[i]) << "index " << i;
+    }
+  }
+}
+
+TEST_F(ThreadPoolTest, TestSetNumThreads) {
+  Caffe::set_num_threads(1);
+  EXPECT_EQ(1, Caffe::num_threads());
+  vector<int> marks(1000, 0);
+  parallel_for(0, marks.size(), 1, MarkRange(&marks));
+  for (int i = 0; i < marks.size(); ++i) {
+    EXPECT_EQ(1, marks[i]);
+  }
+  Caffe::set_num_threads(3);
+  EXPECT_EQ(3, Caffe::num_threads());
+}
+
+static void ReadNumThreads(int* num_threads) {
+  *num_threads = Caffe::num_threads();
+}
+
+TEST_F(ThreadPoolTest, TestSetNumThreadsSeenByOtherThreads) {
+  Caffe::set_num_threads(2);
+  int seen = 0;
+  boost::thread(boost::bind(&ReadNumThreads, &seen)).join();
+  EXPECT_EQ(2, seen);
+  // A thread that already holds the pool picks up the new one.
+  Caffe::set_num_threads(3);
+  EXPECT_EQ(3, Caffe::num_threads());
+  Caffe::set_num_threads(2);
+  EXPECT_EQ(2, Caffe::num_threads());
+  EXPECT_EQ(2, Caffe::thread_pool()->num_threads());
+}
+
+}  // namespace caffe
@@ -0,0 +1,134 @@
+#include <algorithm>
+
+#include "caffe/common.hpp"
+#include "caffe/util/blocked_layout.hpp"
+
+namespace caffe {
+
+namespace {
+
+// Where channel c of an image starts in the layout of block, and how far
+// apart its pixels are.
+inline int ChannelStart(const int c, const int spatial_dim, const int block) {
+  return block ? (c / block) * spatial_dim * block + c % block :
+      c * spatial_dim;
+}
+
+inline int PixelStride(const int block) {
+  return block ? block : 1;
+}
+
+}  // namespace
+
+template <typename Dtype>
+void reorder_channels_cpu(const int num, const int channels,
+    const int spatial_dim, const int src_block, const int dst_block,
+    const Dtype* src, Dtype* dst) {
+  CHECK(!src_block || channels % src_block == 0);
+  CHECK(!dst_block || channels % dst_block == 0);
+  const int src_stride = PixelStride(src_block);
+  const int dst_stride = PixelStride(dst_block);
+  for (int n = 0; n < num; ++n) {
+    for (int c = 0; c < channels; ++c) {
+      const Dtype* in = src + ChannelStart(c, spatial_dim, src_block);
+      Dtype* out = dst + ChannelStart(c, spatial_dim, dst_block);
+      for (int i = 0; i < spatial_dim; ++i) {
+        out[i * dst_stride] = in[i * src_stride];
+      }
+    }
+    src += channels * spatial_dim;
+    dst += channels * spatial_dim;
+  }
+}
+
+template void reorder_channels_cpu<float>(const int num, const int channels,
+    const int spatial_dim, const int src_block, const int dst_block,
+    const float* src, float* dst);
+template void reorder_channels_cpu<double>(const int num, const int channels,
+    const int spatial_dim, const int src_block, const int dst_block,
+    const double* src, double* dst);
+
+template <typename Dtype>
+void blocked_conv_pack_weights_cpu(const Dtype* weights, const int num_output,
+    const int kernel_dim, const int block, Dtype* packed) {
+  CHECK_EQ(0, num_output % block);
+  for (int o = 0; o < num_output; ++o) {
+    Dtype* panel = packed + (o / block) * kernel_dim * block + o % block;
+    for (int k = 0; k < kernel_dim; ++k) {
+      panel[k * block] = weights[o * kernel_dim + k];
+    }
+  }
+}
+
+template void blocked_conv_pack_weights_cpu<float>(const float* weights,
+    const int num_output, const int kernel_dim, const int block,
+    float* packed);
+template void blocked_conv_pack_weights_cpu<double>(const double* weights,
+    const int num_output, const int kernel_dim, const int block,
+    double* packed);
+
+template <typename Dtype>
+void blocked_conv_cpu(const Dtype* data_im, const int channels,
+    const int in_block, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const Dtype* packed, const Dtype* bias,
+    const int block, Dtype* data_out) {
+  const int output_h = (height + 2 * pad_h -
+      (dilation_h * (kernel_h - 1) + 1)) / stride_h + 1;
+  const int output_w = (width + 2 * pad_w -
+      (dilation_w * (kernel_w - 1) + 1)) / stride_w + 1;
+  const int spatial_dim = height * width;
+  const int in_stride = PixelStride(in_block);
+  for (int oh = 0; oh < output_h; ++oh) {
+    Dtype* out_row = data_out + oh * output_w * block;
+    for (int ow = 0; ow < output_w; ++ow) {
+      for (int k = 0; k < block; ++k) {
+        out_row[ow * block + k] = bias ? bias[k] : Dtype(0);
+      }
+    }
+    const Dtype* w = packed;
+    for (int c = 0; c < channels; ++c) {
+      const Dtype* im = data_im + ChannelStart(c, spatial_dim, in_block);
+      for (int ki = 0; ki < kernel_h; ++ki) {
+        const int row = oh * stride_h - pad_h + ki * dilation_h;
+        if (row < 0 || row >= height) {
+          w += kernel_w * block;
+          continue;
+        }
+        const Dtype* im_row = im + row * width * in_stride;
+        for (int kj = 0; kj < kernel_w; ++kj, w += block) {
+          // The output columns whose input column lies inside the image.
+          const int offset = kj * dilation_w - pad_w;
+          const int end = offset >= width ? 0 :
+              std::min(output_w, (width - 1 - offset) / stride_w + 1);
+          const int begin = std::min(end, offset >= 0 ? 0 :
+              (-offset + stride_w - 1) / stride_w);
+          for (int ow = begin; ow < end; ++ow) {
+            const Dtype value =
+                im_row[(ow * stride_w + offset) * in_stride];
+            Dtype* out = out_row + ow * block;
+            for (int k = 0; k < block; ++k) {
+              out[k] += value * w[k];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template void blocked_conv_cpu<float>(const float* data_im,
+    const int channels, const int in_block, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const float* packed, const float* bias,
+    const int block, float* data_out);
+template void blocked_conv_cpu<double>(const double* data_im,
+    const int channels, const int in_block, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const double* packed, const double* bias,
+    const int block, double* data_out);
+
+}  // namespace caffe
@@ -0,0 +1,95 @@
+#include <boost/thread.hpp>
+#include <fstream>  // NOLINT(readability/streams)
+#include <map>
+#include <string>
+
+#include "caffe/util/conv_autotune.hpp"
+
+namespace caffe {
+
+namespace {
+
+boost::mutex& CacheMutex() {
+  static boost::mutex mutex;
+  return mutex;
+}
+
+string ReadCpuModelName() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      const size_t colon = line.find(':');
+      if (colon != string::npos) {
+        const size_t begin = line.find_first_not_of(" \t", colon + 1);
+        return begin == string::npos ? "unknown" : line.substr(begin);
+      }
+    }
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+string cpu_model_name() {
+  static const string name = ReadCpuModelName();
+  return name;
+}
+
+ConvAlgorithmCache& ConvAlgorithmCache::Get() {
+  static ConvAlgorithmCache cache;
+  return cache;
+}
+
+void ConvAlgorithmCache::Load(const string& file) {
+  if (choices_.count(file)) {
+    return;
+  }
+  std::map<string, string>& choices = choices_[file];
+  if (file.empty()) {
+    return;
+  }
+  std::ifstream in(file.c_str());
+  string line;
+  while (std::getline(in, line)) {
+    const size_t tab = line.rfind('\t');
+    if (tab != string::npos) {
+      choices[line.substr(0, tab)] = line.substr(tab + 1);
+    }
+  }
+}
+
+bool ConvAlgorithmCache::Lookup(const string& file, const string& key,
+    string* algorithm) {
+  boost::mutex::scoped_lock lock(CacheMutex());
+  Load(file);
+  const std::map<string, string>& choices = choices_[file];
+  std::map<string, string>::const_iterator it = choices.find(key);
+  if (it == choices.end()) {
+    return false;
+  }
+  *algorithm = it->second;
+  return true;
+}
+
+void ConvAlgorithmCache::Store(const string& file, const string& key,
+    const string& algorithm) {
+  boost::mutex::scoped_lock lock(CacheMutex());
+  Load(file);
+  choices_[file][key] = algorithm;
+  if (!file.empty()) {
+    std::ofstream out(file.c_str(), std::ios::app);
+    out << key << '\t' << algorithm << '\n';
+    if (!out) {
+      LOG(WARNING) << "Failed to save the convolution autotuning choice to "
+                   << file;
+    }
+  }
+}
+
+void ConvAlgorithmCache::Clear() {
+  boost::mutex::scoped_lock lock(CacheMutex());
+  choices_.clear();
+}
+
+}  // namespace caffe
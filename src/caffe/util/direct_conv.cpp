@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <vector>
+
+#include "caffe/common.hpp"
+#include "caffe/util/direct_conv.hpp"
+
+namespace caffe {
+
+namespace {
+
+// The shape of one 2D convolution, with the range [col_begin, col_end) of
+// output columns for which each kernel column reads inside the image.
+struct Geometry {
+  Geometry(const int channels, const int height, const int width,
+      const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+      const int stride_h, const int stride_w, const int dilation_h,
+      const int dilation_w)
+      : channels(channels), height(height), width(width),
+        kernel_h(kernel_h), kernel_w(kernel_w), pad_h(pad_h), pad_w(pad_w),
+        stride_h(stride_h), stride_w(stride_w), dilation_h(dilation_h),
+        dilation_w(dilation_w),
+        output_h((height + 2 * pad_h - (dilation_h * (kernel_h - 1) + 1)) /
+            stride_h + 1),
+        output_w((width + 2 * pad_w - (dilation_w * (kernel_w - 1) + 1)) /
+            stride_w + 1),
+        col_begin(kernel_w), col_end(kernel_w) {
+    for (int kj = 0; kj < kernel_w; ++kj) {
+      const int offset = col_offset(kj);
+      const int end = offset >= width ? 0 :
+          std::min(output_w, (width - 1 - offset) / stride_w + 1);
+      const int begin = offset >= 0 ? 0 :
+          (-offset + stride_w - 1) / stride_w;
+      col_begin[kj] = std::min(begin, end);
+      col_end[kj] = end;
+    }
+  }
+  // The image row of output row oh for kernel row ki, or -1 in the padding.
+  inline int input_row(const int oh, const int ki) const {
+    const int row = oh * stride_h - pad_h + ki * dilation_h;
+    return row >= 0 && row < height ? row : -1;
+  }
+  // The image column of output column 0 for kernel column kj.
+  inline int col_offset(const int kj) const {
+    return kj * dilation_w - pad_w;
+  }
+  const int channels, height, width;
+  const int kernel_h, kernel_w, pad_h, pad_w;
+  const int stride_h, stride_w, dilation_h, dilation_w;
+  const int output_h, output_w;
+  std::vector<int> col_begin, col_end;
+};
+
+// out[j] += alpha * in[j * stride] for j in [0, n).
+template <typename Dtype>
+inline void RowAxpy(const int n, const Dtype alpha, const Dtype* in,
+    const int stride, Dtype* out) {
+  if (stride == 1) {
+    for (int j = 0; j < n; ++j) {
+      out[j] += alpha * in[j];
+    }
+  } else {
+    for (int j = 0; j < n; ++j) {
+      out[j] += alpha * in[j * stride];
+    }
+  }
+}
+
+// in[j * stride] += alpha * out[j] for j in [0, n).
+template <typename Dtype>
+inline void RowAxpyStrided(const int n, const Dtype alpha, const Dtype* out,
+    const int stride, Dtype* in) {
+  if (stride == 1) {
+    for (int j = 0; j < n; ++j) {
+      in[j] += alpha * out[j];
+    }
+  } else {
+    for (int j = 0; j < n; ++j) {
+      in[j * stride] += alpha * out[j];
+    }
+  }
+}
+
+// The sum of out[j] * in[j * stride] for j in [0, n).
+template <typename Dtype>
+inline Dtype RowDot(const int n, const Dtype* out, const Dtype* in,
+    const int stride) {
+  Dtype sum = 0;
+  if (stride == 1) {
+    for (int j = 0; j < n; ++j) {
+      sum += out[j] * in[j];
+    }
+  } else {
+    for (int j = 0; j < n; ++j) {
+      sum += out[j] * in[j * stride];
+    }
+  }
+  return sum;
+}
+
+}  // namespace
+
+template <typename Dtype>
+void direct_conv_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* weights,
+    const int num_output, Dtype* data_out) {
+  const Geometry g(channels, height, width, kernel_h, kernel_w, pad_h, pad_w,
+      stride_h, stride_w, dilation_h, dilation_w);
+  const int kernel_size = kernel_h * kernel_w;
+  for (int o = 0; o < num_output; ++o) {
+    Dtype* out = data_out + o * g.output_h * g.output_w;
+    std::fill(out, out + g.output_h * g.output_w, Dtype(0));
+    for (int c = 0; c < channels; ++c) {
+      const Dtype* im = data_im + c * height * width;
+      const Dtype* w = weights + (o * channels + c) * kernel_size;
+      for (int oh = 0; oh < g.output_h; ++oh) {
+        Dtype* out_row = out + oh * g.output_w;
+        for (int ki = 0; ki < kernel_h; ++ki) {
+          const int row = g.input_row(oh, ki);
+          if (row < 0) {
+            continue;
+          }
+          const Dtype* im_row = im + row * width;
+          for (int kj = 0; kj < kernel_w; ++kj) {
+            const int begin = g.col_begin[kj];
+            RowAxpy(g.col_end[kj] - begin, w[ki * kernel_w + kj],
+                im_row + begin * stride_w + g.col_offset(kj), stride_w,
+                out_row + begin);
+          }
+        }
+      }
+    }
+  }
+}
+
+template void direct_conv_cpu<float>(const float* data_im,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const float* weights, const int num_output,
+    float* data_out);
+template void direct_conv_cpu<double>(const double* data_im,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const double* weights, const int num_output,
+    double* data_out);
+
+template <typename Dtype>
+void direct_conv_weight_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* top_diff,
+    const int num_output, Dtype* weight_diff) {
+  const Geometry g(channels, height, width, kernel_h, kernel_w, pad_h, pad_w,
+      stride_h, stride_w, dilation_h, dilation_w);
+  const int kernel_size = kernel_h * kernel_w;
+  for (int o = 0; o < num_output; ++o) {
+    const Dtype* out = top_diff + o * g.output_h * g.output_w;
+    for (int c = 0; c < channels; ++c) {
+      const Dtype* im = data_im + c * height * width;
+      Dtype* w_diff = weight_diff + (o * channels + c) * kernel_size;
+      for (int ki = 0; ki < kernel_h; ++ki) {
+        for (int kj = 0; kj < kernel_w; ++kj) {
+          const int begin = g.col_begin[kj];
+          Dtype sum = 0;
+          for (int oh = 0; oh < g.output_h; ++oh) {
+            const int row = g.input_row(oh, ki);
+            if (row < 0) {
+              continue;
+            }
+            sum += RowDot(g.col_end[kj] - begin,
+                out + oh * g.output_w + begin,
+                im + row * width + begin * stride_w + g.col_offset(kj),
+                stride_w);
+          }
+          w_diff[ki * kernel_w + kj] += sum;
+        }
+      }
+    }
+  }
+}
+
+template void direct_conv_weight_cpu<float>(const float* data_im,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const float* top_diff, const int num_output,
+    float* weight_diff);
+template void direct_conv_weight_cpu<double>(const double* data_im,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const double* top_diff, const int num_output,
+    double* weight_diff);
+
+template <typename Dtype>
+void direct_conv_data_cpu(const Dtype* top_diff, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* weights,
+    const int num_output, Dtype* bottom_diff) {
+  const Geometry g(channels, height, width, kernel_h, kernel_w, pad_h, pad_w,
+      stride_h, stride_w, dilation_h, dilation_w);
+  const int kernel_size = kernel_h * kernel_w;
+  std::fill(bottom_diff, bottom_diff + channels * height * width, Dtype(0));
+  for (int c = 0; c < channels; ++c) {
+    Dtype* im = bottom_diff + c * height * width;
+    for (int o = 0; o < num_output; ++o) {
+      const Dtype* out = top_diff + o * g.output_h * g.output_w;
+      const Dtype* w = weights + (o * channels + c) * kernel_size;
+      for (int oh = 0; oh < g.output_h; ++oh) {
+        const Dtype* out_row = out + oh * g.output_w;
+        for (int ki = 0; ki < kernel_h; ++ki) {
+          const int row = g.input_row(oh, ki);
+          if (row < 0) {
+            continue;
+          }
+          Dtype* im_row = im + row * width;
+          for (int kj = 0; kj < kernel_w; ++kj) {
+            const int begin = g.col_begin[kj];
+            RowAxpyStrided(g.col_end[kj] - begin, w[ki * kernel_w + kj],
+                out_row + begin, stride_w,
+                im_row + begin * stride_w + g.col_offset(kj));
+          }
+        }
+      }
+    }
+  }
+}
+
+template void direct_conv_data_cpu<float>(const float* top_diff,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const float* weights, const int num_output,
+    float* bottom_diff);
+template void direct_conv_data_cpu<double>(const double* top_diff,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const double* weights, const int num_output,
+    double* bottom_diff);
+
+}  // namespace caffe
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "caffe/common.hpp"
+#include "caffe/util/fft_conv.hpp"
+
+namespace caffe {
+
+namespace {
+
+// Fills the n / 2 twiddle factors exp(-2 pi i k / n) of an FFT of size n,
+// computed in double precision.
+template <typename Dtype>
+void Twiddles(const int n, Dtype* twiddles) {
+  for (int k = 0; k < n / 2; ++k) {
+    const double angle = -2. * M_PI * k / n;
+    twiddles[2 * k] = std::cos(angle);
+    twiddles[2 * k + 1] = std::sin(angle);
+  }
+}
+
+// In-place radix-2 FFT of n complex numbers spaced stride complex numbers
+// apart, unscaled. The inverse transform uses the conjugate twiddles.
+template <typename Dtype>
+void Fft(const int n, const Dtype* twiddles, const bool inverse,
+    const int stride, Dtype* data) {
+  // Bit-reversal permutation.
+  for (int i = 1, j = 0; i < n; ++i) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(data[2 * i * stride], data[2 * j * stride]);
+      std::swap(data[2 * i * stride + 1], data[2 * j * stride + 1]);
+    }
+  }
+  const Dtype sign = inverse ? -1 : 1;
+  for (int len = 2; len <= n; len <<= 1) {
+    const int half = len / 2;
+    const int step = n / len;
+    for (int i = 0; i < n; i += len) {
+      for (int k = 0; k < half; ++k) {
+        const Dtype wr = twiddles[2 * k * step];
+        const Dtype wi = sign * twiddles[2 * k * step + 1];
+        Dtype* u = data + 2 * (i + k) * stride;
+        Dtype* v = data + 2 * (i + k + half) * stride;
+        const Dtype vr = v[0] * wr - v[1] * wi;
+        const Dtype vi = v[0] * wi + v[1] * wr;
+        v[0] = u[0] - vr;
+        v[1] = u[1] - vi;
+        u[0] += vr;
+        u[1] += vi;
+      }
+    }
+  }
+}
+
+// In-place 2D FFT of a row-major fft_h x fft_w complex array.
+template <typename Dtype>
+void Fft2d(const int fft_h, const int fft_w, const Dtype* twiddles_h,
+    const Dtype* twiddles_w, const bool inverse, Dtype* data) {
+  if (fft_w > 1) {
+    for (int y = 0; y < fft_h; ++y) {
+      Fft(fft_w, twiddles_w, inverse, 1, data + 2 * y * fft_w);
+    }
+  }
+  if (fft_h > 1) {
+    for (int x = 0; x < fft_w; ++x) {
+      Fft(fft_h, twiddles_h, inverse, fft_w, data + 2 * x);
+    }
+  }
+}
+
+}  // namespace
+
+int fft_conv_size(const int output_size, const int kernel_extent) {
+  int size = 1;
+  while (size < kernel_extent) {
+    size <<= 1;
+  }
+  // Grow the tile while that cuts the transform size per useful output,
+  // up to four times the kernel, which bounds the size of the transformed
+  // filters.
+  const int max_size = 4 * size;
+  int best = size;
+  double best_ratio = static_cast<double>(size) /
+      std::min(size - kernel_extent + 1, output_size);
+  while (size - kernel_extent + 1 < output_size && size < max_size) {
+    size <<= 1;
+    const double ratio = static_cast<double>(size) /
+        std::min(size - kernel_extent + 1, output_size);
+    if (ratio < best_ratio) {
+      best = size;
+      best_ratio = ratio;
+    }
+  }
+  return best;
+}
+
+int fft_conv_transformed_size(const int num_output, const int channels,
+    const int fft_h, const int fft_w) {
+  return 2 * num_output * channels * fft_h * fft_w;
+}
+
+int fft_conv_workspace_size(const int channels, const int fft_h,
+    const int fft_w) {
+  // The spectra of the input tile channels, the output accumulator, and the
+  // twiddle factors.
+  return 2 * (channels + 1) * fft_h * fft_w + fft_h + fft_w;
+}
+
+template <typename Dtype>
+void fft_conv_transform_weights_cpu(const Dtype* weights,
+    const int num_output, const int channels, const int kernel_h,
+    const int kernel_w, const int dilation_h, const int dilation_w,
+    const int fft_h, const int fft_w, const bool flip, Dtype* transformed) {
+  const int fft_size = fft_h * fft_w;
+  const int extent_h = dilation_h * (kernel_h - 1) + 1;
+  const int extent_w = dilation_w * (kernel_w - 1) + 1;
+  CHECK_LE(extent_h, fft_h);
+  CHECK_LE(extent_w, fft_w);
+  std::vector<Dtype> twiddles_h(fft_h + 1), twiddles_w(fft_w + 1);
+  Twiddles(fft_h, &twiddles_h[0]);
+  Twiddles(fft_w, &twiddles_w[0]);
+  // The inverse transform is unscaled, so scale the filters instead.
+  const Dtype scale = Dtype(1) / fft_size;
+  for (int k = 0; k < num_output; ++k) {
+    for (int c = 0; c < channels; ++c) {
+      const Dtype* w = weights + (k * channels + c) * kernel_h * kernel_w;
+      Dtype* spectrum = transformed + 2 * fft_size *
+          (flip ? c * num_output + k : k * channels + c);
+      std::fill(spectrum, spectrum + 2 * fft_size, Dtype(0));
+      for (int i = 0; i < kernel_h; ++i) {
+        for (int j = 0; j < kernel_w; ++j) {
+          const int y = flip ? extent_h - 1 - i * dilation_h : i * dilation_h;
+          const int x = flip ? extent_w - 1 - j * dilation_w : j * dilation_w;
+          spectrum[2 * (y * fft_w + x)] = w[i * kernel_w + j] * scale;
+        }
+      }
+      Fft2d(fft_h, fft_w, &twiddles_h[0], &twiddles_w[0], false, spectrum);
+      // Correlation is convolution with the conjugate spectrum.
+      for (int f = 0; f < fft_size; ++f) {
+        spectrum[2 * f + 1] = -spectrum[2 * f + 1];
+      }
+    }
+  }
+}
+
+template void fft_conv_transform_weights_cpu<float>(const float* weights,
+    const int num_output, const int channels, const int kernel_h,
+    const int kernel_w, const int dilation_h, const int dilation_w,
+    const int fft_h, const int fft_w, const bool flip, float* transformed);
+template void fft_conv_transform_weights_cpu<double>(const double* weights,
+    const int num_output, const int channels, const int kernel_h,
+    const int kernel_w, const int dilation_h, const int dilation_w,
+    const int fft_h, const int fft_w, const bool flip, double* transformed);
+
+template <typename Dtype>
+void fft_conv_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int pad_h, const int pad_w,
+    const int kernel_extent_h, const int kernel_extent_w, const int fft_h,
+    const int fft_w, const Dtype* transformed, const int num_output,
+    Dtype* data_out, Dtype* workspace) {
+  const int fft_size = fft_h * fft_w;
+  const int output_h = height + 2 * pad_h - kernel_extent_h + 1;
+  const int output_w = width + 2 * pad_w - kernel_extent_w + 1;
+  // Each tile yields the outputs whose receptive field lies in it.
+  const int tile_h = fft_h - kernel_extent_h + 1;
+  const int tile_w = fft_w - kernel_extent_w + 1;
+  CHECK_GT(tile_h, 0);
+  CHECK_GT(tile_w, 0);
+  Dtype* input_spectra = workspace;
+  Dtype* output_spectrum = input_spectra + 2 * channels * fft_size;
+  Dtype* twiddles_h = output_spectrum + 2 * fft_size;
+  Dtype* twiddles_w = twiddles_h + fft_h;
+  Twiddles(fft_h, twiddles_h);
+  Twiddles(fft_w, twiddles_w);
+  for (int oy = 0; oy < output_h; oy += tile_h) {
+    for (int ox = 0; ox < output_w; ox += tile_w) {
+      // Transform the tile of every input channel, zero outside the image.
+      for (int c = 0; c < channels; ++c) {
+        const Dtype* im = data_im + c * height * width;
+        Dtype* spectrum = input_spectra + 2 * c * fft_size;
+        for (int y = 0; y < fft_h; ++y) {
+          const int row = oy - pad_h + y;
+          Dtype* line = spectrum + 2 * y * fft_w;
+          for (int x = 0; x < fft_w; ++x) {
+            const int col = ox - pad_w + x;
+            line[2 * x] = row >= 0 && row < height && col >= 0 &&
+                col < width ? im[row * width + col] : Dtype(0);
+            line[2 * x + 1] = 0;
+          }
+        }
+        Fft2d(fft_h, fft_w, twiddles_h, twiddles_w, false, spectrum);
+      }
+      const int rows = std::min(tile_h, output_h - oy);
+      const int cols = std::min(tile_w, output_w - ox);
+      for (int k = 0; k < num_output; ++k) {
+        // Multiply-accumulate the spectra over the input channels.
+        std::fill(output_spectrum, output_spectrum + 2 * fft_size, Dtype(0));
+        for (int c = 0; c < channels; ++c) {
+          const Dtype* a = input_spectra + 2 * c * fft_size;
+          const Dtype* b = transformed + 2 * (k * channels + c) * fft_size;
+          for (int f = 0; f < fft_size; ++f) {
+            output_spectrum[2 * f] += a[2 * f] * b[2 * f] -
+                a[2 * f + 1] * b[2 * f + 1];
+            output_spectrum[2 * f + 1] += a[2 * f] * b[2 * f + 1] +
+                a[2 * f + 1] * b[2 * f];
+          }
+        }
+        Fft2d(fft_h, fft_w, twiddles_h, twiddles_w, true, output_spectrum);
+        Dtype* out = data_out + (k * output_h + oy) * output_w + ox;
+        for (int y = 0; y < rows; ++y) {
+          for (int x = 0; x < cols; ++x) {
+            out[y * output_w + x] = output_spectrum[2 * (y * fft_w + x)];
+          }
+        }
+      }
+    }
+  }
+}
+
+template void fft_conv_cpu<float>(const float* data_im, const int channels,
+    const int height, const int width, const int pad_h, const int pad_w,
+    const int kernel_extent_h, const int kernel_extent_w, const int fft_h,
+    const int fft_w, const float* transformed, const int num_output,
+    float* data_out, float* workspace);
+template void fft_conv_cpu<double>(const double* data_im, const int channels,
+    const int height, const int width, const int pad_h, const int pad_w,
+    const int kernel_extent_h, const int kernel_extent_w, const int fft_h,
+    const int fft_w, const double* transformed, const int num_output,
+    double* data_out, double* workspace);
+
+}  // namespace caffe
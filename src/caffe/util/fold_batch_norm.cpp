@@ -0,0 +1,192 @@
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/util/fold_batch_norm.hpp"
+
+namespace caffe {
+
+namespace {
+
+// Whether the layer maps each channel of its one bottom by y = a * x + b
+// with parameters of its own, so that it can be folded.
+bool IsFoldableAffine(const LayerParameter& layer_param, const Phase phase) {
+  if (layer_param.bottom_size() != 1 || layer_param.top_size() != 1) {
+    return false;
+  }
+  if (layer_param.type() == "BatchNorm") {
+    const BatchNormParameter& batch_norm_param =
+        layer_param.batch_norm_param();
+    const bool use_global_stats = batch_norm_param.has_use_global_stats() ?
+        batch_norm_param.use_global_stats() : phase == TEST;
+    return use_global_stats && layer_param.blobs_size() == 3;
+  }
+  if (layer_param.type() == "Scale") {
+    const ScaleParameter& scale_param = layer_param.scale_param();
+    return scale_param.axis() == 1 && scale_param.num_axes() == 1 &&
+        layer_param.blobs_size() == (scale_param.bias_term() ? 2 : 1);
+  }
+  if (layer_param.type() == "Bias") {
+    const BiasParameter& bias_param = layer_param.bias_param();
+    return bias_param.axis() == 1 && bias_param.num_axes() == 1 &&
+        layer_param.blobs_size() == 1;
+  }
+  return false;
+}
+
+// The a and b of each channel of a foldable layer.
+void GetAffine(const LayerParameter& layer_param, const int channels,
+    vector<double>* a, vector<double>* b) {
+  a->assign(channels, 1);
+  b->assign(channels, 0);
+  vector<shared_ptr<Blob<double> > > blobs(layer_param.blobs_size());
+  for (int i = 0; i < blobs.size(); ++i) {
+    blobs[i].reset(new Blob<double>());
+    blobs[i]->FromProto(layer_param.blobs(i));
+  }
+  if (layer_param.type() == "BatchNorm") {
+    // The stored mean and variance are sums scaled by blobs[2], as in
+    // BatchNormLayer::Forward_cpu.
+    CHECK_EQ(channels, blobs[0]->count());
+    CHECK_EQ(channels, blobs[1]->count());
+    const double scale_factor = blobs[2]->cpu_data()[0] == 0 ?
+        0 : 1 / blobs[2]->cpu_data()[0];
+    const double eps = layer_param.batch_norm_param().eps();
+    for (int c = 0; c < channels; ++c) {
+      const double mean = blobs[0]->cpu_data()[c] * scale_factor;
+      const double variance = blobs[1]->cpu_data()[c] * scale_factor;
+      (*a)[c] = 1 / std::sqrt(variance + eps);
+      (*b)[c] = -mean * (*a)[c];
+    }
+  } else if (layer_param.type() == "Scale") {
+    CHECK_EQ(channels, blobs[0]->count());
+    for (int c = 0; c < channels; ++c) {
+      (*a)[c] = blobs[0]->cpu_data()[c];
+      (*b)[c] = blobs.size() > 1 ? blobs[1]->cpu_data()[c] : 0;
+    }
+  } else {
+    CHECK_EQ(channels, blobs[0]->count());
+    for (int c = 0; c < channels; ++c) {
+      (*b)[c] = blobs[0]->cpu_data()[c];
+    }
+  }
+}
+
+// Whether any layer but the one at skip reads the blob.
+bool ReadByOthers(const NetParameter& param, const string& blob_name,
+    const int skip) {
+  for (int i = 0; i < param.layer_size(); ++i) {
+    if (i == skip) {
+      continue;
+    }
+    for (int j = 0; j < param.layer(i).bottom_size(); ++j) {
+      if (param.layer(i).bottom(j) == blob_name) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Writes blob as double_data or as float data.
+void WriteBlob(const Blob<double>& blob, const bool double_data,
+    BlobProto* proto) {
+  proto->Clear();
+  if (double_data) {
+    blob.ToProto(proto);
+    return;
+  }
+  Blob<float> float_blob(blob.shape());
+  float* data = float_blob.mutable_cpu_data();
+  for (int i = 0; i < blob.count(); ++i) {
+    data[i] = blob.cpu_data()[i];
+  }
+  float_blob.ToProto(proto);
+}
+
+}  // namespace
+
+void FoldBatchNorm(const NetParameter& param, NetParameter* param_folded) {
+  param_folded->CopyFrom(param);
+  param_folded->clear_layer();
+  vector<bool> folded(param.layer_size(), false);
+  for (int i = 0; i < param.layer_size(); ++i) {
+    if (folded[i]) {
+      continue;
+    }
+    const LayerParameter& layer_param = param.layer(i);
+    LayerParameter* conv_param = param_folded->add_layer();
+    conv_param->CopyFrom(layer_param);
+    if (layer_param.type() != "Convolution" || layer_param.top_size() != 1 ||
+        layer_param.blobs_size() == 0) {
+      continue;
+    }
+    const int channels = layer_param.convolution_param().num_output();
+    string top = layer_param.top(0);
+    // Every folded layer applies y = a * x + b on top of the ones before.
+    vector<double> scale(channels, 1), shift(channels, 0);
+    int num_folded = 0;
+    for (int j = i + 1; j < param.layer_size(); ++j) {
+      const LayerParameter& next = param.layer(j);
+      bool reads_top = false;
+      for (int k = 0; k < next.bottom_size(); ++k) {
+        reads_top |= next.bottom(k) == top;
+      }
+      if (!reads_top) {
+        continue;
+      }
+      const Phase phase = next.has_phase() ? next.phase() :
+          param.state().phase();
+      if (!IsFoldableAffine(next, phase) ||
+          (next.top(0) != top && ReadByOthers(param, top, j))) {
+        break;
+      }
+      vector<double> a, b;
+      GetAffine(next, channels, &a, &b);
+      for (int c = 0; c < channels; ++c) {
+        scale[c] *= a[c];
+        shift[c] = shift[c] * a[c] + b[c];
+      }
+      LOG(INFO) << "Folding " << next.type() << " layer " << next.name()
+          << " into " << layer_param.name();
+      folded[j] = true;
+      ++num_folded;
+      top = next.top(0);
+    }
+    if (num_folded == 0) {
+      continue;
+    }
+    conv_param->set_top(0, top);
+    const bool double_data = conv_param->blobs(0).double_data_size() > 0;
+    Blob<double> weights;
+    weights.FromProto(conv_param->blobs(0));
+    CHECK_EQ(0, weights.count() % channels);
+    const int channel_dim = weights.count() / channels;
+    double* weight_data = weights.mutable_cpu_data();
+    for (int c = 0; c < channels; ++c) {
+      for (int k = 0; k < channel_dim; ++k) {
+        weight_data[c * channel_dim + k] *= scale[c];
+      }
+    }
+    WriteBlob(weights, double_data, conv_param->mutable_blobs(0));
+    Blob<double> bias(vector<int>(1, channels));
+    const bool had_bias = conv_param->convolution_param().bias_term() &&
+        conv_param->blobs_size() > 1;
+    if (had_bias) {
+      bias.FromProto(conv_param->blobs(1));
+      CHECK_EQ(channels, bias.count());
+    } else {
+      conv_param->mutable_convolution_param()->set_bias_term(true);
+      conv_param->add_blobs();
+    }
+    double* bias_data = bias.mutable_cpu_data();
+    for (int c = 0; c < channels; ++c) {
+      bias_data[c] = bias_data[c] * scale[c] + shift[c];
+    }
+    WriteBlob(bias, double_data, conv_param->mutable_blobs(1));
+  }
+}
+
+}  // namespace caffe
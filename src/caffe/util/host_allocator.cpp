@@ -0,0 +1,513 @@
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "caffe/util/host_allocator.hpp"
+
+namespace caffe {
+
+namespace {
+
+const size_t kMinBlockBytes = 64;
+// Only blocks up to this size go through the per-thread caches, and each
+// thread caches at most kThreadCacheMaxBytes of them.
+const size_t kThreadCacheMaxBlockBytes = 1 << 20;
+const size_t kThreadCacheMaxBytes = 16 << 20;
+const size_t kDefaultMaxHeldBytes = static_cast<size_t>(1) << 30;
+const size_t kHugePageBytes = 2 << 20;
+
+// Free blocks keyed by their size class.
+typedef map<size_t, vector<void*> > FreeLists;
+
+void* PopBlock(FreeLists* lists, const size_t block_size) {
+  FreeLists::iterator it = lists->find(block_size);
+  if (it == lists->end() || it->second.empty()) {
+    return NULL;
+  }
+  void* ptr = it->second.back();
+  it->second.pop_back();
+  return ptr;
+}
+
+void ReleaseAll(FreeLists* lists) {
+  for (FreeLists::iterator it = lists->begin(); it != lists->end(); ++it) {
+    for (int i = 0; i < it->second.size(); ++i) {
+      free(it->second[i]);
+    }
+  }
+  lists->clear();
+}
+
+struct ThreadCache;
+
+// The shared cache. Its mutex also guards the set of live thread caches, and
+// must be taken before any thread cache mutex.
+struct Pool {
+  Pool()
+      : max_held_bytes(kDefaultMaxHeldBytes), bytes_held(0), bytes_in_use(0),
+        hits(0), misses(0) {}
+  boost::mutex mutex;
+  FreeLists free_lists;
+  set<ThreadCache*> thread_caches;
+  // Atomic: Allocate() and Free() read it without the mutex to decide
+  // whether to go through the thread cache.
+  boost::atomic<size_t> max_held_bytes;
+  size_t bytes_held;
+  // Signed: blocks may be freed by a different thread than allocated them.
+  ptrdiff_t bytes_in_use;
+  size_t hits;
+  size_t misses;
+};
+
+// Deliberately never destroyed, since threads may still flush their caches
+// into it while static objects are being torn down.
+Pool& GetPool() {
+  static Pool* pool = new Pool();
+  return *pool;
+}
+
+struct ThreadCache {
+  ThreadCache() : bytes_held(0), bytes_in_use(0), hits(0) {
+    Pool& pool = GetPool();
+    boost::mutex::scoped_lock pool_lock(pool.mutex);
+    pool.thread_caches.insert(this);
+  }
+  // Hands the cached blocks and the counters over to the shared cache.
+  ~ThreadCache() {
+    Pool& pool = GetPool();
+    boost::mutex::scoped_lock pool_lock(pool.mutex);
+    boost::mutex::scoped_lock lock(mutex);
+    for (FreeLists::iterator it = free_lists.begin();
+         it != free_lists.end(); ++it) {
+      for (int i = 0; i < it->second.size(); ++i) {
+        if (pool.bytes_held + it->first <= pool.max_held_bytes) {
+          pool.free_lists[it->first].push_back(it->second[i]);
+          pool.bytes_held += it->first;
+        } else {
+          free(it->second[i]);
+        }
+      }
+    }
+    free_lists.clear();
+    pool.bytes_in_use += bytes_in_use;
+    pool.hits += hits;
+    pool.thread_caches.erase(this);
+  }
+  boost::mutex mutex;
+  FreeLists free_lists;
+  size_t bytes_held;
+  ptrdiff_t bytes_in_use;
+  // Only hits are counted per thread; misses always reach the shared cache.
+  size_t hits;
+};
+
+static boost::thread_specific_ptr<ThreadCache> thread_cache_;
+
+ThreadCache* GetThreadCache() {
+  if (!thread_cache_.get()) {
+    thread_cache_.reset(new ThreadCache());
+  }
+  return thread_cache_.get();
+}
+
+void* SystemAllocate(const size_t block_size) {
+  void* ptr = malloc(block_size);
+  if (!ptr) {
+    // Give the cached blocks back and try once more before failing.
+    HostAllocator::Trim();
+    ptr = malloc(block_size);
+  }
+  return ptr;
+}
+
+// Parses a node list such as "0-1,4" from sysfs into node ids.
+vector<int> ReadOnlineNumaNodes() {
+  vector<int> nodes;
+  FILE* f = fopen("/sys/devices/system/node/online", "r");
+  if (f) {
+    int first, last;
+    while (fscanf(f, "%d", &first) == 1) {
+      last = first;
+      int c = fgetc(f);
+      if (c == '-') {
+        if (fscanf(f, "%d", &last) != 1) { break; }
+        c = fgetc(f);
+      }
+      for (int node = first; node <= last; ++node) {
+        nodes.push_back(node);
+      }
+      if (c != ',') { break; }
+    }
+    fclose(f);
+  }
+  if (nodes.empty()) {
+    nodes.push_back(0);
+  }
+  return nodes;
+}
+
+// The online nodes, read once: node hotplug is not followed.
+const vector<int>& OnlineNumaNodes() {
+  static const vector<int>* nodes = new vector<int>(ReadOnlineNumaNodes());
+  return *nodes;
+}
+
+// Small placed blocks are carved out of placed chunks of this size instead of
+// being mapped one by one, which would cost a page (2MB with huge pages) and
+// a system call each.
+const size_t kPlacedMaxPooledBytes = 256 << 10;
+const size_t kPlacedChunkBytes = kHugePageBytes;
+
+// The free small blocks of one policy, and the chunk they are carved from.
+struct PlacedPool {
+  PlacedPool() : chunk(NULL), chunk_left(0) {}
+  FreeLists free_lists;
+  char* chunk;
+  size_t chunk_left;
+};
+
+// The bytes placed on each node by policy allocations, and the pools of small
+// placed blocks keyed by PolicyKey().
+struct NumaState {
+  NumaState() : node_bytes(HostAllocator::num_numa_nodes(), 0) {}
+  boost::mutex mutex;
+  vector<size_t> node_bytes;
+  map<int, PlacedPool> pools;
+};
+
+NumaState& GetNumaState() {
+  static NumaState* state = new NumaState();
+  return *state;
+}
+
+int PolicyKey(const HostMemoryPolicy& policy) {
+  const int node = policy.interleave ? -1 : policy.numa_node;
+  return (node + 1) * 4 + (policy.huge_pages ? 2 : 0) +
+      (policy.interleave ? 1 : 0);
+}
+
+// Adds (or removes, if sign < 0) a placed buffer to the per-node counters.
+// The caller holds the NumaState mutex.
+void CountPlacedBytes(NumaState* state, const size_t bytes,
+    const HostMemoryPolicy& policy, const int sign) {
+  if (!policy.interleave && policy.numa_node < 0) {
+    return;
+  }
+  vector<int> single_node;
+  if (!policy.interleave) {
+    single_node.push_back(policy.numa_node);
+  }
+  const vector<int>& nodes = policy.interleave ? OnlineNumaNodes() :
+      single_node;
+  const size_t share = bytes / nodes.size();
+  for (int i = 0; i < nodes.size(); ++i) {
+    if (sign > 0) {
+      state->node_bytes[nodes[i]] += share;
+    } else {
+      state->node_bytes[nodes[i]] -= share;
+    }
+  }
+}
+
+#ifdef __linux__
+size_t PlacedLength(const size_t size, const HostMemoryPolicy& policy) {
+  const size_t alignment = policy.huge_pages ? kHugePageBytes :
+      static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+void BindPlacedMemory(void* ptr, const size_t length,
+    const HostMemoryPolicy& policy) {
+  typedef unsigned long MaskWord;  // NOLINT(runtime/int)
+  const int bits = 8 * sizeof(MaskWord);
+  vector<MaskWord> mask(HostAllocator::num_numa_nodes() / bits + 1, 0);
+  int mode;
+  if (policy.interleave) {
+    const vector<int>& nodes = OnlineNumaNodes();
+    for (int i = 0; i < nodes.size(); ++i) {
+      mask[nodes[i] / bits] |= MaskWord(1) << (nodes[i] % bits);
+    }
+    mode = MPOL_INTERLEAVE;
+  } else if (policy.numa_node >= 0) {
+    mask[policy.numa_node / bits] |=
+        MaskWord(1) << (policy.numa_node % bits);
+    // Preferred rather than bound, so that a full node falls back gracefully.
+    mode = MPOL_PREFERRED;
+  } else {
+    return;
+  }
+  if (syscall(SYS_mbind, ptr, length, mode, &mask[0], mask.size() * bits + 1,
+      0) != 0) {
+    LOG_EVERY_N(WARNING, 1000) << "mbind failed; NUMA placement of host "
+        << "memory is not applied.";
+  }
+}
+
+void* MapPlaced(const size_t size, const HostMemoryPolicy& policy) {
+  const size_t length = PlacedLength(size, policy);
+  // Map the alignment in excess, then unmap the slack around the aligned
+  // range. mmap already aligns to the base page size.
+  const size_t slack = policy.huge_pages ? kHugePageBytes : 0;
+  void* mapped = mmap(NULL, length + slack, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapped == MAP_FAILED) {
+    return NULL;
+  }
+  char* base = static_cast<char*>(mapped);
+  char* ptr = base;
+  if (slack > 0) {
+    const size_t misalignment = reinterpret_cast<size_t>(base) % slack;
+    ptr = base + (misalignment ? slack - misalignment : 0);
+    if (ptr > base) {
+      munmap(base, ptr - base);
+    }
+    const size_t tail = (base + length + slack) - (ptr + length);
+    if (tail > 0) {
+      munmap(ptr + length, tail);
+    }
+  }
+#ifdef MADV_HUGEPAGE
+  if (policy.huge_pages) {
+    madvise(ptr, length, MADV_HUGEPAGE);
+  }
+#endif
+  // The pages are not touched yet, so the policy decides where they land.
+  BindPlacedMemory(ptr, length, policy);
+  return ptr;
+}
+
+void UnmapPlaced(void* ptr, const size_t size, const HostMemoryPolicy& policy) {
+  munmap(ptr, PlacedLength(size, policy));
+}
+#else
+void* MapPlaced(const size_t size, const HostMemoryPolicy& policy) {
+  LOG_EVERY_N(WARNING, 1000) << "Host memory policies are only supported on "
+      << "Linux; falling back to malloc.";
+  return malloc(size);
+}
+
+void UnmapPlaced(void* ptr, const size_t size, const HostMemoryPolicy& policy) {
+  free(ptr);
+}
+#endif  // __linux__
+
+// Serves a small placed block from the pool of its policy, carving a new
+// chunk when the pool has no free block of its class.
+void* AllocatePooled(NumaState* state, const size_t block_size,
+    const HostMemoryPolicy& policy) {
+  PlacedPool& pool = state->pools[PolicyKey(policy)];
+  void* ptr = PopBlock(&pool.free_lists, block_size);
+  if (ptr) {
+    return ptr;
+  }
+  if (pool.chunk_left < block_size) {
+    // The tail of the old chunk, less than one block, is left unused.
+    pool.chunk = static_cast<char*>(MapPlaced(kPlacedChunkBytes, policy));
+    if (!pool.chunk) {
+      pool.chunk_left = 0;
+      return NULL;
+    }
+    pool.chunk_left = kPlacedChunkBytes;
+  }
+  ptr = pool.chunk;
+  pool.chunk += block_size;
+  pool.chunk_left -= block_size;
+  return ptr;
+}
+
+}  // namespace
+
+int HostAllocator::num_numa_nodes() {
+  return OnlineNumaNodes().back() + 1;
+}
+
+vector<size_t> HostAllocator::NodeBytes() {
+  NumaState& state = GetNumaState();
+  boost::mutex::scoped_lock lock(state.mutex);
+  return state.node_bytes;
+}
+
+size_t HostAllocator::SizeClass(size_t size) {
+  if (size <= kMinBlockBytes) {
+    return kMinBlockBytes;
+  }
+  // Find base such that base < size <= 2 * base, then round up to a quarter
+  // of base, which bounds the wasted space to 25%.
+  size_t base = kMinBlockBytes;
+  while (size - base > base) {
+    base *= 2;
+  }
+  const size_t step = base / 4;
+  return (size + step - 1) / step * step;
+}
+
+void* HostAllocator::Allocate(size_t size, const HostMemoryPolicy& policy) {
+  if (!policy.is_default()) {
+    if (policy.numa_node >= 0) {
+      CHECK_LT(policy.numa_node, num_numa_nodes()) << "No such NUMA node.";
+    }
+    NumaState& state = GetNumaState();
+    boost::mutex::scoped_lock lock(state.mutex);
+    const size_t block_size = SizeClass(size);
+    void* ptr = block_size <= kPlacedMaxPooledBytes ?
+        AllocatePooled(&state, block_size, policy) : MapPlaced(size, policy);
+    CHECK(ptr) << "host allocation of size " << size << " failed";
+    CountPlacedBytes(&state, block_size <= kPlacedMaxPooledBytes ?
+        block_size : size, policy, 1);
+    return ptr;
+  }
+  const size_t block_size = SizeClass(size);
+  Pool& pool = GetPool();
+  if (pool.max_held_bytes.load(boost::memory_order_relaxed) > 0 &&
+      block_size <= kThreadCacheMaxBlockBytes) {
+    ThreadCache* cache = GetThreadCache();
+    boost::mutex::scoped_lock lock(cache->mutex);
+    cache->bytes_in_use += block_size;
+    void* ptr = PopBlock(&cache->free_lists, block_size);
+    if (ptr) {
+      cache->bytes_held -= block_size;
+      ++cache->hits;
+      return ptr;
+    }
+  } else {
+    boost::mutex::scoped_lock pool_lock(pool.mutex);
+    pool.bytes_in_use += block_size;
+  }
+  {
+    boost::mutex::scoped_lock pool_lock(pool.mutex);
+    void* ptr = PopBlock(&pool.free_lists, block_size);
+    if (ptr) {
+      pool.bytes_held -= block_size;
+      ++pool.hits;
+      return ptr;
+    }
+    ++pool.misses;
+  }
+  // Always reserve the whole class, so that the block can be cached on free
+  // even if caching was off when it was allocated.
+  void* ptr = SystemAllocate(block_size);
+  CHECK(ptr) << "host allocation of size " << size << " failed";
+  return ptr;
+}
+
+void HostAllocator::Free(void* ptr, size_t size,
+    const HostMemoryPolicy& policy) {
+  if (!ptr) {
+    return;
+  }
+  if (!policy.is_default()) {
+    NumaState& state = GetNumaState();
+    boost::mutex::scoped_lock lock(state.mutex);
+    const size_t block_size = SizeClass(size);
+    if (block_size <= kPlacedMaxPooledBytes) {
+      // Pooled blocks stay mapped for reuse by the same policy.
+      state.pools[PolicyKey(policy)].free_lists[block_size].push_back(ptr);
+      CountPlacedBytes(&state, block_size, policy, -1);
+    } else {
+      UnmapPlaced(ptr, size, policy);
+      CountPlacedBytes(&state, size, policy, -1);
+    }
+    return;
+  }
+  const size_t block_size = SizeClass(size);
+  Pool& pool = GetPool();
+  if (pool.max_held_bytes.load(boost::memory_order_relaxed) > 0 &&
+      block_size <= kThreadCacheMaxBlockBytes) {
+    ThreadCache* cache = GetThreadCache();
+    boost::mutex::scoped_lock lock(cache->mutex);
+    cache->bytes_in_use -= block_size;
+    if (cache->bytes_held + block_size <= kThreadCacheMaxBytes) {
+      cache->free_lists[block_size].push_back(ptr);
+      cache->bytes_held += block_size;
+      return;
+    }
+  } else {
+    boost::mutex::scoped_lock pool_lock(pool.mutex);
+    pool.bytes_in_use -= block_size;
+  }
+  {
+    boost::mutex::scoped_lock pool_lock(pool.mutex);
+    if (pool.bytes_held + block_size <= pool.max_held_bytes) {
+      pool.free_lists[block_size].push_back(ptr);
+      pool.bytes_held += block_size;
+      return;
+    }
+  }
+  free(ptr);
+}
+
+void HostAllocator::Trim() {
+  Pool& pool = GetPool();
+  boost::mutex::scoped_lock pool_lock(pool.mutex);
+  ReleaseAll(&pool.free_lists);
+  pool.bytes_held = 0;
+  for (set<ThreadCache*>::iterator it = pool.thread_caches.begin();
+       it != pool.thread_caches.end(); ++it) {
+    boost::mutex::scoped_lock lock((*it)->mutex);
+    ReleaseAll(&(*it)->free_lists);
+    (*it)->bytes_held = 0;
+  }
+}
+
+HostAllocator::Stats HostAllocator::GetStats() {
+  Pool& pool = GetPool();
+  boost::mutex::scoped_lock pool_lock(pool.mutex);
+  Stats stats;
+  stats.hits = pool.hits;
+  stats.misses = pool.misses;
+  stats.bytes_held = pool.bytes_held;
+  ptrdiff_t bytes_in_use = pool.bytes_in_use;
+  for (set<ThreadCache*>::iterator it = pool.thread_caches.begin();
+       it != pool.thread_caches.end(); ++it) {
+    boost::mutex::scoped_lock lock((*it)->mutex);
+    stats.hits += (*it)->hits;
+    stats.bytes_held += (*it)->bytes_held;
+    bytes_in_use += (*it)->bytes_in_use;
+  }
+  stats.bytes_in_use = bytes_in_use;
+  return stats;
+}
+
+void HostAllocator::ResetStats() {
+  Pool& pool = GetPool();
+  boost::mutex::scoped_lock pool_lock(pool.mutex);
+  pool.hits = 0;
+  pool.misses = 0;
+  for (set<ThreadCache*>::iterator it = pool.thread_caches.begin();
+       it != pool.thread_caches.end(); ++it) {
+    boost::mutex::scoped_lock lock((*it)->mutex);
+    (*it)->hits = 0;
+  }
+}
+
+void HostAllocator::set_max_held_bytes(size_t bytes) {
+  Pool& pool = GetPool();
+  boost::mutex::scoped_lock pool_lock(pool.mutex);
+  pool.max_held_bytes = bytes;
+  if (pool.bytes_held > bytes) {
+    ReleaseAll(&pool.free_lists);
+    pool.bytes_held = 0;
+  }
+  pool_lock.unlock();
+  if (bytes == 0) {
+    Trim();
+  }
+}
+
+size_t HostAllocator::max_held_bytes() {
+  Pool& pool = GetPool();
+  boost::mutex::scoped_lock pool_lock(pool.mutex);
+  return pool.max_held_bytes;
+}
+
+}  // namespace caffe
@@ -0,0 +1,332 @@
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "caffe/common.hpp"
+#include "caffe/util/implicit_gemm.hpp"
+#include "caffe/util/math_functions.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+namespace {
+
+// Register block of the forward micro-kernel: MR weight rows times NR output
+// pixels, kept in accumulators across the whole reduction block.
+const int kMR = 4;
+const int kNR = 16;
+// Cache block: kBlockK rows of im2col for kPanelCols output pixels. A block
+// is 128 KB of floats, so it stays in L2 while every weight row strip
+// streams over it.
+const int kBlockK = 256;
+const int kPanelCols = 128;
+
+// The shape of one 2D convolution.
+struct Geometry {
+  Geometry(const int channels, const int height, const int width,
+      const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+      const int stride_h, const int stride_w, const int dilation_h,
+      const int dilation_w)
+      : channels(channels), height(height), width(width),
+        kernel_h(kernel_h), kernel_w(kernel_w), pad_h(pad_h), pad_w(pad_w),
+        stride_h(stride_h), stride_w(stride_w), dilation_h(dilation_h),
+        dilation_w(dilation_w),
+        output_h((height + 2 * pad_h - (dilation_h * (kernel_h - 1) + 1)) /
+            stride_h + 1),
+        output_w((width + 2 * pad_w - (dilation_w * (kernel_w - 1) + 1)) /
+            stride_w + 1),
+        kernel_dim(channels * kernel_h * kernel_w),
+        spatial_dim(output_h * output_w) {}
+  const int channels, height, width;
+  const int kernel_h, kernel_w, pad_h, pad_w;
+  const int stride_h, stride_w, dilation_h, dilation_w;
+  const int output_h, output_w;
+  const int kernel_dim, spatial_dim;
+};
+
+// Visits rows [k0, k0 + kn) and columns [p0, p0 + pn) of im2col(image):
+// op(col, im) is called with the offset of each element in a row-major block
+// with row stride ld, and its offset in the image, or -1 where the element
+// falls into the padding.
+template <typename Op>
+inline void ForEachColumn(const Geometry& g, const int k0, const int kn,
+    const int p0, const int pn, const int ld, Op op) {
+  const int kernel_size = g.kernel_h * g.kernel_w;
+  for (int k = 0; k < kn; ++k) {
+    const int row = k0 + k;
+    const int c = row / kernel_size;
+    const int ki = (row / g.kernel_w) % g.kernel_h;
+    const int kj = row % g.kernel_w;
+    const int im_offset = c * g.height * g.width;
+    int oh = p0 / g.output_w;
+    int ow = p0 % g.output_w;
+    for (int j = 0; j < pn; ++j) {
+      const int ih = oh * g.stride_h - g.pad_h + ki * g.dilation_h;
+      const int iw = ow * g.stride_w - g.pad_w + kj * g.dilation_w;
+      // Unsigned casts fold the < 0 checks into the upper bound checks.
+      const bool inside = static_cast<unsigned>(ih) <
+          static_cast<unsigned>(g.height) &&
+          static_cast<unsigned>(iw) < static_cast<unsigned>(g.width);
+      op(k * ld + j, inside ? im_offset + ih * g.width + iw : -1);
+      if (++ow == g.output_w) {
+        ow = 0;
+        ++oh;
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+struct Gather {
+  Gather(const Dtype* im, Dtype* col) : im(im), col(col) {}
+  inline void operator()(const int c, const int i) const {
+    col[c] = i >= 0 ? im[i] : Dtype(0);
+  }
+  const Dtype* im;
+  Dtype* col;
+};
+
+template <typename Dtype>
+struct Scatter {
+  Scatter(const Dtype* col, Dtype* im) : col(col), im(im) {}
+  inline void operator()(const int c, const int i) const {
+    if (i >= 0) { im[i] += col[c]; }
+  }
+  const Dtype* col;
+  Dtype* im;
+};
+
+// c (rows x cols, row stride ldc) = a * b, or += if accumulate, where a is
+// one packed kMR-row strip of the weights and b one kNR-column strip of a
+// block, both k deep.
+template <typename Dtype>
+inline void MicroKernel(const int k, const Dtype* a, const Dtype* b,
+    Dtype* c, const int ldc, const int rows, const int cols,
+    const bool accumulate) {
+  Dtype acc[kMR][kNR] = {};
+  for (int l = 0; l < k; ++l) {
+    for (int i = 0; i < kMR; ++i) {
+      const Dtype a_il = a[l * kMR + i];
+      for (int j = 0; j < kNR; ++j) {
+        acc[i][j] += a_il * b[l * kNR + j];
+      }
+    }
+  }
+  for (int i = 0; i < rows; ++i) {
+    Dtype* c_i = c + i * ldc;
+    if (accumulate) {
+      for (int j = 0; j < cols; ++j) { c_i[j] += acc[i][j]; }
+    } else {
+      for (int j = 0; j < cols; ++j) { c_i[j] = acc[i][j]; }
+    }
+  }
+}
+
+// Forward pass for output pixel panels [begin, end).
+template <typename Dtype>
+void ForwardPanels(const Geometry* g, const Dtype* data_im,
+    const Dtype* packed_weights, const int num_output, Dtype* data_out,
+    const int begin, const int end) {
+  const int K = g->kernel_dim;
+  const int P = g->spatial_dim;
+  std::vector<Dtype> block(kBlockK * kPanelCols);
+  for (int panel = begin; panel < end; ++panel) {
+    const int p0 = panel * kPanelCols;
+    const int pn = std::min(kPanelCols, P - p0);
+    const int strips = (pn + kNR - 1) / kNR;
+    for (int k0 = 0; k0 < K; k0 += kBlockK) {
+      const int kn = std::min(kBlockK, K - k0);
+      // Each kNR-column strip is a kn x kNR row-major block of its own, so
+      // the micro-kernel reads it contiguously.
+      for (int s = 0; s < strips; ++s) {
+        Dtype* strip = &block[s * kn * kNR];
+        const int cols = std::min(kNR, pn - s * kNR);
+        if (cols < kNR) {
+          caffe_set(kn * kNR, Dtype(0), strip);
+        }
+        ForEachColumn(*g, k0, kn, p0 + s * kNR, cols, kNR,
+            Gather<Dtype>(data_im, strip));
+      }
+      for (int m0 = 0; m0 < num_output; m0 += kMR) {
+        const Dtype* a = packed_weights + m0 * K + k0 * kMR;
+        const int rows = std::min(kMR, num_output - m0);
+        for (int s = 0; s < strips; ++s) {
+          MicroKernel(kn, a, &block[s * kn * kNR],
+              data_out + m0 * P + p0 + s * kNR, P, rows,
+              std::min(kNR, pn - s * kNR), k0 > 0);
+        }
+      }
+    }
+  }
+}
+
+// Weight gradient for im2col rows [begin, end), which no other task touches.
+template <typename Dtype>
+void WeightRows(const Geometry* g, const Dtype* data_im,
+    const Dtype* top_diff, const int num_output, Dtype* weight_diff,
+    const int begin, const int end) {
+  const int K = g->kernel_dim;
+  const int P = g->spatial_dim;
+  std::vector<Dtype> block(kBlockK * kPanelCols);
+  for (int k0 = begin; k0 < end; k0 += kBlockK) {
+    const int kn = std::min(kBlockK, end - k0);
+    for (int p0 = 0; p0 < P; p0 += kPanelCols) {
+      const int pn = std::min(kPanelCols, P - p0);
+      ForEachColumn(*g, k0, kn, p0, pn, pn, Gather<Dtype>(data_im, &block[0]));
+      for (int m = 0; m < num_output; ++m) {
+        const Dtype* top = top_diff + m * P + p0;
+        Dtype* weight = weight_diff + m * K + k0;
+        for (int k = 0; k < kn; ++k) {
+          const Dtype* col = &block[k * pn];
+          Dtype sum = 0;
+          for (int p = 0; p < pn; ++p) {
+            sum += top[p] * col[p];
+          }
+          weight[k] += sum;
+        }
+      }
+    }
+  }
+}
+
+// Bottom gradient for channels [begin, end): their im2col rows are computed
+// a block at a time and scattered back, so no other task writes to them.
+template <typename Dtype>
+void DataChannels(const Geometry* g, const Dtype* top_diff,
+    const Dtype* weights, const int num_output, Dtype* bottom_diff,
+    const int begin, const int end) {
+  const int K = g->kernel_dim;
+  const int P = g->spatial_dim;
+  const int kernel_size = g->kernel_h * g->kernel_w;
+  const int image_size = g->height * g->width;
+  caffe_set((end - begin) * image_size, Dtype(0),
+      bottom_diff + begin * image_size);
+  std::vector<Dtype> block(kBlockK * kPanelCols);
+  const int row_end = end * kernel_size;
+  for (int k0 = begin * kernel_size; k0 < row_end; k0 += kBlockK) {
+    const int kn = std::min(kBlockK, row_end - k0);
+    for (int p0 = 0; p0 < P; p0 += kPanelCols) {
+      const int pn = std::min(kPanelCols, P - p0);
+      caffe_set(kn * pn, Dtype(0), &block[0]);
+      for (int m = 0; m < num_output; ++m) {
+        const Dtype* top = top_diff + m * P + p0;
+        const Dtype* weight = weights + m * K + k0;
+        for (int k = 0; k < kn; ++k) {
+          const Dtype w = weight[k];
+          Dtype* col = &block[k * pn];
+          for (int p = 0; p < pn; ++p) {
+            col[p] += w * top[p];
+          }
+        }
+      }
+      ForEachColumn(*g, k0, kn, p0, pn, pn,
+          Scatter<Dtype>(&block[0], bottom_diff));
+    }
+  }
+}
+
+}  // namespace
+
+int implicit_gemm_packed_size(const int num_output, const int kernel_dim) {
+  return (num_output + kMR - 1) / kMR * kMR * kernel_dim;
+}
+
+template <typename Dtype>
+void implicit_gemm_pack_weights_cpu(const Dtype* weights,
+    const int num_output, const int kernel_dim, Dtype* packed) {
+  // Strip t holds rows [t * kMR, (t + 1) * kMR) interleaved, column by
+  // column; rows past num_output are zero.
+  for (int m0 = 0; m0 < num_output; m0 += kMR) {
+    Dtype* strip = packed + m0 * kernel_dim;
+    for (int k = 0; k < kernel_dim; ++k) {
+      for (int i = 0; i < kMR; ++i) {
+        strip[k * kMR + i] = m0 + i < num_output ?
+            weights[(m0 + i) * kernel_dim + k] : Dtype(0);
+      }
+    }
+  }
+}
+
+template void implicit_gemm_pack_weights_cpu<float>(const float* weights,
+    const int num_output, const int kernel_dim, float* packed);
+template void implicit_gemm_pack_weights_cpu<double>(const double* weights,
+    const int num_output, const int kernel_dim, double* packed);
+
+template <typename Dtype>
+void implicit_gemm_conv_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* packed_weights,
+    const int num_output, Dtype* data_out) {
+  const Geometry g(channels, height, width, kernel_h, kernel_w, pad_h, pad_w,
+      stride_h, stride_w, dilation_h, dilation_w);
+  const int num_panels = (g.spatial_dim + kPanelCols - 1) / kPanelCols;
+  parallel_for(0, num_panels, 1, boost::bind(&ForwardPanels<Dtype>, &g,
+      data_im, packed_weights, num_output, data_out, _1, _2));
+}
+
+template void implicit_gemm_conv_cpu<float>(const float* data_im,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const float* packed_weights, const int num_output,
+    float* data_out);
+template void implicit_gemm_conv_cpu<double>(const double* data_im,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const double* packed_weights, const int num_output,
+    double* data_out);
+
+template <typename Dtype>
+void implicit_gemm_conv_weight_cpu(const Dtype* data_im, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* top_diff,
+    const int num_output, Dtype* weight_diff) {
+  const Geometry g(channels, height, width, kernel_h, kernel_w, pad_h, pad_w,
+      stride_h, stride_w, dilation_h, dilation_w);
+  parallel_for(0, g.kernel_dim, kernel_h * kernel_w,
+      boost::bind(&WeightRows<Dtype>, &g, data_im, top_diff, num_output,
+          weight_diff, _1, _2));
+}
+
+template void implicit_gemm_conv_weight_cpu<float>(const float* data_im,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const float* top_diff, const int num_output,
+    float* weight_diff);
+template void implicit_gemm_conv_weight_cpu<double>(const double* data_im,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const double* top_diff, const int num_output,
+    double* weight_diff);
+
+template <typename Dtype>
+void implicit_gemm_conv_data_cpu(const Dtype* top_diff, const int channels,
+    const int height, const int width, const int kernel_h, const int kernel_w,
+    const int pad_h, const int pad_w, const int stride_h, const int stride_w,
+    const int dilation_h, const int dilation_w, const Dtype* weights,
+    const int num_output, Dtype* bottom_diff) {
+  const Geometry g(channels, height, width, kernel_h, kernel_w, pad_h, pad_w,
+      stride_h, stride_w, dilation_h, dilation_w);
+  parallel_for(0, channels, 1, boost::bind(&DataChannels<Dtype>, &g,
+      top_diff, weights, num_output, bottom_diff, _1, _2));
+}
+
+template void implicit_gemm_conv_data_cpu<float>(const float* top_diff,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const float* weights, const int num_output,
+    float* bottom_diff);
+template void implicit_gemm_conv_data_cpu<double>(const double* top_diff,
+    const int channels, const int height, const int width,
+    const int kernel_h, const int kernel_w, const int pad_h, const int pad_w,
+    const int stride_h, const int stride_w, const int dilation_h,
+    const int dilation_w, const double* weights, const int num_output,
+    double* bottom_diff);
+
+}  // namespace caffe
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "caffe/common.hpp"
+#include "caffe/util/insert_reorders.hpp"
+
+namespace caffe {
+
+namespace {
+
+// The current versions of a blob of the input net: its NCHW and its blocked
+// copy, by name in the output net, or empty if there is none.
+struct BlobVersions {
+  BlobVersions() : consumed(false) {}
+  string plain;
+  string blocked;
+  // Whether a layer has read the current version, i.e. it is no net output.
+  bool consumed;
+};
+
+// Returns base, or base with a numeric suffix if that is taken, and takes it.
+string UniqueName(const string& base, set<string>* names) {
+  string name = base;
+  for (int i = 1; names->count(name); ++i) {
+    ostringstream stream;
+    stream << base << "_" << i;
+    name = stream.str();
+  }
+  names->insert(name);
+  return name;
+}
+
+// Whether the tops of a layer of this type have as many axes as its first
+// bottom.
+bool KeepsNumAxes(const string& type) {
+  return type == "Convolution" || type == "Pooling" || type == "ReLU" ||
+      type == "Eltwise" || type == "BatchNorm" || type == "Scale" ||
+      type == "LRN" || type == "Dropout";
+}
+
+}  // namespace
+
+bool TakesBlockedLayout(const LayerParameter& layer_param,
+    const int channel_block, const int bottom_num_axes) {
+  if (layer_param.loss_weight_size() > 0 || layer_param.top_size() != 1) {
+    return false;
+  }
+  const string& type = layer_param.type();
+  if (type == "Convolution") {
+    const ConvolutionParameter& conv_param = layer_param.convolution_param();
+    return layer_param.bottom_size() == 1 &&
+        layer_param.quantization_param().precision() ==
+        QuantizationParameter_Precision_FLOAT &&
+        (bottom_num_axes >= 0 ? bottom_num_axes == 4 :
+         conv_param.kernel_size_size() == 2 || conv_param.has_kernel_h()) &&
+        conv_param.group() == 1 && conv_param.axis() == 1 &&
+        !conv_param.force_nd_im2col() &&
+        conv_param.num_output() % channel_block == 0 &&
+        (conv_param.engine() == ConvolutionParameter_Engine_DEFAULT ||
+         conv_param.engine() == ConvolutionParameter_Engine_CAFFE);
+  } else if (type == "Pooling") {
+    const PoolingParameter_PoolMethod pool = layer_param.pooling_param().pool();
+    return pool == PoolingParameter_PoolMethod_MAX ||
+        pool == PoolingParameter_PoolMethod_AVE;
+  } else if (type == "ReLU") {
+    return layer_param.relu_param().engine() != ReLUParameter_Engine_CUDNN;
+  } else if (type == "Eltwise") {
+    return true;
+  }
+  return false;
+}
+
+void InsertReorders(const NetParameter& param, NetParameter* param_reorder) {
+  const int block = param.channel_block();
+  CHECK_GT(block, 0);
+  param_reorder->CopyFrom(param);
+  param_reorder->clear_layer();
+  map<string, BlobVersions> blobs;
+  set<string> blob_names;
+  set<string> layer_names;
+  // The number of axes of the blobs known from the net, which the layers of
+  // a chain and the in-place layers keep.
+  map<string, int> num_axes;
+  for (int i = 0; i < param.input_size(); ++i) {
+    blobs[param.input(i)].plain = UniqueName(param.input(i), &blob_names);
+    if (i < param.input_shape_size()) {
+      num_axes[param.input(i)] = param.input_shape(i).dim_size();
+    } else if (param.input_dim_size() > 0) {
+      num_axes[param.input(i)] = 4;
+    }
+  }
+  for (int i = 0; i < param.layer_size(); ++i) {
+    layer_names.insert(param.layer(i).name());
+  }
+  for (int i = 0; i < param.layer_size(); ++i) {
+    const LayerParameter& layer_param = param.layer(i);
+    // Chains start at convolutions, which read NCHW too; the other layers
+    // join a chain when one of their inputs is in it. In-place layers only
+    // join on a blob that has no NCHW copy, which would go stale.
+    int bottom_num_axes = -1;
+    if (layer_param.bottom_size() > 0 &&
+        num_axes.count(layer_param.bottom(0))) {
+      bottom_num_axes = num_axes[layer_param.bottom(0)];
+    }
+    bool blocked = TakesBlockedLayout(layer_param, block, bottom_num_axes);
+    if (blocked && layer_param.type() != "Convolution") {
+      bool blocked_input = false;
+      for (int j = 0; j < layer_param.bottom_size(); ++j) {
+        blocked_input |= !blobs[layer_param.bottom(j)].blocked.empty();
+      }
+      blocked = blocked_input;
+    }
+    for (int j = 0; blocked && j < layer_param.top_size() &&
+         j < layer_param.bottom_size(); ++j) {
+      const BlobVersions& versions = blobs[layer_param.bottom(j)];
+      if (layer_param.top(j) == layer_param.bottom(j)) {
+        blocked = !versions.blocked.empty() && versions.plain.empty();
+      }
+    }
+    // Bring every input into the layout the layer reads.
+    vector<string> bottoms(layer_param.bottom_size());
+    for (int j = 0; j < layer_param.bottom_size(); ++j) {
+      const string& blob_name = layer_param.bottom(j);
+      BlobVersions& versions = blobs[blob_name];
+      if (versions.plain.empty() && versions.blocked.empty()) {
+        // Unknown; InsertSplits reports it.
+        versions.plain = blob_name;
+      }
+      versions.consumed = true;
+      if (blocked && !versions.blocked.empty()) {
+        bottoms[j] = versions.blocked;
+      } else if (blocked && layer_param.type() == "Convolution") {
+        bottoms[j] = versions.plain;
+      } else if (blocked) {
+        versions.blocked = UniqueName(blob_name + "_blocked", &blob_names);
+        ConfigureReorderLayer(UniqueName(blob_name + "_to_blocked",
+            &layer_names), versions.plain, versions.blocked, block,
+            param_reorder->add_layer());
+        bottoms[j] = versions.blocked;
+      } else if (versions.plain.empty()) {
+        versions.plain = UniqueName(blob_name, &blob_names);
+        ConfigureReorderLayer(UniqueName(blob_name + "_to_nchw",
+            &layer_names), versions.blocked, versions.plain, 0,
+            param_reorder->add_layer());
+        bottoms[j] = versions.plain;
+      } else {
+        bottoms[j] = versions.plain;
+      }
+    }
+    LayerParameter* new_layer_param = param_reorder->add_layer();
+    new_layer_param->CopyFrom(layer_param);
+    for (int j = 0; j < bottoms.size(); ++j) {
+      new_layer_param->set_bottom(j, bottoms[j]);
+    }
+    if (blocked && layer_param.type() == "Convolution") {
+      new_layer_param->mutable_convolution_param()->set_channel_block(block);
+    }
+    for (int j = 0; j < layer_param.top_size(); ++j) {
+      const string& blob_name = layer_param.top(j);
+      BlobVersions& versions = blobs[blob_name];
+      const bool in_place = j < layer_param.bottom_size() &&
+          blob_name == layer_param.bottom(j);
+      const InputParameter& input_param = layer_param.input_param();
+      if (layer_param.type() == "Input" && input_param.shape_size() > 0) {
+        num_axes[blob_name] = input_param.shape(
+            std::min(j, input_param.shape_size() - 1)).dim_size();
+      } else if (!in_place && bottom_num_axes >= 0 &&
+          KeepsNumAxes(layer_param.type())) {
+        num_axes[blob_name] = bottom_num_axes;
+      } else if (!in_place) {
+        num_axes.erase(blob_name);
+      }
+      if (in_place) {
+        new_layer_param->set_top(j, bottoms[j]);
+        (blocked ? versions.plain : versions.blocked).clear();
+      } else if (blocked) {
+        versions.blocked = UniqueName(blob_name + "_blocked", &blob_names);
+        versions.plain.clear();
+        new_layer_param->set_top(j, versions.blocked);
+      } else {
+        versions.plain = UniqueName(blob_name, &blob_names);
+        versions.blocked.clear();
+        new_layer_param->set_top(j, versions.plain);
+      }
+      versions.consumed = false;
+    }
+  }
+  // The net outputs are NCHW, under their own names.
+  for (map<string, BlobVersions>::iterator it = blobs.begin();
+       it != blobs.end(); ++it) {
+    BlobVersions& versions = it->second;
+    if (!versions.consumed && versions.plain.empty()) {
+      versions.plain = UniqueName(it->first, &blob_names);
+      ConfigureReorderLayer(UniqueName(it->first + "_to_nchw", &layer_names),
+          versions.blocked, versions.plain, 0, param_reorder->add_layer());
+    }
+  }
+}
+
+void ConfigureReorderLayer(const string& layer_name, const string& bottom,
+    const string& top, const int channel_block,
+    LayerParameter* reorder_layer_param) {
+  reorder_layer_param->Clear();
+  reorder_layer_param->set_name(layer_name);
+  reorder_layer_param->set_type("Reorder");
+  reorder_layer_param->add_bottom(bottom);
+  reorder_layer_param->add_top(top);
+  reorder_layer_param->mutable_reorder_param()->set_channel_block(
+      channel_block);
+}
+
+}  // namespace caffe
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "caffe/common.hpp"
+#include "caffe/util/int8_gemm.hpp"
+#include "caffe/util/simd_math.hpp"
+
+// As in simd_math.cpp, the AVX2 kernel is compiled for its instruction set
+// with a function attribute and picked at run time.
+#if defined(__GNUC__) && !defined(__CUDACC__) && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ >= 5)
+#define CAFFE_INT8_X86
+#include <immintrin.h>
+#define CAFFE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace caffe {
+
+namespace {
+
+// The columns of B are packed a panel at a time, so that the panel (K x
+// kPanelCols int8) stays in cache while every row of A goes over it.
+const int kPanelCols = 256;
+
+// The four values of row a from k4 * 4 on, zero past K, as one int32.
+inline int32_t int8_quad(const int8_t* a, const int K, const int k4) {
+  int32_t quad = 0;
+  memcpy(&quad, a + k4 * 4, std::min(4, K - k4 * 4));
+  return quad;
+}
+
+// The int32 sums of row a (K values) with the cols8 columns of a panel.
+void int8_panel_scalar(const int8_t* a, const int K, const int8_t* panel,
+    const int cols8, int32_t* sum) {
+  std::fill(sum, sum + cols8, 0);
+  for (int k4 = 0; k4 < (K + 3) / 4; ++k4) {
+    const int8_t* q = a + k4 * 4;
+    const int32_t a0 = q[0];
+    const int32_t a1 = k4 * 4 + 1 < K ? q[1] : 0;
+    const int32_t a2 = k4 * 4 + 2 < K ? q[2] : 0;
+    const int32_t a3 = k4 * 4 + 3 < K ? q[3] : 0;
+    if (a0 == 0 && a1 == 0 && a2 == 0 && a3 == 0) {
+      continue;
+    }
+    const int8_t* b = panel + k4 * cols8 * 4;
+    for (int j = 0; j < cols8; ++j) {
+      sum[j] += a0 * b[4 * j] + a1 * b[4 * j + 1] + a2 * b[4 * j + 2] +
+          a3 * b[4 * j + 3];
+    }
+  }
+}
+
+#ifdef CAFFE_INT8_X86
+// V vectors of 8 columns from column j: each step multiplies four values of
+// k for every column, maddubs taking |a| against b with the sign of a, and
+// madd summing the pairs of int16 products into int32. The int16 sums cannot
+// saturate, as the values lie in [-127, 127].
+template <int V>
+CAFFE_TARGET_AVX2 void int8_columns_avx2(const int8_t* a, const int K,
+    const int8_t* panel, const int cols8, const int j, int32_t* sum) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i acc[V];
+  for (int v = 0; v < V; ++v) {
+    acc[v] = _mm256_setzero_si256();
+  }
+  for (int k4 = 0; k4 < (K + 3) / 4; ++k4) {
+    const __m256i a_quad = _mm256_set1_epi32(int8_quad(a, K, k4));
+    const __m256i a_abs = _mm256_abs_epi8(a_quad);
+    const int8_t* b = panel + (k4 * cols8 + j) * 4;
+    for (int v = 0; v < V; ++v) {
+      const __m256i b_v = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(b + v * 32));
+      const __m256i products = _mm256_maddubs_epi16(a_abs,
+          _mm256_sign_epi8(b_v, a_quad));
+      acc[v] = _mm256_add_epi32(acc[v], _mm256_madd_epi16(products, ones));
+    }
+  }
+  for (int v = 0; v < V; ++v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(sum + j + v * 8), acc[v]);
+  }
+}
+
+CAFFE_TARGET_AVX2 void int8_panel_avx2(const int8_t* a, const int K,
+    const int8_t* panel, const int cols8, int32_t* sum) {
+  int j = 0;
+  for (; j + 32 <= cols8; j += 32) {
+    int8_columns_avx2<4>(a, K, panel, cols8, j, sum);
+  }
+  for (; j < cols8; j += 8) {
+    int8_columns_avx2<1>(a, K, panel, cols8, j, sum);
+  }
+}
+#endif  // CAFFE_INT8_X86
+
+}  // namespace
+
+template <typename Dtype>
+Dtype int8_max_abs(const int n, const Dtype* data) {
+  Dtype range = 0;
+  for (int i = 0; i < n; ++i) {
+    range = std::max(range, static_cast<Dtype>(std::fabs(data[i])));
+  }
+  return range;
+}
+
+template <typename Dtype>
+void int8_quantize_cpu(const int n, const Dtype* x, const Dtype scale,
+    int8_t* q) {
+  for (int i = 0; i < n; ++i) {
+    const Dtype value = std::min(Dtype(127),
+        std::max(Dtype(-127), x[i] * scale));
+    q[i] = static_cast<int8_t>(value < 0 ? value - Dtype(0.5) :
+        value + Dtype(0.5));
+  }
+}
+
+template <typename Dtype>
+void int8_quantize_rows_cpu(const int rows, const int cols, const Dtype* data,
+    Dtype* scale, int8_t* q) {
+  for (int r = 0; r < rows; ++r) {
+    scale[r] = int8_scale(int8_max_abs(cols, data + r * cols));
+    int8_quantize_cpu(cols, data + r * cols, scale[r], q + r * cols);
+  }
+}
+
+void int8_pack_cpu(const int K, const int N, const int8_t* B,
+    const int k_stride, const int n_stride, int8_t* packed) {
+  const int K4 = (K + 3) / 4;
+  for (int j0 = 0; j0 < N; j0 += kPanelCols) {
+    const int cols = std::min(kPanelCols, N - j0);
+    const int cols8 = (cols + 7) / 8 * 8;
+    int8_t* panel = packed + K4 * 4 * j0;
+    for (int k4 = 0; k4 < K4; ++k4) {
+      int8_t* p = panel + k4 * cols8 * 4;
+      for (int j = 0; j < cols8; ++j) {
+        for (int d = 0; d < 4; ++d) {
+          const int k = k4 * 4 + d;
+          p[j * 4 + d] = k < K && j < cols ?
+              B[k * k_stride + (j0 + j) * n_stride] : 0;
+        }
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void int8_gemm_cpu(const int M, const int N, const int K, const int8_t* A,
+    const int8_t* packed_B, const Dtype* scale, const Dtype* bias,
+    const bool channels_in_columns, Dtype* C) {
+  CHECK_LT(K, 1 << 17) << "int32 accumulation could overflow.";
+  void (*panel_sums)(const int8_t*, const int, const int8_t*, const int,
+      int32_t*) = int8_panel_scalar;
+#ifdef CAFFE_INT8_X86
+  if (simd_isa() >= SIMD_AVX2) {
+    panel_sums = int8_panel_avx2;
+  }
+#endif
+  int32_t sum[kPanelCols];
+  const int K4 = (K + 3) / 4;
+  for (int j0 = 0; j0 < N; j0 += kPanelCols) {
+    const int cols = std::min(kPanelCols, N - j0);
+    const int8_t* panel = packed_B + K4 * 4 * j0;
+    for (int i = 0; i < M; ++i) {
+      panel_sums(A + i * K, K, panel, (cols + 7) / 8 * 8, sum);
+      // Requantize: back to the scale of the floating point output, with the
+      // bias added while the row is in registers.
+      Dtype* c = C + i * N + j0;
+      if (channels_in_columns) {
+        for (int j = 0; j < cols; ++j) {
+          c[j] = sum[j] * scale[j0 + j] + (bias ? bias[j0 + j] : Dtype(0));
+        }
+      } else {
+        const Dtype row_scale = scale[i];
+        const Dtype row_bias = bias ? bias[i] : Dtype(0);
+        for (int j = 0; j < cols; ++j) {
+          c[j] = sum[j] * row_scale + row_bias;
+        }
+      }
+    }
+  }
+}
+
+// Explicit instantiation
+template float int8_max_abs<float>(const int n, const float* data);
+template double int8_max_abs<double>(const int n, const double* data);
+template void int8_quantize_cpu<float>(const int n, const float* x,
+    const float scale, int8_t* q);
+template void int8_quantize_cpu<double>(const int n, const double* x,
+    const double scale, int8_t* q);
+template void int8_quantize_rows_cpu<float>(const int rows, const int cols,
+    const float* data, float* scale, int8_t* q);
+template void int8_quantize_rows_cpu<double>(const int rows, const int cols,
+    const double* data, double* scale, int8_t* q);
+template void int8_gemm_cpu<float>(const int M, const int N, const int K,
+    const int8_t* A, const int8_t* packed_B, const float* scale,
+    const float* bias, const bool channels_in_columns, float* C);
+template void int8_gemm_cpu<double>(const int M, const int N, const int K,
+    const int8_t* A, const int8_t* packed_B, const double* scale,
+    const double* bias, const bool channels_in_columns, double* C);
+
+}  // namespace caffe
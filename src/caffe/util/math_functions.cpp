@@ -1,14 +1,253 @@
 #include <boost/math/special_functions/next.hpp>
 #include <boost/random.hpp>
+#include <boost/thread.hpp>
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 #include "caffe/common.hpp"
 #include "caffe/util/math_functions.hpp"
 #include "caffe/util/rng.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
+namespace {
+
+// Each thread gets at least this many elements of an element-wise loop.
+const int kMinElementsPerThread = 4096;
+// Reductions are summed in blocks of this many elements.
+const int kReductionBlock = 16384;
+
+boost::mutex parallel_mutex;
+int parallel_threshold = 65536;
+
+int ParallelThreshold() {
+  boost::lock_guard<boost::mutex> lock(parallel_mutex);
+  return parallel_threshold;
+}
+
+// Calls op(begin, end) on contiguous ranges of [0, n), one per pool task.
+template <typename Op>
+class RangeTask {
+ public:
+  RangeTask(const Op& op, const int n, const int num_tasks)
+      : op_(op), n_(n), num_tasks_(num_tasks) {}
+  void operator()(const int i) const {
+    op_(Boundary(i), i + 1 == num_tasks_ ? n_ : Boundary(i + 1));
+  }
+
+ private:
+  // Task boundaries fall on 64-byte multiples for float arrays.
+  int Boundary(const int i) const {
+    return static_cast<int>(static_cast<int64_t>(n_) * i / num_tasks_) & ~15;
+  }
+
+  const Op& op_;
+  const int n_;
+  const int num_tasks_;
+};
+
+// Runs op over [0, n) split across the pool and returns true, or returns
+// false without doing anything when n is below the threshold, parallelism is
+// unavailable or the caller already is a pool task; the caller then runs its
+// serial code.
+template <typename Op>
+bool ParallelFor(const int n, const Op& op) {
+  if (n < ParallelThreshold() || ThreadPool::in_parallel_region()) {
+    return false;
+  }
+  shared_ptr<ThreadPool> thread_pool = Caffe::thread_pool();
+  const int num_tasks = std::min(thread_pool->num_threads(),
+      n / kMinElementsPerThread);
+  if (num_tasks < 2) {
+    return false;
+  }
+  RangeTask<Op> task(op, n, num_tasks);
+  thread_pool->Run(num_tasks, boost::ref(task));
+  return true;
+}
+
+// Computes partials[i] = op(begin, end) for the i-th block of a reduction.
+template <typename Dtype, typename Op>
+class BlockTask {
+ public:
+  BlockTask(const Op& op, const int n, Dtype* partials)
+      : op_(op), n_(n), partials_(partials) {}
+  void operator()(const int i) const {
+    const int begin = i * kReductionBlock;
+    partials_[i] = op_(begin, std::min(n_, begin + kReductionBlock));
+  }
+
+ private:
+  const Op& op_;
+  const int n_;
+  Dtype* partials_;
+};
+
+// Sums op(begin, end) over blocks of [0, n). Above the threshold the block
+// boundaries and the summation order depend on n only, whether or not the
+// blocks run in parallel, so the result is reproducible for any thread count.
+template <typename Dtype, typename Op>
+Dtype BlockedReduce(const int n, const Op& op) {
+  if (n < ParallelThreshold() || n <= kReductionBlock) {
+    return op(0, n);
+  }
+  const int num_blocks = (n - 1) / kReductionBlock + 1;
+  vector<Dtype> partials(num_blocks);
+  BlockTask<Dtype, Op> task(op, n, &partials[0]);
+  if (ThreadPool::in_parallel_region()) {
+    for (int i = 0; i < num_blocks; ++i) {
+      task(i);
+    }
+  } else {
+    Caffe::thread_pool()->Run(num_blocks, boost::ref(task));
+  }
+  Dtype sum = 0;
+  for (int i = 0; i < num_blocks; ++i) {
+    sum += partials[i];
+  }
+  return sum;
+}
+
+// Range operations for ParallelFor. Each calls the public function on its
+// range, which runs serially because it is called from a pool task.
+
+template <typename Dtype>
+struct ScalarOp {  // f(n, alpha, y)
+  typedef void (*Func)(const int, const Dtype, Dtype*);
+  ScalarOp(Func f, const Dtype alpha, Dtype* y) : f(f), alpha(alpha), y(y) {}
+  void operator()(const int begin, const int end) const {
+    f(end - begin, alpha, y + begin);
+  }
+  Func f;
+  const Dtype alpha;
+  Dtype* y;
+};
+
+template <typename Dtype>
+struct UnaryOp {  // f(n, a, y)
+  typedef void (*Func)(const int, const Dtype*, Dtype*);
+  UnaryOp(Func f, const Dtype* a, Dtype* y) : f(f), a(a), y(y) {}
+  void operator()(const int begin, const int end) const {
+    f(end - begin, a + begin, y + begin);
+  }
+  Func f;
+  const Dtype* a;
+  Dtype* y;
+};
+
+template <typename Dtype>
+struct BinaryOp {  // f(n, a, b, y)
+  typedef void (*Func)(const int, const Dtype*, const Dtype*, Dtype*);
+  BinaryOp(Func f, const Dtype* a, const Dtype* b, Dtype* y)
+      : f(f), a(a), b(b), y(y) {}
+  void operator()(const int begin, const int end) const {
+    f(end - begin, a + begin, b + begin, y + begin);
+  }
+  Func f;
+  const Dtype* a;
+  const Dtype* b;
+  Dtype* y;
+};
+
+template <typename Dtype>
+struct ScaledUnaryOp {  // f(n, alpha, x, y) and f(n, x, alpha, y)
+  typedef void (*Func)(const int, const Dtype, const Dtype*, Dtype*);
+  typedef void (*PowxFunc)(const int, const Dtype*, const Dtype, Dtype*);
+  ScaledUnaryOp(Func f, const Dtype alpha, const Dtype* x, Dtype* y)
+      : f(f), powx_f(NULL), alpha(alpha), x(x), y(y) {}
+  ScaledUnaryOp(PowxFunc f, const Dtype* x, const Dtype alpha, Dtype* y)
+      : f(NULL), powx_f(f), alpha(alpha), x(x), y(y) {}
+  void operator()(const int begin, const int end) const {
+    if (f) {
+      f(end - begin, alpha, x + begin, y + begin);
+    } else {
+      powx_f(end - begin, x + begin, alpha, y + begin);
+    }
+  }
+  Func f;
+  PowxFunc powx_f;
+  const Dtype alpha;
+  const Dtype* x;
+  Dtype* y;
+};
+
+template <typename Dtype>
+struct AxpbyOp {
+  AxpbyOp(const Dtype alpha, const Dtype* x, const Dtype beta, Dtype* y)
+      : alpha(alpha), x(x), beta(beta), y(y) {}
+  void operator()(const int begin, const int end) const {
+    caffe_cpu_axpby(end - begin, alpha, x + begin, beta, y + begin);
+  }
+  const Dtype alpha;
+  const Dtype* x;
+  const Dtype beta;
+  Dtype* y;
+};
+
+template <typename Dtype>
+struct CopyOp {
+  CopyOp(const Dtype* x, Dtype* y) : x(x), y(y) {}
+  void operator()(const int begin, const int end) const {
+    memcpy(y + begin, x + begin,  // NOLINT(caffe/alt_fn)
+        sizeof(Dtype) * (end - begin));
+  }
+  const Dtype* x;
+  Dtype* y;
+};
+
+inline float SerialAsum(const int n, const float* x) {
+  return cblas_sasum(n, x, 1);
+}
+inline double SerialAsum(const int n, const double* x) {
+  return cblas_dasum(n, x, 1);
+}
+inline float SerialDot(const int n, const float* x, const int incx,
+    const float* y, const int incy) {
+  return cblas_sdot(n, x, incx, y, incy);
+}
+inline double SerialDot(const int n, const double* x, const int incx,
+    const double* y, const int incy) {
+  return cblas_ddot(n, x, incx, y, incy);
+}
+
+template <typename Dtype>
+struct AsumOp {
+  explicit AsumOp(const Dtype* x) : x(x) {}
+  Dtype operator()(const int begin, const int end) const {
+    return SerialAsum(end - begin, x + begin);
+  }
+  const Dtype* x;
+};
+
+template <typename Dtype>
+struct DotOp {
+  DotOp(const Dtype* x, const int incx, const Dtype* y, const int incy)
+      : x(x), incx(incx), y(y), incy(incy) {}
+  Dtype operator()(const int begin, const int end) const {
+    return SerialDot(end - begin, x + begin * incx, incx, y + begin * incy,
+        incy);
+  }
+  const Dtype* x;
+  const int incx;
+  const Dtype* y;
+  const int incy;
+};
+
+}  // namespace
+
+void caffe_cpu_set_parallel_threshold(const int threshold) {
+  CHECK_GE(threshold, 0);
+  boost::lock_guard<boost::mutex> lock(parallel_mutex);
+  parallel_threshold = threshold;
+}
+
+int caffe_cpu_parallel_threshold() {
+  return ParallelThreshold();
+}
+
 template<>
 void caffe_cpu_gemm<float>(const CBLAS_TRANSPOSE TransA,
     const CBLAS_TRANSPOSE TransB, const int M, const int N, const int K,
@@ -47,14 +286,27 @@ void caffe_cpu_gemv<double>(const CBLAS_TRANSPOSE TransA, const int M,
 
 template <>
 void caffe_axpy<float>(const int N, const float alpha, const float* X,
-    float* Y) { cblas_saxpy(N, alpha, X, 1, Y, 1); }
+    float* Y) {
+  if (ParallelFor(N, ScaledUnaryOp<float>(caffe_axpy<float>, alpha, X, Y))) {
+    return;
+  }
+  cblas_saxpy(N, alpha, X, 1, Y, 1);
+}
 
 template <>
 void caffe_axpy<double>(const int N, const double alpha, const double* X,
-    double* Y) { cblas_daxpy(N, alpha, X, 1, Y, 1); }
+    double* Y) {
+  if (ParallelFor(N, ScaledUnaryOp<double>(caffe_axpy<double>, alpha, X, Y))) {
+    return;
+  }
+  cblas_daxpy(N, alpha, X, 1, Y, 1);
+}
 
 template <typename Dtype>
 void caffe_set(const int N, const Dtype alpha, Dtype* Y) {
+  if (ParallelFor(N, ScalarOp<Dtype>(caffe_set<Dtype>, alpha, Y))) {
+    return;
+  }
   if (alpha == 0) {
     memset(Y, 0, sizeof(Dtype) * N);  // NOLINT(caffe/alt_fn)
     return;
@@ -70,6 +322,9 @@ template void caffe_set<double>(const int N, const double alpha, double* Y);
 
 template <>
 void caffe_add_scalar(const int N, const float alpha, float* Y) {
+  if (ParallelFor(N, ScalarOp<float>(caffe_add_scalar<float>, alpha, Y))) {
+    return;
+  }
   for (int i = 0; i < N; ++i) {
     Y[i] += alpha;
   }
@@ -77,6 +332,9 @@ void caffe_add_scalar(const int N, const float alpha, float* Y) {
 
 template <>
 void caffe_add_scalar(const int N, const double alpha, double* Y) {
+  if (ParallelFor(N, ScalarOp<double>(caffe_add_scalar<double>, alpha, Y))) {
+    return;
+  }
   for (int i = 0; i < N; ++i) {
     Y[i] += alpha;
   }
@@ -92,7 +350,7 @@ void caffe_copy(const int N, const Dtype* X, Dtype* Y) {
 #else
       NO_GPU;
 #endif
-    } else {
+    } else if (!ParallelFor(N, CopyOp<Dtype>(X, Y))) {
       memcpy(Y, X, sizeof(Dtype) * N);  // NOLINT(caffe/alt_fn)
     }
   }
@@ -106,123 +364,189 @@ template void caffe_copy<double>(const int N, const double* X, double* Y);
 
 template <>
 void caffe_scal<float>(const int N, const float alpha, float *X) {
+  if (ParallelFor(N, ScalarOp<float>(caffe_scal<float>, alpha, X))) {
+    return;
+  }
   cblas_sscal(N, alpha, X, 1);
 }
 
 template <>
 void caffe_scal<double>(const int N, const double alpha, double *X) {
+  if (ParallelFor(N, ScalarOp<double>(caffe_scal<double>, alpha, X))) {
+    return;
+  }
   cblas_dscal(N, alpha, X, 1);
 }
 
 template <>
 void caffe_cpu_axpby<float>(const int N, const float alpha, const float* X,
                             const float beta, float* Y) {
+  if (ParallelFor(N, AxpbyOp<float>(alpha, X, beta, Y))) {
+    return;
+  }
   cblas_saxpby(N, alpha, X, 1, beta, Y, 1);
 }
 
 template <>
 void caffe_cpu_axpby<double>(const int N, const double alpha, const double* X,
                              const double beta, double* Y) {
+  if (ParallelFor(N, AxpbyOp<double>(alpha, X, beta, Y))) {
+    return;
+  }
   cblas_daxpby(N, alpha, X, 1, beta, Y, 1);
 }
 
 template <>
 void caffe_add<float>(const int n, const float* a, const float* b,
     float* y) {
+  if (ParallelFor(n, BinaryOp<float>(caffe_add<float>, a, b, y))) {
+    return;
+  }
   vsAdd(n, a, b, y);
 }
 
 template <>
 void caffe_add<double>(const int n, const double* a, const double* b,
     double* y) {
+  if (ParallelFor(n, BinaryOp<double>(caffe_add<double>, a, b, y))) {
+    return;
+  }
   vdAdd(n, a, b, y);
 }
 
 template <>
 void caffe_sub<float>(const int n, const float* a, const float* b,
     float* y) {
+  if (ParallelFor(n, BinaryOp<float>(caffe_sub<float>, a, b, y))) {
+    return;
+  }
   vsSub(n, a, b, y);
 }
 
 template <>
 void caffe_sub<double>(const int n, const double* a, const double* b,
     double* y) {
+  if (ParallelFor(n, BinaryOp<double>(caffe_sub<double>, a, b, y))) {
+    return;
+  }
   vdSub(n, a, b, y);
 }
 
 template <>
 void caffe_mul<float>(const int n, const float* a, const float* b,
     float* y) {
+  if (ParallelFor(n, BinaryOp<float>(caffe_mul<float>, a, b, y))) {
+    return;
+  }
   vsMul(n, a, b, y);
 }
 
 template <>
 void caffe_mul<double>(const int n, const double* a, const double* b,
     double* y) {
+  if (ParallelFor(n, BinaryOp<double>(caffe_mul<double>, a, b, y))) {
+    return;
+  }
   vdMul(n, a, b, y);
 }
 
 template <>
 void caffe_div<float>(const int n, const float* a, const float* b,
     float* y) {
+  if (ParallelFor(n, BinaryOp<float>(caffe_div<float>, a, b, y))) {
+    return;
+  }
   vsDiv(n, a, b, y);
 }
 
 template <>
 void caffe_div<double>(const int n, const double* a, const double* b,
     double* y) {
+  if (ParallelFor(n, BinaryOp<double>(caffe_div<double>, a, b, y))) {
+    return;
+  }
   vdDiv(n, a, b, y);
 }
 
 template <>
 void caffe_powx<float>(const int n, const float* a, const float b,
     float* y) {
+  if (ParallelFor(n, ScaledUnaryOp<float>(caffe_powx<float>, a, b, y))) {
+    return;
+  }
   vsPowx(n, a, b, y);
 }
 
 template <>
 void caffe_powx<double>(const int n, const double* a, const double b,
     double* y) {
+  if (ParallelFor(n, ScaledUnaryOp<double>(caffe_powx<double>, a, b, y))) {
+    return;
+  }
   vdPowx(n, a, b, y);
 }
 
 template <>
 void caffe_sqr<float>(const int n, const float* a, float* y) {
+  if (ParallelFor(n, UnaryOp<float>(caffe_sqr<float>, a, y))) {
+    return;
+  }
   vsSqr(n, a, y);
 }
 
 template <>
 void caffe_sqr<double>(const int n, const double* a, double* y) {
+  if (ParallelFor(n, UnaryOp<double>(caffe_sqr<double>, a, y))) {
+    return;
+  }
   vdSqr(n, a, y);
 }
 
 template <>
 void caffe_exp<float>(const int n, const float* a, float* y) {
+  if (ParallelFor(n, UnaryOp<float>(caffe_exp<float>, a, y))) {
+    return;
+  }
   vsExp(n, a, y);
 }
 
 template <>
 void caffe_exp<double>(const int n, const double* a, double* y) {
+  if (ParallelFor(n, UnaryOp<double>(caffe_exp<double>, a, y))) {
+    return;
+  }
   vdExp(n, a, y);
 }
 
 template <>
 void caffe_log<float>(const int n, const float* a, float* y) {
+  if (ParallelFor(n, UnaryOp<float>(caffe_log<float>, a, y))) {
+    return;
+  }
   vsLn(n, a, y);
 }
 
 template <>
 void caffe_log<double>(const int n, const double* a, double* y) {
+  if (ParallelFor(n, UnaryOp<double>(caffe_log<double>, a, y))) {
+    return;
+  }
   vdLn(n, a, y);
 }
 
 template <>
 void caffe_abs<float>(const int n, const float* a, float* y) {
+  if (ParallelFor(n, UnaryOp<float>(caffe_abs<float>, a, y))) {
+    return;
+  }
     vsAbs(n, a, y);
 }
 
 template <>
 void caffe_abs<double>(const int n, const double* a, double* y) {
+  if (ParallelFor(n, UnaryOp<double>(caffe_abs<double>, a, y))) {
+    return;
+  }
     vdAbs(n, a, y);
 }
 
@@ -328,13 +652,20 @@ void caffe_rng_bernoulli<float>(const int n, const float p, unsigned int* r);
 template <>
 float caffe_cpu_strided_dot<float>(const int n, const float* x, const int incx,
     const float* y, const int incy) {
-  return cblas_sdot(n, x, incx, y, incy);
+  // Negative increments walk the vectors backwards; leave those to BLAS.
+  if (incx <= 0 || incy <= 0) {
+    return cblas_sdot(n, x, incx, y, incy);
+  }
+  return BlockedReduce<float>(n, DotOp<float>(x, incx, y, incy));
 }
 
 template <>
 double caffe_cpu_strided_dot<double>(const int n, const double* x,
     const int incx, const double* y, const int incy) {
-  return cblas_ddot(n, x, incx, y, incy);
+  if (incx <= 0 || incy <= 0) {
+    return cblas_ddot(n, x, incx, y, incy);
+  }
+  return BlockedReduce<double>(n, DotOp<double>(x, incx, y, incy));
 }
 
 template <typename Dtype>
@@ -350,17 +681,21 @@ double caffe_cpu_dot<double>(const int n, const double* x, const double* y);
 
 template <>
 float caffe_cpu_asum<float>(const int n, const float* x) {
-  return cblas_sasum(n, x, 1);
+  return BlockedReduce<float>(n, AsumOp<float>(x));
 }
 
 template <>
 double caffe_cpu_asum<double>(const int n, const double* x) {
-  return cblas_dasum(n, x, 1);
+  return BlockedReduce<double>(n, AsumOp<double>(x));
 }
 
 template <>
 void caffe_cpu_scale<float>(const int n, const float alpha, const float *x,
                             float* y) {
+  if (ParallelFor(n,
+      ScaledUnaryOp<float>(caffe_cpu_scale<float>, alpha, x, y))) {
+    return;
+  }
   cblas_scopy(n, x, 1, y, 1);
   cblas_sscal(n, alpha, y, 1);
 }
@@ -368,6 +703,10 @@ void caffe_cpu_scale<float>(const int n, const float alpha, const float *x,
 template <>
 void caffe_cpu_scale<double>(const int n, const double alpha, const double *x,
                              double* y) {
+  if (ParallelFor(n,
+      ScaledUnaryOp<double>(caffe_cpu_scale<double>, alpha, x, y))) {
+    return;
+  }
   cblas_dcopy(n, x, 1, y, 1);
   cblas_dscal(n, alpha, y, 1);
 }
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "caffe/util/memory_planner.hpp"
+
+namespace caffe {
+
+namespace {
+
+// Orders block indices by decreasing size, then by first use, so that the
+// placement is deterministic.
+class LargerBlockFirst {
+ public:
+  explicit LargerBlockFirst(const vector<MemoryBlock>& blocks)
+      : blocks_(blocks) {}
+  bool operator()(const int a, const int b) const {
+    if (blocks_[a].size != blocks_[b].size) {
+      return blocks_[a].size > blocks_[b].size;
+    }
+    if (blocks_[a].first != blocks_[b].first) {
+      return blocks_[a].first < blocks_[b].first;
+    }
+    return a < b;
+  }
+ private:
+  const vector<MemoryBlock>& blocks_;
+};
+
+inline size_t AlignUp(const size_t value, const size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+inline bool LifetimesOverlap(const MemoryBlock& a, const MemoryBlock& b) {
+  return a.first <= b.last && b.first <= a.last;
+}
+
+}  // namespace
+
+size_t PlanMemoryBlocks(const vector<MemoryBlock>& blocks,
+    const size_t alignment, vector<size_t>* offsets) {
+  CHECK_GT(alignment, 0);
+  CHECK(offsets);
+  offsets->assign(blocks.size(), 0);
+  vector<int> order(blocks.size());
+  for (int i = 0; i < blocks.size(); ++i) {
+    CHECK_LE(blocks[i].first, blocks[i].last)
+        << "Memory block " << i << " ends before it starts.";
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), LargerBlockFirst(blocks));
+  size_t total_size = 0;
+  vector<int> placed;
+  for (int i = 0; i < order.size(); ++i) {
+    const MemoryBlock& block = blocks[order[i]];
+    const size_t size = AlignUp(block.size, alignment);
+    // Collect the [begin, end) ranges already taken by live neighbours.
+    vector<pair<size_t, size_t> > taken;
+    for (int j = 0; j < placed.size(); ++j) {
+      const MemoryBlock& other = blocks[placed[j]];
+      if (LifetimesOverlap(block, other)) {
+        const size_t begin = (*offsets)[placed[j]];
+        taken.push_back(make_pair(begin,
+            begin + AlignUp(other.size, alignment)));
+      }
+    }
+    std::sort(taken.begin(), taken.end());
+    // Best fit: the smallest gap between taken ranges that holds the block,
+    // falling back to the end of the last taken range.
+    size_t best_offset = 0;
+    size_t best_gap = 0;
+    bool found = false;
+    size_t cursor = 0;
+    for (int j = 0; j < taken.size(); ++j) {
+      if (taken[j].first > cursor) {
+        const size_t gap = taken[j].first - cursor;
+        if (gap >= size && (!found || gap < best_gap)) {
+          best_offset = cursor;
+          best_gap = gap;
+          found = true;
+        }
+      }
+      cursor = std::max(cursor, taken[j].second);
+    }
+    if (!found) {
+      best_offset = cursor;
+    }
+    (*offsets)[order[i]] = best_offset;
+    total_size = std::max(total_size, best_offset + size);
+    placed.push_back(order[i]);
+  }
+  return total_size;
+}
+
+size_t PeakLiveBytes(const vector<MemoryBlock>& blocks) {
+  int num_steps = 0;
+  for (int i = 0; i < blocks.size(); ++i) {
+    CHECK_GE(blocks[i].first, 0);
+    num_steps = std::max(num_steps, blocks[i].last + 1);
+  }
+  vector<size_t> live_bytes(num_steps, 0);
+  for (int i = 0; i < blocks.size(); ++i) {
+    for (int step = blocks[i].first; step <= blocks[i].last; ++step) {
+      live_bytes[step] += blocks[i].size;
+    }
+  }
+  size_t peak = 0;
+  for (int step = 0; step < num_steps; ++step) {
+    peak = std::max(peak, live_bytes[step]);
+  }
+  return peak;
+}
+
+}  // namespace caffe
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "caffe/util/int8_gemm.hpp"
+#include "caffe/util/quantization.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void CalibrateQuantization(Net<Dtype>* net, const int iterations,
+    NetParameter* quantized) {
+  CHECK_GT(iterations, 0);
+  const vector<shared_ptr<Layer<Dtype> > >& layers = net->layers();
+  std::map<string, Dtype> ranges;
+  for (int iter = 0; iter < iterations; ++iter) {
+    // One layer at a time, since later layers may overwrite the bottoms:
+    // in place, or in the memory they share.
+    for (int i = 0; i < layers.size(); ++i) {
+      net->ForwardFromTo(i, i);
+      const string type = layers[i]->type();
+      if (type != "Convolution" && type != "InnerProduct") {
+        continue;
+      }
+      Dtype& range = ranges[net->layer_names()[i]];
+      const vector<Blob<Dtype>*>& bottom = net->bottom_vecs()[i];
+      for (int j = 0; j < bottom.size(); ++j) {
+        range = std::max(range,
+            int8_max_abs(bottom[j]->count(), bottom[j]->cpu_data()));
+      }
+    }
+  }
+  net->ToProto(quantized);
+  for (int i = 0; i < quantized->layer_size(); ++i) {
+    LayerParameter* layer_param = quantized->mutable_layer(i);
+    typename std::map<string, Dtype>::const_iterator it =
+        ranges.find(layer_param->name());
+    if (it == ranges.end()) {
+      continue;
+    }
+    QuantizationParameter* quantization_param =
+        layer_param->mutable_quantization_param();
+    quantization_param->set_precision(QuantizationParameter_Precision_INT8);
+    quantization_param->set_bottom_range(it->second);
+    LOG(INFO) << "Quantizing layer " << layer_param->name()
+        << " to INT8 over [-" << it->second << ", " << it->second << "]";
+  }
+}
+
+template <typename Dtype>
+vector<QuantizationError> CompareQuantizedNet(Net<Dtype>* reference,
+    Net<Dtype>* quantized, const int iterations) {
+  CHECK_GT(iterations, 0);
+  int start = 0;
+  while (start < quantized->layers().size() &&
+         quantized->bottom_vecs()[start].empty()) {
+    ++start;
+  }
+  CHECK_LT(start, quantized->layers().size()) << "Nothing to compare.";
+  const int num_outputs = quantized->num_outputs();
+  vector<QuantizationError> errors(num_outputs);
+  vector<double> reference_sum(num_outputs, 0), quantized_sum(num_outputs, 0);
+  vector<double> diff_norm(num_outputs, 0), reference_norm(num_outputs, 0);
+  vector<int> count(num_outputs, 0);
+  for (int iter = 0; iter < iterations; ++iter) {
+    reference->Forward();
+    for (int i = 0; i < start; ++i) {
+      for (int j = 0; j < quantized->top_vecs()[i].size(); ++j) {
+        const string& name =
+            quantized->blob_names()[quantized->top_ids(i)[j]];
+        CHECK(reference->has_blob(name)) << "The reference net has no "
+            << "input " << name;
+        quantized->top_vecs()[i][j]->CopyFrom(*reference->blob_by_name(name),
+            false, true);
+      }
+    }
+    quantized->ForwardFrom(start);
+    for (int k = 0; k < num_outputs; ++k) {
+      QuantizationError& error = errors[k];
+      error.blob_name =
+          quantized->blob_names()[quantized->output_blob_indices()[k]];
+      CHECK(reference->has_blob(error.blob_name)) << "The reference net has "
+          << "no output " << error.blob_name;
+      const Blob<Dtype>& expected = *reference->blob_by_name(error.blob_name);
+      const Blob<Dtype>& actual = *quantized->output_blobs()[k];
+      CHECK_EQ(expected.count(), actual.count());
+      const Dtype* expected_data = expected.cpu_data();
+      const Dtype* actual_data = actual.cpu_data();
+      for (int n = 0; n < actual.count(); ++n) {
+        const double diff = actual_data[n] - expected_data[n];
+        error.max_abs_diff = std::max(error.max_abs_diff, std::fabs(diff));
+        diff_norm[k] += diff * diff;
+        reference_norm[k] += expected_data[n] * expected_data[n];
+        reference_sum[k] += expected_data[n];
+        quantized_sum[k] += actual_data[n];
+      }
+      count[k] += actual.count();
+    }
+  }
+  for (int k = 0; k < num_outputs; ++k) {
+    if (count[k] > 0) {
+      errors[k].reference_mean = reference_sum[k] / count[k];
+      errors[k].quantized_mean = quantized_sum[k] / count[k];
+    }
+    errors[k].relative_error = reference_norm[k] > 0 ?
+        std::sqrt(diff_norm[k] / reference_norm[k]) : std::sqrt(diff_norm[k]);
+  }
+  return errors;
+}
+
+// Explicit instantiation
+template void CalibrateQuantization<float>(Net<float>* net,
+    const int iterations, NetParameter* quantized);
+template void CalibrateQuantization<double>(Net<double>* net,
+    const int iterations, NetParameter* quantized);
+template vector<QuantizationError> CompareQuantizedNet<float>(
+    Net<float>* reference, Net<float>* quantized, const int iterations);
+template vector<QuantizationError> CompareQuantizedNet<double>(
+    Net<double>* reference, Net<double>* quantized, const int iterations);
+
+}  // namespace caffe
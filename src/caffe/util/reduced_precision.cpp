@@ -0,0 +1,121 @@
+#include "caffe/common.hpp"
+#include "caffe/util/reduced_precision.hpp"
+#include "caffe/util/simd_math.hpp"
+
+// As in simd_math.cpp, the F16C kernels are compiled for their instruction
+// set with function attributes and only run if the CPU has it.
+#if defined(__GNUC__) && !defined(__CUDACC__) && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ >= 5)
+#define CAFFE_F16C_X86
+#include <immintrin.h>
+#define CAFFE_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+
+namespace caffe {
+
+namespace {
+
+#ifdef CAFFE_F16C_X86
+
+bool UseF16c() {
+  // Every CPU with AVX2 has F16C; follow the ISA the kernels dispatch to, so
+  // set_simd_isa(SIMD_SCALAR) covers the scalar path too.
+  static const bool f16c = __builtin_cpu_supports("f16c");
+  return f16c && simd_isa() >= SIMD_AVX2;
+}
+
+CAFFE_TARGET_F16C int F16cReduce(const int n, const float* x, uint16_t* y) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), _mm256_cvtps_ph(
+        _mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT));
+  }
+  return i;
+}
+
+CAFFE_TARGET_F16C int F16cExpand(const int n, const uint16_t* x, float* y) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(y + i, _mm256_cvtph_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i))));
+  }
+  return i;
+}
+
+#endif  // CAFFE_F16C_X86
+
+// The number of leading values converted by a vector kernel.
+template <typename Dtype>
+int VectorReduceFp16(const int n, const Dtype* x, uint16_t* y) {
+  return 0;
+}
+
+template <typename Dtype>
+int VectorExpandFp16(const int n, const uint16_t* x, Dtype* y) {
+  return 0;
+}
+
+#ifdef CAFFE_F16C_X86
+template <>
+int VectorReduceFp16<float>(const int n, const float* x, uint16_t* y) {
+  return UseF16c() ? F16cReduce(n, x, y) : 0;
+}
+
+template <>
+int VectorExpandFp16<float>(const int n, const uint16_t* x, float* y) {
+  return UseF16c() ? F16cExpand(n, x, y) : 0;
+}
+#endif
+
+}  // namespace
+
+template <typename Dtype>
+void caffe_cpu_reduce_precision(const int n, const Dtype* x,
+    const StoragePrecision precision, uint16_t* y) {
+  switch (precision) {
+  case FP16:
+    for (int i = VectorReduceFp16(n, x, y); i < n; ++i) {
+      y[i] = float_to_fp16(static_cast<float>(x[i]));
+    }
+    break;
+  case BF16:
+    for (int i = 0; i < n; ++i) {
+      y[i] = float_to_bf16(static_cast<float>(x[i]));
+    }
+    break;
+  default:
+    LOG(FATAL) << "Not a 16-bit storage precision: " << precision;
+  }
+}
+
+template <typename Dtype>
+void caffe_cpu_expand_precision(const int n, const uint16_t* x,
+    const StoragePrecision precision, Dtype* y) {
+  switch (precision) {
+  case FP16:
+    for (int i = VectorExpandFp16(n, x, y); i < n; ++i) {
+      y[i] = fp16_to_float(x[i]);
+    }
+    break;
+  case BF16:
+    for (int i = 0; i < n; ++i) {
+      y[i] = bf16_to_float(x[i]);
+    }
+    break;
+  default:
+    LOG(FATAL) << "Not a 16-bit storage precision: " << precision;
+  }
+}
+
+// Explicit instantiation
+template void caffe_cpu_reduce_precision<float>(const int n, const float* x,
+    const StoragePrecision precision, uint16_t* y);
+template void caffe_cpu_reduce_precision<double>(const int n,
+    const double* x, const StoragePrecision precision, uint16_t* y);
+template void caffe_cpu_expand_precision<float>(const int n,
+    const uint16_t* x, const StoragePrecision precision, float* y);
+template void caffe_cpu_expand_precision<double>(const int n,
+    const uint16_t* x, const StoragePrecision precision, double* y);
+
+}  // namespace caffe
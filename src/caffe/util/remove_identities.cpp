@@ -0,0 +1,144 @@
+#include <string>
+#include <vector>
+
+#include "caffe/common.hpp"
+#include "caffe/util/remove_identities.hpp"
+
+namespace caffe {
+
+namespace {
+
+bool Reads(const LayerParameter& layer_param, const string& blob_name) {
+  for (int i = 0; i < layer_param.bottom_size(); ++i) {
+    if (layer_param.bottom(i) == blob_name) { return true; }
+  }
+  return false;
+}
+
+bool Writes(const LayerParameter& layer_param, const string& blob_name) {
+  for (int i = 0; i < layer_param.top_size(); ++i) {
+    if (layer_param.top(i) == blob_name) { return true; }
+  }
+  return false;
+}
+
+// Whether the layer copies its one bottom to each of its tops in the
+// forward pass.
+bool IsIdentity(const LayerParameter& layer_param, const Phase phase) {
+  if (layer_param.bottom_size() != 1 || layer_param.top_size() == 0 ||
+      layer_param.loss_weight_size() > 0) {
+    return false;
+  }
+  if (layer_param.type() == "Dropout") {
+    return phase == TEST && layer_param.top_size() == 1;
+  }
+  return layer_param.type() == "Split";
+}
+
+// Whether a layer after the one at layer_id reads or writes the blob.
+bool ReadAfter(const NetParameter& param, const string& blob_name,
+    const int layer_id) {
+  for (int i = layer_id + 1; i < param.layer_size(); ++i) {
+    if (Reads(param.layer(i), blob_name)) { return true; }
+  }
+  return false;
+}
+
+bool WrittenAfter(const NetParameter& param, const string& blob_name,
+    const int layer_id) {
+  for (int i = layer_id + 1; i < param.layer_size(); ++i) {
+    if (Writes(param.layer(i), blob_name)) { return true; }
+  }
+  return false;
+}
+
+// Makes the layers after the one at layer_id use the blob to in place of
+// from, up to a layer that writes a new blob named from.
+void RenameAfter(const string& from, const string& to, const int layer_id,
+    NetParameter* param) {
+  for (int i = layer_id + 1; i < param->layer_size(); ++i) {
+    LayerParameter* layer_param = param->mutable_layer(i);
+    if (!Reads(*layer_param, from)) {
+      if (Writes(*layer_param, from)) { return; }
+      continue;
+    }
+    for (int j = 0; j < layer_param->bottom_size(); ++j) {
+      if (layer_param->bottom(j) == from) { layer_param->set_bottom(j, to); }
+    }
+    for (int j = 0; j < layer_param->top_size(); ++j) {
+      if (layer_param->top(j) == from) { layer_param->set_top(j, to); }
+    }
+  }
+}
+
+}  // namespace
+
+void RemoveIdentityLayers(const NetParameter& param,
+    NetParameter* param_removed) {
+  // The layers are renamed in this copy as the earlier ones are removed.
+  NetParameter net_param(param);
+  vector<bool> removed(param.layer_size(), false);
+  for (int i = 0; i < net_param.layer_size(); ++i) {
+    const LayerParameter& layer_param = net_param.layer(i);
+    if (layer_param.type() == "Silence") {
+      // Each bottom must be read as it is here by another layer, between
+      // the last layer to write it and this one, or after this one.
+      bool read_by_others = layer_param.bottom_size() > 0;
+      for (int j = 0; j < layer_param.bottom_size(); ++j) {
+        const string& bottom = layer_param.bottom(j);
+        bool read = ReadAfter(net_param, bottom, i);
+        for (int k = i - 1; !read && k >= 0; --k) {
+          if (removed[k]) { continue; }
+          if (Writes(net_param.layer(k), bottom)) { break; }
+          read = Reads(net_param.layer(k), bottom);
+        }
+        read_by_others &= read;
+      }
+      if (read_by_others) {
+        LOG(INFO) << "Removing Silence layer " << layer_param.name()
+            << ": its bottoms have other readers";
+        removed[i] = true;
+      }
+      continue;
+    }
+    const Phase phase = layer_param.has_phase() ? layer_param.phase() :
+        param.state().phase();
+    if (!IsIdentity(layer_param, phase)) {
+      continue;
+    }
+    const string& bottom = layer_param.bottom(0);
+    if (layer_param.top_size() == 1 && layer_param.top(0) == bottom) {
+      LOG(INFO) << "Removing " << layer_param.type() << " layer "
+          << layer_param.name() << ", which works in place";
+      removed[i] = true;
+      continue;
+    }
+    bool removable = !WrittenAfter(net_param, bottom, i);
+    for (int j = 0; removable && j < layer_param.top_size(); ++j) {
+      const string& top = layer_param.top(j);
+      // Every top must have a reader; a top written again in place must not
+      // be seen through the bottom or the other tops.
+      removable = top != bottom && ReadAfter(net_param, top, i) &&
+          (!WrittenAfter(net_param, top, i) ||
+          (layer_param.top_size() == 1 && !ReadAfter(net_param, bottom, i)));
+    }
+    if (!removable) {
+      continue;
+    }
+    LOG(INFO) << "Removing " << layer_param.type() << " layer "
+        << layer_param.name() << ": its readers take " << bottom;
+    for (int j = 0; j < layer_param.top_size(); ++j) {
+      RenameAfter(layer_param.top(j), bottom, i, &net_param);
+    }
+    removed[i] = true;
+  }
+  param_removed->CopyFrom(net_param);
+  param_removed->clear_layer();
+  for (int i = 0; i < net_param.layer_size(); ++i) {
+    if (!removed[i]) {
+      param_removed->add_layer()->CopyFrom(net_param.layer(i));
+    }
+  }
+}
+
+}  // namespace caffe
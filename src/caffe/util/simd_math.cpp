@@ -0,0 +1,680 @@
+#include <cmath>
+#include <limits>
+
+#include "caffe/util/simd_math.hpp"
+
+// The vector kernels are compiled for their instruction set with function
+// attributes, so the rest of the build needs no -mavx2/-mavx512f flags and
+// the binary still runs on older CPUs.
+#if defined(__GNUC__) && !defined(__CUDACC__) && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ >= 5)
+#define CAFFE_SIMD_X86
+#include <immintrin.h>
+#define CAFFE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define CAFFE_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+namespace caffe {
+
+namespace {
+
+// Scalar reference operations.
+struct AddOp {
+  template <typename Dtype>
+  Dtype operator()(const Dtype a, const Dtype b) const { return a + b; }
+};
+struct SubOp {
+  template <typename Dtype>
+  Dtype operator()(const Dtype a, const Dtype b) const { return a - b; }
+};
+struct MulOp {
+  template <typename Dtype>
+  Dtype operator()(const Dtype a, const Dtype b) const { return a * b; }
+};
+struct DivOp {
+  template <typename Dtype>
+  Dtype operator()(const Dtype a, const Dtype b) const { return a / b; }
+};
+struct SqrOp {
+  template <typename Dtype>
+  Dtype operator()(const Dtype a) const { return a * a; }
+};
+struct AbsOp {
+  template <typename Dtype>
+  Dtype operator()(const Dtype a) const { return std::fabs(a); }
+};
+struct ExpOp {
+  template <typename Dtype>
+  Dtype operator()(const Dtype a) const { return std::exp(a); }
+};
+struct LnOp {
+  template <typename Dtype>
+  Dtype operator()(const Dtype a) const { return std::log(a); }
+};
+
+template <typename Dtype, typename Op>
+void ScalarBinary(const int n, const Dtype* a, const Dtype* b, Dtype* y,
+    const Op& op) {
+  for (int i = 0; i < n; ++i) {
+    y[i] = op(a[i], b[i]);
+  }
+}
+
+template <typename Dtype, typename Op>
+void ScalarUnary(const int n, const Dtype* a, Dtype* y, const Op& op) {
+  for (int i = 0; i < n; ++i) {
+    y[i] = op(a[i]);
+  }
+}
+
+template <typename Dtype>
+void ScalarPowx(const int n, const Dtype* a, const Dtype b, Dtype* y) {
+  for (int i = 0; i < n; ++i) {
+    y[i] = std::pow(a[i], b);
+  }
+}
+
+#ifdef CAFFE_SIMD_X86
+
+// Polynomial approximations of expf and logf after Cephes. exp(x) is reduced
+// to 2^n * exp(r) with |r| <= ln(2)/2; 2^n is applied as two factors so that
+// results near overflow and in the denormal range come out right. log(x) is
+// reduced to n * ln(2) + log(m) with m in [sqrt(1/2), sqrt(2)).
+const float kExpLo = -104.f;  // below this exp rounds to 0
+const float kExpHi = 88.8f;   // above this exp overflows to inf
+const float kLog2e = 1.44269504088896341f;
+const float kLn2Hi = 0.693359375f;
+const float kLn2Lo = -2.12194440e-4f;
+const float kExpP0 = 1.9875691500e-4f;
+const float kExpP1 = 1.3981999507e-3f;
+const float kExpP2 = 8.3334519073e-3f;
+const float kExpP3 = 4.1665795894e-2f;
+const float kExpP4 = 1.6666665459e-1f;
+const float kExpP5 = 5.0000001201e-1f;
+const float kSqrtHalf = 0.707106781186547524f;
+const float kLogP0 = 7.0376836292e-2f;
+const float kLogP1 = -1.1514610310e-1f;
+const float kLogP2 = 1.1676998740e-1f;
+const float kLogP3 = -1.2420140846e-1f;
+const float kLogP4 = 1.4249322787e-1f;
+const float kLogP5 = -1.6668057665e-1f;
+const float kLogP6 = 2.0000714765e-1f;
+const float kLogP7 = -2.4999993993e-1f;
+const float kLogP8 = 3.3333331174e-1f;
+const float kDenormalScale = 8388608.f;  // 2^23
+
+// ---[ AVX2
+
+CAFFE_TARGET_AVX2 inline __m256 Avx2ExpPs(const __m256 x) {
+  const __m256 clamped = _mm256_min_ps(
+      _mm256_max_ps(x, _mm256_set1_ps(kExpLo)), _mm256_set1_ps(kExpHi));
+  const __m256 fx = _mm256_round_ps(
+      _mm256_mul_ps(clamped, _mm256_set1_ps(kLog2e)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m256 r = _mm256_fnmadd_ps(fx, _mm256_set1_ps(kLn2Hi), clamped);
+  r = _mm256_fnmadd_ps(fx, _mm256_set1_ps(kLn2Lo), r);
+  __m256 p = _mm256_set1_ps(kExpP0);
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP1));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP2));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP3));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP4));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kExpP5));
+  p = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r),
+      _mm256_add_ps(r, _mm256_set1_ps(1.f)));
+  const __m256i n = _mm256_cvtps_epi32(fx);
+  const __m256i n1 = _mm256_srai_epi32(n, 1);
+  const __m256i n2 = _mm256_sub_epi32(n, n1);
+  const __m256i bias = _mm256_set1_epi32(127);
+  const __m256 scale1 = _mm256_castsi256_ps(
+      _mm256_slli_epi32(_mm256_add_epi32(n1, bias), 23));
+  const __m256 scale2 = _mm256_castsi256_ps(
+      _mm256_slli_epi32(_mm256_add_epi32(n2, bias), 23));
+  const __m256 result = _mm256_mul_ps(_mm256_mul_ps(p, scale1), scale2);
+  // NaN in, NaN out.
+  return _mm256_blendv_ps(result, x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+}
+
+CAFFE_TARGET_AVX2 inline __m256 Avx2LnPs(const __m256 x) {
+  const __m256 one = _mm256_set1_ps(1.f);
+  // Bring denormals into the normal range first.
+  const __m256 denormal = _mm256_cmp_ps(x,
+      _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+  const __m256 scaled = _mm256_blendv_ps(x,
+      _mm256_mul_ps(x, _mm256_set1_ps(kDenormalScale)), denormal);
+  const __m256 exponent_bias = _mm256_blendv_ps(_mm256_set1_ps(126.f),
+      _mm256_set1_ps(126.f + 23.f), denormal);
+  const __m256i bits = _mm256_castps_si256(scaled);
+  __m256 e = _mm256_sub_ps(
+      _mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 23)), exponent_bias);
+  // Mantissa in [0.5, 1), then shifted to [sqrt(1/2) - 1, sqrt(2) - 1).
+  __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+      _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+      _mm256_set1_epi32(0x3f000000)));
+  const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(kSqrtHalf),
+      _CMP_LT_OQ);
+  e = _mm256_sub_ps(e, _mm256_and_ps(small, one));
+  m = _mm256_add_ps(_mm256_sub_ps(m, one), _mm256_and_ps(small, m));
+  const __m256 z = _mm256_mul_ps(m, m);
+  __m256 p = _mm256_set1_ps(kLogP0);
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP1));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP2));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP3));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP4));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP5));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP6));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP7));
+  p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(kLogP8));
+  p = _mm256_mul_ps(_mm256_mul_ps(p, m), z);
+  p = _mm256_fmadd_ps(e, _mm256_set1_ps(kLn2Lo), p);
+  p = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), p);
+  __m256 result = _mm256_fmadd_ps(e, _mm256_set1_ps(kLn2Hi),
+      _mm256_add_ps(m, p));
+  // log(0) = -inf, log(inf) = inf, log(x < 0) = log(NaN) = NaN.
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  result = _mm256_blendv_ps(result, _mm256_sub_ps(zero, inf),
+      _mm256_cmp_ps(x, zero, _CMP_EQ_OQ));
+  result = _mm256_blendv_ps(result, inf, _mm256_cmp_ps(x, inf, _CMP_EQ_OQ));
+  return _mm256_blendv_ps(result,
+      _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN()),
+      _mm256_cmp_ps(x, zero, _CMP_NGE_UQ));
+}
+
+struct Avx2AddPs {
+  CAFFE_TARGET_AVX2 __m256 operator()(const __m256 a, const __m256 b) const {
+    return _mm256_add_ps(a, b);
+  }
+};
+struct Avx2SubPs {
+  CAFFE_TARGET_AVX2 __m256 operator()(const __m256 a, const __m256 b) const {
+    return _mm256_sub_ps(a, b);
+  }
+};
+struct Avx2MulPs {
+  CAFFE_TARGET_AVX2 __m256 operator()(const __m256 a, const __m256 b) const {
+    return _mm256_mul_ps(a, b);
+  }
+};
+struct Avx2DivPs {
+  CAFFE_TARGET_AVX2 __m256 operator()(const __m256 a, const __m256 b) const {
+    return _mm256_div_ps(a, b);
+  }
+};
+struct Avx2SqrPs {
+  CAFFE_TARGET_AVX2 __m256 operator()(const __m256 a) const {
+    return _mm256_mul_ps(a, a);
+  }
+};
+struct Avx2AbsPs {
+  CAFFE_TARGET_AVX2 __m256 operator()(const __m256 a) const {
+    return _mm256_and_ps(a,
+        _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+  }
+};
+struct Avx2ExpPsOp {
+  CAFFE_TARGET_AVX2 __m256 operator()(const __m256 a) const {
+    return Avx2ExpPs(a);
+  }
+};
+struct Avx2LnPsOp {
+  CAFFE_TARGET_AVX2 __m256 operator()(const __m256 a) const {
+    return Avx2LnPs(a);
+  }
+};
+struct Avx2AddPd {
+  CAFFE_TARGET_AVX2 __m256d operator()(const __m256d a, const __m256d b)
+      const { return _mm256_add_pd(a, b); }
+};
+struct Avx2SubPd {
+  CAFFE_TARGET_AVX2 __m256d operator()(const __m256d a, const __m256d b)
+      const { return _mm256_sub_pd(a, b); }
+};
+struct Avx2MulPd {
+  CAFFE_TARGET_AVX2 __m256d operator()(const __m256d a, const __m256d b)
+      const { return _mm256_mul_pd(a, b); }
+};
+struct Avx2DivPd {
+  CAFFE_TARGET_AVX2 __m256d operator()(const __m256d a, const __m256d b)
+      const { return _mm256_div_pd(a, b); }
+};
+struct Avx2SqrPd {
+  CAFFE_TARGET_AVX2 __m256d operator()(const __m256d a) const {
+    return _mm256_mul_pd(a, a);
+  }
+};
+struct Avx2AbsPd {
+  CAFFE_TARGET_AVX2 __m256d operator()(const __m256d a) const {
+    return _mm256_and_pd(a, _mm256_castsi256_pd(
+        _mm256_set1_epi64x(0x7fffffffffffffffLL)));
+  }
+};
+
+// Masks selecting the first rest lanes, for the loop tails.
+CAFFE_TARGET_AVX2 inline __m256i Avx2TailMaskPs(const int rest) {
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32(rest),
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+CAFFE_TARGET_AVX2 inline __m256i Avx2TailMaskPd(const int rest) {
+  return _mm256_cmpgt_epi64(_mm256_set1_epi64x(rest),
+      _mm256_setr_epi64x(0, 1, 2, 3));
+}
+
+template <typename Op>
+CAFFE_TARGET_AVX2 void Avx2Binary(const int n, const float* a, const float* b,
+    float* y, const Op& op) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(y + i,
+        op(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+  }
+  if (i < n) {
+    const __m256i mask = Avx2TailMaskPs(n - i);
+    _mm256_maskstore_ps(y + i, mask, op(_mm256_maskload_ps(a + i, mask),
+        _mm256_maskload_ps(b + i, mask)));
+  }
+}
+
+template <typename Op>
+CAFFE_TARGET_AVX2 void Avx2Binary(const int n, const double* a,
+    const double* b, double* y, const Op& op) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(y + i,
+        op(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+  }
+  if (i < n) {
+    const __m256i mask = Avx2TailMaskPd(n - i);
+    _mm256_maskstore_pd(y + i, mask, op(_mm256_maskload_pd(a + i, mask),
+        _mm256_maskload_pd(b + i, mask)));
+  }
+}
+
+template <typename Op>
+CAFFE_TARGET_AVX2 void Avx2Unary(const int n, const float* a, float* y,
+    const Op& op) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(y + i, op(_mm256_loadu_ps(a + i)));
+  }
+  if (i < n) {
+    const __m256i mask = Avx2TailMaskPs(n - i);
+    _mm256_maskstore_ps(y + i, mask, op(_mm256_maskload_ps(a + i, mask)));
+  }
+}
+
+template <typename Op>
+CAFFE_TARGET_AVX2 void Avx2Unary(const int n, const double* a, double* y,
+    const Op& op) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(y + i, op(_mm256_loadu_pd(a + i)));
+  }
+  if (i < n) {
+    const __m256i mask = Avx2TailMaskPd(n - i);
+    _mm256_maskstore_pd(y + i, mask, op(_mm256_maskload_pd(a + i, mask)));
+  }
+}
+
+// pow(a, b) as exp(b * log(a)) for blocks of positive finite a; any other
+// block, and the tail, goes through pow() for its special cases.
+CAFFE_TARGET_AVX2 void Avx2Powx(const int n, const float* a, const float b,
+    float* y) {
+  const __m256 vb = _mm256_set1_ps(b);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 va = _mm256_loadu_ps(a + i);
+    const __m256 valid = _mm256_and_ps(_mm256_cmp_ps(va, zero, _CMP_GT_OQ),
+        _mm256_cmp_ps(va, inf, _CMP_LT_OQ));
+    if (_mm256_movemask_ps(valid) == 0xff) {
+      _mm256_storeu_ps(y + i, Avx2ExpPs(_mm256_mul_ps(vb, Avx2LnPs(va))));
+    } else {
+      ScalarPowx(8, a + i, b, y + i);
+    }
+  }
+  ScalarPowx(n - i, a + i, b, y + i);
+}
+
+// ---[ AVX-512
+
+CAFFE_TARGET_AVX512 inline __m512 Avx512ExpPs(const __m512 x) {
+  const __m512 clamped = _mm512_min_ps(
+      _mm512_max_ps(x, _mm512_set1_ps(kExpLo)), _mm512_set1_ps(kExpHi));
+  const __m512 fx = _mm512_roundscale_ps(
+      _mm512_mul_ps(clamped, _mm512_set1_ps(kLog2e)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m512 r = _mm512_fnmadd_ps(fx, _mm512_set1_ps(kLn2Hi), clamped);
+  r = _mm512_fnmadd_ps(fx, _mm512_set1_ps(kLn2Lo), r);
+  __m512 p = _mm512_set1_ps(kExpP0);
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP1));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP2));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP3));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP4));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP5));
+  p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r),
+      _mm512_add_ps(r, _mm512_set1_ps(1.f)));
+  const __m512i n = _mm512_cvtps_epi32(fx);
+  const __m512i n1 = _mm512_srai_epi32(n, 1);
+  const __m512i n2 = _mm512_sub_epi32(n, n1);
+  const __m512i bias = _mm512_set1_epi32(127);
+  const __m512 scale1 = _mm512_castsi512_ps(
+      _mm512_slli_epi32(_mm512_add_epi32(n1, bias), 23));
+  const __m512 scale2 = _mm512_castsi512_ps(
+      _mm512_slli_epi32(_mm512_add_epi32(n2, bias), 23));
+  const __m512 result = _mm512_mul_ps(_mm512_mul_ps(p, scale1), scale2);
+  return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q),
+      result, x);
+}
+
+CAFFE_TARGET_AVX512 inline __m512 Avx512LnPs(const __m512 x) {
+  const __m512 one = _mm512_set1_ps(1.f);
+  const __mmask16 denormal = _mm512_cmp_ps_mask(x,
+      _mm512_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+  const __m512 scaled = _mm512_mask_mul_ps(x, denormal, x,
+      _mm512_set1_ps(kDenormalScale));
+  const __m512 exponent_bias = _mm512_mask_blend_ps(denormal,
+      _mm512_set1_ps(126.f), _mm512_set1_ps(126.f + 23.f));
+  const __m512i bits = _mm512_castps_si512(scaled);
+  __m512 e = _mm512_sub_ps(
+      _mm512_cvtepi32_ps(_mm512_srli_epi32(bits, 23)), exponent_bias);
+  __m512 m = _mm512_castsi512_ps(_mm512_or_si512(
+      _mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)),
+      _mm512_set1_epi32(0x3f000000)));
+  const __mmask16 small = _mm512_cmp_ps_mask(m, _mm512_set1_ps(kSqrtHalf),
+      _CMP_LT_OQ);
+  e = _mm512_mask_sub_ps(e, small, e, one);
+  const __m512 m_minus_one = _mm512_sub_ps(m, one);
+  m = _mm512_mask_add_ps(m_minus_one, small, m_minus_one, m);
+  const __m512 z = _mm512_mul_ps(m, m);
+  __m512 p = _mm512_set1_ps(kLogP0);
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP1));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP2));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP3));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP4));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP5));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP6));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP7));
+  p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(kLogP8));
+  p = _mm512_mul_ps(_mm512_mul_ps(p, m), z);
+  p = _mm512_fmadd_ps(e, _mm512_set1_ps(kLn2Lo), p);
+  p = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), p);
+  __m512 result = _mm512_fmadd_ps(e, _mm512_set1_ps(kLn2Hi),
+      _mm512_add_ps(m, p));
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 inf = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+  result = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, zero, _CMP_EQ_OQ),
+      result, _mm512_sub_ps(zero, inf));
+  result = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, inf, _CMP_EQ_OQ),
+      result, inf);
+  return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, zero, _CMP_NGE_UQ),
+      result, _mm512_set1_ps(std::numeric_limits<float>::quiet_NaN()));
+}
+
+struct Avx512AddPs {
+  CAFFE_TARGET_AVX512 __m512 operator()(const __m512 a, const __m512 b)
+      const { return _mm512_add_ps(a, b); }
+};
+struct Avx512SubPs {
+  CAFFE_TARGET_AVX512 __m512 operator()(const __m512 a, const __m512 b)
+      const { return _mm512_sub_ps(a, b); }
+};
+struct Avx512MulPs {
+  CAFFE_TARGET_AVX512 __m512 operator()(const __m512 a, const __m512 b)
+      const { return _mm512_mul_ps(a, b); }
+};
+struct Avx512DivPs {
+  CAFFE_TARGET_AVX512 __m512 operator()(const __m512 a, const __m512 b)
+      const { return _mm512_div_ps(a, b); }
+};
+struct Avx512SqrPs {
+  CAFFE_TARGET_AVX512 __m512 operator()(const __m512 a) const {
+    return _mm512_mul_ps(a, a);
+  }
+};
+struct Avx512AbsPs {
+  CAFFE_TARGET_AVX512 __m512 operator()(const __m512 a) const {
+    return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a),
+        _mm512_set1_epi32(0x7fffffff)));
+  }
+};
+struct Avx512ExpPsOp {
+  CAFFE_TARGET_AVX512 __m512 operator()(const __m512 a) const {
+    return Avx512ExpPs(a);
+  }
+};
+struct Avx512LnPsOp {
+  CAFFE_TARGET_AVX512 __m512 operator()(const __m512 a) const {
+    return Avx512LnPs(a);
+  }
+};
+struct Avx512AddPd {
+  CAFFE_TARGET_AVX512 __m512d operator()(const __m512d a, const __m512d b)
+      const { return _mm512_add_pd(a, b); }
+};
+struct Avx512SubPd {
+  CAFFE_TARGET_AVX512 __m512d operator()(const __m512d a, const __m512d b)
+      const { return _mm512_sub_pd(a, b); }
+};
+struct Avx512MulPd {
+  CAFFE_TARGET_AVX512 __m512d operator()(const __m512d a, const __m512d b)
+      const { return _mm512_mul_pd(a, b); }
+};
+struct Avx512DivPd {
+  CAFFE_TARGET_AVX512 __m512d operator()(const __m512d a, const __m512d b)
+      const { return _mm512_div_pd(a, b); }
+};
+struct Avx512SqrPd {
+  CAFFE_TARGET_AVX512 __m512d operator()(const __m512d a) const {
+    return _mm512_mul_pd(a, a);
+  }
+};
+struct Avx512AbsPd {
+  CAFFE_TARGET_AVX512 __m512d operator()(const __m512d a) const {
+    return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a),
+        _mm512_set1_epi64(0x7fffffffffffffffLL)));
+  }
+};
+
+template <typename Op>
+CAFFE_TARGET_AVX512 void Avx512Binary(const int n, const float* a,
+    const float* b, float* y, const Op& op) {
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(y + i,
+        op(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+  }
+  if (i < n) {
+    const __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+    _mm512_mask_storeu_ps(y + i, mask, op(_mm512_maskz_loadu_ps(mask, a + i),
+        _mm512_maskz_loadu_ps(mask, b + i)));
+  }
+}
+
+template <typename Op>
+CAFFE_TARGET_AVX512 void Avx512Binary(const int n, const double* a,
+    const double* b, double* y, const Op& op) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(y + i,
+        op(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+  }
+  if (i < n) {
+    const __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+    _mm512_mask_storeu_pd(y + i, mask, op(_mm512_maskz_loadu_pd(mask, a + i),
+        _mm512_maskz_loadu_pd(mask, b + i)));
+  }
+}
+
+template <typename Op>
+CAFFE_TARGET_AVX512 void Avx512Unary(const int n, const float* a, float* y,
+    const Op& op) {
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(y + i, op(_mm512_loadu_ps(a + i)));
+  }
+  if (i < n) {
+    const __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+    _mm512_mask_storeu_ps(y + i, mask, op(_mm512_maskz_loadu_ps(mask, a + i)));
+  }
+}
+
+template <typename Op>
+CAFFE_TARGET_AVX512 void Avx512Unary(const int n, const double* a, double* y,
+    const Op& op) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(y + i, op(_mm512_loadu_pd(a + i)));
+  }
+  if (i < n) {
+    const __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+    _mm512_mask_storeu_pd(y + i, mask, op(_mm512_maskz_loadu_pd(mask, a + i)));
+  }
+}
+
+CAFFE_TARGET_AVX512 void Avx512Powx(const int n, const float* a,
+    const float b, float* y) {
+  const __m512 vb = _mm512_set1_ps(b);
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 inf = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512 va = _mm512_loadu_ps(a + i);
+    const __mmask16 valid = _mm512_cmp_ps_mask(va, zero, _CMP_GT_OQ) &
+        _mm512_cmp_ps_mask(va, inf, _CMP_LT_OQ);
+    if (valid == 0xffff) {
+      _mm512_storeu_ps(y + i,
+          Avx512ExpPs(_mm512_mul_ps(vb, Avx512LnPs(va))));
+    } else {
+      ScalarPowx(16, a + i, b, y + i);
+    }
+  }
+  ScalarPowx(n - i, a + i, b, y + i);
+}
+
+#endif  // CAFFE_SIMD_X86
+
+SimdIsa& CurrentIsa() {
+  static SimdIsa isa = simd_best_isa();
+  return isa;
+}
+
+}  // namespace
+
+SimdIsa simd_best_isa() {
+#ifdef CAFFE_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SIMD_AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SIMD_AVX2;
+  }
+#endif
+  return SIMD_SCALAR;
+}
+
+SimdIsa simd_isa() {
+  return CurrentIsa();
+}
+
+void set_simd_isa(SimdIsa isa) {
+  CHECK_LE(isa, simd_best_isa())
+      << "The instruction set is not supported by this CPU.";
+  CurrentIsa() = isa;
+}
+
+#ifdef CAFFE_SIMD_X86
+#define DISPATCH_SIMD(avx512_call, avx2_call, scalar_call) \
+  switch (CurrentIsa()) { \
+  case SIMD_AVX512: avx512_call; break; \
+  case SIMD_AVX2: avx2_call; break; \
+  default: scalar_call; \
+  }
+#else
+#define DISPATCH_SIMD(avx512_call, avx2_call, scalar_call) scalar_call
+#endif
+
+#define DEFINE_SIMD_BINARY_FUNC(name) \
+  void simd_v##name(const int n, const float* a, const float* b, float* y) { \
+    CHECK_GT(n, 0); CHECK(a); CHECK(b); CHECK(y); \
+    DISPATCH_SIMD(Avx512Binary(n, a, b, y, Avx512##name##Ps()), \
+        Avx2Binary(n, a, b, y, Avx2##name##Ps()), \
+        ScalarBinary(n, a, b, y, name##Op())); \
+  } \
+  void simd_v##name(const int n, const double* a, const double* b, \
+      double* y) { \
+    CHECK_GT(n, 0); CHECK(a); CHECK(b); CHECK(y); \
+    DISPATCH_SIMD(Avx512Binary(n, a, b, y, Avx512##name##Pd()), \
+        Avx2Binary(n, a, b, y, Avx2##name##Pd()), \
+        ScalarBinary(n, a, b, y, name##Op())); \
+  }
+
+DEFINE_SIMD_BINARY_FUNC(Add);
+DEFINE_SIMD_BINARY_FUNC(Sub);
+DEFINE_SIMD_BINARY_FUNC(Mul);
+DEFINE_SIMD_BINARY_FUNC(Div);
+
+#define DEFINE_SIMD_UNARY_FUNC(name) \
+  void simd_v##name(const int n, const float* a, float* y) { \
+    CHECK_GT(n, 0); CHECK(a); CHECK(y); \
+    DISPATCH_SIMD(Avx512Unary(n, a, y, Avx512##name##Ps()), \
+        Avx2Unary(n, a, y, Avx2##name##Ps()), \
+        ScalarUnary(n, a, y, name##Op())); \
+  } \
+  void simd_v##name(const int n, const double* a, double* y) { \
+    CHECK_GT(n, 0); CHECK(a); CHECK(y); \
+    DISPATCH_SIMD(Avx512Unary(n, a, y, Avx512##name##Pd()), \
+        Avx2Unary(n, a, y, Avx2##name##Pd()), \
+        ScalarUnary(n, a, y, name##Op())); \
+  }
+
+DEFINE_SIMD_UNARY_FUNC(Sqr);
+DEFINE_SIMD_UNARY_FUNC(Abs);
+
+void simd_vExp(const int n, const float* a, float* y) {
+  CHECK_GT(n, 0); CHECK(a); CHECK(y);
+  DISPATCH_SIMD(Avx512Unary(n, a, y, Avx512ExpPsOp()),
+      Avx2Unary(n, a, y, Avx2ExpPsOp()),
+      ScalarUnary(n, a, y, ExpOp()));
+}
+
+void simd_vExp(const int n, const double* a, double* y) {
+  CHECK_GT(n, 0); CHECK(a); CHECK(y);
+  ScalarUnary(n, a, y, ExpOp());
+}
+
+void simd_vLn(const int n, const float* a, float* y) {
+  CHECK_GT(n, 0); CHECK(a); CHECK(y);
+  DISPATCH_SIMD(Avx512Unary(n, a, y, Avx512LnPsOp()),
+      Avx2Unary(n, a, y, Avx2LnPsOp()),
+      ScalarUnary(n, a, y, LnOp()));
+}
+
+void simd_vLn(const int n, const double* a, double* y) {
+  CHECK_GT(n, 0); CHECK(a); CHECK(y);
+  ScalarUnary(n, a, y, LnOp());
+}
+
+void simd_vPowx(const int n, const float* a, const float b, float* y) {
+  CHECK_GT(n, 0); CHECK(a); CHECK(y);
+  if (b == 2.f) {
+    simd_vSqr(n, a, y);
+    return;
+  }
+  DISPATCH_SIMD(Avx512Powx(n, a, b, y),
+      Avx2Powx(n, a, b, y),
+      ScalarPowx(n, a, b, y));
+}
+
+void simd_vPowx(const int n, const double* a, const double b, double* y) {
+  CHECK_GT(n, 0); CHECK(a); CHECK(y);
+  if (b == 2.) {
+    simd_vSqr(n, a, y);
+    return;
+  }
+  ScalarPowx(n, a, b, y);
+}
+
+}  // namespace caffe
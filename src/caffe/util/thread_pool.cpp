@@ -0,0 +1,350 @@
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <vector>
+
+#ifdef USE_MKL
+#include <mkl.h>
+#endif
+
+#include "caffe/util/thread_pool.hpp"
+
+#if !defined(USE_MKL) && defined(__GNUC__)
+// OpenBLAS thread controls. They are weak so that Caffe still links against
+// other BLAS libraries, in which case they are NULL.
+extern "C" {
+void openblas_set_num_threads(int num_threads) __attribute__((weak));
+int openblas_get_num_threads() __attribute__((weak));
+}
+#define CAFFE_OPENBLAS_THREADS
+#endif
+
+namespace caffe {
+
+namespace {
+
+// Nesting depth of pool tasks on the current thread.
+boost::thread_specific_ptr<int> parallel_depth;
+
+// Marks the current thread as running pool tasks for its lifetime.
+class ParallelRegion {
+ public:
+  ParallelRegion() {
+    if (!parallel_depth.get()) {
+      parallel_depth.reset(new int(0));
+    }
+    ++*parallel_depth;
+  }
+  ~ParallelRegion() { --*parallel_depth; }
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(ParallelRegion);
+};
+
+// Keeps BLAS calls made on this thread single-threaded for its lifetime, so
+// that BLAS inside pool tasks does not start threads of its own. MKL has a
+// per-thread setting; OpenBLAS only has a process-wide one, which is lowered
+// for the duration of the loop.
+class SerialBlas {
+ public:
+  SerialBlas() {
+#ifdef USE_MKL
+    saved_ = mkl_set_num_threads_local(1);
+#elif defined(CAFFE_OPENBLAS_THREADS)
+    saved_ = 0;
+    if (openblas_set_num_threads && openblas_get_num_threads) {
+      saved_ = openblas_get_num_threads();
+      openblas_set_num_threads(1);
+    }
+#endif
+  }
+  ~SerialBlas() {
+#ifdef USE_MKL
+    mkl_set_num_threads_local(saved_);
+#elif defined(CAFFE_OPENBLAS_THREADS)
+    if (saved_ > 1) {
+      openblas_set_num_threads(saved_);
+    }
+#endif
+  }
+
+ private:
+  int saved_;
+
+  DISABLE_COPY_AND_ASSIGN(SerialBlas);
+};
+
+void RunSerially(int num_tasks, const boost::function<void(int)>& task) {
+  ParallelRegion region;
+  for (int i = 0; i < num_tasks; ++i) {
+    task(i);
+  }
+}
+
+}  // namespace
+
+// The worker threads and the state of the loop being run. A new loop is
+// announced by bumping generation_ under mutex_. The tasks are dealt out as
+// one contiguous share per thread; each share is guarded by its own mutex,
+// so threads only contend when one of them steals.
+class ThreadPool::Workers {
+ public:
+  explicit Workers(int num_workers)
+      : task_(NULL), pending_(0), active_(0), generation_(0), stop_(false) {
+    for (int i = 0; i <= num_workers; ++i) {
+      shares_.push_back(shared_ptr<Share>(new Share()));
+    }
+    for (int i = 0; i < num_workers; ++i) {
+      threads_.push_back(shared_ptr<boost::thread>(
+          new boost::thread(&Workers::Entry, this, i + 1)));
+    }
+  }
+
+  ~Workers() {
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (int i = 0; i < threads_.size(); ++i) {
+      threads_[i]->join();
+    }
+  }
+
+  // Returns false without running anything if another loop is in progress.
+  bool Run(int num_tasks, const boost::function<void(int)>& task) {
+    boost::unique_lock<boost::mutex> run_lock(run_mutex_, boost::try_to_lock);
+    if (!run_lock.owns_lock()) {
+      return false;
+    }
+    ParallelRegion region;
+    SerialBlas serial_blas;
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      const int num_shares = shares_.size();
+      for (int i = 0; i < num_shares; ++i) {
+        Share& share = *shares_[i];
+        boost::lock_guard<boost::mutex> share_lock(share.mutex);
+        share.next = static_cast<int64_t>(num_tasks) * i / num_shares;
+        share.end = static_cast<int64_t>(num_tasks) * (i + 1) / num_shares;
+      }
+      task_ = &task;
+      pending_ = num_tasks;
+      ++generation_;
+    }
+    work_cv_.notify_all();
+    const int done = RunTasks(0, task);
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    pending_ -= done;
+    // Workers still looking for tasks hold on to task_ and the shares, so
+    // wait for them to leave as well.
+    while (pending_ > 0 || active_ > 0) {
+      done_cv_.wait(lock);
+    }
+    task_ = NULL;
+    return true;
+  }
+
+ private:
+  // One thread's share of the loop: tasks [next, end).
+  struct Share {
+    Share() : next(0), end(0) {}
+    boost::mutex mutex;
+    int next;
+    int end;
+  };
+
+  void Entry(int self) {
+    ParallelRegion region;
+#ifdef USE_MKL
+    mkl_set_num_threads_local(1);
+#endif
+    int generation = 0;
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (true) {
+      while (!stop_ && generation == generation_) {
+        work_cv_.wait(lock);
+      }
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+      if (pending_ == 0) {
+        continue;  // woke up after the loop was over
+      }
+      const boost::function<void(int)>* task = task_;
+      ++active_;
+      lock.unlock();
+      const int done = RunTasks(self, *task);
+      lock.lock();
+      --active_;
+      pending_ -= done;
+      if (pending_ == 0 && active_ == 0) {
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  // Runs tasks of the current loop, from the thread's own share first and
+  // then stolen ones, until no share has any left. Returns how many it ran.
+  int RunTasks(int self, const boost::function<void(int)>& task) {
+    int done = 0;
+    int i;
+    while (Claim(self, &i)) {
+      task(i);
+      ++done;
+    }
+    return done;
+  }
+
+  bool Claim(int self, int* i) {
+    if (TakeNext(self, i)) {
+      return true;
+    }
+    const int num_shares = shares_.size();
+    for (int k = 1; k < num_shares; ++k) {
+      if (Steal((self + k) % num_shares, self)) {
+        return TakeNext(self, i);
+      }
+    }
+    return false;
+  }
+
+  bool TakeNext(int self, int* i) {
+    Share& share = *shares_[self];
+    boost::lock_guard<boost::mutex> lock(share.mutex);
+    if (share.next >= share.end) {
+      return false;
+    }
+    *i = share.next++;
+    return true;
+  }
+
+  // Moves the back half of the victim's remaining tasks to the thief.
+  bool Steal(int victim, int thief) {
+    int begin, end;
+    {
+      Share& share = *shares_[victim];
+      boost::lock_guard<boost::mutex> lock(share.mutex);
+      const int left = share.end - share.next;
+      if (left <= 0) {
+        return false;
+      }
+      end = share.end;
+      begin = end - (left + 1) / 2;
+      share.end = begin;
+    }
+    Share& share = *shares_[thief];
+    boost::lock_guard<boost::mutex> lock(share.mutex);
+    share.next = begin;
+    share.end = end;
+    return true;
+  }
+
+  vector<shared_ptr<boost::thread> > threads_;
+  vector<shared_ptr<Share> > shares_;  // one per thread, the caller's first
+  boost::mutex run_mutex_;  // held by the thread whose loop is running
+  boost::mutex mutex_;      // guards the fields below
+  boost::condition_variable work_cv_;
+  boost::condition_variable done_cv_;
+  const boost::function<void(int)>* task_;
+  int pending_;  // tasks not yet run
+  int active_;   // workers inside RunTasks
+  int generation_;
+  bool stop_;
+};
+
+ThreadPool::ThreadPool(int num_threads) : num_threads_(num_threads) {
+  CHECK_GE(num_threads, 1);
+  if (num_threads > 1) {
+    workers_.reset(new Workers(num_threads - 1));
+  }
+}
+
+ThreadPool::~ThreadPool() {}
+
+void ThreadPool::Run(int num_tasks, const boost::function<void(int)>& task) {
+  if (num_tasks <= 0) {
+    return;
+  }
+  if (num_tasks == 1 || !workers_ || in_parallel_region() ||
+      !workers_->Run(num_tasks, task)) {
+    RunSerially(num_tasks, task);
+  }
+}
+
+bool ThreadPool::in_parallel_region() {
+  return parallel_depth.get() && *parallel_depth > 0;
+}
+
+namespace {
+
+// Calls body on the i-th of num_chunks subranges of [begin, end).
+class ChunkTask {
+ public:
+  ChunkTask(const boost::function<void(int, int)>& body, int begin, int end,
+      int num_chunks)
+      : body_(body), begin_(begin), end_(end), num_chunks_(num_chunks) {}
+  void operator()(int i) const {
+    body_(Boundary(i), Boundary(i + 1));
+  }
+
+ private:
+  int Boundary(int i) const {
+    return begin_ + static_cast<int64_t>(end_ - begin_) * i / num_chunks_;
+  }
+
+  const boost::function<void(int, int)>& body_;
+  const int begin_;
+  const int end_;
+  const int num_chunks_;
+};
+
+// Subranges per thread, so that stealing has something to balance.
+const int kChunksPerThread = 4;
+
+}  // namespace
+
+void parallel_for(int begin, int end, int grain,
+    const boost::function<void(int, int)>& body) {
+  CHECK_GE(grain, 1);
+  if (end <= begin) {
+    return;
+  }
+  const int n = end - begin;
+  if (n < 2 * grain || ThreadPool::in_parallel_region()) {
+    body(begin, end);
+    return;
+  }
+  shared_ptr<ThreadPool> pool = Caffe::thread_pool();
+  if (pool->num_threads() == 1) {
+    body(begin, end);
+    return;
+  }
+  const int num_chunks = std::min(n / grain,
+      pool->num_threads() * kChunksPerThread);
+  ChunkTask task(body, begin, end, num_chunks);
+  pool->Run(num_chunks, boost::ref(task));
+}
+
+void set_blas_num_threads(int num_threads) {
+  CHECK_GE(num_threads, 1);
+#ifdef USE_MKL
+  mkl_set_num_threads(num_threads);
+#elif defined(CAFFE_OPENBLAS_THREADS)
+  if (openblas_set_num_threads) {
+    openblas_set_num_threads(num_threads);
+  }
+#endif
+}
+
+int blas_num_threads() {
+#ifdef USE_MKL
+  return mkl_get_max_threads();
+#elif defined(CAFFE_OPENBLAS_THREADS)
+  return openblas_get_num_threads ? openblas_get_num_threads() : 0;
+#else
+  return 0;
+#endif
+}
+
+}  // namespace caffe
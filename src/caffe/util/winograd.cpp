@@ -0,0 +1,277 @@
+#include <boost/bind.hpp>
+#include <algorithm>
+
+#include "caffe/common.hpp"
+#include "caffe/util/math_functions.hpp"
+#include "caffe/util/thread_pool.hpp"
+#include "caffe/util/winograd.hpp"
+
+namespace caffe {
+
+namespace {
+
+// Transform matrices for F(2x2, 3x3) and F(4x4, 3x3); the output tile is
+// A^T [(G g G^T) .* (B^T d B)] A for filter g and input tile d.
+const double kBT2[4 * 4] = {
+  1,  0, -1,  0,
+  0,  1,  1,  0,
+  0, -1,  1,  0,
+  0,  1,  0, -1
+};
+const double kG2[4 * 3] = {
+  1,    0,   0,
+  0.5,  0.5, 0.5,
+  0.5, -0.5, 0.5,
+  0,    0,   1
+};
+const double kAT2[2 * 4] = {
+  1, 1,  1,  0,
+  0, 1, -1, -1
+};
+
+const double kBT4[6 * 6] = {
+  4,  0, -5,  0, 1, 0,
+  0, -4, -4,  1, 1, 0,
+  0,  4, -4, -1, 1, 0,
+  0, -2, -1,  2, 1, 0,
+  0,  2, -1, -2, 1, 0,
+  0,  4,  0, -5, 0, 1
+};
+const double kG4[6 * 3] = {
+   1. / 4,   0,        0,
+  -1. / 6,  -1. / 6,  -1. / 6,
+  -1. / 6,   1. / 6,  -1. / 6,
+   1. / 24,  1. / 12,  1. / 6,
+   1. / 24, -1. / 12,  1. / 6,
+   0,        0,        1
+};
+const double kAT4[4 * 6] = {
+  1, 1,  1, 1,  1, 0,
+  0, 1, -1, 2, -2, 0,
+  0, 1,  1, 4,  4, 0,
+  0, 1, -1, 8, -8, 1
+};
+
+const int kMaxAlpha = 6;
+
+// The matrices of one F(m x m, 3 x 3), converted to Dtype.
+template <typename Dtype>
+struct Transforms {
+  explicit Transforms(const int tile) : m(tile), alpha(tile + 2) {
+    CHECK(tile == 2 || tile == 4) << "Winograd tile must be 2 or 4.";
+    const double* bt = tile == 2 ? kBT2 : kBT4;
+    const double* g = tile == 2 ? kG2 : kG4;
+    const double* at = tile == 2 ? kAT2 : kAT4;
+    for (int i = 0; i < alpha * alpha; ++i) { BT[i] = bt[i]; }
+    for (int i = 0; i < alpha * 3; ++i) { G[i] = g[i]; }
+    for (int i = 0; i < m * alpha; ++i) { AT[i] = at[i]; }
+  }
+  const int m;
+  const int alpha;
+  Dtype BT[kMaxAlpha * kMaxAlpha];
+  Dtype G[kMaxAlpha * 3];
+  Dtype AT[kMaxAlpha * kMaxAlpha];
+};
+
+// out = L X L^T, with L rows x n and X n x n.
+template <typename Dtype>
+inline void Sandwich(const Dtype* L, const int rows, const int n,
+    const Dtype* X, Dtype* out) {
+  Dtype tmp[kMaxAlpha * kMaxAlpha];
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < n; ++j) {
+      Dtype sum = 0;
+      for (int k = 0; k < n; ++k) {
+        sum += L[i * n + k] * X[k * n + j];
+      }
+      tmp[i * n + j] = sum;
+    }
+  }
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < rows; ++j) {
+      Dtype sum = 0;
+      for (int k = 0; k < n; ++k) {
+        sum += tmp[i * n + k] * L[j * n + k];
+      }
+      out[i * rows + j] = sum;
+    }
+  }
+}
+
+// The tiling of one convolution.
+struct Tiling {
+  Tiling(const int m, const int height, const int width, const int pad_h,
+      const int pad_w)
+      : height(height), width(width), pad_h(pad_h), pad_w(pad_w),
+        output_h(height + 2 * pad_h - 2), output_w(width + 2 * pad_w - 2),
+        tiles_h((output_h + m - 1) / m), tiles_w((output_w + m - 1) / m),
+        num_tiles(tiles_h * tiles_w) {}
+  const int height, width, pad_h, pad_w;
+  const int output_h, output_w;
+  const int tiles_h, tiles_w, num_tiles;
+};
+
+// Transforms the filters of rows [begin, end) of the result.
+template <typename Dtype>
+void TransformFilters(const Transforms<Dtype>* t, const Dtype* weights,
+    const int rows, const int cols, const bool flip, Dtype* transformed,
+    const int begin, const int end) {
+  const int alpha2 = t->alpha * t->alpha;
+  Dtype g[9];
+  Dtype u[kMaxAlpha * kMaxAlpha];
+  for (int r = begin; r < end; ++r) {
+    for (int c = 0; c < cols; ++c) {
+      // Row r, column c of the result is filter (c, r), rotated, if flipped.
+      const Dtype* filter = flip ? weights + (c * rows + r) * 9
+          : weights + (r * cols + c) * 9;
+      for (int i = 0; i < 9; ++i) {
+        g[i] = flip ? filter[8 - i] : filter[i];
+      }
+      Sandwich(t->G, t->alpha, 3, g, u);
+      for (int xi = 0; xi < alpha2; ++xi) {
+        transformed[(xi * rows + r) * cols + c] = u[xi];
+      }
+    }
+  }
+}
+
+// Transforms the input tiles of channels [begin, end) into V, which holds
+// alpha^2 matrices of channels x num_tiles.
+template <typename Dtype>
+void TransformInput(const Transforms<Dtype>* t, const Tiling* tiling,
+    const Dtype* data_im, const int channels, Dtype* V,
+    const int begin, const int end) {
+  const int alpha = t->alpha;
+  const int alpha2 = alpha * alpha;
+  const int stride = channels * tiling->num_tiles;
+  Dtype d[kMaxAlpha * kMaxAlpha];
+  Dtype v[kMaxAlpha * kMaxAlpha];
+  for (int c = begin; c < end; ++c) {
+    const Dtype* im = data_im + c * tiling->height * tiling->width;
+    for (int th = 0; th < tiling->tiles_h; ++th) {
+      for (int tw = 0; tw < tiling->tiles_w; ++tw) {
+        const int y0 = th * t->m - tiling->pad_h;
+        const int x0 = tw * t->m - tiling->pad_w;
+        for (int i = 0; i < alpha; ++i) {
+          const int y = y0 + i;
+          for (int j = 0; j < alpha; ++j) {
+            const int x = x0 + j;
+            d[i * alpha + j] = (y >= 0 && y < tiling->height && x >= 0 &&
+                x < tiling->width) ? im[y * tiling->width + x] : Dtype(0);
+          }
+        }
+        Sandwich(t->BT, alpha, alpha, d, v);
+        Dtype* out = V + c * tiling->num_tiles + th * tiling->tiles_w + tw;
+        for (int xi = 0; xi < alpha2; ++xi) {
+          out[xi * stride] = v[xi];
+        }
+      }
+    }
+  }
+}
+
+// Transforms M, alpha^2 matrices of num_output x num_tiles, back into the
+// output tiles of channels [begin, end).
+template <typename Dtype>
+void TransformOutput(const Transforms<Dtype>* t, const Tiling* tiling,
+    const Dtype* M, const int num_output, Dtype* data_out,
+    const int begin, const int end) {
+  const int m = t->m;
+  const int alpha2 = t->alpha * t->alpha;
+  const int stride = num_output * tiling->num_tiles;
+  Dtype mt[kMaxAlpha * kMaxAlpha];
+  Dtype y[kMaxAlpha * kMaxAlpha];
+  for (int k = begin; k < end; ++k) {
+    Dtype* out = data_out + k * tiling->output_h * tiling->output_w;
+    for (int th = 0; th < tiling->tiles_h; ++th) {
+      for (int tw = 0; tw < tiling->tiles_w; ++tw) {
+        const Dtype* in = M + k * tiling->num_tiles + th * tiling->tiles_w
+            + tw;
+        for (int xi = 0; xi < alpha2; ++xi) {
+          mt[xi] = in[xi * stride];
+        }
+        Sandwich(t->AT, m, t->alpha, mt, y);
+        const int rows = std::min(m, tiling->output_h - th * m);
+        const int cols = std::min(m, tiling->output_w - tw * m);
+        for (int i = 0; i < rows; ++i) {
+          for (int j = 0; j < cols; ++j) {
+            out[(th * m + i) * tiling->output_w + tw * m + j] = y[i * m + j];
+          }
+        }
+      }
+    }
+  }
+}
+
+// Per-thread work is a few filters or channels of a few tiles each; keep the
+// grain large enough to pay for the dispatch.
+const int kMinTilesPerTask = 64;
+
+}  // namespace
+
+int winograd_workspace_size(const int tile, const int channels,
+    const int num_output, const int output_h, const int output_w) {
+  const int alpha = tile + 2;
+  const int num_tiles = ((output_h + tile - 1) / tile) *
+      ((output_w + tile - 1) / tile);
+  return alpha * alpha * (channels + num_output) * num_tiles;
+}
+
+template <typename Dtype>
+void winograd_transform_filter_cpu(const int tile, const Dtype* weights,
+    const int num_output, const int channels, const bool flip,
+    Dtype* transformed) {
+  const Transforms<Dtype> t(tile);
+  const int rows = flip ? channels : num_output;
+  const int cols = flip ? num_output : channels;
+  parallel_for(0, rows, std::max(1, kMinTilesPerTask / cols),
+      boost::bind(&TransformFilters<Dtype>, &t, weights, rows, cols, flip,
+          transformed, _1, _2));
+}
+
+template void winograd_transform_filter_cpu<float>(const int tile,
+    const float* weights, const int num_output, const int channels,
+    const bool flip, float* transformed);
+template void winograd_transform_filter_cpu<double>(const int tile,
+    const double* weights, const int num_output, const int channels,
+    const bool flip, double* transformed);
+
+template <typename Dtype>
+void winograd_conv_cpu(const int tile, const Dtype* data_im,
+    const int channels, const int height, const int width,
+    const int pad_h, const int pad_w, const Dtype* transformed,
+    const int num_output, Dtype* data_out, Dtype* workspace) {
+  const Transforms<Dtype> t(tile);
+  const Tiling tiling(tile, height, width, pad_h, pad_w);
+  CHECK_GT(tiling.output_h, 0);
+  CHECK_GT(tiling.output_w, 0);
+  const int alpha2 = t.alpha * t.alpha;
+  const int num_tiles = tiling.num_tiles;
+  const int grain = std::max(1, kMinTilesPerTask / num_tiles);
+  Dtype* V = workspace;
+  Dtype* M = workspace + alpha2 * channels * num_tiles;
+  parallel_for(0, channels, grain, boost::bind(&TransformInput<Dtype>, &t,
+      &tiling, data_im, channels, V, _1, _2));
+  // One (num_output x channels) x (channels x num_tiles) product per
+  // position in the tile.
+  for (int xi = 0; xi < alpha2; ++xi) {
+    caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, num_output, num_tiles,
+        channels, (Dtype)1., transformed + xi * num_output * channels,
+        V + xi * channels * num_tiles, (Dtype)0.,
+        M + xi * num_output * num_tiles);
+  }
+  parallel_for(0, num_output, grain, boost::bind(&TransformOutput<Dtype>,
+      &t, &tiling, M, num_output, data_out, _1, _2));
+}
+
+template void winograd_conv_cpu<float>(const int tile, const float* data_im,
+    const int channels, const int height, const int width,
+    const int pad_h, const int pad_w, const float* transformed,
+    const int num_output, float* data_out, float* workspace);
+template void winograd_conv_cpu<double>(const int tile,
+    const double* data_im, const int channels, const int height,
+    const int width, const int pad_h, const int pad_w,
+    const double* transformed, const int num_output, double* data_out,
+    double* workspace);
+
+}  // namespace caffe
@@ -0,0 +1,26 @@
+#include "caffe/util/workspace.hpp"
+
+namespace caffe {
+
+void Workspace::Reserve(size_t size) {
+  if (size > size_) {
+    // Free the old memory before the new one is allocated on first use.
+    memory_.reset();
+    memory_.reset(new SyncedMemory(size));
+    size_ = size;
+  }
+}
+
+void* Workspace::mutable_cpu_data(size_t size) {
+  Reserve(size);
+  return memory_ ? memory_->mutable_cpu_data_uninitialized() : NULL;
+}
+
+#ifndef CPU_ONLY
+void* Workspace::mutable_gpu_data(size_t size) {
+  Reserve(size);
+  return memory_ ? memory_->mutable_gpu_data() : NULL;
+}
+#endif
+
+}  // namespace caffe